@@ -30,7 +30,9 @@
 #include "w_setup.h"
 
 #include "u_bound.h"
+#include "u_free.h"
 #include "u_markers.h"
+#include "u_rtree.h"
 #include "u_translate.h"
 #include "w_cursor.h"
 
@@ -87,6 +89,13 @@ init_align_canvas(int x, int y, unsigned int shift)
     toggle_all_compoundmarkers();
     draw_compoundelements(cur_c, ERASE);
     old_c = copy_compound(&objects);
+    /* the compounds are moved, unshare them all first */
+    if (old_c == NULL || !unshare_compound_tree(&objects)) {
+	free_compound(&old_c);
+	draw_compoundelements(cur_c, PAINT);
+	toggle_all_compoundmarkers();
+	return;
+    }
     xcmin=ycmin=0;
 
     /* get the current page size */
@@ -122,6 +131,7 @@ init_align_canvas(int x, int y, unsigned int shift)
     else if (cur_valign == ALIGN_ABUT)
       put_msg("Can't ABUT vertically with respect to the canvas");
 
+    rtree_update_object(O_COMPOUND, cur_c);
     draw_compoundelements(cur_c, PAINT);
     toggle_all_compoundmarkers();
     clean_up();
@@ -139,6 +149,15 @@ init_align(F_line *p, int type, int x, int y, int px, int py)
     toggle_compoundmarker(cur_c);
     draw_compoundelements(cur_c, ERASE);
     old_c = copy_compound(cur_c);
+    /* the compounds in it are moved too, unshare them all first */
+    if (!unshare_compound_tree(cur_c)) {
+	/* no memory for its own objects, leave the compound as it was */
+	free_compound(&old_c);
+	draw_compoundelements(cur_c, PAINT);
+	toggle_compoundmarker(cur_c);
+	return;
+    }
+    invalidate_compound_bound(cur_c);
     compound_bound(cur_c, &xcmin, &ycmin, &xcmax, &ycmax);
     align_ellipse();
     align_arc();
@@ -162,6 +181,7 @@ init_align(F_line *p, int type, int x, int y, int px, int py)
      */
     compound_bound(cur_c, &cur_c->nwcorner.x, &cur_c->nwcorner.y,
 		   &cur_c->secorner.x, &cur_c->secorner.y);
+    rtree_update_object(O_COMPOUND, cur_c);
     draw_compoundelements(cur_c, PAINT);
     toggle_compoundmarker(cur_c);
     clean_up();
@@ -237,7 +257,7 @@ align_compound(void)
 	    continue;
 	compound_bound(c, &llx, &lly, &urx, &ury);
 	get_dx_dy();
-	translate_compound(c, dx, dy);
+	(void) translate_compound(c, dx, dy);	/* already unshared */
     }
 }
 
@@ -788,7 +808,7 @@ adjust_object_pos (F_line *obj_ptr, int obj_type, int delta_x, int delta_y)
     break;
   case O_COMPOUND:
     c = (F_compound *) obj_ptr;
-    translate_compound(c, delta_x, delta_y);
+    (void) translate_compound(c, delta_x, delta_y);	/* already unshared */
     c->distrib = 1;
     break;
   default:
@@ -172,6 +172,8 @@ add_splinearrow(F_spline *spline, F_point *prev_point, F_point *selected_point)
 void
 delete_linearrow(F_line *line, F_point *prev_point, F_point *selected_point)
 {
+    F_arrow	   *for_arrow = NULL, *back_arrow = NULL;
+
     if (line->points->next == NULL)
 	return;			/* A single point line */
 
@@ -179,25 +181,22 @@ delete_linearrow(F_line *line, F_point *prev_point, F_point *selected_point)
 	if (!line->back_arrow)
 	    return;
 	draw_line(line, ERASE);
-	saved_back_arrow=line->back_arrow;
-	if (saved_for_arrow && saved_for_arrow != line->for_arrow)
-	    free((char *) saved_for_arrow);
-	saved_for_arrow = NULL;
+	back_arrow = line->back_arrow;
 	line->back_arrow = NULL;
 	redisplay_line(line);
     } else if (selected_point->next == NULL) {	/* forward arrow */
 	if (!line->for_arrow)
 	    return;
 	draw_line(line, ERASE);
-	saved_for_arrow=line->for_arrow;
-	if (saved_back_arrow && saved_back_arrow != line->back_arrow)
-	    free((char *) saved_back_arrow);
-	saved_back_arrow = NULL;
+	for_arrow = line->for_arrow;
 	line->for_arrow = NULL;
 	redisplay_line(line);
     } else
 	return;
     clean_up();
+    /* the journal keeps the arrowhead for undo */
+    saved_for_arrow = for_arrow;
+    saved_back_arrow = back_arrow;
     set_last_prevpoint(prev_point);
     set_last_selectedpoint(selected_point);
     set_latestline(line);
@@ -208,31 +207,30 @@ delete_linearrow(F_line *line, F_point *prev_point, F_point *selected_point)
 void
 delete_arcarrow(F_arc *arc, int point_num)
 {
+    F_arrow	   *for_arrow = NULL, *back_arrow = NULL;
+
     if (arc->type == T_PIE_WEDGE_ARC)
 	return;;
     if (point_num == 0) {	/* backward arrow  */
 	if (!arc->back_arrow)
 	    return;
 	draw_arc(arc, ERASE);
-	saved_back_arrow=arc->back_arrow;
-	if (saved_for_arrow && saved_for_arrow != arc->for_arrow)
-	    free((char *) saved_for_arrow);
-	saved_for_arrow = NULL;
+	back_arrow = arc->back_arrow;
 	arc->back_arrow = NULL;
 	redisplay_arc(arc);
     } else if (point_num == 2) {/* for_arrow  */
 	if (!arc->for_arrow)
 	    return;
 	draw_arc(arc, ERASE);
-	saved_for_arrow=arc->for_arrow;
-	if (saved_back_arrow && saved_back_arrow != arc->back_arrow)
-	    free((char *) saved_back_arrow);
-	saved_back_arrow = NULL;
+	for_arrow = arc->for_arrow;
 	arc->for_arrow = NULL;
 	redisplay_arc(arc);
     } else
 	return;
     clean_up();
+    /* the journal keeps the arrowhead for undo */
+    saved_for_arrow = for_arrow;
+    saved_back_arrow = back_arrow;
     set_last_arcpointnum(point_num);
     set_latestarc(arc);
     set_action_object(F_DELETE_ARROW_HEAD, O_ARC);
@@ -242,31 +240,30 @@ delete_arcarrow(F_arc *arc, int point_num)
 void
 delete_splinearrow(F_spline *spline, F_point *prev_point, F_point *selected_point)
 {
+    F_arrow	   *for_arrow = NULL, *back_arrow = NULL;
+
     if (closed_spline(spline))
 	return;
     if (prev_point == NULL) {	/* selected_point is the first point */
 	if (!spline->back_arrow)
 	    return;
 	draw_spline(spline, ERASE);
-	saved_back_arrow=spline->back_arrow;
-	if (saved_for_arrow && saved_for_arrow != spline->for_arrow)
-	    free((char *) saved_for_arrow);
-	saved_for_arrow = NULL;
+	back_arrow = spline->back_arrow;
 	spline->back_arrow = NULL;
 	redisplay_spline(spline);
     } else if (selected_point->next == NULL) {	/* forward arrow */
 	if (!spline->for_arrow)
 	    return;
 	draw_spline(spline, ERASE);
-	saved_for_arrow=spline->for_arrow;
-	if (saved_back_arrow && saved_back_arrow != spline->back_arrow)
-	    free((char *) saved_back_arrow);
-	saved_back_arrow = NULL;
+	for_arrow = spline->for_arrow;
 	spline->for_arrow = NULL;
 	redisplay_spline(spline);
     } else
 	return;
     clean_up();
+    /* the journal keeps the arrowhead for undo */
+    saved_for_arrow = for_arrow;
+    saved_back_arrow = back_arrow;
     set_last_prevpoint(prev_point);
     set_last_selectedpoint(selected_point);
     set_latestspline(spline);
@@ -20,6 +20,7 @@
 #include "mode.h"
 #include "object.h"
 #include "paintop.h"
+#include "u_create.h"
 #include "u_search.h"
 #include "u_list.h"
 #include "u_undo.h"
@@ -72,6 +73,11 @@ init_break(F_line *p, int type, int x, int y, int px, int py, int loc_tag)
     cur_c = (F_compound *) p;
     mask_toggle_compoundmarker(cur_c);
     clean_up();
+    /* its objects go into the figure */
+    if (!unshare_compound(cur_c)) {
+	mask_toggle_compoundmarker(cur_c);
+	return;
+    }
     list_delete_compound(&objects.compounds, cur_c);
     tail(&objects, &object_tails);
     append_objects(&objects, cur_c, &object_tails);
@@ -27,6 +27,7 @@
 #include "u_create.h"
 #include "u_draw.h"
 #include "u_list.h"
+#include "u_pool.h"
 #include "u_search.h"
 #include "u_undo.h"
 #include "w_canvas.h"
@@ -209,7 +210,7 @@ check_poly(F_line * this_line, struct f_point ** i_point_p, int type)
       if ((prev_point->x == this_point->x) &&
 	  (prev_point->y == this_point->y)) {
 	prev_point->next = next_point;
-	free(this_point);
+	pool_free(&point_pool, this_point);
 	nr_pts--;
 	update_pp = False;
       }
@@ -41,9 +41,11 @@
 
 #include "e_scale.h"
 #include "u_bound.h"
+#include "u_create.h"
 #include "u_list.h"
 #include "u_markers.h"
 #include "u_redraw.h"
+#include "u_rtree.h"
 #include "w_color.h"
 #include "w_cursor.h"
 #include "w_modepanel.h"
@@ -79,6 +81,11 @@ open_this_compound(F_compound *c, Boolean vis)
   F_compound *d;
 
   mask_toggle_compoundmarker(c);
+  /* its objects are edited in place */
+  if (!unshare_compound(c)) {
+	mask_toggle_compoundmarker(c);
+	return;
+  }
 
   /* save current indicator panel button mask */
   save_mask = cur_indmask;
@@ -91,6 +98,7 @@ open_this_compound(F_compound *c, Boolean vis)
   objects = *c;
   objects.GABPtr = c;		/* Where original compound came from */
   objects.draw_parent = vis;
+  rtree_invalidate();
   if (!close_popup_isup)
 	popup_close_compound();
   redisplay_canvas();
@@ -137,7 +145,9 @@ close_compound(void)
     compound_bound(&objects, &objects.nwcorner.x, &objects.nwcorner.y,
 			&objects.secorner.x, &objects.secorner.y);
     *d = objects;		/* Put in any changes */
+    invalidate_compound_bound(d);
     objects = *c;		/* Restore compound above */
+    rtree_invalidate();
     /* user may have deleted all objects inside the compound */
     if (object_count(d)==0) {
 	list_delete_compound(&objects.compounds, d);
@@ -176,7 +186,9 @@ close_all_compounds(void)
       compound_bound(&objects, &objects.nwcorner.x, &objects.nwcorner.y,
 			&objects.secorner.x, &objects.secorner.y);
       *d = objects;		/* Put in any changes */
+      invalidate_compound_bound(d);
       objects = *c;
+      rtree_invalidate();
       /* user may have deleted all objects inside the compound */
       if (object_count(d)==0) {
 	list_delete_compound(&objects.compounds, d);
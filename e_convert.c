@@ -35,7 +35,9 @@
 #include "f_util.h"
 #include "u_free.h"
 #include "u_markers.h"
+#include "u_pool.h"
 #include "u_redraw.h"
+#include "u_rtree.h"
 #include "w_cursor.h"
 
 static void	init_convert_line_spline(F_line *p, int type, int x, int y, int px, int py);
@@ -301,7 +303,7 @@ toggle_polyline_polygon(F_line *line, F_point *previous_point, F_point *selected
     {
       point = line->points;
       line->points = point->next;           /* unchain the first point */
-      free((char *) point);
+      pool_free(&point_pool, point);
             
       if ((line->points != selected_point) && (previous_point != NULL))
 	{
@@ -326,6 +328,7 @@ toggle_open_closed_spline(F_spline *spline, F_point *previous_point, F_point *se
 {
   F_point *last_pt;
   F_sfactor *last_sfactor, *previous_sfactor, *selected_sfactor;
+  double origin_tension, extremity_tension;
 
   if (spline->points->next == NULL || spline->points->next->next == NULL) {
       put_msg("Not enough points for a spline");
@@ -345,7 +348,8 @@ toggle_open_closed_spline(F_spline *spline, F_point *previous_point, F_point *se
     {
       previous_sfactor = search_sfactor(spline, previous_point);
       selected_sfactor = previous_sfactor->next;
-      set_last_tension(selected_sfactor->s, previous_sfactor->s);
+      origin_tension = selected_sfactor->s;
+      extremity_tension = previous_sfactor->s;
     }
 
   draw_spline(spline, ERASE);
@@ -398,8 +402,12 @@ toggle_open_closed_spline(F_spline *spline, F_point *previous_point, F_point *se
       set_last_arrows(spline->for_arrow, spline->back_arrow);
       spline->back_arrow = spline->for_arrow = NULL;
     }
+  rtree_update_object(O_SPLINE, spline);
   draw_spline(spline, PAINT);
   set_action_object(F_OPEN_CLOSE, O_SPLINE);
+  /* after clean_up(), which puts the last action in the undo journal */
+  if (previous_point != NULL)
+      set_last_tension(origin_tension, extremity_tension);
   set_last_selectedpoint(spline->points);
   set_last_prevpoint(NULL);
   set_latestspline(spline);
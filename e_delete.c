@@ -25,6 +25,7 @@
 #include "u_draw.h"
 #include "u_elastic.h"
 #include "u_redraw.h"
+#include "u_rtree.h"
 #include "u_search.h"
 #include "u_list.h"
 #include "u_undo.h"
@@ -38,6 +39,7 @@
 #include "e_glue.h"
 #include "f_save.h"
 #include "u_markers.h"
+#include "u_pool.h"
 #include "w_cursor.h"
 
 static void	init_delete(F_line *p, int type, int x, int y, int px, int py);
@@ -141,7 +143,7 @@ delete_region(int x, int y)
     c->secorner.y = max2(fix_y, y);
     tag_obj_in_region(c->nwcorner.x,c->nwcorner.y,c->secorner.x,c->secorner.y);
     if (compose_compound(c) == 0) {
-	free((char *) c);
+	pool_free(&compound_pool, c);
 	delete_selected();
 	draw_mousefun_canvas();
 	put_msg("Empty region, figure unchanged");
@@ -286,6 +288,7 @@ void delete_all(void)
     objects.splines = NULL;
     objects.texts = NULL;
     objects.comments = NULL;
+    rtree_invalidate();
 
     object_tails.arcs = NULL;
     object_tails.compounds = NULL;
@@ -1057,13 +1057,13 @@ done_figure_comments(void)
 
     switch (button_result) {
       case DONE:
+	clean_up();
 	/* save old comments */
 	saved_objects.comments = objects.comments;
 	/* get new comments */
 	s = panel_get_value(comments_panel);
 	/* allocate space and copy */
 	copy_comments(&s, &objects.comments);
-	clean_up();
 	set_action_object(F_EDIT, O_FIGURE);
 	set_modifiedflag();
 	break;
@@ -1432,6 +1432,8 @@ get_new_compound_values(void)
     /* get any comments */
     new_c->comments = my_strdup(panel_get_value(comments_panel));
 
+    invalidate_compound_bound(new_c);
+
     /* get any new text object values */
     for (t=new_c->texts,i=0; t ;t=t->next,i++) {
 	if (t->cstring)
@@ -1446,13 +1448,21 @@ get_new_compound_values(void)
 	t->descent = size.descent;
     }
 
-    translate_compound(new_c, dx, dy);
+    /* unshared by done_compound, so these can't fail */
+    (void) translate_compound(new_c, dx, dy);
     scale_compound(new_c, scalex, scaley, nw_x, nw_y);
 }
 
 static void
 done_compound(void)
 {
+    /* old_c shares the objects until they are changed */
+    if (button_result != CANCEL && !unshare_compound_tree(new_c)) {
+	/* no memory for a copy, leave the compound as it was */
+	if (button_result == APPLY)
+	    return;
+	button_result = CANCEL;
+    }
     switch (button_result) {
 
       case APPLY:
@@ -5454,6 +5464,8 @@ void collapse_depths(F_compound *compound)
 	F_text	 *t;
 	F_compound *c;
 
+	if (!unshare_compound(compound))
+	    return;
 	for (l = compound->lines; l != NULL; l = l->next) {
 	    remove_depth(O_POLYLINE, l->depth);
 	    l->depth = min_compound_depth;
@@ -21,6 +21,8 @@
 #include "object.h"
 #include "paintop.h"
 #include "e_rotate.h"
+#include "u_bound.h"
+#include "u_free.h"
 #include "u_draw.h"
 #include "u_search.h"
 #include "u_create.h"
@@ -54,7 +56,7 @@ static void	flip_search(F_line *p, int type, int x, int y, int px, int py);
 
 
 void flip_arc (F_arc *a, int x, int y, int flip_axis);
-void flip_compound (F_compound *c, int x, int y, int flip_axis);
+Boolean flip_compound (F_compound *c, int x, int y, int flip_axis);
 void flip_ellipse (F_ellipse *e, int x, int y, int flip_axis);
 void flip_line (F_line *l, int x, int y, int flip_axis);
 void flip_spline (F_spline *s, int x, int y, int flip_axis);
@@ -210,7 +212,12 @@ init_flipcompound(F_compound *old_c, int px, int py)
 
     set_temp_cursor(wait_cursor);
     new_c = copy_compound(old_c);
-    flip_compound(new_c, px, py, flip_axis);
+    if (new_c == NULL || !flip_compound(new_c, px, py, flip_axis)) {
+	/* no memory for its own objects, leave the compound as it was */
+	free_compound(&new_c);
+	reset_cursor();
+	return;
+    }
     if (copy) {
 	add_compound(new_c);
     } else {
@@ -384,7 +391,12 @@ void flip_arc(F_arc *a, int x, int y, int flip_axis)
     }
 }
 
-void flip_compound(F_compound *c, int x, int y, int flip_axis)
+/*
+ * Flip compound c and everything in it.  Returns False, with the
+ * compound left as it was, if there isn't the memory to unshare it.
+ */
+
+Boolean flip_compound(F_compound *c, int x, int y, int flip_axis)
 {
     F_line	   *l;
     F_arc	   *a;
@@ -394,6 +406,10 @@ void flip_compound(F_compound *c, int x, int y, int flip_axis)
     F_compound	   *c1;
     int		    p, q;
 
+    /* unshare it all before anything is flipped */
+    if (!unshare_compound_tree(c))
+	return False;
+    invalidate_compound_bound(c);
     switch (flip_axis) {
     case UD_FLIP:		/* x axis  */
 	p = y + (y - c->nwcorner.y);
@@ -419,5 +435,6 @@ void flip_compound(F_compound *c, int x, int y, int flip_axis)
     for (t = c->texts; t != NULL; t = t->next)
 	flip_text(t, x, y, flip_axis);
     for (c1 = c->compounds; c1 != NULL; c1 = c1->next)
-	flip_compound(c1, x, y, flip_axis);
+	(void) flip_compound(c1, x, y, flip_axis);	/* already unshared */
+    return True;
 }
@@ -19,6 +19,6 @@ extern int	setanchor;
 extern int	setanchor_x;
 extern int	setanchor_y;
 
-extern int flip_compound (F_compound *c, int x, int y, int flip_axis);
+extern Boolean flip_compound (F_compound *c, int x, int y, int flip_axis);
 extern void flip_lr_selected (void);
 extern void flip_ud_selected (void);
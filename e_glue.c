@@ -27,6 +27,7 @@
 #include "u_draw.h"
 #include "u_elastic.h"
 #include "u_list.h"
+#include "u_rtree.h"
 #include "u_search.h"
 #include "u_undo.h"
 #include "w_canvas.h"
@@ -36,6 +37,7 @@
 
 #include "d_box.h"
 #include "u_markers.h"
+#include "u_pool.h"
 #include "w_cursor.h"
 
 static void	create_compoundobject(int x, int y), cancel_tag_region(void),
@@ -153,7 +155,7 @@ create_compoundobject(int x, int y)
 	return;
 
     if (compose_compound(c) == 0) {
-	free((char *) c);
+	pool_free(&compound_pool, c);
 	compound_selected();
 	draw_mousefun_canvas();
 	put_msg("Empty compound, ignored");
@@ -191,8 +193,19 @@ create_compoundobject(int x, int y)
     draw_mousefun_canvas();
 }
 
+/*
+ * Only the objects whose bounds overlap the region can lie inside it, so
+ * the sel_xxx() routines look at those that the R-tree returns (in list
+ * order) instead of at every object in the figure, unless there wasn't
+ * the memory to collect them.
+ */
+
+static RT_hit	 *region_hits;
+static int	  region_nhits;
+
 void tag_obj_in_region(int xmin, int ymin, int xmax, int ymax)
 {
+    region_nhits = rtree_search(xmin, ymin, xmax, ymax, &region_hits);
     sel_ellipse(xmin, ymin, xmax, ymax);
     sel_line(xmin, ymin, xmax, ymax);
     sel_spline(xmin, ymin, xmax, ymax);
@@ -241,8 +254,12 @@ static void
 sel_ellipse(int xmin, int ymin, int xmax, int ymax)
 {
     F_ellipse	   *e;
+    int		    i;
 
-    for (e = objects.ellipses; e != NULL; e = e->next) {
+    i = 0;
+    e = NULL;
+    while ((e = (F_ellipse *) rtree_hit_next(region_hits, region_nhits,
+					O_ELLIPSE, &i, e)) != NULL) {
 	if (!active_layer(e->depth))
 	    continue;
 	if (xmin > e->center.x - e->radiuses.x)
@@ -270,6 +287,7 @@ get_ellipse(F_ellipse **list)
 	    continue;
 	}
 	remove_depth(O_ELLIPSE, e->depth);
+	rtree_remove_object(O_ELLIPSE, e);
 	if (*list == NULL)
 	    *list = e;
 	else
@@ -280,7 +298,9 @@ get_ellipse(F_ellipse **list)
 	else {
 	    e = ee->next = e->next;
 	}
-	ellipse->next = NULL;
+	if (e != NULL)
+	    e->prev = (e == objects.ellipses)? NULL: ee;
+	ellipse->prev = ellipse->next = NULL;
     }
 }
 
@@ -288,9 +308,12 @@ static void
 sel_arc(int xmin, int ymin, int xmax, int ymax)
 {
     F_arc	   *a;
-    int		    urx, ury, llx, lly;
+    int		    urx, ury, llx, lly, i;
 
-    for (a = objects.arcs; a != NULL; a = a->next) {
+    i = 0;
+    a = NULL;
+    while ((a = (F_arc *) rtree_hit_next(region_hits, region_nhits,
+					O_ARC, &i, a)) != NULL) {
 	if (!active_layer(a->depth))
 	    continue;
 	arc_bound(a, &llx, &lly, &urx, &ury);
@@ -319,6 +342,7 @@ get_arc(F_arc **list)
 	    continue;
 	}
 	remove_depth(O_ARC, a->depth);
+	rtree_remove_object(O_ARC, a);
 	if (*list == NULL)
 	    *list = a;
 	else
@@ -328,7 +352,9 @@ get_arc(F_arc **list)
 	    a = objects.arcs = objects.arcs->next;
 	else
 	    a = aa->next = a->next;
-	arc->next = NULL;
+	if (a != NULL)
+	    a->prev = (a == objects.arcs)? NULL: aa;
+	arc->prev = arc->next = NULL;
     }
 }
 
@@ -337,9 +363,12 @@ sel_line(int xmin, int ymin, int xmax, int ymax)
 {
     F_line	   *l;
     F_point	   *p;
-    int		    inbound;
+    int		    inbound, i;
 
-    for (l = objects.lines; l != NULL; l = l->next) {
+    i = 0;
+    l = NULL;
+    while ((l = (F_line *) rtree_hit_next(region_hits, region_nhits,
+					O_POLYLINE, &i, l)) != NULL) {
 	if (!active_layer(l->depth))
 	    continue;
 	for (inbound = 1, p = l->points; p != NULL && inbound;
@@ -374,6 +403,7 @@ get_line(F_line **list)
 	    continue;
 	}
 	remove_depth(O_POLYLINE, l->depth);
+	rtree_remove_object(O_POLYLINE, l);
 	if (*list == NULL)
 	    *list = l;
 	else
@@ -383,7 +413,9 @@ get_line(F_line **list)
 	    l = objects.lines = objects.lines->next;
 	else
 	    l = ll->next = l->next;
-	line->next = NULL;
+	if (l != NULL)
+	    l->prev = (l == objects.lines)? NULL: ll;
+	line->prev = line->next = NULL;
     }
 }
 
@@ -391,9 +423,12 @@ static void
 sel_spline(int xmin, int ymin, int xmax, int ymax)
 {
     F_spline	   *s;
-    int		    urx, ury, llx, lly;
+    int		    urx, ury, llx, lly, i;
 
-    for (s = objects.splines; s != NULL; s = s->next) {
+    i = 0;
+    s = NULL;
+    while ((s = (F_spline *) rtree_hit_next(region_hits, region_nhits,
+					O_SPLINE, &i, s)) != NULL) {
 	if (!active_layer(s->depth))
 	    continue;
 	spline_bound(s, &llx, &lly, &urx, &ury);
@@ -422,6 +457,7 @@ get_spline(F_spline **list)
 	    continue;
 	}
 	remove_depth(O_SPLINE, s->depth);
+	rtree_remove_object(O_SPLINE, s);
 	if (*list == NULL)
 	    *list = s;
 	else
@@ -431,7 +467,9 @@ get_spline(F_spline **list)
 	    s = objects.splines = objects.splines->next;
 	else
 	    s = ss->next = s->next;
-	spline->next = NULL;
+	if (s != NULL)
+	    s->prev = (s == objects.splines)? NULL: ss;
+	spline->prev = spline->next = NULL;
     }
 }
 
@@ -440,9 +478,12 @@ sel_text(int xmin, int ymin, int xmax, int ymax)
 {
     F_text	   *t;
     int		    txmin, txmax, tymin, tymax;
-    int		    dum;
+    int		    dum, i;
 
-    for (t = objects.texts; t != NULL; t = t->next) {
+    i = 0;
+    t = NULL;
+    while ((t = (F_text *) rtree_hit_next(region_hits, region_nhits,
+					O_TEXT, &i, t)) != NULL) {
 	if (!active_layer(t->depth))
 	    continue;
 	text_bound(t, &txmin, &tymin, &txmax, &tymax,
@@ -467,6 +508,7 @@ get_text(F_text **list)
 	    continue;
 	}
 	remove_depth(O_TEXT, t->depth);
+	rtree_remove_object(O_TEXT, t);
 	if (*list == NULL)
 	    *list = t;
 	else
@@ -476,7 +518,9 @@ get_text(F_text **list)
 	    t = objects.texts = objects.texts->next;
 	else
 	    t = tt->next = t->next;
-	text->next = NULL;
+	if (t != NULL)
+	    t->prev = (t == objects.texts)? NULL: tt;
+	text->prev = text->next = NULL;
     }
 }
 
@@ -484,8 +528,12 @@ static void
 sel_compound(int xmin, int ymin, int xmax, int ymax)
 {
     F_compound	   *c;
+    int		    i;
 
-    for (c = objects.compounds; c != NULL; c = c->next) {
+    i = 0;
+    c = NULL;
+    while ((c = (F_compound *) rtree_hit_next(region_hits, region_nhits,
+					O_COMPOUND, &i, c)) != NULL) {
 	if (!any_active_in_compound(c))
 	    continue;
 	if (xmin > c->nwcorner.x)
@@ -513,6 +561,7 @@ get_compound(F_compound **list)
 	    continue;
 	}
 	remove_compound_depth(c);
+	rtree_remove_object(O_COMPOUND, c);
 	if (*list == NULL)
 	    *list = c;
 	else
@@ -522,6 +571,8 @@ get_compound(F_compound **list)
 	    c = objects.compounds = objects.compounds->next;
 	else
 	    c = cc->next = c->next;
-	compd->next = NULL;
+	if (c != NULL)
+	    c->prev = (c == objects.compounds)? NULL: cc;
+	compd->prev = compd->next = NULL;
     }
 }
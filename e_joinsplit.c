@@ -35,6 +35,7 @@
 #include "f_util.h"
 #include "u_free.h"
 #include "u_markers.h"
+#include "u_pool.h"
 #include "u_redraw.h"
 #include "w_cursor.h"
 
@@ -226,7 +227,7 @@ join_line2(F_line *obj, int type, int x, int y, F_point *p, F_point *q)
 	    lastp = last_point(new_l->points);
 	    append_point(new_l->points->x, new_l->points->y, &lastp);
 	} else if (!connect_line_points(line1, first1, line, first2, new_l)) {
-		free(new_l);
+		pool_free(&line_pool, new_l);
 		return;
 	}
 	clean_up();
@@ -272,7 +273,7 @@ join_spline2(F_line *obj, int type, int x, int y, F_point *p, F_point *q)
 	    new_s->sfactors->s = new_s->sfactors->next->s;
 	    last_sfactor(new_s->sfactors)->s = new_s->sfactors->s;
 	} else if (!connect_spline_points(spline1, first1, spline, first2, new_s)) {
-		free(new_s);
+		pool_free(&spline_pool, new_s);
 		return;
 	}
 	clean_up();
@@ -34,6 +34,7 @@
 #include "w_msgpanel.h"
 
 #include "f_util.h"
+#include "u_free.h"
 #include "u_geom.h"
 #include "u_redraw.h"
 #include "w_cursor.h"
@@ -593,6 +594,13 @@ fix_movedcompoundpoint(int x, int y)
 
     /* make a copy of the original and save as unchanged object */
     old_c = copy_compound(cur_c);
+    /* it is scaled as a whole, unshare it all first */
+    if (old_c == NULL || !unshare_compound_tree(cur_c)) {
+	free_compound(&old_c);
+	update_markers(new_objmask);
+	wrapup_movepoint();
+	return;
+    }
     clean_up();
     old_c->next = cur_c;
     set_latestcompound(old_c);
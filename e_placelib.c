@@ -41,6 +41,7 @@
 
 #include "e_flip.h"
 #include "e_scale.h"
+#include "u_free.h"
 #include "u_redraw.h"
 #include "u_translate.h"
 #include "u_undo.h"
@@ -60,6 +61,7 @@ static int	off_library_x,off_library_y;
 static void	init_move_object(int x, int y),move_object(int x, int y),change_draw_mode(int x, int y);
 static void	transform_lib_obj(XKeyEvent *kpe, unsigned char c, KeySym keysym),place_lib_object(int x, int y, unsigned int shift);
 static void	put_draw(int paint_mode);
+static void	stop_place_lib_obj(void);
 static void	sel_place_lib_obj_proc(int x, int y, int shift);
 static int	orig_put_x, orig_put_y;
 
@@ -78,6 +80,12 @@ put_selected(void)
 	set_action_on();
 	cur_c = lib_compounds[cur_library_object]->compound;
 	new_c = copy_compound(cur_c);
+	/* it is moved about until placed, so it gets its own objects now */
+	if (new_c == NULL || !unshare_compound_tree(new_c)) {
+	    free_compound(&new_c);
+	    stop_place_lib_obj();
+	    return;
+	}
 	/* add it to the depths so it is displayed */
 	add_compound_depth(new_c);
 	/* find lower-right corner for draw_box() */
@@ -126,18 +134,19 @@ transform_lib_obj(XKeyEvent *kpe, unsigned char c, KeySym keysym)
 
     /* first erase the existing image */
     put_draw(ERASE);
+    /* new_c was unshared by put_selected(), so these can't fail */
     if (c == 'r') {
 	rotn_dirn = 1;
 	act_rotnangle = 90;
-	rotate_compound(new_c, x, y);
+	(void) rotate_compound(new_c, x, y);
     } else if (c == 'l') {
 	rotn_dirn = -1;
 	act_rotnangle = 90;
-	rotate_compound(new_c, x, y);
+	(void) rotate_compound(new_c, x, y);
     } else if (c == 'h') {
-	flip_compound(new_c, x, y, LR_FLIP);
+	(void) flip_compound(new_c, x, y, LR_FLIP);
     } else if (c == 'v') {
-	flip_compound(new_c, x, y, UD_FLIP);
+	(void) flip_compound(new_c, x, y, UD_FLIP);
     } else if (c == 's') {
 	scale_compound(new_c, 0.9, 0.9, x, y);
     } else if (c == 'S') {
@@ -199,9 +208,9 @@ change_draw_mode(int x, int y)
 {
     put_draw(ERASE);
     draw_box = !draw_box;
-    translate_compound(new_c,-new_c->nwcorner.x,-new_c->nwcorner.y);
+    (void) translate_compound(new_c,-new_c->nwcorner.x,-new_c->nwcorner.y);
     if (!draw_box)
-	translate_compound(new_c,cur_x,cur_y);
+	(void) translate_compound(new_c,cur_x,cur_y);
     
     put_draw(PAINT);
 }
@@ -219,7 +228,7 @@ place_lib_object_orig(int x, int y, unsigned int shift)
     /* move back to original position */
     dx = orig_put_x-x;
     dy = orig_put_y-y;
-    translate_compound(new_c,dx,dy);
+    (void) translate_compound(new_c,dx,dy);
     /* remove it from the depths because it will be added when it is put in the main list */
     remove_compound_depth(new_c);
     add_compound(new_c);
@@ -241,7 +250,7 @@ place_lib_object(int x, int y, unsigned int shift)
     put_draw(ERASE);
     clean_up();
     if (draw_box) 
-    	translate_compound(new_c,cur_x,cur_y);
+    	(void) translate_compound(new_c,cur_x,cur_y);
     /* remove it from the depths because it will be added when it is put in the main list */
     remove_compound_depth(new_c);
     add_compound(new_c);
@@ -279,7 +288,7 @@ move_object(int x, int y)
     if (!draw_box) {
 	dx=x-cur_x;
 	dy=y-cur_y;
-	translate_compound(new_c,dx,dy);
+	(void) translate_compound(new_c,dx,dy);
     }
     cur_x=x;cur_y=y;
     put_draw(PAINT);
@@ -293,7 +302,7 @@ init_move_object(int x, int y)
     cur_x=x;
     cur_y=y;
     if (!draw_box)    
-	translate_compound(new_c,x,y);
+	(void) translate_compound(new_c,x,y);
     
     put_draw(PAINT);
     canvas_locmove_proc = move_object;
@@ -310,6 +319,15 @@ cancel_place_lib_obj(int x, int y, int shift)
 	place_lib_object_orig(x, y, shift);
 	return;
     }
+    stop_place_lib_obj();
+    put_draw(ERASE);
+    /* remove it from the depths */
+    remove_compound_depth(new_c);
+}
+
+static void
+stop_place_lib_obj(void)
+{
     reset_action_on();
     canvas_leftbut_proc = null_proc;
     canvas_middlebut_proc = null_proc;
@@ -321,8 +339,5 @@ cancel_place_lib_obj(int x, int y, int shift)
     set_mousefun("","","", "", "", "");
     turn_off_current();
     set_cursor(arrow_cursor);
-    put_draw(ERASE);
-    /* remove it from the depths */
-    remove_compound_depth(new_c);
 }
 
@@ -32,6 +32,7 @@
 
 #include "d_text.h"
 #include "u_bound.h"
+#include "u_free.h"
 #include "u_markers.h"
 #include "u_redraw.h"
 #include "w_cursor.h"
@@ -67,7 +68,7 @@ void rotate_ellipse (F_ellipse *e, int x, int y);
 void rotate_arc (F_arc *a, int x, int y);
 void rotate_spline (F_spline *s, int x, int y);
 int valid_rot_angle (F_compound *c);
-void rotate_compound (F_compound *c, int x, int y);
+Boolean rotate_compound (F_compound *c, int x, int y);
 void rotate_point (F_point *p, int x, int y);
 void rotate_xy (int *orig_x, int *orig_y, int x, int y);
 
@@ -319,7 +320,12 @@ void init_rotatecompound(F_compound *c, int px, int py)
     }
     set_temp_cursor(wait_cursor);
     compound = copy_compound(c);
-    rotate_compound(compound, px, py);
+    if (compound == NULL || !rotate_compound(compound, px, py)) {
+	/* no memory for its own objects, leave the compound as it was */
+	free_compound(&compound);
+	reset_cursor();
+	return;
+    }
     if (copy) {
 	add_compound(compound);
     } else {
@@ -353,17 +359,19 @@ void rotate_line(F_line *l, int x, int y)
 
 }
 
-void rotate_figure(F_compound *f, int x, int y)
+Boolean rotate_figure(F_compound *f, int x, int y)
 {
   float old_rotn_dirn, old_act_rotnangle;
+  Boolean ok;
 
   old_rotn_dirn = rotn_dirn;
   old_act_rotnangle = act_rotnangle;
   rotn_dirn = -1;
   act_rotnangle = 90.0;
-  rotate_compound(f,x,y);
+  ok = rotate_compound(f,x,y);
   rotn_dirn = old_rotn_dirn;
   act_rotnangle = old_act_rotnangle;
+  return ok;
 }
 
 void rotate_spline(F_spline *s, int x, int y)
@@ -488,7 +496,12 @@ int valid_rot_angle(F_compound *c)
     return 1;
 }
 
-void rotate_compound(F_compound *c, int x, int y)
+/*
+ * Rotate compound c and everything in it.  Returns False, with the
+ * compound left as it was, if there isn't the memory to unshare it.
+ */
+
+Boolean rotate_compound(F_compound *c, int x, int y)
 {
     F_line	   *l;
     F_arc	   *a;
@@ -497,6 +510,10 @@ void rotate_compound(F_compound *c, int x, int y)
     F_text	   *t;
     F_compound	   *c1;
 
+    /* unshare it all before anything is rotated */
+    if (!unshare_compound_tree(c))
+	return False;
+    invalidate_compound_bound(c);
     for (l = c->lines; l != NULL; l = l->next)
 	rotate_line(l, x, y);
     for (a = c->arcs; a != NULL; a = a->next)
@@ -508,13 +525,14 @@ void rotate_compound(F_compound *c, int x, int y)
     for (t = c->texts; t != NULL; t = t->next)
 	rotate_text(t, x, y);
     for (c1 = c->compounds; c1 != NULL; c1 = c1->next)
-	rotate_compound(c1, x, y);
+	(void) rotate_compound(c1, x, y);	/* already unshared */
 
     /*
      * Make the bounding box exactly match the dimensions of the compound.
      */
     compound_bound(c, &c->nwcorner.x, &c->nwcorner.y,
 		   &c->secorner.x, &c->secorner.y);
+    return True;
 }
 
 void rotate_point(F_point *p, int x, int y)
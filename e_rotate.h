@@ -21,7 +21,7 @@ extern int	setcenter_y;
 extern int	rotn_dirn;
 extern float	act_rotnangle;
 
-extern int rotate_compound (F_compound *c, int x, int y);
+extern Boolean rotate_compound (F_compound *c, int x, int y);
 extern int rotate_line (F_line *l, int x, int y);
 extern void rotate_ccw_selected (void);
 extern void rotate_cw_selected (void);
@@ -38,6 +38,7 @@
 #include "f_util.h"
 #include "u_bound.h"
 #include "u_fonts.h"
+#include "u_free.h"
 #include "u_geom.h"
 #include "u_list.h"
 #include "u_markers.h"
@@ -685,6 +686,13 @@ fix_boxscale_compound(int x, int y)
     erase_lengths();
     adjust_box_pos(x, y, from_x, from_y, &x, &y);
     new_c = copy_compound(cur_c);
+    if (new_c == NULL || !unshare_compound_tree(new_c)) {
+	/* no memory for its own objects, leave the compound as it was */
+	free_compound(&new_c);
+	toggle_compoundmarker(cur_c);
+	wrapup_scale();
+	return;
+    }
     scalex = (double) (x - fix_x) / (from_x - fix_x);
     scaley = (double) (y - fix_y) / (from_y - fix_y);
     scale_compound(new_c, scalex, scaley, fix_x, fix_y);
@@ -731,6 +739,13 @@ fix_scale_compound(int x, int y)
     adjust_box_pos(x, y, from_x, from_y, &cur_x, &cur_y);
     /* make a copy of the original and save as unchanged object */
     old_c = copy_compound(cur_c);
+    if (!unshare_compound_tree(cur_c)) {
+	/* no memory for its own objects, leave the compound as it was */
+	free_compound(&old_c);
+	toggle_compoundmarker(cur_c);
+	wrapup_scale();
+	return;
+    }
     clean_up();
     set_latestcompound(old_c);
     set_action_object(F_EDIT, O_COMPOUND);
@@ -774,6 +789,9 @@ scale_compound(F_compound *c, double sx, double sy, int refx, int refy)
     /* if sx and sy == 1.0, return now */
     if (sx == 0.0 && sy == 0.0)
 	return;
+    if (!unshare_compound(c))
+	return;
+    invalidate_compound_bound(c);
 
     /* check if really a dimension line */
     if (rescale_dimension_line(c, sx, sy, refx, refy))
@@ -833,6 +851,9 @@ rescale_dimension_line(F_compound *dimline, float scalex, float scaley, int refx
     if (!dimline_components(dimline, &line, &tick1, &tick2, &box))
 	/* not a dimension line, return */
 	return False;
+    if (!unshare_compound(dimline))
+	return True;	/* can't change it, leave it as it is */
+    invalidate_compound_bound(dimline);
 	
     /* see if user has deleted main line */
     if (!line)
@@ -1006,6 +1027,8 @@ rescale_dimension_line(F_compound *dimline, float scalex, float scaley, int refx
     dimline->nwcorner.y = y1;
     dimline->secorner.x = x2;
     dimline->secorner.y = y2;
+    /* these leave out the line widths, so they aren't the bounds */
+    invalidate_compound_bound(dimline);
     
     return True;
 }
@@ -647,6 +647,9 @@ void update_compound(F_compound *compound)
     F_line	   *dline, *dtick1, *dtick2, *dbox;
     F_text	   *dtext;
 
+    if (!unshare_compound(compound))
+	return;
+    invalidate_compound_bound(compound);
     /* if this is a dimension line, update its settings from the dimline settings */
     if (dimline_components(compound, &dline, &dtick1, &dtick2, &dbox)) {
 	if (dline) {
@@ -20,6 +20,7 @@
 #include "resources.h"
 #include "mode.h"
 #include "object.h"
+#include "f_picobj.h"
 #include "f_read.h"
 #include "f_util.h"
 #include "u_create.h"
@@ -39,7 +40,9 @@
 #include "u_bound.h"
 #include "u_draw.h"
 #include "u_list.h"
+#include "u_pool.h"
 #include "u_redraw.h"
+#include "u_rtree.h"
 #include "w_cursor.h"
 #include "w_grid.h"
 
@@ -76,6 +79,8 @@ load_file(char *file, int xoff, int yoff)
     c.texts = NULL;
     c.comments = NULL;
     c.next = NULL;
+    c.shared = NULL;
+    c.bound_key = 0;
     set_temp_cursor(wait_cursor);
 
     /* initialize the active_layers array */
@@ -85,7 +90,10 @@ load_file(char *file, int xoff, int yoff)
     /* object counters for depths */
     clearallcounts();
 
+    /* the pictures are read after the figure is drawn */
+    defer_picture_reads = True;
     s = read_figc(file, &c, DONT_MERGE, REMAP_IMAGES, xoff, yoff, &settings);
+    defer_picture_reads = False;
     defer_update_layers = 1;	/* so update_layers() won't update for each object */
     add_compound_depth(&c);	/* count objects at each depth */
     defer_update_layers = 0;
@@ -99,6 +107,7 @@ load_file(char *file, int xoff, int yoff)
 	close_all_compounds();
 	saved_objects = objects;
 	objects = c;
+	rtree_invalidate();
 
 	/* update the settings in appres.xxx from the settings struct returned from read_fig */
 	update_settings(&settings);
@@ -120,6 +129,7 @@ load_file(char *file, int xoff, int yoff)
 	clean_up();
 	saved_objects = objects;
 	objects = c;
+	rtree_invalidate();
 	redisplay_canvas();
 	put_msg("Current figure \"%s\" (new file)", file);
 	(void) strcpy(save_filename, cur_filename);
@@ -250,7 +260,9 @@ void merge_file(char *file, int xoff, int yoff)
     pic_obj_read = False;
 
     /* read merged file into compound */
+    defer_picture_reads = True;
     s = read_figc(file, c, MERGE, DONT_REMAP_IMAGES, xoff, yoff, &settings);
+    defer_picture_reads = False;
 
     if (s == 0) {			/* Successful read */
 	/* only if there are objects other than user colors */
@@ -263,7 +275,7 @@ void merge_file(char *file, int xoff, int yoff)
 		    /* save ptr to embedded compound */
 		    c2 = c->compounds;
 		    /* free the toplevel */
-		    free((char *) c);
+		    pool_free(&compound_pool, c);
 	            c = c2;
 	    }
 	    compound_bound(c, &c->nwcorner.x, &c->nwcorner.y,
@@ -26,7 +26,9 @@
 #include "f_picobj.h"
 #include "f_util.h"
 #include "u_create.h"
+#include "u_draw.h"
 #include "u_elastic.h"
+#include "u_redraw.h"
 #include "w_canvas.h"
 #include "w_msgpanel.h"
 #include "w_setup.h"
@@ -64,7 +66,9 @@ static	 struct hdr {
 			{"PCX", "\012\005\001",	    3, read_pcx,	True},
 			{"EPS", "%!",		    2, read_epsf,	True},
 			{"PDF", "%PDF",		    2, read_pdf,	True},
+			{"PPM", "P2",		    2, read_ppm,	True},
 			{"PPM", "P3",		    2, read_ppm,	True},
+			{"PPM", "P5",		    2, read_ppm,	True},
 			{"PPM", "P6",		    2, read_ppm,	True},
 			{"TIFF", "II*\000",	    4, read_tif,	False},
 			{"TIFF", "MM\000*",	    4, read_tif,	False},
@@ -81,6 +85,40 @@ static	 struct hdr {
 
 #define NUMHEADERS sizeof(headers)/sizeof(headers[0])
 
+/*
+ * The repository is the list "pictures", with a hash table on the file
+ * name to find an entry.  The decoded bitmaps count against
+ * appres.picture_memory.  When they hold more than that, the bitmaps of the
+ * pictures least recently drawn, and not drawn in the last redisplay of the
+ * whole canvas, are freed.  Such a picture keeps its size and colormap, and
+ * its file is read again when the pixmap must be made at a new size.
+ */
+
+#define		PIC_HASHSIZE		256	/* entries in hash table (power of 2) */
+#define		DEF_PICTURE_MEMORY	65536	/* Kbytes, if appres.picture_memory isn't set */
+
+static struct _pics *pic_hash[PIC_HASHSIZE];
+static struct _pics *pic_tail = NULL;		/* last entry in "pictures" */
+static long	     pic_bytes = 0;		/* memory held by all bitmaps */
+static unsigned long pic_pass = 1;		/* redisplay pass being drawn */
+static unsigned long pic_shown = 0;		/* last pass of the whole canvas */
+
+static struct _pics *add_picture_entry(char *file, unsigned h);
+static void	reset_pic(F_pic *pic, int color);
+static void	read_picfile(F_pic *pic);
+static void	count_bitmap(struct _pics *pics);
+static void	trim_pictures(struct _pics *keep);
+
+static unsigned
+hash_file(char *file)
+{
+    unsigned	    h = 0;
+
+    while (*file)
+	h = h * 31 + (unsigned char) *file++;
+    return h & (PIC_HASHSIZE - 1);
+}
+
 /*
  * Check through the pictures repository to see if "file" is already there.
  * If so, set the pic->pic_cache pointer to that repository entry and set
@@ -90,26 +128,14 @@ static	 struct hdr {
  * If "force" is true, read the file unconditionally.
  */
 
-
-
 void read_picobj(F_pic *pic, char *file, int color, Boolean force, Boolean *existing)
 {
-    FILE	   *fd;
-    int		    type;
-    int		    i,j,c;
-    char	    buf[20],realname[PATH_MAX];
-    Boolean	    found, reread;
-    struct _pics   *pics, *lastpic;
+    unsigned	    h;
+    Boolean	    reread;
+    struct _pics   *pics;
     time_t	    mtime;
 
-    pic->color = color;
-    /* don't touch the flipped flag - caller has already set it */
-    pic->pixmap = (Pixmap) NULL;
-    pic->hw_ratio = 0.0;
-    pic->pix_rotation = 0;
-    pic->pix_width = 0;
-    pic->pix_height = 0;
-    pic->pix_flipped = 0;
+    reset_pic(pic, color);
 
     /* check if user pressed cancel button */
     if (check_cancel())
@@ -119,30 +145,32 @@ void read_picobj(F_pic *pic, char *file, int color, Boolean force, Boolean *exis
     app_flush();
 
     /* look in the repository for this filename */
-    lastpic = pictures;
     reread = False;
-    for (pics = pictures; pics; pics = pics->next) {
-	if (strcmp(pics->file, file)==0) {
-	    /* found it - make sure the timestamp is >= the timestamp of the file  */
-	    /* check both the "realname" and the original name */
-	    if ((mtime = file_timestamp(pics->realname) < 0))
-		mtime = file_timestamp(pics->file);
-	    if (mtime < 0) {
-		/* oops, doesn't exist? */
-		file_msg("Error %s on %s",strerror(errno),file);
-		return;
-	    }
-	    /* or if force is true then reread it */
-	    if (force || (mtime > pics->time_stamp)) {
-		reread = True;
-		break;			/* no, re-read the file */
-	    }
+    h = hash_file(file);
+    for (pics = pic_hash[h]; pics; pics = pics->hnext)
+	if (strcmp(pics->file, file)==0)
+	    break;
+    if (pics) {
+	/* found it - make sure the timestamp is >= the timestamp of the file  */
+	/* check both the "realname" and the original name */
+	if ((mtime = file_timestamp(pics->realname) < 0))
+	    mtime = file_timestamp(pics->file);
+	if (mtime < 0) {
+	    /* oops, doesn't exist? */
+	    file_msg("Error %s on %s",strerror(errno),file);
+	    return;
+	}
+	/* or if force is true then reread it */
+	if (force || (mtime > pics->time_stamp)) {
+	    reread = True;		/* no, re-read the file */
+	} else {
 	    pic->pic_cache = pics;
 	    pics->refcount++;
 	    if (appres.DEBUG)
 		fprintf(stderr,"Found stored picture %s, count=%d\n",file,pics->refcount);
-	    /* if there is a bitmap, return, otherwise fall through and reread the file */
-	    if (pics->bitmap != NULL) {
+	    /* if there is a bitmap (or it was only let go to save memory), return,
+	       otherwise fall through and reread the file */
+	    if (pics->bitmap != NULL || pics->dropped) {
 		*existing = True;
 		put_msg("Reading Picture object file...found cached picture");
 		/* must set the h/w ratio here */
@@ -152,8 +180,6 @@ void read_picobj(F_pic *pic, char *file, int color, Boolean force, Boolean *exis
 	    if (appres.DEBUG)
 		fprintf(stderr,"Re-reading file\n");
 	}
-	/* keep pointer to last entry */
-	lastpic = pics;
     }
     *existing = False;
     if (reread) {
@@ -161,31 +187,310 @@ void read_picobj(F_pic *pic, char *file, int color, Boolean force, Boolean *exis
 	    fprintf(stderr,"Timestamp changed, reread file %s\n",file);
     } else if (pics == NULL) {
 	/* didn't find it in the repository, add it */
-	pics = create_picture_entry();
-	if (lastpic) {
-	    /* add to list */
-	    lastpic->next = pics;
-	    pics->prev = lastpic;
-	} else {
-	    /* first one */
-	    pictures = pics;
-	}
-	pics->file = strdup(file);
-	pics->refcount = 1;
-	pics->bitmap = (unsigned char *) NULL;
-	pics->subtype = T_PIC_NONE;
-	pics->numcols = 0;
-	pics->size_x = 0;
-	pics->size_y = 0;
-	pics->bit_size.x = 0;
-	pics->bit_size.y = 0;
-	if (appres.DEBUG)
-	    fprintf(stderr,"New picture %s\n",file);
+	pics = add_picture_entry(file, h);
     }
     /* put it in the pic */
     pic->pic_cache = pics;
     pic->pixmap = (Pixmap) NULL;
 
+    read_picfile(pic);
+    pics->pending = False;
+    /* make room for it */
+    trim_pictures(pics);
+}
+
+/* add a new entry for "file" (with hash value h) to the repository */
+
+static struct _pics *
+add_picture_entry(char *file, unsigned h)
+{
+    struct _pics   *pics;
+
+    pics = create_picture_entry();
+    if (pic_tail) {
+	/* add to list */
+	pic_tail->next = pics;
+	pics->prev = pic_tail;
+    } else {
+	/* first one */
+	pictures = pics;
+    }
+    pic_tail = pics;
+    pics->hnext = pic_hash[h];
+    pic_hash[h] = pics;
+    pics->file = strdup(file);
+    pics->refcount = 1;
+    pics->bitmap = (unsigned char *) NULL;
+    pics->subtype = T_PIC_NONE;
+    pics->numcols = 0;
+    pics->size_x = 0;
+    pics->size_y = 0;
+    pics->bit_size.x = 0;
+    pics->bit_size.y = 0;
+    if (appres.DEBUG)
+	fprintf(stderr,"New picture %s\n",file);
+    return pics;
+}
+
+static void
+reset_pic(F_pic *pic, int color)
+{
+    pic->color = color;
+    /* don't touch the flipped flag - caller has already set it */
+    pic->pixmap = (Pixmap) NULL;
+    pic->hw_ratio = 0.0;
+    pic->pix_rotation = 0;
+    pic->pix_width = 0;
+    pic->pix_height = 0;
+    pic->pix_flipped = 0;
+}
+
+/*
+ * The pictures of a figure being loaded are read in the background, by an
+ * Xt work procedure that reads one file each time the event queue is empty,
+ * so the figure can be seen and used while they come in.  Until a picture
+ * is read it is "pending" and draw_pic_pixmap() draws a shaded box in its
+ * place.  Each picture is drawn as soon as it is read, a picture with a
+ * colormap in the nearest of the colorcells the others already use.  Once
+ * the last file is in, the colors of all of them are remapped at once, as
+ * after reading them in the foreground, if any had to make do that way.
+ * The readers call picture_progress() for each row, so the windows are
+ * redrawn when exposed even while a big file is being read.
+ */
+
+Boolean		defer_picture_reads = False;	/* read_picture() queues the files */
+
+typedef struct pic_job {
+    F_line	   *line;			/* picture object waiting */
+    struct pic_job *next;
+} pic_job;
+
+static pic_job	   *pic_jobs = NULL, *last_pic_job = NULL;
+static XtWorkProcId pic_work_id = (XtWorkProcId) 0;
+static struct _pics *pic_reading = NULL;	/* being read in the background */
+static Boolean	    pic_stood_in = False;	/* another was drawn as a box meanwhile */
+static Boolean	    pic_recolor = False;	/* colors only approximated so far */
+
+static Boolean	read_pictures(XtPointer client_data);
+static void	color_picture(struct _pics *pics);
+static void	color_pictures(void);
+
+/*
+ * Like read_picobj(), but a file not yet in the repository is read later.
+ */
+
+void
+read_picobj_later(F_line *line, char *file, int color)
+{
+    F_pic	   *pic = line->pic;
+    struct _pics   *pics;
+    pic_job	   *job;
+    Boolean	    dum;
+    unsigned	    h;
+
+    h = hash_file(file);
+    for (pics = pic_hash[h]; pics; pics = pics->hnext)
+	if (strcmp(pics->file, file)==0)
+	    break;
+    /* pictures already read are shared at once */
+    if ((pics && !pics->pending) ||
+	(job = (pic_job *) malloc(sizeof(pic_job))) == NULL) {
+	read_picobj(pic, file, color, False, &dum);
+	return;
+    }
+    reset_pic(pic, color);
+    if (pics == NULL) {
+	pics = add_picture_entry(file, h);
+	pics->pending = True;
+    } else {
+	pics->refcount++;
+    }
+    pic->pic_cache = pics;
+
+    job->line = line;
+    job->next = (pic_job *) NULL;
+    if (last_pic_job)
+	last_pic_job->next = job;
+    else
+	pic_jobs = job;
+    last_pic_job = job;
+    if (pic_work_id == 0)
+	pic_work_id = XtAppAddWorkProc(tool_app, read_pictures, (XtPointer) NULL);
+}
+
+/*
+ * Work procedure: read the picture the first object in the queue waits for
+ * and draw the objects that wait for it.  Return True when the queue is empty.
+ */
+
+static Boolean
+read_pictures(XtPointer client_data)
+{
+    pic_job	   *job, *prev;
+    struct _pics   *pics;
+
+    if (pic_jobs == NULL) {
+	pic_work_id = 0;
+	color_pictures();
+	return True;
+    }
+    pics = pic_jobs->line->pic->pic_cache;
+    if (pics->pending) {
+	if (pics->bitmap == NULL && !pics->dropped) {
+	    pic_reading = pics;
+	    read_picfile(pic_jobs->line->pic);
+	    pic_reading = NULL;
+	}
+	pics->pending = False;
+	trim_pictures(pics);
+	if ((pics->bitmap != NULL || pics->dropped) && pics->numcols > 0)
+	    color_picture(pics);
+	/* pictures exposed during the read were only drawn as boxes */
+	if (pic_stood_in) {
+	    pic_stood_in = False;
+	    redisplay_canvas();
+	}
+    }
+
+    /* take the objects using this picture out of the queue */
+    prev = (pic_job *) NULL;
+    for (job = pic_jobs; job; ) {
+	if (job->line->pic->pic_cache != pics) {
+	    prev = job;
+	    job = job->next;
+	    continue;
+	}
+	if (job->line->pic->hw_ratio == 0.0 && pics->bit_size.x != 0)
+	    job->line->pic->hw_ratio = (float) pics->bit_size.y/pics->bit_size.x;
+	redisplay_line(job->line);
+	if (prev)
+	    prev->next = job->next;
+	else
+	    pic_jobs = job->next;
+	free(job);
+	job = prev? prev->next: pic_jobs;
+    }
+    last_pic_job = prev;
+
+    if (pic_jobs != NULL)
+	return False;
+    pic_work_id = 0;
+    color_pictures();
+    return True;
+}
+
+/*
+ * A picture with colors was read: give it the nearest of the colorcells in
+ * use, or, if it is the first, colorcells of its own.
+ */
+
+static void
+color_picture(struct _pics *pics)
+{
+    Boolean	    exact;
+
+    if (map_picture_colors(pics, &exact)) {
+	if (!exact)
+	    pic_recolor = True;
+	return;
+    }
+    remap_imagecolors();
+}
+
+/* the last picture is in, remap the colors if some were approximated */
+
+static void
+color_pictures(void)
+{
+    if (pic_recolor) {
+	pic_recolor = False;
+	remap_imagecolors();
+	redraw_images(&objects);
+    }
+}
+
+/*
+ * Called by the readers for each row.  While a picture is read in the
+ * background, the exposed parts of the windows are redrawn meanwhile.  No
+ * other events are served, as the reader can't be entered again.
+ */
+
+void
+picture_progress(void)
+{
+    static int	    rows = 0;
+    XEvent	    event;
+
+    if (pic_reading == NULL || ++rows % 16 != 0)
+	return;
+    while (XCheckMaskEvent(tool_d, ExposureMask, &event))
+	XtDispatchEvent(&event);
+}
+
+/*
+ * Whether a picture has to be drawn as a placeholder: it is still to be
+ * read, or its bitmap is gone while another picture is being read, as the
+ * readers can't be entered again.
+ */
+
+Boolean
+picture_waiting(struct _pics *pics)
+{
+    if (pics->pending)
+	return True;
+    if (pic_reading == NULL || pics->bitmap != NULL)
+	return False;
+    pic_stood_in = True;
+    return True;
+}
+
+/* take a picture object that is being freed out of the queue */
+
+void
+cancel_picobj(F_line *line)
+{
+    pic_job	   *job, *prev;
+
+    prev = (pic_job *) NULL;
+    for (job = pic_jobs; job; prev = job, job = job->next)
+	if (job->line == line)
+	    break;
+    if (job == NULL)
+	return;
+    if (prev)
+	prev->next = job->next;
+    else
+	pic_jobs = job->next;
+    if (last_pic_job == job)
+	last_pic_job = prev;
+    free(job);
+}
+
+/*
+ * Read the file of the repository entry of "pic" into its bitmap.
+ */
+
+static void
+read_picfile(F_pic *pic)
+{
+    FILE	   *fd;
+    int		    type;
+    int		    i,j,c;
+    char	    buf[20],realname[PATH_MAX];
+    char	   *file;
+    Boolean	    found;
+    struct _pics   *pics;
+
+    pics = pic->pic_cache;
+    file = pics->file;
+
+    /* any old bitmap is replaced */
+    if (pics->bitmap) {
+	free(pics->bitmap);
+	pics->bitmap = NULL;
+    }
+    count_bitmap(pics);
+
     /* open the file and read a few bytes of the header to see what it is */
     if ((fd=open_picfile(file, &type, PIPEOK, realname)) == NULL) {
 	file_msg("No such picture file: %s",file);
@@ -194,6 +499,8 @@ void read_picobj(F_pic *pic, char *file, int color, Boolean force, Boolean *exis
     /* get the modified time and save it */
     pics->time_stamp = file_timestamp(file);
     /* and save the realname (it may be compressed) */
+    if (pics->realname)
+	free(pics->realname);
     pics->realname = strdup(realname);
 
     /* read some bytes from the file */
@@ -228,6 +535,7 @@ void read_picobj(F_pic *pic, char *file, int color, Boolean force, Boolean *exis
 		file_msg("%s: Bad %s format",file, headers[i].type);
 	    }
 	}
+	count_bitmap(pics);
 	put_msg("Reading Picture object file...Done");
 	return;
     }
@@ -238,6 +546,156 @@ void read_picobj(F_pic *pic, char *file, int color, Boolean force, Boolean *exis
     app_flush();
 }
 
+/*
+ * Read the bitmap of a picture again if it was freed to save memory.
+ * The X colors already given to the image are kept.
+ * Return True if the picture has a bitmap.
+ */
+
+Boolean
+load_picture_bitmap(F_pic *pic)
+{
+    struct _pics   *pics = pic->pic_cache;
+    struct Cmap	    cmap[MAX_COLORMAP_SIZE];
+    float	    hw_ratio;
+    int		    i, numcols;
+
+    if (pics->bitmap != NULL)
+	return True;
+    if (!pics->dropped)
+	return False;
+    if (appres.DEBUG)
+	fprintf(stderr,"Reload bitmap of picture %s\n",pics->file);
+
+    /* the readers forget the pixmap, which is being remade anyway */
+    if (pic->pixmap != 0)
+	XFreePixmap(tool_d, pic->pixmap);
+    pic->pixmap = (Pixmap) 0;
+    if (pic->mask != 0)
+	XFreePixmap(tool_d, pic->mask);
+    pic->mask = (Pixmap) 0;
+
+    numcols = pics->numcols;
+    for (i=0; i<numcols; i++)
+	cmap[i] = pics->cmap[i];
+    hw_ratio = pic->hw_ratio;
+    read_picfile(pic);
+    pic->hw_ratio = hw_ratio;
+    if (pics->numcols == numcols)
+	for (i=0; i<numcols; i++)
+	    pics->cmap[i].pixel = cmap[i].pixel;
+
+    trim_pictures(pics);
+    return pics->bitmap != NULL;
+}
+
+/* note the memory held by the bitmap of "pics" */
+
+static void
+count_bitmap(struct _pics *pics)
+{
+    pic_bytes -= pics->bytes;
+    pics->bytes = 0;
+    pics->dropped = False;
+    if (pics->bitmap != NULL) {
+	if (pics->numcols > 0)
+	    pics->bytes = (long) pics->bit_size.x * pics->bit_size.y;
+	else
+	    pics->bytes = (long) (pics->bit_size.x + 7) / 8 * pics->bit_size.y;
+    }
+    pic_bytes += pics->bytes;
+}
+
+/* free the bitmap of a picture; it is read again when needed */
+
+void
+drop_picture_bitmap(struct _pics *pics)
+{
+    if (pics->bitmap == NULL)
+	return;
+    if (appres.DEBUG)
+	fprintf(stderr,"Free bitmap of picture %s, %ld bytes\n",pics->file,pics->bytes);
+    free(pics->bitmap);
+    pics->bitmap = NULL;
+    count_bitmap(pics);
+    pics->dropped = True;
+}
+
+/*
+ * Free the bitmaps of the pictures least recently drawn until the rest fit
+ * in the budget.  Pictures drawn since the whole canvas was last drawn are
+ * on the screen and are kept, and so is "keep".
+ */
+
+static void
+trim_pictures(struct _pics *keep)
+{
+    struct _pics   *pics, *oldest;
+    long	    budget;
+
+    budget = (appres.picture_memory > 0? appres.picture_memory: DEF_PICTURE_MEMORY) * 1024L;
+    while (pic_bytes > budget) {
+	oldest = (struct _pics *) NULL;
+	for (pics = pictures; pics; pics = pics->next) {
+	    /* the picture being read, if any, is pending */
+	    if (pics == keep || pics->bitmap == NULL || pics->pending)
+		continue;
+	    if (pics->drawn != 0 && pics->drawn >= pic_shown)
+		continue;
+	    if (oldest == NULL || pics->drawn < oldest->drawn)
+		oldest = pics;
+	}
+	if (oldest == NULL)
+	    break;
+	drop_picture_bitmap(oldest);
+    }
+}
+
+/* a picture was drawn on the canvas */
+
+void
+touch_picture(struct _pics *pics)
+{
+    pics->drawn = pic_pass;
+}
+
+/*
+ * The whole canvas has been drawn, so the pictures not drawn in this
+ * pass are off the screen.
+ */
+
+void
+pictures_shown(void)
+{
+    pic_shown = pic_pass++;
+    trim_pictures((struct _pics *) NULL);
+}
+
+/* take a picture out of the repository */
+
+void
+remove_picture_entry(struct _pics *pics)
+{
+    struct _pics  **hp;
+
+    for (hp = &pic_hash[hash_file(pics->file)]; *hp; hp = &(*hp)->hnext)
+	if (*hp == pics) {
+	    *hp = pics->hnext;
+	    break;
+	}
+    if (pics->next)
+	pics->next->prev = pics->prev;
+    else
+	pic_tail = pics->prev;
+    if (pics->prev)
+	pics->prev->next = pics->next;
+    else
+	pictures = pics->next;
+    pics->prev = pics->next = pics->hnext = (struct _pics *) NULL;
+    pic_bytes -= pics->bytes;
+    pics->bytes = 0;
+}
+
 /* 
    Open the file 'name' and return its type (pipe or real file) in 'type'.
    Return the full name in 'retname'.  This will have a .gz or .Z if the file is
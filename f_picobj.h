@@ -22,3 +22,14 @@ extern void		 close_picfile(FILE *file, int type);
 #define PIPEOK		True
 #define PIPE_NOTOK	False
 extern void read_picobj (F_pic *pic, char *file, int color, Boolean force, Boolean *existing);
+extern Boolean load_picture_bitmap (F_pic *pic);
+extern void drop_picture_bitmap (struct _pics *pics);
+extern void touch_picture (struct _pics *pics);
+extern void pictures_shown (void);
+extern void remove_picture_entry (struct _pics *pics);
+extern void read_picobj_later (F_line *line, char *file, int color);
+extern void cancel_picobj (F_line *line);
+extern void picture_progress (void);
+extern Boolean picture_waiting (struct _pics *pics);
+
+extern Boolean	defer_picture_reads;
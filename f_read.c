@@ -17,6 +17,7 @@
 
 #include "fig.h"
 #include "figx.h"
+#include <stdarg.h>
 #include "resources.h"
 #include "object.h"
 #include "mode.h"
@@ -42,16 +43,21 @@
 #include "f_util.h"
 #include "u_bound.h"
 #include "u_free.h"
+#include "u_pool.h"
 #include "u_scale.h"
 #include "u_translate.h"
 #include "w_util.h"
 #include "w_layers.h"
+#include "w_softdraw.h"
+#ifdef USE_THREADS
+#include <pthread.h>
+#endif
 
 /* EXPORTS */
 
 int		 defer_update_layers = 0; /* if != 0, update_layers() doesn't update */
-int		 line_no, save_line;	/* current input line number */
-int		 num_object;		/* current number of objects */
+READER_LOCAL int line_no, save_line;	/* current input line number */
+READER_LOCAL int num_object;		/* current number of objects */
 char		*read_file_name;	/* current input file name */
 
 /* LOCAL */
@@ -65,8 +71,20 @@ static F_text     *read_textobject(FILE *fp);
 static F_spline   *read_splineobject(FILE *fp);
 static F_arc      *read_arcobject(FILE *fp);
 static F_compound *read_compoundobject(FILE *fp);
+static int	   read_object_list(FILE *fp, F_compound *obj, char *stop);
 static char	  *attach_comments(void);
-static void	   count_lines_correctly(FILE *fp);
+static void	   read_msg(char *format, ...);
+static void	   text_fonts(F_text *t);
+static void	   read_picture(F_line *l, char *picfile);
+static void	   bound_compound(F_compound *com);
+static int	   load_input(FILE *fp);
+static void	   free_input(void);
+static Boolean	   next_line(void);
+static void	   line_to_buf(void);
+static int	   line_rest(char *s, int size);
+static int	   scan_line(const char *fmt, ...);
+static Boolean	   next_int(int *val);
+static Boolean	   next_double(double *val);
 static int	   read_return(int status);
 static Boolean	   contains_picture(F_compound *compound);
 
@@ -82,15 +100,80 @@ static Boolean	   contains_picture(F_compound *compound);
 /* input buffer length */
 #define	BUF_SIZE	1024
 
-char		 buf[BUF_SIZE];		/* input buffer */
-char		*comments[MAXCOMMENTS];	/* comments saved for current object */
-int		 numcom;		/* current comment index */
+READER_LOCAL char buf[BUF_SIZE];	/* input buffer */
+READER_LOCAL char *comments[MAXCOMMENTS]; /* comments saved for current object */
+READER_LOCAL int numcom;		/* current comment index */
 Boolean		 com_alloc = False;	/* whether or not the comment array has been init. */
 int		 TFX;			/* true for 1.4TFX protocol */
 int		 proto;			/* file protocol*10 */
 float	         fproto, xfigproto;	/* floating values for protocol of figure
 					   file and current protocol */
 
+/*
+ * The input file (after the "#FIG" line) is read into memory in one go and
+ * parsed in place.  in_pos is where fgets()/fscanf() on the file would
+ * continue; read_line() makes the next line the current one (in_line up to
+ * in_eol, which includes the newline) and scan_line() parses numbers from
+ * it at in_cur, like sscanf() on buf used to.  The buffer has a NUL after
+ * the last character, which stops skip_blanks() at the end.
+ */
+
+static char	*in_buf = NULL;		/* file contents */
+static char	*in_end;		/* end of the contents (the NUL) */
+static READER_LOCAL char *in_pos;	/* next unread character */
+static READER_LOCAL char *in_line, *in_eol; /* current line */
+static READER_LOCAL char *in_cur;	/* next unscanned character of current line */
+
+/* exact powers of ten for converting decimal fractions */
+static double	 pow_ten[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+			       1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+
+#define	at_end()	(in_pos >= in_end)
+#define	is_digit(c)	((unsigned) ((c) - '0') < 10)
+
+#ifdef USE_THREADS
+/*
+ * Files of at least PARALLEL_READ_SIZE bytes are split into chunks at
+ * top-level objects and the chunks are read by up to MAX_READ_THREADS
+ * threads.  Anything a thread may not do itself (messages, fonts, pictures
+ * and compound bounds, which need the fonts) is kept as a list of fixups
+ * that is done in file order when the chunk is taken.
+ */
+
+#define	PARALLEL_READ_SIZE	(4*1024*1024)
+#define	MIN_READ_CHUNK		(1024*1024)
+#define	MAX_READ_THREADS	8
+
+#define	FIX_MSG		0
+#define	FIX_TEXT	1
+#define	FIX_PICTURE	2
+#define	FIX_BOUND	3
+
+typedef struct read_fixup {
+    int			 type;
+    void		*obj;		/* text, line or compound */
+    char		*str;		/* message or picture file name */
+    struct read_fixup	*next;
+} read_fixup;
+
+typedef struct {
+    char	   *start, *stop;	/* part of the input to read */
+    int		    line;		/* line_no at start */
+    char	   *end;		/* where the thread stopped */
+    int		    end_line;		/* and line_no there */
+    F_compound	    objs;		/* objects read */
+    int		    num_object;
+    read_fixup	   *fixups, *last_fixup;
+    Boolean	    ran;		/* the thread did run */
+    Boolean	    bad_format;		/* stopped at a line without object code */
+    Boolean	    incomplete;		/* stopped early, read from start serially */
+} read_chunk;
+
+static READER_LOCAL read_chunk *cur_chunk = NULL; /* NULL in the main thread */
+
+static int	   read_parallel(FILE *fp, F_compound *obj);
+#endif /* USE_THREADS */
+
 /* initialize the user color counter - then read figure file. 
    Called from load_file(), merge_file(), preview_figure(), load_lib_obj(),
    and paste(), but NOT from read_figure() (import Fig as picture) */
@@ -280,12 +363,17 @@ readfp_fig(FILE *fp, F_compound *obj, Boolean merge, int xoff, int yoff, fig_set
 	if (strstr(buf, "TFX") != NULL)
 	    TFX = True;
 
+	/* the rest is parsed from memory */
+	if ((status = load_input(fp)) != 0)
+	    return read_return(status);
+
 	if (proto >= 30) {
 	    /* read Portrait/Landscape indicator now */
 	    if (read_line(fp) < 0) {
 		file_msg("No Portrait/Landscape specification");
 		return read_return(BAD_FORMAT);		/* error */
 	    }
+	    line_to_buf();
 	    settings->landscape = (strncasecmp(buf,"landscape",9) == 0);
 
 	    /* read Centering indicator now */
@@ -293,6 +381,7 @@ readfp_fig(FILE *fp, F_compound *obj, Boolean merge, int xoff, int yoff, fig_set
 		file_msg("No Center/Flushleft specification");
 		return read_return(BAD_FORMAT);		/* error */
 	    }
+	    line_to_buf();
 	    if ((strncasecmp(buf,"center",6) == 0) || 
 		(strncasecmp(buf,"flush",5) == 0)) {
 		    /* use negative to ensure 1/0 (strcmp may return 3 or 4 for false) */
@@ -302,6 +391,7 @@ readfp_fig(FILE *fp, F_compound *obj, Boolean merge, int xoff, int yoff, fig_set
 			file_msg("No Metric/Inches specification");
 			return read_return(BAD_FORMAT);		/* error */
 		    }
+		    line_to_buf();
 	    }
 	    /* set metric/inches mode appropriately */
 	    settings->units = (strncasecmp(buf,"metric",5) != 0);
@@ -314,6 +404,7 @@ readfp_fig(FILE *fp, F_compound *obj, Boolean merge, int xoff, int yoff, fig_set
 		    file_msg("No Paper size specification");
 		    return read_return(BAD_FORMAT);		/* error */
 		}
+		line_to_buf();
 		/* parse the paper size */
 		settings->papersize = parse_papersize(buf);
 
@@ -322,6 +413,7 @@ readfp_fig(FILE *fp, F_compound *obj, Boolean merge, int xoff, int yoff, fig_set
 		    file_msg("No Magnification specification");
 		    return read_return(BAD_FORMAT);		/* error */
 		}
+		line_to_buf();
 		settings->magnification = atoi(buf);
 
 		/* read multiple page flag now */
@@ -329,6 +421,7 @@ readfp_fig(FILE *fp, F_compound *obj, Boolean merge, int xoff, int yoff, fig_set
 		    file_msg("No Multiple page flag specification");
 		    return read_return(BAD_FORMAT);		/* error */
 		}
+		line_to_buf();
 		if (strncasecmp(buf,"multiple",8) != 0 &&
 		    strncasecmp(buf,"single",6) != 0) {
 		    file_msg("No Multiple page flag specification");
@@ -341,6 +434,7 @@ readfp_fig(FILE *fp, F_compound *obj, Boolean merge, int xoff, int yoff, fig_set
 		    file_msg("No Transparent color specification");
 		    return read_return(BAD_FORMAT);		/* error */
 		}
+		line_to_buf();
 		settings->transparent = atoi(buf);
 	    }
 	}
@@ -391,7 +485,7 @@ readfp_fig(FILE *fp, F_compound *obj, Boolean merge, int xoff, int yoff, fig_set
 	read_scale_compound(obj, scale_factor, 0);
 
     /* shift the figure by the amount in the x and y offsets from the file panel */
-    translate_compound(obj, xoff, yoff);
+    (void) translate_compound(obj, xoff, yoff);	/* just read, nothing shared */
 
     /* get bounding box of whole figure */
     compound_bound(obj,&obj->nwcorner.x,&obj->nwcorner.y,&obj->secorner.x,&obj->secorner.y);
@@ -429,6 +523,7 @@ readfp_fig(FILE *fp, F_compound *obj, Boolean merge, int xoff, int yoff, fig_set
 static int
 read_return(int status)
 {
+    free_input();
     defer_update_layers = 0;
     if (!update_figs)
 	update_layers();
@@ -437,13 +532,7 @@ read_return(int status)
 
 int read_objects(FILE *fp, F_compound *obj, int *res)
 {
-    F_ellipse	   *e, *le = NULL;
-    F_line	   *l, *ll = NULL;
-    F_text	   *t, *lt = NULL;
-    F_spline	   *s, *ls = NULL;
-    F_arc	   *a, *la = NULL;
-    F_compound	   *c, *lc = NULL;
-    int		    object, ppi, coord_sys;
+    int		    ppi, coord_sys;
 
     if (read_line(fp) < 0) {
 	file_msg("No Resolution specification; figure is empty");
@@ -451,7 +540,7 @@ int read_objects(FILE *fp, F_compound *obj, int *res)
     }
 
     /* read the resolution (ppi) and the coordinate system used (upper-left or lower-left) */
-    if (sscanf(buf, "%d%d\n", &ppi, &coord_sys) != 2) {
+    if (scan_line("dd", &ppi, &coord_sys) != 2) {
 	file_msg("Figure resolution or coordinate specifier missing in line %d.", line_no);
 	return BAD_FORMAT;
     }
@@ -462,16 +551,65 @@ int read_objects(FILE *fp, F_compound *obj, int *res)
     /* save the resolution for caller */
     *res = ppi;
 
-    while (read_line(fp) > 0) {
-	if (sscanf(buf, "%d", &object) != 1) {
-	    file_msg("Incorrect format at line %d.", line_no);
+#ifdef USE_THREADS
+    if (in_end - in_pos >= PARALLEL_READ_SIZE)
+	return read_parallel(fp, obj);
+#endif
+    return read_object_list(fp, obj, in_end);
+}				/* read_objects */
+
+/*
+ * Read top-level objects into obj, appending to its lists, until the
+ * input position reaches stop (or the end of the input).
+ */
+
+static int
+read_object_list(FILE *fp, F_compound *obj, char *stop)
+{
+    F_ellipse	   *e, *le;
+    F_line	   *l, *ll;
+    F_text	   *t, *lt;
+    F_spline	   *s, *ls;
+    F_arc	   *a, *la;
+    F_compound	   *c, *lc;
+    int		    object;
+
+    /* find the ends of the lists */
+    for (le = obj->ellipses; le && le->next; le = le->next)
+	;
+    for (ll = obj->lines; ll && ll->next; ll = ll->next)
+	;
+    for (lt = obj->texts; lt && lt->next; lt = lt->next)
+	;
+    for (ls = obj->splines; ls && ls->next; ls = ls->next)
+	;
+    for (la = obj->arcs; la && la->next; la = la->next)
+	;
+    for (lc = obj->compounds; lc && lc->next; lc = lc->next)
+	;
+
+    while (in_pos < stop && read_line(fp) > 0) {
+	if (scan_line("d", &object) != 1) {
+	    read_msg("Incorrect format at line %d.", line_no);
+#ifdef USE_THREADS
+	    if (cur_chunk)
+		cur_chunk->bad_format = True;
+#endif
 	    return (num_object != 0? 0: BAD_FORMAT);	/* ok if any objects have been read */
 	}
 	switch (object) {
 	case O_COLOR_DEF:
+#ifdef USE_THREADS
+	    /* the other threads check colors against the definitions
+	       so far, leave this part of the file to the serial reader */
+	    if (cur_chunk) {
+		cur_chunk->incomplete = True;
+		return 0;
+	    }
+#endif
 	    read_colordef(fp);
 	    if (num_object) {
-		file_msg("Color definitions must come before other objects (line %d).",
+		read_msg("Color definitions must come before other objects (line %d).",
 			line_no);
 	    }
 	    break;
@@ -530,17 +668,345 @@ int read_objects(FILE *fp, F_compound *obj, int *res)
 	    num_object++;
 	    break;
 	default:
-	    file_msg("Incorrect object code at line %d.", line_no);
+	    read_msg("Incorrect object code at line %d.", line_no);
 	    continue;
 	} /* switch */
 	
     } /* while */
 
-    if (feof(fp))
+    if (in_pos >= stop)
 	return 0;
     else
 	return errno;
-}				/* read_objects */
+}
+
+#ifdef USE_THREADS
+
+static void
+add_fixup(int type, void *obj, char *str)
+{
+    read_fixup	   *f;
+
+    if ((f = (read_fixup *) malloc(sizeof(read_fixup))) == NULL)
+	return;
+    f->type = type;
+    f->obj = obj;
+    f->str = str? strdup(str): NULL;
+    f->next = NULL;
+    if (cur_chunk->last_fixup)
+	cur_chunk->last_fixup->next = f;
+    else
+	cur_chunk->fixups = f;
+    cur_chunk->last_fixup = f;
+}
+
+/* thread: read the top-level objects of one chunk */
+
+static void *
+read_chunk_proc(void *arg)
+{
+    read_chunk	   *ch = (read_chunk *) arg;
+    int		    i;
+
+    cur_chunk = ch;
+    in_pos = ch->start;
+    line_no = ch->line;
+    num_object = numcom = 0;
+    (void) read_object_list((FILE *) NULL, &ch->objs, ch->stop);
+    ch->end = in_pos;
+    ch->end_line = line_no;
+    ch->num_object = num_object;
+    /* comments left over belong to an object of the next chunk */
+    if (numcom > 0)
+	ch->incomplete = True;
+    for (i = 0; i < MAXCOMMENTS; i++)
+	if (comments[i])
+	    free(comments[i]);
+    return NULL;
+}
+
+/*
+ * Divide the rest of the input into at most n chunks of about equal size.
+ * A chunk starts at a line with a top-level object code in the first
+ * column, or at the comments and empty lines just before it.  Compound
+ * nesting is followed by the "6" and "-6" lines.  This can be fooled by
+ * points or text lines that look like objects, but read_parallel() only
+ * takes a chunk that starts where the previous one stopped.
+ */
+
+static int
+split_input(read_chunk *chunks, int n)
+{
+    char	   *p, *q, *block;
+    long	    size;
+    int		    i, depth, line, block_line;
+
+    size = (in_end - in_pos) / n;
+    chunks[0].start = in_pos;
+    chunks[0].line = line_no;
+    i = 1;
+    depth = 0;
+    line = line_no;
+    block = NULL;
+    block_line = 0;
+    for (p = in_pos; p < in_end && i < n; p = q + 1, line++) {
+	if (*p == '#' || *p == '\n' || *p == '\r') {
+	    if (block == NULL) {
+		block = p;
+		block_line = line;
+	    }
+	} else {
+	    if (depth == 0 && p - in_pos >= i * size &&
+		*p >= '1' && *p <= '6' && (p[1] == ' ' || p[1] == '\t')) {
+		    chunks[i].start = block? block: p;
+		    chunks[i].line = block? block_line: line;
+		    i++;
+	    }
+	    if (p[0] == '6' && isspace((unsigned char) p[1]))
+		depth++;
+	    else if (p[0] == '-' && p[1] == '6' && isspace((unsigned char) p[2]) && depth > 0)
+		depth--;
+	    block = NULL;
+	}
+	if ((q = (char *) memchr(p, '\n', in_end - p)) == NULL)
+	    break;
+    }
+    for (n = 0; n < i; n++)
+	chunks[n].stop = (n < i-1)? chunks[n+1].start: in_end;
+    return i;
+}
+
+static void
+free_fixups(read_fixup *f)
+{
+    read_fixup	   *next;
+
+    for ( ; f; f = next) {
+	next = f->next;
+	if (f->str)
+	    free(f->str);
+	free((char *) f);
+    }
+}
+
+/* append list b to list a, whose last element is last */
+
+#define append_list(a, b, last) \
+    if (b) { \
+	if (last) \
+	    last->next = b; \
+	else \
+	    a = b; \
+	for (last = b; last->next; last = last->next) \
+	    ; \
+    }
+
+/*
+ * Read the top-level objects with several threads.  The chunks are taken
+ * in file order as long as each starts where the previous one stopped, so
+ * it was read exactly as the serial reader would have read it.  The rest
+ * of the file (from a chunk that doesn't fit on) is read serially.
+ */
+
+static int
+read_parallel(FILE *fp, F_compound *obj)
+{
+    read_chunk	    chunks[MAX_READ_THREADS];
+    pthread_t	    threads[MAX_READ_THREADS];
+    read_fixup	   *f;
+    F_ellipse	   *le;
+    F_line	   *ll;
+    F_text	   *lt;
+    F_spline	   *ls;
+    F_arc	   *la;
+    F_compound	   *lc, *objs;
+    char	   *pos;
+    long	    ncpu;
+    int		    i, n, line;
+    Boolean	    done;
+
+    /* the color definitions come first and all threads need them */
+    while (in_pos[0] == '0' && isspace((unsigned char) in_pos[1]) &&
+	   read_line(fp) > 0)
+	    read_colordef(fp);
+
+    ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    n = min2((in_end - in_pos) / MIN_READ_CHUNK, MAX_READ_THREADS);
+    n = min2(n, ncpu);
+    if (n < 2)
+	return read_object_list(fp, obj, in_end);
+
+    bzero((char *) chunks, sizeof(chunks));
+    n = split_input(chunks, n);
+    for (i = 0; i < n; i++)
+	chunks[i].ran = (pthread_create(&threads[i], NULL,
+					read_chunk_proc, &chunks[i]) == 0);
+    for (i = 0; i < n; i++)
+	if (chunks[i].ran)
+	    pthread_join(threads[i], NULL);
+
+    for (le = obj->ellipses; le && le->next; le = le->next)
+	;
+    for (ll = obj->lines; ll && ll->next; ll = ll->next)
+	;
+    for (lt = obj->texts; lt && lt->next; lt = lt->next)
+	;
+    for (ls = obj->splines; ls && ls->next; ls = ls->next)
+	;
+    for (la = obj->arcs; la && la->next; la = la->next)
+	;
+    for (lc = obj->compounds; lc && lc->next; lc = lc->next)
+	;
+    pos = in_pos;
+    line = line_no;
+    done = False;
+    for (i = 0; i < n && !done; i++) {
+	if (!chunks[i].ran || chunks[i].incomplete ||
+	    chunks[i].start != pos || chunks[i].line != line)
+		break;
+	/* do what the thread left for us, in file order */
+	for (f = chunks[i].fixups; f; f = f->next) {
+	    switch (f->type) {
+	      case FIX_MSG:
+		file_msg("%s", f->str);
+		break;
+	      case FIX_TEXT:
+		text_fonts((F_text *) f->obj);
+		break;
+	      case FIX_PICTURE:
+		read_picture((F_line *) f->obj, f->str);
+		break;
+	      case FIX_BOUND:
+		bound_compound((F_compound *) f->obj);
+		break;
+	    }
+	}
+	objs = &chunks[i].objs;
+	append_list(obj->ellipses, objs->ellipses, le);
+	append_list(obj->lines, objs->lines, ll);
+	append_list(obj->texts, objs->texts, lt);
+	append_list(obj->splines, objs->splines, ls);
+	append_list(obj->arcs, objs->arcs, la);
+	append_list(obj->compounds, objs->compounds, lc);
+	num_object += chunks[i].num_object;
+	pos = chunks[i].end;
+	line = chunks[i].end_line;
+	/* the serial reader stops at a line without an object code */
+	done = chunks[i].bad_format;
+    }
+    /* throw away the chunks we can't use */
+    for (n--; n >= i; n--) {
+	objs = &chunks[n].objs;
+	free_arc(&objs->arcs);
+	free_compound(&objs->compounds);
+	free_ellipse(&objs->ellipses);
+	free_line(&objs->lines);
+	free_spline(&objs->splines);
+	free_text(&objs->texts);
+    }
+    for (i = 0; i < MAX_READ_THREADS; i++)
+	free_fixups(chunks[i].fixups);
+
+    in_pos = pos;
+    line_no = line;
+    if (done)
+	return (num_object != 0? 0: BAD_FORMAT);
+    return read_object_list(fp, obj, in_end);
+}
+#endif /* USE_THREADS */
+
+/* give a message, or keep it for later in a reader thread */
+
+static void
+read_msg(char *format, ...)
+{
+    va_list	    ap;
+    char	    msg[300];
+
+    va_start(ap, format);
+    vsprintf(msg, format, ap);
+    va_end(ap);
+#ifdef USE_THREADS
+    if (cur_chunk) {
+	add_fixup(FIX_MSG, NULL, msg);
+	return;
+    }
+#endif
+    file_msg("%s", msg);
+}
+
+/* get the font of a text and its size in Fig units (needs the display) */
+
+static void
+text_fonts(F_text *t)
+{
+    PR_SIZE	    tx_dim;
+
+    if (update_figs)
+	return;
+#ifdef USE_THREADS
+    if (cur_chunk) {
+	add_fixup(FIX_TEXT, t, NULL);
+	return;
+    }
+#endif
+    /* get the UNZOOMED font struct */
+    t->fontstruct = lookfont(x_fontnum(psfont_text(t), t->font), t->size);
+    /* now calculate the actual length and height of the string in fig units */
+    tx_dim = textsize(t->fontstruct, strlen(t->cstring), t->cstring);
+    t->length = round(tx_dim.length);
+    t->ascent = round(tx_dim.ascent);
+    t->descent = round(tx_dim.descent);
+    /* now get the zoomed font struct */
+    t->zoom = zoomscale;
+    if (display_zoomscale != 1.0)
+	t->fontstruct = lookfont(x_fontnum(psfont_text(t), t->font),
+			    round(t->size*display_zoomscale));
+}
+
+/* read the image file of a picture object */
+
+static void
+read_picture(F_line *l, char *picfile)
+{
+    Boolean	    dum;
+
+#ifdef USE_THREADS
+    if (cur_chunk) {
+	add_fixup(FIX_PICTURE, l, picfile);
+	return;
+    }
+#endif
+    if (!update_figs && !soft_drawing) {
+	/* only read in the image if update_figs is False and there is a display */
+	if (defer_picture_reads)
+	    read_picobj_later(l, picfile, l->pen_color);
+	else
+	    read_picobj(l->pic, picfile, l->pen_color, False, &dum);
+    } else {
+	/* otherwise just make a pseudo entry with the filename */
+	l->pic->pic_cache = create_picture_entry();
+	l->pic->pic_cache->file = strdup(picfile);
+    }
+    /* we've read in a pic object - merge_file uses this info to decide
+       whether or not to remap any picture colors in first figure */
+    pic_obj_read = True;
+}
+
+/* calculate the bounds of a compound read without them */
+
+static void
+bound_compound(F_compound *com)
+{
+#ifdef USE_THREADS
+    if (cur_chunk) {
+	add_fixup(FIX_BOUND, com, NULL);
+	return;
+    }
+#endif
+    compound_bound(com, &com->nwcorner.x, &com->nwcorner.y,
+			&com->secorner.x, &com->secorner.y);
+}
 
 int parse_papersize(char *size)
 {
@@ -573,6 +1039,7 @@ read_colordef(FILE *fp)
 {
     int		    c,r,g,b;
 
+    line_to_buf();
     if ((sscanf(buf, "%*d %d #%02x%02x%02x", &c, &r, &g, &b) != 4) ||
 		(c < NUM_STD_COLS) || (c >= MAX_USR_COLS+NUM_STD_COLS)) {
 	buf[strlen(buf)-1]='\0';	/* remove the newline */
@@ -605,7 +1072,7 @@ read_arcobject(FILE *fp)
     a->next = NULL;
     a->for_arrow = a->back_arrow = NULL;
     if (proto >= 30) {
-	n = sscanf(buf, "%*d%d%d%d%d%d%d%d%d%f%d%d%d%d%f%f%d%d%d%d%d%d\n",
+	n = scan_line("ddddddddfddddffdddddd",
 	       &a->type, &a->style, &a->thickness,
 	       &a->pen_color, &a->fill_color, &a->depth,
 	       &a->pen_style, &a->fill_style,
@@ -616,7 +1083,7 @@ read_arcobject(FILE *fp)
 	       &a->point[1].x, &a->point[1].y,
 	       &a->point[2].x, &a->point[2].y);
     } else {
-	n = sscanf(buf, "%*d%d%d%d%d%d%d%d%f%d%d%d%f%f%d%d%d%d%d%d\n",
+	n = scan_line("dddddddfdddffdddddd",
 	       &a->type, &a->style, &a->thickness,
 	       &a->pen_color, &a->depth,
 	       &a->pen_style, &a->fill_style,
@@ -630,8 +1097,8 @@ read_arcobject(FILE *fp)
     }
     a->type--;	/* internally, 0=open arc, 1=pie wedge */
     if (((proto < 22) && (n != 19)) || ((proto >= 30) && (n != 21))) {
-	file_msg(Err_incomp, "arc", save_line);
-	free((char *) a);
+	read_msg(Err_incomp, "arc", save_line);
+	pool_free(&arc_pool, a);
 	return NULL;
     }
     a->fill_style = FILL_CONVERT(a->fill_style);
@@ -646,8 +1113,8 @@ read_arcobject(FILE *fp)
     if (fa) {
 	if (read_line(fp) == -1)
 	    return a;
-	if (sscanf(buf, "%d%d%f%f%f", &type, &style, &thickness, &wd, &ht) != 5) {
-	    file_msg(Err_incomp, "arc", save_line);
+	if (scan_line("ddfff", &type, &style, &thickness, &wd, &ht) != 5) {
+	    read_msg(Err_incomp, "arc", save_line);
 	    return a;
 	}
 	/* throw away any arrow heads on pie-wedge arcs */
@@ -662,8 +1129,8 @@ read_arcobject(FILE *fp)
     if (ba) {
 	if (read_line(fp) == -1)
 	    return a;
-	if (sscanf(buf, "%d%d%f%f%f", &type, &style, &thickness, &wd, &ht) != 5) {
-	    file_msg(Err_incomp, "arc", save_line);
+	if (scan_line("ddfff", &type, &style, &thickness, &wd, &ht) != 5) {
+	    read_msg(Err_incomp, "arc", save_line);
 	    return a;
 	}
 	/* throw away any arrow heads on pie-wedge arcs */
@@ -701,21 +1168,21 @@ read_compoundobject(FILE *fp)
 
     save_line = line_no;
     /* read bounding info for compound */
-    n = sscanf(buf, "%*d%d%d%d%d\n", &com->nwcorner.x, &com->nwcorner.y,
+    n = scan_line("dddd", &com->nwcorner.x, &com->nwcorner.y,
 	       &com->secorner.x, &com->secorner.y);
     /* if compound spec has no bounds, set to 0 and calculate later */
     if (n <= 0) {
 	com->nwcorner.x =com->nwcorner.y = com->secorner.x = com->secorner.y = 0;
     } else if (n != 4) {
 	/* otherwise, if there aren't 4 numbers, complain */
-	file_msg(Err_incomp, "compound", save_line);
-	free((char *) com);
+	read_msg(Err_incomp, "compound", save_line);
+	pool_free(&compound_pool, com);
 	return NULL;
     }
     while (read_line(fp) > 0) {
-	if (sscanf(buf, "%d", &object) != 1) {
-	    file_msg(Err_incomp, "compound", save_line);
-	    free((char *) com);
+	if (scan_line("d", &object) != 1) {
+	    read_msg(Err_incomp, "compound", save_line);
+	    pool_free(&compound_pool, com);
 	    return NULL;
 	}
 	switch (object) {
@@ -771,18 +1238,16 @@ read_compoundobject(FILE *fp)
 	    /* if compound def had no bounds or all zeroes, calculate bounds now */
 	    if (com->nwcorner.x == 0 && com->nwcorner.x == 0 && 
 	        com->nwcorner.x == 0 && com->nwcorner.x == 0)
-		    compound_bound(com, &com->nwcorner.x, &com->nwcorner.y,
-					&com->secorner.x, &com->secorner.y);
+		    bound_compound(com);
 	    return com;
 	default:
-	    file_msg("Incorrect object code at line %d.", save_line);
+	    read_msg("Incorrect object code at line %d.", save_line);
 	    continue;
 	}			/* switch */
     } /* while (read_line(fp) > 0) */
 
-    if (feof(fp)) {
- 	compound_bound(com, &com->nwcorner.x, &com->nwcorner.y,
- 	           &com->secorner.x, &com->secorner.y);
+    if (at_end()) {
+	bound_compound(com);
 	return com;
     } else {
 	return NULL;
@@ -801,7 +1266,7 @@ read_ellipseobject(void)
     save_line = line_no;
     e->next = NULL;
     if (proto >= 30) {
-	n = sscanf(buf, "%*d%d%d%d%d%d%d%d%d%f%d%f%d%d%d%d%d%d%d%d\n",
+	n = scan_line("ddddddddfdfdddddddd",
 	       &e->type, &e->style, &e->thickness,
 	       &e->pen_color, &e->fill_color, &e->depth,
 	       &e->pen_style, &e->fill_style,
@@ -811,7 +1276,7 @@ read_ellipseobject(void)
 	       &e->start.x, &e->start.y,
 	       &e->end.x, &e->end.y);
     } else {
-	n = sscanf(buf, "%*d%d%d%d%d%d%d%d%f%d%f%d%d%d%d%d%d%d%d\n",
+	n = scan_line("dddddddfdfdddddddd",
 	       &e->type, &e->style, &e->thickness,
 	       &e->pen_color, &e->depth, &e->pen_style, &e->fill_style,
 	       &e->style_val, &e->direction, &e->angle,
@@ -822,8 +1287,8 @@ read_ellipseobject(void)
 	e->fill_color = e->pen_color;
     }
     if (((proto < 22) && (n != 18)) || ((proto >= 30) && (n != 19))) {
-	file_msg(Err_incomp, "ellipse", save_line);
-	free((char *) e);
+	read_msg(Err_incomp, "ellipse", save_line);
+	pool_free(&ellipse_pool, e);
 	return NULL;
     }
     e->fill_style = FILL_CONVERT(e->fill_style);
@@ -846,7 +1311,7 @@ read_lineobject(FILE *fp)
     float	    thickness, wd, ht;
     int		    ox, oy;
     char	    picfile[PATH_MAX];
-    Boolean	    dum;
+    char	   *start;
 
     if ((l = create_line()) == NULL)
 	return NULL;
@@ -856,7 +1321,9 @@ read_lineobject(FILE *fp)
     l->for_arrow = l->back_arrow = NULL;
     l->next = NULL;
 
-    sscanf(buf, "%*d%d", &l->type);
+    start = in_cur;
+    scan_line("d", &l->type);
+    in_cur = start;
 
     /* 2.0 has radius parm only for arc-box objects */
     /* 2.1 or later has radius parm for all line objects */
@@ -864,17 +1331,17 @@ read_lineobject(FILE *fp)
 	all line objects and fill color separate from border color */
     radius_flag = ((proto >= 21) || (l->type == T_ARCBOX && proto == 20));
     if (proto >= 30) {
-	n = sscanf(buf, "%*d%d%d%d%d%d%d%d%d%f%d%d%d%d%d%d",
+	n = scan_line("ddddddddfdddddd",
 		   &l->type, &l->style, &l->thickness, &l->pen_color, &l->fill_color,
 		   &l->depth, &l->pen_style, &l->fill_style, &l->style_val,
 		   &l->join_style, &l->cap_style, &l->radius, &fa, &ba, &npts);
     } else {	/* v2.1 and earlier */
 	if (radius_flag) {
-	    n = sscanf(buf, "%*d%d%d%d%d%d%d%d%f%d%d%d",
+	    n = scan_line("dddddddfddd",
 		   &l->type, &l->style, &l->thickness, &l->pen_color, &l->depth,
 	      &l->pen_style, &l->fill_style, &l->style_val, &l->radius, &fa, &ba);
 	} else { /* old format uses pen for radius of arc-box * corners */
-	    n = sscanf(buf, "%*d%d%d%d%d%d%d%d%f%d%d",
+	    n = scan_line("dddddddfdd",
 		   &l->type, &l->style, &l->thickness, &l->pen_color,
 	           &l->depth, &l->pen_style, &l->fill_style, &l->style_val, &fa, &ba);
 	    if (l->type == T_ARCBOX) {
@@ -890,8 +1357,8 @@ read_lineobject(FILE *fp)
     if ((!radius_flag && n != 10) ||
 	(radius_flag && ((proto == 21 && n != 11) ||
 			((proto >= 30) && n != 15)))) {
-	    file_msg(Err_incomp, "line", save_line);
-	    free((char *) l);
+	    read_msg(Err_incomp, "line", save_line);
+	    pool_free(&line_pool, l);
 	    return NULL;
     }
     l->fill_style = FILL_CONVERT(l->fill_style);
@@ -903,8 +1370,8 @@ read_lineobject(FILE *fp)
     if (fa) {
 	if (read_line(fp) == -1)
 	    return NULL;
-	if (sscanf(buf, "%d%d%f%f%f", &type, &style, &thickness, &wd, &ht) != 5) {
-	    file_msg(Err_incomp, "line", save_line);
+	if (scan_line("ddfff", &type, &style, &thickness, &wd, &ht) != 5) {
+	    read_msg(Err_incomp, "line", save_line);
 	    return NULL;
 	}
 	/* make sure arrowhead is legal and convert units */
@@ -915,8 +1382,8 @@ read_lineobject(FILE *fp)
     if (ba) {
 	if (read_line(fp) == -1)
 	    return NULL;
-	if (sscanf(buf, "%d%d%f%f%f", &type, &style, &thickness, &wd, &ht) != 5) {
-	    file_msg(Err_incomp, "line", save_line);
+	if (scan_line("ddfff", &type, &style, &thickness, &wd, &ht) != 5) {
+	    read_msg(Err_incomp, "line", save_line);
 	    return NULL;
 	}
 	/* make sure arrowhead is legal and convert units */
@@ -927,16 +1394,19 @@ read_lineobject(FILE *fp)
 	char s1[PATH_MAX];
 
 	if (read_line(fp) == -1) {
-	    free((char *) l);
+	    pool_free(&line_pool, l);
 	    return NULL;
 	}
 	if ((l->pic = create_pic()) == NULL) {
-	    free((char *) l);
+	    pool_free(&line_pool, l);
 	    return NULL;
 	}
-	if (sscanf(buf, "%d %[^\n]", &l->pic->flipped, s1) != 2) {
-	    file_msg(Err_incomp, "Picture Object", save_line);
-	    free((char *) l);
+	n = scan_line("d", &l->pic->flipped);
+	while (in_cur < in_eol && isspace((unsigned char) *in_cur))
+	    in_cur++;
+	if (n != 1 || line_rest(s1, PATH_MAX) == 0) {
+	    read_msg(Err_incomp, "Picture Object", save_line);
+	    pool_free(&line_pool, l);
 	    return NULL;
 	}
 
@@ -946,22 +1416,12 @@ read_lineobject(FILE *fp)
 	else
 	    strcpy(picfile, s1);
 
-	if (!update_figs) {
-	    /* only read in the image if update_figs is False */
-	    read_picobj(l->pic, picfile, l->pen_color, False, &dum);
-	} else {
-	    /* otherwise just make a pseudo entry with the filename */
-	    l->pic->pic_cache = create_picture_entry();
-	    l->pic->pic_cache->file = strdup(picfile);
-	}
-	/* we've read in a pic object - merge_file uses this info to decide
-	   whether or not to remap any picture colors in first figure */
-	pic_obj_read = True;
+	read_picture(l, picfile);
     } else
 	l->pic = NULL;
 
     if ((p = create_point()) == NULL) {
-	free((char *) l);
+	pool_free(&line_pool, l);
 	return NULL;
     }
 
@@ -970,8 +1430,8 @@ read_lineobject(FILE *fp)
 
     /* read first point */
     line_no++;
-    if (fscanf(fp, "%d%d", &p->x, &p->y) != 2) {
-	file_msg(Err_incomp, "line", save_line);
+    if (!next_int(&p->x) || !next_int(&p->y)) {
+	read_msg(Err_incomp, "line", save_line);
 	free_linestorage(l);
 	return NULL;
     }
@@ -982,9 +1442,8 @@ read_lineobject(FILE *fp)
 	npts = 1000000;	/* loop until we find 9999 9999 for previous fig files */
     cnpts = 1;		/* keep track of actual number of points read */
     for (--npts; npts > 0; npts--) {
-	count_lines_correctly(fp);
-	if (fscanf(fp, "%d%d", &x, &y) != 2) {
-	    file_msg(Err_incomp, "line", save_line);
+	if (!next_int(&x) || !next_int(&y)) {
+	    read_msg(Err_incomp, "line", save_line);
 	    free_linestorage(l);
 	    return NULL;
 	}
@@ -1011,10 +1470,10 @@ read_lineobject(FILE *fp)
     if ((cnpts < 5 && (l->type == T_BOX || l->type == T_ARCBOX || l->type == T_PICTURE)) ||
 	(cnpts < 3 && l->type == T_POLYGON)) {
 	    if (l->type == T_POLYGON) {
-		file_msg("Deleting polygon containing fewer than 3 points at line %d",
+		read_msg("Deleting polygon containing fewer than 3 points at line %d",
 			save_line);
 	    } else {
-		file_msg("Deleting zero-size %s at line %d",
+		read_msg("Deleting zero-size %s at line %d",
 			l->type==T_BOX? "box" : l->type==T_ARCBOX? "arcbox" : "picture",
 			save_line);
 	    }
@@ -1048,7 +1507,7 @@ read_splineobject(FILE *fp)
     int		    type, style;
     float	    thickness, wd, ht;
     double	    s_param;
-    float	    lx, ly, rx, ry;
+    double	    lx, ly, rx, ry;
 
     if ((s = create_spline()) == NULL)
 	return NULL;
@@ -1062,20 +1521,20 @@ read_splineobject(FILE *fp)
     /* 3.0(experimental 2.2) or later has number of points parm for all spline
 	objects and fill color separate from border color */
     if (proto >= 30) {
-	    n = sscanf(buf, "%*d%d%d%d%d%d%d%d%d%f%d%d%d%d",
+	    n = scan_line("ddddddddfdddd",
 		    &s->type, &s->style, &s->thickness, &s->pen_color, &s->fill_color,
 		    &s->depth, &s->pen_style, &s->fill_style, &s->style_val,
 		    &s->cap_style, &fa, &ba, &npts);
     } else {
-	    n = sscanf(buf, "%*d%d%d%d%d%d%d%d%f%d%d",
+	    n = scan_line("dddddddfdd",
 		    &s->type, &s->style, &s->thickness, &s->pen_color,
 		    &s->depth, &s->pen_style, &s->fill_style, &s->style_val, &fa, &ba);
 	    s->fill_color = s->pen_color;
 	    s->cap_style = CAP_BUTT;	/* butt line cap */
     }
     if (((proto < 22) && (n != 10)) || ((proto >= 30) && n != 13)) {
-	file_msg(Err_incomp, "spline", save_line);
-	free((char *) s);
+	read_msg(Err_incomp, "spline", save_line);
+	pool_free(&spline_pool, s);
 	return NULL;
     }
     s->fill_style = FILL_CONVERT(s->fill_style);
@@ -1087,8 +1546,8 @@ read_splineobject(FILE *fp)
     if (fa) {
 	if (read_line(fp) == -1)
 	    return NULL;
-	if (sscanf(buf, "%d%d%f%f%f", &type, &style, &thickness, &wd, &ht) != 5) {
-	    file_msg(Err_incomp, "spline", save_line);
+	if (scan_line("ddfff", &type, &style, &thickness, &wd, &ht) != 5) {
+	    read_msg(Err_incomp, "spline", save_line);
 	    return NULL;
 	}
 	/* make sure arrowhead is legal and convert units */
@@ -1099,8 +1558,8 @@ read_splineobject(FILE *fp)
     if (ba) {
 	if (read_line(fp) == -1)
 	    return NULL;
-	if (sscanf(buf, "%d%d%f%f%f", &type, &style, &thickness, &wd, &ht) != 5) {
-	    file_msg(Err_incomp, "spline", save_line);
+	if (scan_line("ddfff", &type, &style, &thickness, &wd, &ht) != 5) {
+	    read_msg(Err_incomp, "spline", save_line);
 	    return NULL;
 	}
 	/* make sure arrowhead is legal and convert units */
@@ -1110,8 +1569,8 @@ read_splineobject(FILE *fp)
 
     /* read first point */
     line_no++;
-    if ((n = fscanf(fp, "%d%d", &x, &y)) != 2) {
-	file_msg(Err_incomp, "spline", save_line);
+    if (!next_int(&x) || !next_int(&y)) {
+	read_msg(Err_incomp, "spline", save_line);
 	free_splinestorage(s);
 	return NULL;
     };
@@ -1128,9 +1587,8 @@ read_splineobject(FILE *fp)
 	npts = 1000000;	/* loop until we find 9999 9999 for previous fig files */
     numpts = 1;
     for (--npts; npts > 0; npts--) {
-	count_lines_correctly(fp);
-	if (fscanf(fp, "%d%d", &x, &y) != 2) {
-	    file_msg(Err_incomp, "spline", save_line);
+	if (!next_int(&x) || !next_int(&y)) {
+	    read_msg(Err_incomp, "spline", save_line);
 	    p->next = NULL;
 	    free_splinestorage(s);
 	    return NULL;
@@ -1155,9 +1613,9 @@ read_splineobject(FILE *fp)
 	                        /* 2 control points per point given by user in
 			           version 3.1 and older : don't read them */
           while (c--) {
-            count_lines_correctly(fp);
-            if (fscanf(fp, "%f%f%f%f", &lx, &ly, &rx, &ry) != 4) {
-              file_msg(Err_incomp, "spline", save_line);
+            if (!next_double(&lx) || !next_double(&ly) ||
+		!next_double(&rx) || !next_double(&ry)) {
+              read_msg(Err_incomp, "spline", save_line);
 	      free_splinestorage(s);
               return NULL;
             }
@@ -1166,7 +1624,7 @@ read_splineobject(FILE *fp)
 	if (closed_spline(s)) {
 	    F_point *ptr   = s->points; 
 	    s->points = s->points->next;
-	    free (ptr);
+	    pool_free(&point_pool, ptr);
 	}
 	if (! make_sfactors(s)) {
 	    free_splinestorage(s);
@@ -1177,9 +1635,8 @@ read_splineobject(FILE *fp)
 
     /* Read sfactors - the s parameter for splines */
     
-    count_lines_correctly(fp);
-    if ((n = fscanf(fp, "%lf", &s_param)) != 1) {
-	file_msg(Err_incomp, "spline", save_line);
+    if (!next_double(&s_param)) {
+	read_msg(Err_incomp, "spline", save_line);
 	free_splinestorage(s);
 	return NULL;
     };
@@ -1190,9 +1647,8 @@ read_splineobject(FILE *fp)
     s->sfactors = cp;
     cp->s = s_param;
     while (--c) {
-	count_lines_correctly(fp);
-	if (fscanf(fp, "%lf", &s_param) != 1) {
-	    file_msg(Err_incomp, "spline", save_line);
+	if (!next_double(&s_param)) {
+	    read_msg(Err_incomp, "spline", save_line);
 	    cp->next = NULL;
 	    free_splinestorage(s);
 	    return NULL;
@@ -1207,11 +1663,11 @@ read_splineobject(FILE *fp)
 	cp = cq;
     }
     if (closed_spline(s) && numpts < 3) {
-	file_msg("Closed splines must have 3 or more points, removing spline at line %d", save_line);
+	read_msg("Closed splines must have 3 or more points, removing spline at line %d", save_line);
 	free_splinestorage(s);
 	return NULL;
     } else if (numpts < 2) {
-	file_msg("Open splines must have 2 or more points, removing spline at line %d", save_line);
+	read_msg("Open splines must have 2 or more points, removing spline at line %d", save_line);
 	free_splinestorage(s);
 	return NULL;
     }
@@ -1233,7 +1689,6 @@ read_textobject(FILE *fp)
     float	    tx_size;
     float	    length, height;
     Boolean	    more;
-    PR_SIZE	    tx_dim;
 
     if ((t = create_text()) == NULL)
 	return NULL;
@@ -1256,25 +1711,36 @@ read_textobject(FILE *fp)
      *	     actual font structure in read_scale_text().
      */
 
+    s[0] = '\0';
     if (proto >= 30) {	/* order of parms is more like other objects now;
 			   string is now terminated with the literal '\001',
 			   and 8-bit characters are represented as \xxx */
-	n = sscanf(buf, "%*d%d%d%d%d%d%f%f%d%f%f%d%d%[^\n]",
+	n = scan_line("dddddffdffdd",
 		&t->type, &t->color, &t->depth, &t->pen_style,
 		&t->font, &tx_size, &t->angle, &t->flags,
-		&height, &length, &t->base_x, &t->base_y, s);
+		&height, &length, &t->base_x, &t->base_y);
+	/* the string is the rest of the line, with its leading blank */
+	if (n == 12 && line_rest(s, BUF_SIZE) > 0)
+	    n++;
     } else {
-	n = sscanf(buf, "%*d%d%d%f%d%d%d%f%d%f%f%d%d%[^\1]%[\1]",
+	n = scan_line("ddfdddfdffdd",
 		&t->type, &t->font, &tx_size, &t->pen_style,
 		&t->color, &t->depth, &t->angle, &t->flags,
-		&height, &length, &t->base_x, &t->base_y, s, junk);
+		&height, &length, &t->base_x, &t->base_y);
+	/* the string goes up to a CONTROL-A or the end of the line */
+	if (n == 12) {
+	    for (len = 0; in_cur < in_eol && *in_cur != '\1'; len++)
+		s[len] = *in_cur++;
+	    s[len] = '\0';
+	    if (len > 0) {
+		n++;
+		if (in_cur < in_eol)		/* found the CONTROL-A */
+		    n++;
+	    }
+	}
     }
-    /* remove newline */
-    buf[strlen(buf)-1] = '\0';
-    if (buf[strlen(buf)-1] == '\r')
-	buf[strlen(buf)-1] = '\0';
     /* remove any trailing carriage returns (^M, possibly from a PC) */
-    if (s[strlen(s)-1] == '\r')
+    if (s[0] && s[strlen(s)-1] == '\r')
 	s[strlen(s)-1] = '\0';
     /* use these for now, but recalculate later in read_scale_text if not update_figs */
     t->ascent = round(height);
@@ -1282,8 +1748,8 @@ read_textobject(FILE *fp)
     t->length = round(length);
 
     if (n < 11) {
-	file_msg(Err_incomp, "text", save_line);
-	free((char *) t);
+	read_msg(Err_incomp, "text", save_line);
+	pool_free(&text_pool, t);
 	return NULL;
     }
 
@@ -1314,15 +1780,11 @@ read_textobject(FILE *fp)
 
     /* check for valid font number */
     if (t->font >= MAXFONT(t)) {
-	file_msg("Invalid text font (%d) at line %d, setting to DEFAULT.",
+	read_msg("Invalid text font (%d) at line %d, setting to DEFAULT.",
 		t->font, save_line);
 	t->font = DEFAULT;
     }
 
-    /* get the UNZOOMED font struct */
-    if (!update_figs)
-	t->fontstruct = lookfont(x_fontnum(psfont_text(t), t->font), t->size);
-
     fix_depth(&t->depth);
     check_color(&t->color);
     more = False;
@@ -1344,8 +1806,9 @@ read_textobject(FILE *fp)
 	/* Read in the subsequent lines of the text object if there is more than one. */
 	do {
 	    line_no++;		/* As is done in read_line */
-	    if (fgets(buf, BUF_SIZE, fp) == NULL)
+	    if (!next_line())
 		break;
+	    line_to_buf();
 	    /* remove newline */
 	    buf[strlen(buf)-1] = '\0';
 	    if (buf[strlen(buf)-1] == '\r')
@@ -1367,7 +1830,7 @@ read_textobject(FILE *fp)
 	    if (strlen(s) + 1 + strlen(s_temp) + 1 > BUF_SIZE) {
 		/* Too many characters.	 Ignore the rest. */
 		if (!ignore)
-		    file_msg("Truncating TEXT object to %d chars in line %d.",
+		    read_msg("Truncating TEXT object to %d chars in line %d.",
 				BUF_SIZE, save_line);
 		ignore = 1;
 	    }
@@ -1386,8 +1849,8 @@ read_textobject(FILE *fp)
 			if (l < len && isdigit(s[l+1])) {
 			    /* yes, allow exactly 3 digits following the \ for the octal value */
 			    if (sscanf(&s[l+1],"%3o",&num)!=1) {
-				file_msg("Error in parsing text string on line.", save_line);
-				free((char *) t);
+				read_msg("Error in parsing text string on line.", save_line);
+				pool_free(&text_pool, t);
 				return NULL;
 			    }
 			    buf[n++]= (unsigned char) num;	/* put char in */
@@ -1405,7 +1868,7 @@ read_textobject(FILE *fp)
     }
 
     if (t->type > T_RIGHT_JUSTIFIED) {
-	file_msg("Invalid text justification at line %d, setting to LEFT.", save_line);
+	read_msg("Invalid text justification at line %d, setting to LEFT.", save_line);
 	t->type = T_LEFT_JUSTIFIED;
     }
 
@@ -1414,24 +1877,13 @@ read_textobject(FILE *fp)
     }
     /* skip first blank from input file by starting at s[1] */
     if ((t->cstring = new_string(strlen(&s[1]))) == NULL) {
-	free((char *) t);
+	pool_free(&text_pool, t);
 	return NULL;
     }
     /* copy string to text object */
     (void) strcpy(t->cstring, &s[1]);
 
-    if (!update_figs) {
-	/* now calculate the actual length and height of the string in fig units */
-	tx_dim = textsize(t->fontstruct, strlen(t->cstring), t->cstring);
-	t->length = round(tx_dim.length);
-	t->ascent = round(tx_dim.ascent);
-	t->descent = round(tx_dim.descent);
-	/* now get the zoomed font struct */
-	t->zoom = zoomscale;
-	if (display_zoomscale != 1.0)
-	    t->fontstruct = lookfont(x_fontnum(psfont_text(t), t->font),
-				round(t->size*display_zoomscale));
-    }
+    text_fonts(t);
 
     t->comments = attach_comments();		/* attach any comments */
     return t;
@@ -1485,17 +1937,230 @@ attach_comments(void)
     return comp;
 }
 
+/* read the rest of fp into memory, return 0 or errno */
+
+static int
+load_input(FILE *fp)
+{
+    struct stat	    st;
+    size_t	    size, len, n;
+    long	    here;
+    char	   *p;
+
+    size = 64*1024;
+    if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode) &&
+	(here = ftell(fp)) >= 0 && st.st_size > here)
+	    size = st.st_size - here + 1;
+    if ((in_buf = (char *) malloc(size + 1)) == NULL)
+	return ENOMEM;
+    len = 0;
+    while ((n = fread(in_buf + len, 1, size - len, fp)) > 0) {
+	len += n;
+	if (len == size) {
+	    /* file grew or is a pipe */
+	    size *= 2;
+	    if ((p = (char *) realloc(in_buf, size + 1)) == NULL) {
+		free_input();
+		return ENOMEM;
+	    }
+	    in_buf = p;
+	}
+    }
+    if (ferror(fp)) {
+	free_input();
+	return errno? errno: EIO;
+    }
+    in_buf[len] = '\0';
+    in_pos = in_line = in_eol = in_cur = in_buf;
+    in_end = in_buf + len;
+    return 0;
+}
+
+static void
+free_input(void)
+{
+    if (in_buf)
+	free(in_buf);
+    in_buf = NULL;
+}
+
+/* make the next line of the input the current one, the way fgets() with
+   a buffer of BUF_SIZE would split it */
+
+static Boolean
+next_line(void)
+{
+    char	   *p;
+    size_t	    len;
+
+    if (at_end())
+	return False;
+    len = min2(in_end - in_pos, BUF_SIZE-1);
+    if ((p = (char *) memchr(in_pos, '\n', len)) != NULL)
+	len = p - in_pos + 1;
+    in_line = in_cur = in_pos;
+    in_eol = in_pos += len;
+    return True;
+}
+
+/* copy the current line to buf, as fgets() would have read it */
+
+static void
+line_to_buf(void)
+{
+    int		    len = in_eol - in_line;
+
+    memcpy(buf, in_line, len);
+    buf[len] = '\0';
+}
+
+/* copy the rest of the current line up to the newline (like %[^\n]) to s,
+   return its length */
+
+static int
+line_rest(char *s, int size)
+{
+    int		    len;
+
+    for (len = 0; in_cur < in_eol && *in_cur != '\n' && len < size-1; len++)
+	s[len] = *in_cur++;
+    s[len] = '\0';
+    return len;
+}
+
+/* convert an integer at *p (no leading blanks), like %d */
+
+static Boolean
+parse_int(char **p, char *end, int *val)
+{
+    char	   *c = *p;
+    Boolean	    neg = False;
+    int		    n;
+
+    if (c < end && (*c == '-' || *c == '+'))
+	neg = (*c++ == '-');
+    if (c >= end || !is_digit(*c))
+	return False;
+    for (n = 0; c < end && is_digit(*c); c++)
+	n = n*10 + (*c - '0');
+    *val = neg? -n: n;
+    *p = c;
+    return True;
+}
+
+/* convert a floating point number at *p (no leading blanks), like %f/%lf.
+   Plain decimals of up to 15 digits are converted here, which is exact;
+   anything else is left to strtod() */
+
+static Boolean
+parse_double(char **p, char *end, double *val)
+{
+    char	   *c = *p;
+    char	    tmp[64], *e;
+    Boolean	    neg = False;
+    double	    mant;
+    int		    ndig, nfrac;
+
+    if (c < end && (*c == '-' || *c == '+'))
+	neg = (*c++ == '-');
+    mant = 0.0;
+    ndig = nfrac = 0;
+    for ( ; c < end && is_digit(*c); c++, ndig++)
+	mant = mant*10.0 + (*c - '0');
+    if (c < end && *c == '.')
+	for (c++; c < end && is_digit(*c); c++, ndig++, nfrac++)
+	    mant = mant*10.0 + (*c - '0');
+    if (ndig > 0 && ndig <= 15 && !(c < end &&
+		(*c == 'e' || *c == 'E' || *c == 'x' || *c == 'X'))) {
+	*val = neg? -mant/pow_ten[nfrac]: mant/pow_ten[nfrac];
+	*p = c;
+	return True;
+    }
+    /* exponent, hex, inf/nan or many digits */
+    ndig = min2(end - *p, (int) sizeof(tmp) - 1);
+    memcpy(tmp, *p, ndig);
+    tmp[ndig] = '\0';
+    *val = strtod(tmp, &e);
+    if (e == tmp)
+	return False;
+    *p += e - tmp;
+    return True;
+}
+
+/*
+ * Scan the current line from in_cur according to fmt, where each 'd'
+ * stands for an int * and each 'f' for a float * argument.  Leading
+ * blanks are skipped before each number.  Returns the number of values
+ * converted, like sscanf().
+ */
+
+static int
+scan_line(const char *fmt, ...)
+{
+    va_list	    ap;
+    double	    d;
+    int		    n;
+
+    va_start(ap, fmt);
+    for (n = 0; *fmt; fmt++, n++) {
+	while (in_cur < in_eol && isspace((unsigned char) *in_cur))
+	    in_cur++;
+	if (*fmt == 'd') {
+	    if (!parse_int(&in_cur, in_eol, va_arg(ap, int *)))
+		break;
+	} else {
+	    if (!parse_double(&in_cur, in_eol, &d))
+		break;
+	    *va_arg(ap, float *) = d;
+	}
+    }
+    va_end(ap);
+    return n;
+}
+
+/*
+ * Skip blanks and newlines in the input for the point and sfactor lists,
+ * which may be spread over any number of lines, counting the lines in
+ * line_no.
+ */
+
+static void
+skip_blanks(void)
+{
+    for ( ; ; in_pos++) {
+	if (*in_pos == '\n')
+	    line_no++;
+	else if (!isspace((unsigned char) *in_pos))
+	    return;
+    }
+}
+
+/* read the next integer or double from the input, like fscanf(fp, "%d") */
+
+static Boolean
+next_int(int *val)
+{
+    skip_blanks();
+    return parse_int(&in_pos, in_end, val);
+}
+
+static Boolean
+next_double(double *val)
+{
+    skip_blanks();
+    return parse_double(&in_pos, in_end, val);
+}
+
 int read_line(FILE *fp)
 {
     while (1) {
-	if (NULL == fgets(buf, BUF_SIZE, fp)) {
+	if (!next_line())
 	    return -1;
-	}
 	line_no++;
-	if (*buf == '#') {		/* save any comments */
+	if (*in_line == '#') {		/* save any comments */
 	    if (save_comment(fp) < 0)
 		return -1;
-	} else if (*buf != '\n')	/* Skip empty lines */
+	} else if (*in_line != '\n')	/* Skip empty lines */
 	    return 1;
     }
 }
@@ -1504,22 +2169,24 @@ int read_line(FILE *fp)
 
 int save_comment(FILE *fp)
 {
-    int		    i;
+    int		    i, len;
 
-    i=strlen(buf);
+    len = in_eol - in_line;
     /* see if we've allocated space for this comment */
     if (comments[numcom])
 	free(comments[numcom]);
-    if ((comments[numcom] = (char*) new_string(i+1)) == NULL)
+    if ((comments[numcom] = (char*) new_string(len+1)) == NULL)
 	    return -1;
     /* remove any newline */
-    if (buf[i-1] == '\n')
-	buf[i-1] = '\0';
+    if (in_line[len-1] == '\n')
+	len--;
     i=1; 
-    if (buf[1] == ' ')	/* remove one leading blank from the comment, if there is one */
+    if (len > 1 && in_line[1] == ' ')	/* remove one leading blank from the comment, if there is one */
 	i=2;
-    if (numcom < MAXCOMMENTS)
-	strcpy(comments[numcom++], &buf[i]);
+    if (numcom < MAXCOMMENTS) {
+	memcpy(comments[numcom], &in_line[i], max2(len-i, 0));
+	comments[numcom++][max2(len-i, 0)] = '\0';
+    }
     return 1;
 }
 
@@ -1527,10 +2194,12 @@ int save_comment(FILE *fp)
 
 void skip_line(FILE *fp)
 {
-    while (fgetc(fp) != '\n') {
-	if (feof(fp))
-	    return;
-    }
+    char	   *p;
+
+    if ((p = (char *) memchr(in_pos, '\n', in_end - in_pos)) != NULL)
+	in_pos = p + 1;
+    else
+	in_pos = in_end;
 }
 
 /* make sure angle is 0 to 2PI */
@@ -1547,13 +2216,13 @@ void fix_depth(int *depth)
 {
     if (*depth>MAX_DEPTH) {
 	    *depth=MAX_DEPTH;
-	    file_msg("Depth > Maximum allowed (%d), setting to %d in line %d.",
+	    read_msg("Depth > Maximum allowed (%d), setting to %d in line %d.",
 			MAX_DEPTH, save_line, MAX_DEPTH);
 	}
 	else if (*depth<0 || proto<21) {
 	    *depth=0;
 	    if (proto>=21)
-		file_msg("Depth < 0, setting to 0 in line %d.", save_line);
+		read_msg("Depth < 0, setting to 0 in line %d.", save_line);
 	}
 }
 
@@ -1606,7 +2275,7 @@ void shift_figure(F_compound *obj)
     for (s = obj->splines; s != NULL; s = s->next)
 	translate_spline(s, dx, dy);
     for (c = obj->compounds; c != NULL; c = c->next)
-	translate_compound(c, dx, dy);
+	(void) translate_compound(c, dx, dy);	/* just read, nothing shared */
     for (t = obj->texts; t != NULL; t = t->next)
 	translate_text(t, dx, dy);
 }
@@ -1634,7 +2303,7 @@ void check_color(int *color)
 	return;
     if (!n_colorFree[*color-NUM_STD_COLS])
 	return;
-    file_msg("Cannot locate user color %d, using default color for line %d.",
+    read_msg("Cannot locate user color %d, using default color for line %d.",
 		*color,line_no);
     *color = DEFAULT;
     return;
@@ -1834,32 +2503,6 @@ void renumber(int *color)
 	*color = renum[*color-NUM_STD_COLS]+NUM_STD_COLS;
 }
 
-/* this function is to count line numbers correctly while reading
- * input files.
- * It skips all tabs and spaces and increments the global
- * variable line_no if a newline was found.
- * If any other character is read, it is put back to the input
- * stream and the function returns.
- * It should be called from within the point reading loops
- * in the read_{line,spline}object functions, where the point
- * coordinates may be given in an arbitrary number of lines.
- * Added by Andreas_Bagge@maush2.han.de (A.Bagge), 14.12.94
- */
-
-static void
-count_lines_correctly(FILE *fp)
-{
-    int cc;
-    do{
-	cc=getc(fp);
-	if (cc=='\n') {
-	   line_no++;
-	   cc=getc(fp);
-	}
-    } while (cc==' '||cc=='\t');
-    ungetc(cc,fp);
-}
-
 /* make sure arrow style value is legal and convert arrow width and height to
  * same units as thickness in V4.0 and later we will save the values in these units */
 
@@ -26,9 +26,17 @@
 #define REMAP_IMAGES		True
 #define DONT_REMAP_IMAGES	False
 
+/* with USE_THREADS large files are read by several threads, each having
+   its own copy of the reader state */
+#ifdef USE_THREADS
+#define READER_LOCAL	__thread
+#else
+#define READER_LOCAL
+#endif
+
 extern int	 defer_update_layers;	/* if != 0, update_layers() doesn't update */
-extern int	 line_no;
-extern int	 num_object;
+extern READER_LOCAL int	 line_no;
+extern READER_LOCAL int	 num_object;
 extern char	*read_file_name;
 
 /* structure which is filled by readfp_fig */
@@ -18,11 +18,9 @@
 #include "resources.h"
 #include "object.h"
 #include "f_picobj.h"
+#include "f_util.h"
 #include "w_msgpanel.h"
-
-#include "f_readpcx.h"
-
-#define BUFLEN 1024
+#include "w_setup.h"
 
 /* Some of the following code is extracted from giftopnm.c, from the netpbm package */
 
@@ -40,13 +38,18 @@
 static Boolean	ReadColorMap(FILE *fd, unsigned int number, struct Cmap *cmap);
 static Boolean	DoGIFextension(FILE *fd, int label);
 static int	GetDataBlock(FILE *fd, unsigned char *buf);
+static Boolean	ReadImage(FILE *fd, unsigned char *image, int width, int height,
+			  Boolean interlace);
 
 #define LOCALCOLORMAP		0x80
+#define INTERLACE		0x40
 #define	ReadOK(file,buffer,len)	(fread((void *) buffer, (size_t) len, (size_t) 1, (FILE *) file) != 0)
 #define BitSet(byte, bit)	(((byte) & (bit)) == (bit))
 
 #define LM_to_uint(a,b)			(((b)<<8)|(a))
 
+#define MAX_LWZ_BITS		12
+
 struct {
 	unsigned int	Width;
 	unsigned int	Height;
@@ -66,29 +69,37 @@ struct {
 
 /* return codes:  PicSuccess (1) : success
 		  FileInvalid (-2) : invalid file
-*/
-
 
+   The first image of the file is decoded right here into pic_cache->bitmap,
+   one byte (colormap index) per pixel, with its colormap in pic_cache->cmap.
+*/
 
 int
 read_gif(FILE *file, int filetype, F_pic *pic)
 {
-	char		buf[BUFLEN],pcxname[PATH_MAX];
-	FILE		*giftopcx;
+	unsigned char	buf[16];
 	struct Cmap 	localColorMap[MAX_COLORMAP_SIZE];
-	int		i, stat, size;
+	struct Cmap	*cmap;
+	int		i, width, height;
 	int		useGlobalColormap;
-	unsigned int	bitPixel, red, green, blue;
+	unsigned int	bitPixel, numcols;
 	unsigned char	c;
 	char		version[4];
 
-	/* first read header to look for any transparent color extension */
+	/* make scale factor smaller for metric */
+	float scale = (appres.INCHES ?
+			(float)PIX_PER_INCH :
+			2.54*PIX_PER_CM)/(float)DISPLAY_PIX_PER_INCH;
+
+	pic->pic_cache->bitmap = NULL;
 
 	if (! ReadOK(file,buf,6)) {
+		close_picfile(file,filetype);
 		return FileInvalid;
 	}
 
 	if (strncmp((char*)buf,"GIF",3) != 0) {
+		close_picfile(file,filetype);
 		return FileInvalid;
 	}
 
@@ -97,10 +108,12 @@ read_gif(FILE *file, int filetype, F_pic *pic)
 
 	if ((strcmp(version, "87a") != 0) && (strcmp(version, "89a") != 0)) {
 		file_msg("Unknown GIF version %s",version);
+		close_picfile(file,filetype);
 		return FileInvalid;
 	}
 
 	if (! ReadOK(file,buf,7)) {
+		close_picfile(file,filetype);
 		return FileInvalid;		/* failed to read screen descriptor */
 	}
 
@@ -111,10 +124,14 @@ read_gif(FILE *file, int filetype, F_pic *pic)
 	GifScreen.Background      = (unsigned int) buf[5];
 	GifScreen.AspectRatio     = (unsigned int) buf[6];
 
+	/* no global colormap is the same as an empty one */
+	numcols = 0;
 	if (BitSet(buf[4], LOCALCOLORMAP)) {	/* Global Colormap */
 		if (!ReadColorMap(file,GifScreen.BitPixel,GifScreen.ColorMap)) {
+			close_picfile(file,filetype);
 			return FileInvalid;	/* error reading global colormap */
 		}
+		numcols = GifScreen.BitPixel;
 	}
 
 	if (GifScreen.AspectRatio != 0 && GifScreen.AspectRatio != 49) {
@@ -125,14 +142,12 @@ read_gif(FILE *file, int filetype, F_pic *pic)
 	/* assume no transparent color for now */
 	Gif89.transparent =  TRANSP_NONE;
 
-	/* read the full header to get any transparency information */
+	/* read up to the first image, getting any transparency information */
 	for (;;) {
-		if (! ReadOK(file,&c,1)) {
-			return FileInvalid;	/* EOF / read error on image data */
-		}
-
-		if (c == ';') {			/* GIF terminator, finish up */
-			return PicSuccess;	/* all done */
+		if (! ReadOK(file,&c,1) || c == ';') {
+			/* EOF / read error or GIF terminator before any image */
+			close_picfile(file,filetype);
+			return FileInvalid;
 		}
 
 		if (c == '!') { 		/* Extension */
@@ -147,80 +162,209 @@ read_gif(FILE *file, int filetype, F_pic *pic)
 		}
 
 		if (! ReadOK(file,buf,9)) {
+			close_picfile(file,filetype);
 			return FileInvalid;	/* couldn't read left/top/width/height */
 		}
+		break;				/* image starts here, header is done */
+	}
 
-		useGlobalColormap = ! BitSet(buf[8], LOCALCOLORMAP);
+	useGlobalColormap = ! BitSet(buf[8], LOCALCOLORMAP);
 
-		bitPixel = 1<<((buf[8]&0x07)+1);
+	bitPixel = 1<<((buf[8]&0x07)+1);
 
-		if (! useGlobalColormap) {
-		    if (!ReadColorMap(file, bitPixel, localColorMap)) {
-			file_msg("error reading local GIF colormap" );
-			return PicSuccess;
-		    }
-		}
-		break;				/* image starts here, header is done */
+	if (useGlobalColormap) {
+	    cmap = GifScreen.ColorMap;
+	} else {
+	    if (!ReadColorMap(file, bitPixel, localColorMap)) {
+		file_msg("error reading local GIF colormap" );
+		close_picfile(file,filetype);
+		return FileInvalid;
+	    }
+	    cmap = localColorMap;
+	    numcols = bitPixel;
+	}
+	if (numcols == 0) {
+	    file_msg("GIF image has no colormap");
+	    close_picfile(file,filetype);
+	    return FileInvalid;
 	}
 
-	/* save transparent indicator */
-	pic->pic_cache->transp = Gif89.transparent;
-
-	/* close it and open it again (it may be a pipe so we can't just rewind) */
-	close_picfile(file, filetype);
-	file = open_picfile(pic->pic_cache->file, &filetype, PIPEOK, pcxname);
-	
-	/* now call giftopnm and ppmtopcx */
-
-	/* make name for temp output file */
-	sprintf(pcxname, "%s/%s%06d.pix", TMPDIR, "xfig-pcx", getpid());
-	/* make command to convert gif to pcx into temp file */
-	sprintf(buf, "giftopnm | ppmtopcx > %s 2> /dev/null", pcxname);
-	if ((giftopcx = popen(buf,"w" )) == 0) {
-	    file_msg("Cannot open pipe to giftopnm or ppmtopcx\n");
+	width = LM_to_uint(buf[4],buf[5]);
+	height = LM_to_uint(buf[6],buf[7]);
+	if (width <= 0 || height <= 0) {
 	    close_picfile(file,filetype);
 	    return FileInvalid;
 	}
-	while ((size=fread(buf, 1, BUFLEN, file)) != 0) {
-	    fwrite(buf, size, 1, giftopcx);
+	/* width*height mustn't overflow the size of the bitmap */
+	if (width > INT_MAX / height) {
+	    file_msg("GIF image is too large");
+	    close_picfile(file,filetype);
+	    return FileInvalid;
 	}
-	/* close pipe */
-	pclose(giftopcx);
-	if ((giftopcx = fopen(pcxname, "rb")) == NULL) {
-	    file_msg("Can't open temp output file\n");
+	if ((pic->pic_cache->bitmap = malloc(width*height)) == NULL) {
+	    file_msg("Out of memory reading GIF image");
 	    close_picfile(file,filetype);
 	    return FileInvalid;
 	}
-	/* now call read_pcx to read the pcx file */
-	stat = read_pcx(giftopcx, filetype, pic);
+	if (!ReadImage(file, (unsigned char *) pic->pic_cache->bitmap, width, height,
+			BitSet(buf[8], INTERLACE))) {
+	    free(pic->pic_cache->bitmap);
+	    pic->pic_cache->bitmap = NULL;
+	    close_picfile(file,filetype);
+	    return FileInvalid;
+	}
+
+	for (i=0; i<numcols; i++)
+	    pic->pic_cache->cmap[i] = cmap[i];
+	pic->pic_cache->numcols = numcols;
+	/* an index outside the colormap can't be transparent */
+	if (Gif89.transparent >= (int) numcols)
+	    Gif89.transparent = TRANSP_NONE;
+	pic->pic_cache->transp = Gif89.transparent;
+
+	pic->pixmap = None;
 	pic->pic_cache->subtype = T_PIC_GIF;
+	pic->pic_cache->bit_size.x = width;
+	pic->pic_cache->bit_size.y = height;
+	pic->hw_ratio = (float) height / width;
+	pic->pic_cache->size_x = width * scale;
+	pic->pic_cache->size_y = height * scale;
+	/* if monochrome display map bitmap */
+	if (tool_cells <= 2 || appres.monochrome)
+	    map_to_mono(pic);
+
+	close_picfile(file,filetype);
+	return PicSuccess;
+}
+
+/*
+ * Decode the LZW compressed raster of a width x height image into image[],
+ * one byte per pixel, putting the rows of an interlaced image in their place.
+ * A raster that ends early leaves the rest of the image at index 0, as
+ * giftopnm does; only a code that can't be in the table is an error.
+ */
+
+static Boolean
+ReadImage(FILE *fd, unsigned char *image, int width, int height, Boolean interlace)
+{
+	static unsigned short	prefix[1<<MAX_LWZ_BITS];
+	static unsigned char	suffix[1<<MAX_LWZ_BITS];
+	static unsigned char	stack[(1<<MAX_LWZ_BITS)+1];
+	static int		pass_start[] = { 0, 4, 2, 1 };
+	static int		pass_step[]  = { 8, 8, 4, 2 };
+	unsigned char	block[256], *sp, *row, first;
+	unsigned char	c;
+	unsigned long	datum;
+	int		bits, count, pos;
+	int		set_code_size, code_size, code_mask;
+	int		clear_code, end_code, avail, code, in_code, old_code;
+	int		x, y, pass;
+
+	if (! ReadOK(fd,&c,1))
+		return False;
+	set_code_size = c;
+	if (set_code_size < 1 || set_code_size > 8) {
+		file_msg("bad GIF code size %d", set_code_size);
+		return False;
+	}
+	clear_code = 1 << set_code_size;
+	end_code = clear_code + 1;
+	avail = clear_code + 2;
+	code_size = set_code_size + 1;
+	code_mask = (1 << code_size) - 1;
+	old_code = -1;
+	first = 0;
+	for (code = 0; code < clear_code; code++) {
+		prefix[code] = 0;
+		suffix[code] = code;
+	}
 
-	/* remove temp file */
-	unlink(pcxname);
-
-	/* now match original transparent colortable index with possibly new 
-	   colortable from ppmtopcx */
-	if (pic->pic_cache->transp != TRANSP_NONE) {
-	    if (useGlobalColormap) {
-		red = GifScreen.ColorMap[pic->pic_cache->transp].red;
-		green = GifScreen.ColorMap[pic->pic_cache->transp].green;
-		blue = GifScreen.ColorMap[pic->pic_cache->transp].blue;
-	    } else {
-		red = localColorMap[pic->pic_cache->transp].red;
-		green = localColorMap[pic->pic_cache->transp].green;
-		blue = localColorMap[pic->pic_cache->transp].blue;
+	memset(image, 0, width*height);
+	datum = 0;
+	bits = count = pos = 0;
+	sp = stack;
+	x = y = pass = 0;
+	row = image;
+
+	while (y < height) {
+	    if (sp == stack) {
+		/* get the next code, a data block at a time */
+		while (bits < code_size) {
+		    if (pos == count) {
+			if ((count = GetDataBlock(fd, block)) <= 0)
+			    return True;	/* end of data, keep what we have */
+			pos = 0;
+		    }
+		    datum |= (unsigned long) block[pos++] << bits;
+		    bits += 8;
+		}
+		code = datum & code_mask;
+		datum >>= code_size;
+		bits -= code_size;
+
+		if (code == clear_code) {
+		    code_size = set_code_size + 1;
+		    code_mask = (1 << code_size) - 1;
+		    avail = clear_code + 2;
+		    old_code = -1;
+		    continue;
+		}
+		if (code == end_code)
+		    break;
+		if (old_code == -1) {
+		    /* first code after a clear must be a plain color */
+		    if (code > clear_code)
+			return False;
+		    *sp++ = first = suffix[code];
+		    old_code = code;
+		    continue;
+		}
+		if (code > avail)
+		    return False;
+
+		in_code = code;
+		if (code == avail) {
+		    *sp++ = first;
+		    code = old_code;
+		}
+		while (code > clear_code) {
+		    *sp++ = suffix[code];
+		    code = prefix[code];
+		}
+		*sp++ = first = suffix[code];
+
+		if (avail < (1 << MAX_LWZ_BITS)) {
+		    prefix[avail] = old_code;
+		    suffix[avail] = first;
+		    avail++;
+		    if ((avail & code_mask) == 0 && avail < (1 << MAX_LWZ_BITS)) {
+			code_size++;
+			code_mask = (1 << code_size) - 1;
+		    }
+		}
+		old_code = in_code;
 	    }
-	    for (i=0; i<pic->pic_cache->numcols; i++) {
-		if (pic->pic_cache->cmap[i].red == red &&
-		    pic->pic_cache->cmap[i].green == green &&
-		    pic->pic_cache->cmap[i].blue == blue)
-			break;
+
+	    /* put out the pixel and move along */
+	    row[x] = *--sp;
+	    if (++x == width) {
+		x = 0;
+		picture_progress();
+		if (interlace) {
+		    y += pass_step[pass];
+		    while (y >= height && ++pass < 4)
+			y = pass_start[pass];
+		} else {
+		    y++;
+		}
+		row = image + y*width;
 	    }
-	    if (i < pic->pic_cache->numcols)
-		pic->pic_cache->transp = i;
 	}
 
-	return stat;
+	/* skip anything left of the raster */
+	while (GetDataBlock(fd, block) > 0)
+		;
+	return True;
 }
 
 static Boolean
@@ -256,7 +400,7 @@ DoGIFextension(FILE *fd, int label)
 		break;
 	case 0xfe:		/* Comment Extension */
 		str = "Comment Extension";
-		while (GetDataBlock(fd, buf) != 0) {
+		while (GetDataBlock(fd, buf) > 0) {
 			; /* GIF comment */
 		}
 		return False;
@@ -269,7 +413,7 @@ DoGIFextension(FILE *fd, int label)
 		if ((buf[0] & 0x1) != 0)
 			Gif89.transparent = buf[3];
 
-		while (GetDataBlock(fd, buf) != 0)
+		while (GetDataBlock(fd, buf) > 0)
 			;
 		return False;
 	default:
@@ -281,7 +425,7 @@ DoGIFextension(FILE *fd, int label)
 	if (appres.DEBUG)
 		fprintf(stderr,"got a '%s' extension\n", str );
 
-	while (GetDataBlock(fd, buf) != 0)
+	while (GetDataBlock(fd, buf) > 0)
 		;
 
 	return False;
@@ -214,6 +214,7 @@ read_JPEG_file (FILE *file)
 	  (void) jpeg_read_scanlines(&cinfo, buffer, 1);
 	  for (i = 0; i < row_stride; i++)
 		*bitmapptr++ = (unsigned char) buffer[0][i];
+	  picture_progress();
 	}
 
 	/* Step 7: fill up the colortable in the pict object */
@@ -28,6 +28,7 @@
 
 #include "d_spline.h"
 #include "u_free.h"
+#include "u_pool.h"
 
 /*******    Fig 1.3 subtype of objects	  *******/
 #define			DRAW_ELLIPSE_BY_RAD	1
@@ -164,7 +165,7 @@ read_1_3_arcobject(FILE *fp)
     a->type = T_OPEN_ARC;
     if (n != 17) {
 	file_msg("Incomplete arc data");
-	free((char *) a);
+	pool_free(&arc_pool, a);
 	return (NULL);
     }
     if (f) {
@@ -306,7 +307,7 @@ read_1_3_ellipseobject(FILE *fp)
 	       &e->end.x, &e->end.y);
     if (n != 13) {
 	file_msg("Incomplete ellipse data");
-	free((char *) e);
+	pool_free(&ellipse_pool, e);
 	return (NULL);
     }
     if (t == DRAW_ELLIPSE_BY_RAD)
@@ -340,7 +341,7 @@ read_1_3_lineobject(FILE *fp)
     l->back_arrow = NULL;
     l->next = NULL;
     if ((p = create_point()) == NULL) {
-	free((char *) l);
+	pool_free(&line_pool, l);
 	return (NULL);
     }
     l->points = p;
@@ -349,7 +350,7 @@ read_1_3_lineobject(FILE *fp)
 	       &f, &b, &h, &w, &p->x, &p->y);
     if (n != 10) {
 	file_msg("Incomplete line data");
-	free((char *) l);
+	pool_free(&line_pool, l);
 	return (NULL);
     }
     if (t == DRAW_POLYLINE)
@@ -407,7 +408,7 @@ read_1_3_splineobject(FILE *fp)
     s->sfactors = NULL;
     s->next = NULL;
     if ((p = create_point()) == NULL) {
-	free((char *) s);
+	pool_free(&spline_pool, s);
 	return (NULL);
     }
     s->points = p;
@@ -417,7 +418,7 @@ read_1_3_splineobject(FILE *fp)
 	       &h, &w, &p->x, &p->y);
     if (n != 10) {
 	file_msg("Incomplete spline data");
-	free((char *) s);
+	pool_free(&spline_pool, s);
 	return (NULL);
     }
     if (t == DRAW_CLOSEDSPLINE)
@@ -456,7 +457,7 @@ read_1_3_splineobject(FILE *fp)
 				  has the same coordinates) */
 	F_point *ptr =s->points;
 	s->points=s->points->next;
-	free(ptr);
+	pool_free(&point_pool, ptr);
     }
     if (! make_sfactors(s)) {
 	free_splinestorage(s);
@@ -491,11 +492,11 @@ read_1_3_textobject(FILE *fp)
 		&t->base_x, &t->base_y, buf);
     if (n != 8) {
 	file_msg("Incomplete text data");
-	free((char *) t);
+	pool_free(&text_pool, t);
 	return (NULL);
     }
     if ((t->cstring = new_string(strlen(buf))) == NULL) {
-	free((char *) t);
+	pool_free(&text_pool, t);
 	file_msg("Empty text string at line %d.", line_no);
 	return (NULL);
     }
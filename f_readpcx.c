@@ -52,9 +52,19 @@ struct pcxhed
   };  /* palette info is after image data */
 
 
+/* the file is read through our own buffer, a block at a time */
+struct pcxin {
+	FILE	*file;
+	int	 pos, len;
+	byte	 buf[16384];
+  };
+
+#define pcx_getc(in)	((in)->pos < (in)->len ? (in)->buf[(in)->pos++] : pcx_fill(in))
+
 /* prototypes */
-void dispbyte(unsigned char *ptr,int *xp,int *yp,int c,int w,int h,
-              int real_bpp,int byteline,int *planep,int *pmaskp);
+static int	pcx_fill(struct pcxin *in);
+static int	pcx_read(struct pcxin *in, byte *buf, int n);
+static void	pcx_row(byte *dst, byte *line, int w, int byteline, int real_bpp);
 
 int	_read_pcx(FILE *pcxfile, F_pic *pic);
 
@@ -93,21 +103,19 @@ read_pcx(FILE *file, int filetype, F_pic *pic)
    file (actually a pipe).
 */
 
-void pcx_decode();
-
 int _read_pcx(FILE *pcxfile, F_pic *pic)
 {
-	int		 i,w,h,bytepp,x,y,yy,byteline,plane,pmask;
-	unsigned char	*pal;
+	int		 i,w,h,bytepp,x,y,byteline,nbytes,n,k;
+	byte		*line, pal[768];
 	struct pcxhed	 header;
-	int		 count, cnt;
-	long		 bytemax,bytesdone;
-	byte		 inbyte;
+	struct pcxin	 in;
+	int		 c, run, runval;
 	int		 real_bpp;		/* how many bpp file really is */
 
 	pic->pic_cache->bitmap=NULL;
 
-	fread(&header,1,sizeof(struct pcxhed),pcxfile);
+	if (fread(&header,1,sizeof(struct pcxhed),pcxfile) != sizeof(struct pcxhed))
+	    return FileInvalid;
 	if (header.manuf!=10 || header.encod!=1)
 	    return FileInvalid;
 
@@ -142,52 +150,55 @@ int _read_pcx(FILE *pcxfile, F_pic *pic)
 	if (!real_bpp)
 	    return FileInvalid;
 
-	if ((pal=calloc(768,1))==NULL)
-	    return FileInvalid;
-
 	w=(header.x2lo+256*header.x2hi)-(header.x1lo+256*header.x1hi)+1;
 	h=(header.y2lo+256*header.y2hi)-(header.y1lo+256*header.y1hi)+1;
 	byteline=header.bytelinelo+256*header.bytelinehi;
 
-	if (w==0 || h==0)
+	/* each plane of a scan line must hold a whole row */
+	if (w<=0 || h<=0 || byteline < (w*header.bpp+7)/8 || w > INT_MAX/3/(h+2))
 	    return FileInvalid;
 
-	x=0; y=0;
-	bytemax=w*h;
-	if (real_bpp==1 || real_bpp==4)
-	    bytemax=(1<<30);	/* we use a 'y<h' test instead for these files */
-
-	if ((pic->pic_cache->bitmap=malloc(w*(h+2)*bytepp))==NULL)
+	/* one scan line, all planes */
+	nbytes = byteline*header.nplanes;
+	if ((line=malloc(nbytes))==NULL)
 	    return FileInvalid;
-
-	/* need this if more than one bitplane */
+	if ((pic->pic_cache->bitmap=malloc(w*(h+2)*bytepp))==NULL) {
+	    free(line);
+	    return FileInvalid;
+	}
+	/* rows missing at the end of a short file stay 0 */
 	memset(pic->pic_cache->bitmap,0,w*h*bytepp);
 
-	bytesdone=0;
-
-	/* start reading image */
-	for (yy=0; yy<h; yy++) {
-	  plane = 0;
-	  pmask = 1;
-	  
-	  y = yy;
-	  x = 0;
-	  while (y == yy) {
-	    inbyte=fgetc(pcxfile);
-	    if ((inbyte & 0xC0) != 0xC0) {
-	      dispbyte(pic->pic_cache->bitmap,&x,&y,inbyte,w,h,real_bpp,
-		byteline,&plane,&pmask);
-	      bytesdone++;
-	    } else {
-	      cnt = inbyte & 0x3F;
-	      inbyte = fgetc(pcxfile);
-	      for (count=0; count<cnt; count++)
-		dispbyte(pic->pic_cache->bitmap,&x,&y,inbyte,w,h,real_bpp,
-			byteline,&plane,&pmask);
-	      bytesdone += cnt;
+	/* start reading image, a scan line at a time.  A run may go on from
+	   the end of one scan line into the next. */
+	in.file = pcxfile;
+	in.pos = in.len = 0;
+	run = runval = 0;
+	for (y=0; y<h; y++) {
+	    picture_progress();
+	    for (n=0; n<nbytes; n+=k) {
+		if (run == 0) {
+		    if ((c = pcx_getc(&in)) == EOF)
+			break;
+		    if ((c & 0xC0) != 0xC0) {
+			/* a single byte */
+			line[n] = c;
+			k = 1;
+			continue;
+		    }
+		    run = c & 0x3F;
+		    if ((runval = pcx_getc(&in)) == EOF)
+			break;
+		}
+		k = min2(run, nbytes-n);
+		memset(line+n, runval, k);
+		run -= k;
 	    }
-	  }
+	    if (n < nbytes)
+		break;
+	    pcx_row((byte *) pic->pic_cache->bitmap + y*w*bytepp, line, w, byteline, real_bpp);
 	}
+	free(line);
 
 	pic->pic_cache->bit_size.x = w;
 	pic->pic_cache->bit_size.y = h;
@@ -213,12 +224,17 @@ int _read_pcx(FILE *pcxfile, F_pic *pic)
 		break;
 
 	    case 8:
-		/* 8-bit */
-		fseek(pcxfile, -768L, SEEK_END);/* locate colormap in last 768 bytes of file */
+		/* 8-bit, the colormap follows the image data after a byte of 12.
+		   If it isn't there, it is in the last 768 bytes of the file. */
+		if (pcx_getc(&in) != 12 || pcx_read(&in, pal, 768) != 768) {
+		    memset(pal, 0, 768);
+		    fseek(pcxfile, -768L, SEEK_END);
+		    fread(pal, 1, 768, pcxfile);
+		}
 		for (x=0; x<256; x++) {
-		    pic->pic_cache->cmap[x].red   = fgetc(pcxfile);
-		    pic->pic_cache->cmap[x].green = fgetc(pcxfile);
-		    pic->pic_cache->cmap[x].blue  = fgetc(pcxfile);
+		    pic->pic_cache->cmap[x].red   = pal[x*3  ];
+		    pic->pic_cache->cmap[x].green = pal[x*3+1];
+		    pic->pic_cache->cmap[x].blue  = pal[x*3+2];
 		}
 		/* start with 256 */
 		pic->pic_cache->numcols = 256;
@@ -242,81 +258,75 @@ int _read_pcx(FILE *pcxfile, F_pic *pic)
 	return PicSuccess;  
 }
 
+/* refill the buffer and return its first byte, or EOF */
+
+static int
+pcx_fill(struct pcxin *in)
+{
+	in->len = fread(in->buf, 1, sizeof(in->buf), in->file);
+	in->pos = 0;
+	if (in->len <= 0) {
+	    in->len = 0;
+	    return EOF;
+	}
+	return in->buf[in->pos++];
+}
+
+/* read up to n bytes into buf, return how many there were */
 
-void
-dispbyte(unsigned char *ptr,int *xp,int *yp,int c,int w,int h,
-              int real_bpp,int byteline,int *planep,int *pmaskp)
+static int
+pcx_read(struct pcxin *in, byte *buf, int n)
 {
-	int f;
-	unsigned char *dstptr;
+	int	 i, c;
+
+	for (i=0; i<n && (c = pcx_getc(in)) != EOF; i++)
+	    buf[i] = c;
+	return i;
+}
+
+/*
+ * Put the w pixels of a decoded scan line into the bitmap row dst.
+ * The planes of the scan line are byteline bytes each.  Pixels of 1 to 4
+ * bits are one bit in each plane and become one byte; 24-bit pixels are
+ * a red, a green and a blue plane byte and become blue, green, red bytes.
+ */
+
+static void
+pcx_row(byte *dst, byte *line, int w, int byteline, int real_bpp)
+{
+	int	 x, plane, pix;
+	byte	 mask, *src;
 
 	switch(real_bpp) {
 	  case 1:
+		for (x=0; x<w; x++)
+		    dst[x] = (line[x>>3] >> (7-(x&7))) & 1;
+		break;
+
 	  case 2:
 	  case 3:
 	  case 4:
-		/* mono or 4-bit */
-
-		if ((*yp)>=h)
-		    return;
-
-		dstptr=ptr+(*yp)*w+*xp;
-		w=byteline*8;
-
-		for (f=0; f<8; f++) {
-		   *dstptr++|=(c&(0x80>>(f&7)))?(*pmaskp):0;
-		   (*xp)++;
-		   if (*xp>=w) {
-			if (real_bpp==1) {
-			    (*xp)=0,(*yp)++;
-			    return;
-			}
-			(*xp)=0;
-			(*planep)++;
-			(*pmaskp)<<=1;
-			if (real_bpp==2) {
-			    if (*planep==2) {
-				(*yp)++;
-				return;
-			    }
-			} else if (real_bpp==3) {
-			    if (*planep==3) {
-				(*yp)++;
-				return;
-			    }
-			} else {
-			    /* otherwise, it's 4 bpp */
-			    if (*planep==4) {
-				(*yp)++;
-				return;
-			    }
-			}
-		    }
-		    if ((*yp)>=h)
-			return;
+		for (x=0; x<w; x++) {
+		    mask = 0x80 >> (x&7);
+		    src = line + (x>>3);
+		    pix = 0;
+		    for (plane=0; plane<real_bpp; plane++, src+=byteline)
+			if (*src & mask)
+			    pix |= 1<<plane;
+		    dst[x] = pix;
 		}
 		break;
-	  
+
 	  case 8:
-		*(ptr+(*yp)*w+*xp)=c;
-		(*xp)++;
-		if (*xp>=byteline) {
-		    (*xp)=0;
-		    (*yp)++;
-		}
+		memcpy(dst, line, w);
 		break;
-	  
+
 	  case 24:
-		*(ptr+((*yp)*w+*xp)*3+(2-(*planep)))=c;
-		(*xp)++;
-		if (*xp>=byteline) {
-		    (*xp)=0;
-		    (*planep)++; /* no need to change pmask */
-		    if (*planep==3) {
-			(*yp)++;
-			return;
-		    }
+		for (x=0; x<w; x++) {
+		    *dst++ = line[2*byteline+x];	/* blue */
+		    *dst++ = line[byteline+x];		/* green */
+		    *dst++ = line[x];			/* red */
 		}
 		break;
-	  }
+	}
 }
@@ -1,2 +1,2 @@
 extern int read_pcx (FILE *file, int filetype, F_pic *pic);
-extern int read_pcx (FILE *file, int filetype, F_pic *pic);
+extern int _read_pcx (FILE *pcxfile, F_pic *pic);
@@ -42,6 +42,7 @@ read_png(FILE *file, int filetype, F_pic *pic)
     png_bytep	   *row_pointers;
     char	   *ptr;
     int		    num_palette;
+    int		    pass, passes;
     png_colorp	    palette;
     png_color_16    background;
 
@@ -170,8 +171,14 @@ read_png(FILE *file, int filetype, F_pic *pic)
 	}
     }
 
-    /* finally, read the file */
-    png_read_image(png_ptr, row_pointers);
+    /* finally, read the file, a row at a time (all of them in each pass
+       of an interlaced one) */
+    passes = png_set_interlace_handling(png_ptr);
+    for (pass=0; pass<passes; pass++)
+	for (i=0; i<h; i++) {
+	    png_read_row(png_ptr, row_pointers[i], (png_bytep) NULL);
+	    picture_progress();
+	}
 
     /* allocate the bitmap */
     if ((pic->pic_cache->bitmap=malloc(rowsize*h))==NULL) {
@@ -17,49 +17,204 @@
 #include "resources.h"
 #include "object.h"
 #include "f_picobj.h"
+#include "f_util.h"
 #include "w_msgpanel.h"
+#include "w_setup.h"
 
-#include "f_readpcx.h"
-
-#define BUFLEN 1024
+static int	ppm_int(FILE *file);
+static Boolean	ppm_palette(F_pic *pic);
 
 /* return codes:  PicSuccess (1) : success
 		  FileInvalid (-2) : invalid file
-*/
-
 
+   Plain (P2, P3) and raw (P5, P6) PGM and PPM files are read here.  The
+   pixels go into pic_cache->bitmap as blue, green, red bytes like those of
+   a 24-bit PCX file, and are then turned into colormap indices, exactly if
+   there are no more than 256 colors and with map_to_palette() otherwise.
+*/
 
 int
 read_ppm(FILE *file, int filetype, F_pic *pic)
 {
-	char	 buf[BUFLEN],pcxname[PATH_MAX];
-	FILE	*giftopcx;
-	int	 stat, size;
-
-	/* make name for temp output file */
-	sprintf(pcxname, "%s/%s%06d.pix", TMPDIR, "xfig-pcx", getpid());
-	/* make command to convert gif to pcx into temp file */
-	sprintf(buf, "ppmtopcx > %s 2> /dev/null", pcxname);
-	if ((giftopcx = popen(buf,"w" )) == 0) {
-	    file_msg("Cannot open pipe to ppmtopcx\n");
+	unsigned char	*bitmap, *p;
+	static unsigned char scale_val[65536];
+	int		 kind, w, h, maxval, x, y, i, c, v[3];
+	Boolean		 gray, raw;
+
+	/* make scale factor smaller for metric */
+	float scale = (appres.INCHES ?
+			(float)PIX_PER_INCH :
+			2.54*PIX_PER_CM)/(float)DISPLAY_PIX_PER_INCH;
+
+	pic->pic_cache->bitmap = NULL;
+
+	if (getc(file) != 'P') {
+	    close_picfile(file,filetype);
+	    return FileInvalid;
+	}
+	kind = getc(file);
+	if (kind != '2' && kind != '3' && kind != '5' && kind != '6') {
+	    close_picfile(file,filetype);
+	    return FileInvalid;
+	}
+	gray = (kind == '2' || kind == '5');
+	raw = (kind == '5' || kind == '6');
+
+	w = ppm_int(file);
+	h = ppm_int(file);
+	maxval = ppm_int(file);
+	if (w <= 0 || h <= 0 || maxval <= 0 || maxval > 65535 ||
+	    w > INT_MAX / 3 / h) {
+	    close_picfile(file,filetype);
+	    return FileInvalid;
+	}
+	/* exactly one white space character separates the header from raw data */
+	if (raw && !isspace(getc(file))) {
+	    close_picfile(file,filetype);
+	    return FileInvalid;
+	}
+
+	if ((bitmap = (unsigned char *) malloc(w*h*3)) == NULL) {
+	    file_msg("Out of memory reading PPM image");
 	    close_picfile(file,filetype);
 	    return FileInvalid;
 	}
-	while ((size=fread(buf, 1, BUFLEN, file)) != 0) {
-	    fwrite(buf, size, 1, giftopcx);
+
+	/* sample values scaled to 0..255 */
+	for (i=0; i<=maxval; i++)
+	    scale_val[i] = (i*255 + maxval/2) / maxval;
+
+	p = bitmap;
+	for (y=0; y<h; y++) {
+	    picture_progress();
+	    for (x=0; x<w; x++) {
+		for (i=0; i < (gray? 1: 3); i++) {
+		    if (!raw) {
+			c = ppm_int(file);
+		    } else {
+			c = getc(file);
+			if (maxval > 255 && c != EOF)
+			    c = (c << 8) | getc(file);
+		    }
+		    if (c < 0) {
+			free(bitmap);
+			close_picfile(file,filetype);
+			return FileInvalid;
+		    }
+		    v[i] = scale_val[min2(c, maxval)];
+		}
+		if (gray)
+		    v[1] = v[2] = v[0];
+		*p++ = v[2];
+		*p++ = v[1];
+		*p++ = v[0];
+	    }
 	}
-	/* close pipe */
-	pclose(giftopcx);
-	if ((giftopcx = fopen(pcxname, "rb")) == NULL) {
-	    file_msg("Can't open temp output file\n");
+
+	pic->pic_cache->bitmap = (char *) bitmap;
+	pic->pic_cache->bit_size.x = w;
+	pic->pic_cache->bit_size.y = h;
+	if (!ppm_palette(pic) && !map_to_palette(pic)) {
+	    pic->pic_cache->bitmap = NULL;
 	    close_picfile(file,filetype);
 	    return FileInvalid;
 	}
-	/* now call read_pcx to read the pcx file */
-	stat = read_pcx(giftopcx, filetype, pic);
+
+	pic->pixmap = None;
+	pic->hw_ratio = (float) h / w;
 	pic->pic_cache->subtype = T_PIC_PPM;
-	/* remove temp file */
-	unlink(pcxname);
+	pic->pic_cache->transp = TRANSP_NONE;
+	pic->pic_cache->size_x = w * scale;
+	pic->pic_cache->size_y = h * scale;
+	/* if monochrome display map bitmap */
+	if (tool_cells <= 2 || appres.monochrome)
+	    map_to_mono(pic);
+
 	close_picfile(file,filetype);
-	return stat;
+	return PicSuccess;
+}
+
+/* read a decimal number from the header or the pixels of a plain file,
+   skipping white space and comments.  Return -1 at EOF or on a bad number. */
+
+static int
+ppm_int(FILE *file)
+{
+	int	c, n;
+
+	for (;;) {
+	    c = getc(file);
+	    if (c == '#') {
+		while ((c = getc(file)) != '\n' && c != EOF)
+		    ;
+	    }
+	    if (c == EOF)
+		return -1;
+	    if (!isspace(c))
+		break;
+	}
+	if (!isdigit(c))
+	    return -1;
+	for (n = 0; isdigit(c); c = getc(file)) {
+	    if (n > (INT_MAX - 9) / 10)
+		return -1;
+	    n = n*10 + c - '0';
+	}
+	/* leave the character after the number for the caller */
+	ungetc(c, file);
+	return n;
+}
+
+/*
+ * Change the 3-byte pixels of pic_cache->bitmap to indices into a colormap of
+ * their colors, if there are no more than 256 of them.  A small hash table of
+ * the colors seen so far is looked up for each run of equal pixels.  Return
+ * False and leave the bitmap alone if there are more colors.
+ */
+
+#define PAL_HASH	1024	/* a power of 2, at least 4 times 256 */
+
+static Boolean
+ppm_palette(F_pic *pic)
+{
+	long		 key[PAL_HASH], k, last;
+	unsigned char	 index[PAL_HASH], *old, *newmap, *p, idx;
+	int		 npix, numcols, i, h;
+
+	for (h=0; h<PAL_HASH; h++)
+	    key[h] = -1;
+	npix = pic->pic_cache->bit_size.x * pic->pic_cache->bit_size.y;
+	if ((newmap = (unsigned char *) malloc(npix)) == NULL)
+	    return False;
+	old = (unsigned char *) pic->pic_cache->bitmap;
+	numcols = 0;
+	last = -1;
+	idx = 0;
+	for (i=0, p=old; i<npix; i++, p+=3) {
+	    k = ((long) p[2] << 16) | (p[1] << 8) | p[0];
+	    if (k != last) {
+		h = (int) ((k * 2654435761UL) >> 8) & (PAL_HASH-1);
+		while (key[h] != -1 && key[h] != k)
+		    h = (h+1) & (PAL_HASH-1);
+		if (key[h] == -1) {
+		    if (numcols == 256) {
+			free(newmap);
+			return False;
+		    }
+		    key[h] = k;
+		    index[h] = numcols;
+		    pic->pic_cache->cmap[numcols].red   = p[2];
+		    pic->pic_cache->cmap[numcols].green = p[1];
+		    pic->pic_cache->cmap[numcols].blue  = p[0];
+		    numcols++;
+		}
+		idx = index[h];
+		last = k;
+	    }
+	    newmap[i] = idx;
+	}
+	pic->pic_cache->numcols = numcols;
+	pic->pic_cache->bitmap = (char *) newmap;
+	free(old);
+	return True;
 }
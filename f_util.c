@@ -216,6 +216,7 @@ static int	  scol, ncolors;
 static int	  num_oldcolors = -1;
 static Boolean	  usenet;
 static int	  npixels;
+static int	  image_cells_used = 0;	/* cells holding colors of the pictures */
 
 #define REMAP_MSG	"Remapping picture colors..."
 #define REMAP_MSG2	"Remapping picture colors...Done"
@@ -243,6 +244,7 @@ void remap_imagecolors(void)
     put_msg(REMAP_MSG);
     set_temp_cursor(wait_cursor);
     app_flush();
+    image_cells_used = 0;
 
     if (ncolors > appres.max_image_colors) {
 	if (appres.DEBUG) 
@@ -338,6 +340,7 @@ void remap_imagecolors(void)
 
 	/* get the new, mapped indices for the image colormap */
 	remap_image_colormap();
+	image_cells_used = avail_image_cols;
     } else {
 	/*
 	 * Extract the RGB values from the image's colormap and allocate
@@ -350,6 +353,7 @@ void remap_imagecolors(void)
 	    image_cells[i].flags = DoRed|DoGreen|DoBlue;
 	}
 	YStoreColors(tool_cm, image_cells, scol);
+	image_cells_used = scol;
 	scol = 0;	/* global color counter */
 	readjust_cmap();
 	if (appres.DEBUG) 
@@ -360,6 +364,48 @@ void remap_imagecolors(void)
     app_flush();
 }
 
+/*
+ * Give each color of a picture read after the others the nearest of the
+ * colorcells those use, so it can be drawn without remapping them all.
+ * Returns False if no cells hold picture colors yet; *exact tells whether
+ * every color was found as it is.
+ */
+
+Boolean
+map_picture_colors(struct _pics *pics, Boolean *exact)
+{
+    int		    i, j, best;
+    long	    d, bestd, dr, dg, db;
+
+    *exact = True;
+    /* if monochrome, there is nothing to map */
+    if (tool_cells <= 2 || appres.monochrome)
+	return True;
+    if (image_cells_used == 0)
+	return False;
+
+    for (i=0; i<pics->numcols; i++) {
+	best = 0;
+	bestd = -1;
+	for (j=0; j<image_cells_used; j++) {
+	    dr = (long) pics->cmap[i].red - (image_cells[j].red >> 8);
+	    dg = (long) pics->cmap[i].green - (image_cells[j].green >> 8);
+	    db = (long) pics->cmap[i].blue - (image_cells[j].blue >> 8);
+	    d = dr*dr + dg*dg + db*db;
+	    if (bestd < 0 || d < bestd) {
+		best = j;
+		bestd = d;
+		if (d == 0)
+		    break;
+	    }
+	}
+	if (bestd != 0)
+	    *exact = False;
+	pics->cmap[i].pixel = image_cells[best].pixel;
+    }
+    return True;
+}
+
 /* allocate the color cells for the pictures */
 
 void alloc_imagecolors(int num)
@@ -378,6 +424,7 @@ void alloc_imagecolors(int num)
 }
 
 /* count the number of colors in all the pictures in the picture repository */
+/* (a picture whose bitmap was freed to save memory keeps its colors) */
 
 int
 count_colors(void)
@@ -387,7 +434,7 @@ count_colors(void)
 
     ncolors = 0;
     for (pics = pictures; pics; pics = pics->next)
-	if (pics->bitmap != NULL)
+	if (pics->bitmap != NULL || pics->dropped)
 		ncolors += pics->numcols;
     return ncolors;
 }
@@ -412,7 +459,7 @@ void readjust_cmap(void)
 
     /* first adjust the colormaps in the repository */
     for (pics = pictures; pics; pics = pics->next)
-	if (pics->bitmap != NULL && pics->numcols > 0) {
+	if ((pics->bitmap != NULL || pics->dropped) && pics->numcols > 0) {
 	    for (i=0; i<pics->numcols; i++) {
 		j = pics->cmap[i].pixel;
 		pics->cmap[i].pixel = image_cells[j].pixel;
@@ -455,7 +502,7 @@ void extract_cmap(void)
 
     /* extract the colormaps in the repository */
     for (pics = pictures; pics; pics = pics->next)
-	if (pics->bitmap != NULL && pics->numcols > 0) {
+	if ((pics->bitmap != NULL || pics->dropped) && pics->numcols > 0) {
 	    for (i=0; i<pics->numcols; i++) {
 		image_cells[scol].red   = pics->cmap[i].red << 8;
 		image_cells[scol].green = pics->cmap[i].green << 8;
@@ -500,7 +547,7 @@ void remap_image_colormap(void)
     int		   p;
 
     for (pics = pictures; pics; pics = pics->next)
-	if (pics->bitmap != NULL && pics->numcols > 0) {
+	if ((pics->bitmap != NULL || pics->dropped) && pics->numcols > 0) {
 	    for (i=0; i<pics->numcols; i++) {
 		/* real color from the image */
 		col[N_RED] = pics->cmap[i].red;
@@ -40,6 +40,7 @@ extern int emptyname_msg (char *name, char *msg);
 extern int get_directory (char *direct);
 extern int ok_to_write (char *file_name, char *op_name);
 extern void remap_imagecolors (void);
+extern Boolean map_picture_colors (struct _pics *pics, Boolean *exact);
 extern void update_recent_files (void);
 extern void update_xfigrc (char *name, char *string);
 int		update_fig_files(int argc, char** argv);
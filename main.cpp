@@ -120,6 +120,7 @@ static XtActionsRec	main_actions[] =
     {"PopupCharmap",	(XtActionProc) popup_character_map},
     {"PopupGlobals",	(XtActionProc) show_global_settings},
     {"Undo",		(XtActionProc) undo},
+    {"Redo",		(XtActionProc) redo},
     {"Paste",		(XtActionProc) paste},
     {"SpellCheck",	(XtActionProc) spell_check},
     {"Search",		(XtActionProc) popup_search_panel},
@@ -229,6 +230,8 @@ static XtResource application_resources[] = {
       XtOffset(appresPtr, but_per_row), XtRImmediate, (caddr_t) 0},
     {"max_image_colors", "Max_image_colors", XtRInt, sizeof(int),
       XtOffset(appresPtr, max_image_colors), XtRImmediate, (caddr_t) 0},
+    {"picture_memory", "Picture_memory", XtRInt, sizeof(int),
+      XtOffset(appresPtr, picture_memory), XtRImmediate, (caddr_t) 0},
     {"installowncmap", "Installcmap", XtRBoolean, sizeof(Boolean),
       XtOffset(appresPtr, installowncmap), XtRBoolean, (caddr_t) & FAlse},
     {"dontswitchcmap", "Dontswitchcmap", XtRBoolean, sizeof(Boolean),
@@ -257,6 +260,8 @@ static XtResource application_resources[] = {
       XtOffset(appresPtr, jpeg_quality), XtRImmediate, (caddr_t) 0},
     {"transparent", "Transparent", XtRInt, sizeof(int),
       XtOffset(appresPtr, transparent), XtRImmediate, (caddr_t) TRANSP_NONE },
+    {"undo_memory", "Undo_memory", XtRInt, sizeof(int),
+      XtOffset(appresPtr, undo_memory), XtRImmediate, (caddr_t) 0},
     {"library_dir", "Directory", XtRString, sizeof(char *),
       XtOffset(appresPtr, library_dir), XtRString, (caddr_t) OBJLIBDIR},
     {"debug", "Debug",   XtRBoolean, sizeof(Boolean),
@@ -415,6 +420,7 @@ XrmOptionDescRec options[] =
     {"-pageborder", ".pageborder", XrmoptionSepArg, (caddr_t) NULL},
     {"-paper_size", ".paper_size", XrmoptionSepArg, (caddr_t) NULL},
     {"-pheight", ".pheight", XrmoptionSepArg, 0},
+    {"-picture_memory", ".picture_memory", XrmoptionSepArg, 0},
     {"-Portrait", ".landscape", XrmoptionNoArg, "False"},
     {"-portrait", ".landscape", XrmoptionNoArg, "False"},
     {"-pwidth", ".pwidth", XrmoptionSepArg, 0},
@@ -453,6 +459,7 @@ XrmOptionDescRec options[] =
     {"-tablet", ".tablet", XrmoptionNoArg, "True"},
     {"-track", ".trackCursor", XrmoptionNoArg, "True"},
     {"-transparent_color", ".transparent", XrmoptionSepArg, 0},
+    {"-undo_memory", ".undo_memory", XrmoptionSepArg, 0},
     {"-userscale", ".userscale", XrmoptionSepArg, 0},
     {"-write_v40", ".write_v40", XrmoptionNoArg, "True"},
     {"-userunit", ".userunit", XrmoptionSepArg, 0},
@@ -525,6 +532,7 @@ char *help_list[] = {
 	"[-pageborder <color>] ",
 	"[-paper_size <size>] ",
 	"[-pheight <height>] ",
+	"[-picture_memory <Kbytes>] ",
 	"[-portrait] ",
 	"[-pwidth <width>] ",
 	"[-right] ",
@@ -557,6 +565,7 @@ char *help_list[] = {
 	"[-tablet] ",
 	"[-track] ",
 	"[-transparent_color <color number>] ",
+	"[-undo_memory <Kbytes>] ",
 	"[-update file1 file2 ...] ",
 	"[-userscale <scale>] ",
 	"[-userunit <units>] ",
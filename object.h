@@ -116,6 +116,11 @@ struct _pics {
 	        int	      numcols;		/* number of colors in cmap */
 	        int	      transp;		/* transparent color (TRANSP_NONE if none) for GIFs */
 		int	      refcount;		/* number of references to picture */
+		long	      bytes;		/* memory held by bitmap */
+		Boolean	      dropped;		/* bitmap freed to save memory, read again when needed */
+		Boolean	      pending;		/* still being read in the background */
+		unsigned long drawn;		/* redisplay pass it was last drawn in */
+		struct _pics *hnext;		/* hash chain of repository */
 		struct _pics *prev;
 		struct _pics *next;
 	     };
@@ -143,6 +148,22 @@ typedef struct f_arrow {
     float	    ht;
 }
 	F_arrow;
+
+/*
+ * Bounds of an object, kept with the values they were computed from so
+ * that any change to the object is noticed (u_bound.c).  Lines and
+ * splines only need them for their arrowheads, so theirs are allocated
+ * the first time they have some.
+ */
+
+#define		BOUND_KEY	24
+
+typedef struct f_bound {
+    int		    nkey;		/* 0 if not computed yet */
+    int		    key[BOUND_KEY];
+    int		    xmin, ymin, xmax, ymax;
+}
+	F_bound;
 
 /******************/
 /* Ellipse object */
@@ -173,6 +194,8 @@ typedef struct f_ellipse {
     struct f_pos    end;
     char	   *comments;
     struct f_ellipse *next;
+    struct f_ellipse *prev;	/* back link, checked before use (u_list.c) */
+    F_bound	    bound;	/* cached bounds (u_bound.c) */
 }
 	F_ellipse;
 
@@ -216,6 +239,8 @@ typedef struct f_arc {
     struct f_pos    point[3];
     char	   *comments;
     struct f_arc   *next;
+    struct f_arc   *prev;	/* back link, checked before use (u_list.c) */
+    F_bound	    bound;	/* cached bounds (u_bound.c) */
 }
 	F_arc;
 
@@ -285,6 +310,10 @@ typedef struct f_line {
     F_pic   	   *pic;	/* picture object, if type = T_PICTURE */
     char	   *comments;
     struct f_line  *next;
+    struct f_line  *prev;	/* back link, checked before use (u_list.c) */
+    F_bound	   *bound;	/* cached bounds with arrowheads, or NULL */
+    struct vx_index *vindex;	/* grids over the points when there are many
+				   (u_vindex.c), or NULL */
 }
 	F_line;
 
@@ -322,6 +351,9 @@ typedef struct f_text {
     char	   *cstring;
     char	   *comments;
     struct f_text  *next;
+    struct f_text  *prev;	/* back link, checked before use (u_list.c) */
+    F_bound	    bound;	/* cached bounds and ... */
+    int		    bound_corners[8];	/* ... corners (u_bound.c) */
 }
 	F_text;
 
@@ -400,6 +432,11 @@ typedef struct f_spline {
     struct f_shape *sfactors;
     char	   *comments;
     struct f_spline *next;
+    struct f_spline_cache *cache;	/* flattened curve, see u_draw.c */
+    struct f_spline *prev;	/* back link, checked before use (u_list.c) */
+    F_bound	   *bound;	/* cached bounds with arrowheads, or NULL */
+    struct vx_index *vindex;	/* grids over the points when there are many
+				   (u_vindex.c), or NULL */
 }
 	F_spline;
 
@@ -433,6 +470,11 @@ typedef struct f_compound {
     Boolean	       draw_parent;
     struct f_compound *compounds;
     struct f_compound *next;
+    struct f_compound *prev;	/* back link, checked before use (u_list.c) */
+    struct f_compound *shared;	/* next compound sharing these objects, in a
+				   ring; NULL if they're not shared (u_create.c) */
+    int		       bound_key;	/* grid the corners were rounded to, 0 if
+				   they must be recomputed (u_bound.c) */
 }
 	F_compound;
 
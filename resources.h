@@ -209,6 +209,7 @@ typedef struct _appres {
     int		 papersize;		/* size of paper */
     Boolean	 RHS_PANEL;
     char	*pdf_viewer;		/* viewer for pdf docs */
+    int		 picture_memory;	/* Kbytes of decoded pictures kept in memory */
     int		 rulerthick;		/* thickness of rulers */
     Boolean	 scalablefonts;		/* whether user wants scalable fonts or not */
     Boolean	 showallbuttons;
@@ -239,6 +240,7 @@ typedef struct _appres {
     Boolean	 tracking;		/* mouse tracking in rulers */
     int		 transparent;		/* transparent color for GIF export
 						(-2=none, -1=background) */
+    int		 undo_memory;		/* Kbytes of saved objects kept for undo */
     float	 userscale;		/* scale screen units to user units */
     char	*userunit;		/* user defined unit name */
     float	 zoom;			/* starting zoom scale */
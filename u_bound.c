@@ -21,6 +21,7 @@
 #include "mode.h"
 #include "paintop.h"
 #include "u_bound.h"
+#include "u_undo.h"
 #include "w_drawprim.h"
 #include "w_file.h"
 #include "w_setup.h"
@@ -43,6 +44,122 @@ static void	points_bound(F_point *points, int half_wd, int *xmin, int *ymin, int
 static void	general_spline_bound(F_spline *s, int *xmin, int *ymin, int *xmax, int *ymax);
 static void	approx_spline_bound(F_spline *s, int *xmin, int *ymin, int *xmax, int *ymax);
 static void arrow_bound(int objtype, F_line *obj, int *xmin, int *ymin, int *xmax, int *ymax);
+static void	angle_ellipse_bound(F_ellipse *e, int *xmin, int *ymin, int *xmax, int *ymax);
+static void	corners_text_bound(F_text *t, int *xmin, int *ymin, int *xmax, int *ymax, int *rx1, int *ry1, int *rx2, int *ry2, int *rx3, int *ry3, int *rx4, int *ry4);
+
+/*
+ * The bounds of each object are kept in its F_bound along with a key made
+ * of everything they were computed from: the extent of the points, the
+ * thickness, the ends and arrowheads, the zoom factor and so on.  The key
+ * is rebuilt and compared on each call, so an object edited in place gets
+ * new bounds without its editors having to say so, and the expensive part
+ * (arrowheads, the trigonometry of arcs, ellipses and texts) is only done
+ * when something changed.  With appres.DEBUG set the bounds are always
+ * recomputed so that they are drawn.
+ */
+
+long		bound_hits = 0;		/* for xfig-bench */
+long		bound_misses = 0;
+
+static int	key[BOUND_KEY];
+static int	nkey;
+
+static void
+key_int(int v)
+{
+    key[nkey++] = v;
+}
+
+static void
+key_float(float f)
+{
+    union {
+	float	f;
+	int	i;
+    } u;
+
+    u.i = 0;
+    u.f = f;
+    key[nkey++] = u.i;
+}
+
+static void
+key_arrow(F_arrow *a)
+{
+    if (a == NULL) {
+	key_int(-1);
+	return;
+    }
+    key_int(a->type);
+    key_int(a->style);
+    key_float(a->thickness);
+    key_float(a->wd);
+    key_float(a->ht);
+}
+
+/* add the arrowheads of a line or spline and the points they sit on */
+
+static void
+key_arrows(F_line *obj)
+{
+    F_point	   *p, *q;
+
+    key_arrow(obj->for_arrow);
+    if (obj->for_arrow) {
+	for (q = p = obj->points; p->next; p = p->next)
+	    q = p;
+	key_int(q->x);
+	key_int(q->y);
+	key_int(p->x);
+	key_int(p->y);
+    }
+    key_arrow(obj->back_arrow);
+    if (obj->back_arrow) {
+	key_int(obj->points->x);
+	key_int(obj->points->y);
+	key_int(obj->points->next->x);
+	key_int(obj->points->next->y);
+    }
+}
+
+/* return True and the kept bounds in b if they were computed from the key */
+
+static Boolean
+kept_bound(F_bound *b, int *xmin, int *ymin, int *xmax, int *ymax)
+{
+    if (appres.DEBUG || b->nkey != nkey ||
+	bcmp((char *) b->key, (char *) key, nkey * sizeof(int)) != 0) {
+	    bound_misses++;
+	    return False;
+    }
+    bound_hits++;
+    *xmin = b->xmin;
+    *ymin = b->ymin;
+    *xmax = b->xmax;
+    *ymax = b->ymax;
+    return True;
+}
+
+static void
+keep_bound(F_bound *b, int xmin, int ymin, int xmax, int ymax)
+{
+    b->nkey = nkey;
+    bcopy((char *) key, (char *) b->key, nkey * sizeof(int));
+    b->xmin = xmin;
+    b->ymin = ymin;
+    b->xmax = xmax;
+    b->ymax = ymax;
+}
+
+/* the kept bounds of a line or spline, allocated the first time they're needed */
+
+static F_bound *
+alloc_bound(F_bound **b)
+{
+    if (*b == NULL && (*b = (F_bound *) malloc(sizeof(F_bound))) != NULL)
+	(*b)->nkey = 0;
+    return *b;
+}
 
 void arc_bound(F_arc *arc, int *xmin, int *ymin, int *xmax, int *ymax)
 {
@@ -51,6 +168,22 @@ void arc_bound(F_arc *arc, int *xmin, int *ymin, int *xmax, int *ymax)
     int		    bx, by, sx, sy;
     int		    half_wd;
 
+    nkey = 0;
+    key_int(arc->type);
+    key_int(arc->direction);
+    key_int(arc->thickness);
+    key_float(ZOOM_FACTOR);
+    key_float(arc->center.x);
+    key_float(arc->center.y);
+    for (bx = 0; bx < 3; bx++) {
+	key_int(arc->point[bx].x);
+	key_int(arc->point[bx].y);
+    }
+    key_arrow(arc->for_arrow);
+    key_arrow(arc->back_arrow);
+    if (kept_bound(&arc->bound, xmin, ymin, xmax, ymax))
+	return;
+
     dx = arc->point[0].x - arc->center.x;
     dy = arc->center.y - arc->point[0].y;
     if (dx==0.0)
@@ -155,6 +288,46 @@ void arc_bound(F_arc *arc, int *xmin, int *ymin, int *xmax, int *ymax)
 
     /* now add in the arrow (if any) boundaries */
     arrow_bound(O_ARC, (F_line *)arc, xmin, ymin, xmax, ymax);
+    keep_bound(&arc->bound, *xmin, *ymin, *xmax, *ymax);
+}
+
+/*
+ * The corners of a compound are kept as its bounds, so compound_bound()
+ * only goes through the objects inside when the compound has changed.
+ * bound_key is the grid step the corners were rounded to, or 0 if they
+ * must be recomputed; the edits of a compound call
+ * invalidate_compound_bound() on it.  The figure
+ * and saved_objects are changed by the list routines, so their bounds
+ * are never kept.
+ */
+
+static int
+grid_step(void)
+{
+    if (cur_pointposn == P_ANY)
+	return 1;
+    return posn_rnd[cur_gridunit][cur_pointposn];
+}
+
+#define	keeps_bound(c)	((c) != &objects && (c) != &saved_objects)
+
+void invalidate_compound_bound(F_compound *compound)
+{
+    compound->bound_key = 0;
+}
+
+/*
+ * Move the corners with the compound, but have them recomputed: the bounds
+ * of arcs, ellipses and texts are truncated, so they don't move exactly.
+ */
+
+void translate_compound_bound(F_compound *compound, int dx, int dy)
+{
+    compound->nwcorner.x += dx;
+    compound->nwcorner.y += dy;
+    compound->secorner.x += dx;
+    compound->secorner.y += dy;
+    compound->bound_key = 0;
 }
 
 void compound_bound(F_compound *compound, int *xmin, int *ymin, int *xmax, int *ymax)
@@ -172,6 +345,13 @@ void compound_bound(F_compound *compound, int *xmin, int *ymin, int *xmax, int *
 	*xmin = *ymin = *xmax = *ymax = 0;
 	return;
     }
+    if (keeps_bound(compound) && compound->bound_key == grid_step()) {
+	*xmin = compound->nwcorner.x;
+	*ymin = compound->nwcorner.y;
+	*xmax = compound->secorner.x;
+	*ymax = compound->secorner.y;
+	return;
+    }
 
     llx = lly = urx = ury = 0;
 
@@ -192,10 +372,7 @@ void compound_bound(F_compound *compound, int *xmin, int *ymin, int *xmax, int *
     }
 
     for (c = compound->compounds; c != NULL; c = c->next) {
-	sx = c->nwcorner.x;
-	sy = c->nwcorner.y;
-	bx = c->secorner.x;
-	by = c->secorner.y;
+	compound_bound(c, &sx, &sy, &bx, &by);
 	if (first) {
 	    first = 0;
 	    llx = sx;
@@ -285,6 +462,13 @@ void compound_bound(F_compound *compound, int *xmin, int *ymin, int *xmax, int *
     *ymin = lly;
     *xmax = urx;
     *ymax = ury;
+    if (keeps_bound(compound)) {
+	compound->nwcorner.x = llx;
+	compound->nwcorner.y = lly;
+	compound->secorner.x = urx;
+	compound->secorner.y = ury;
+	compound->bound_key = grid_step();
+    }
     /* show the boundaries */
     if (appres.DEBUG && !preview_in_progress) {
 	pw_vector(canvas_win, *xmin, *ymin, *xmax, *ymin, PAINT, 1, RUBBER_LINE, 0.0, RED);
@@ -294,10 +478,27 @@ void compound_bound(F_compound *compound, int *xmin, int *ymin, int *xmax, int *
     }
 }
 
+void ellipse_bound(F_ellipse *e, int *xmin, int *ymin, int *xmax, int *ymax)
+{
+    nkey = 0;
+    key_int(e->center.x);
+    key_int(e->center.y);
+    key_int(e->radiuses.x);
+    key_int(e->radiuses.y);
+    key_float(e->angle);
+    key_int(e->thickness);
+    key_float(ZOOM_FACTOR);
+    if (kept_bound(&e->bound, xmin, ymin, xmax, ymax))
+	return;
+    angle_ellipse_bound(e, xmin, ymin, xmax, ymax);
+    keep_bound(&e->bound, *xmin, *ymin, *xmax, *ymax);
+}
+
 /* basically, use the code for drawing the ellipse to find its bounds */
 /* From James Tough (see u_draw.c: angle_ellipse() */
 
-void ellipse_bound(F_ellipse *e, int *xmin, int *ymin, int *xmax, int *ymax)
+static void
+angle_ellipse_bound(F_ellipse *e, int *xmin, int *ymin, int *xmax, int *ymax)
 {
 	int	    half_wd;
 	double	    c1, c2, c3, c4, c5, c6, v1, cphi, sphi, cphisqr, sphisqr;
@@ -407,18 +608,40 @@ void ellipse_bound(F_ellipse *e, int *xmin, int *ymin, int *xmax, int *ymax)
 	}
 }
 
+/*
+ * Lines and splines still go through their points each time, as that is
+ * how a change to them is found, but the arrowheads are only recomputed
+ * when the points they sit on, the arrows or the thickness change.
+ */
+
 void line_bound(F_line *l, int *xmin, int *ymin, int *xmax, int *ymax)
 {
+    F_bound	   *b;
+
     points_bound(l->points, (l->thickness / 2), xmin, ymin, xmax, ymax);
     /* now add in the arrow (if any) boundaries */
     /* but only if there are two or more points in the line */
-    if (l->points->next) {
+    if (l->points->next && (l->for_arrow || l->back_arrow)) {
+	nkey = 0;
+	key_int(*xmin);
+	key_int(*ymin);
+	key_int(*xmax);
+	key_int(*ymax);
+	key_int(l->thickness);
+	key_float(ZOOM_FACTOR);
+	key_arrows(l);
+	if ((b = alloc_bound(&l->bound)) && kept_bound(b, xmin, ymin, xmax, ymax))
+	    return;
 	arrow_bound(O_POLYLINE, l, xmin, ymin, xmax, ymax);
+	if (b)
+	    keep_bound(b, *xmin, *ymin, *xmax, *ymax);
     }
 }
 
 void spline_bound(F_spline *s, int *xmin, int *ymin, int *xmax, int *ymax)
 {
+    F_bound	   *b;
+
     if (approx_spline(s))
 	approx_spline_bound(s, xmin, ymin, xmax, ymax);
     else
@@ -430,7 +653,21 @@ void spline_bound(F_spline *s, int *xmin, int *ymin, int *xmax, int *ymax)
     *ymin -= s->thickness>>1;
 
     /* now add in the arrow (if any) boundaries */
-    arrow_bound(O_SPLINE, (F_line *)s, xmin, ymin, xmax, ymax);
+    if (s->for_arrow || s->back_arrow) {
+	nkey = 0;
+	key_int(*xmin);
+	key_int(*ymin);
+	key_int(*xmax);
+	key_int(*ymax);
+	key_int(s->thickness);
+	key_float(ZOOM_FACTOR);
+	key_arrows((F_line *) s);
+	if ((b = alloc_bound(&s->bound)) && kept_bound(b, xmin, ymin, xmax, ymax))
+	    return;
+	arrow_bound(O_SPLINE, (F_line *)s, xmin, ymin, xmax, ymax);
+	if (b)
+	    keep_bound(b, *xmin, *ymin, *xmax, *ymax);
+    }
 }
 
 static void
@@ -505,6 +742,30 @@ approx_spline_bound(F_spline *s, int *xmin, int *ymin, int *xmax, int *ymax)
  */
 
 void text_bound(F_text *t, int *xmin, int *ymin, int *xmax, int *ymax, int *rx1, int *ry1, int *rx2, int *ry2, int *rx3, int *ry3, int *rx4, int *ry4)
+{
+    int		   *r = t->bound_corners;
+
+    nkey = 0;
+    key_int(t->type);
+    key_float(t->angle);
+    key_int(t->base_x);
+    key_int(t->base_y);
+    key_int(t->ascent);
+    key_int(t->descent);
+    key_int(text_length(t));
+    if (!kept_bound(&t->bound, xmin, ymin, xmax, ymax)) {
+	corners_text_bound(t, xmin, ymin, xmax, ymax, &r[0], &r[1], &r[2], &r[3],
+			&r[4], &r[5], &r[6], &r[7]);
+	keep_bound(&t->bound, *xmin, *ymin, *xmax, *ymax);
+    }
+    *rx1 = r[0]; *ry1 = r[1];
+    *rx2 = r[2]; *ry2 = r[3];
+    *rx3 = r[4]; *ry3 = r[5];
+    *rx4 = r[6]; *ry4 = r[7];
+}
+
+static void
+corners_text_bound(F_text *t, int *xmin, int *ymin, int *xmax, int *ymax, int *rx1, int *ry1, int *rx2, int *ry2, int *rx3, int *ry3, int *rx4, int *ry4)
 {
     int		    h, l;
     int		    x1,y1, x2,y2, x3,y3, x4,y4;
@@ -18,11 +18,15 @@
 #ifndef U_BOUND_H
 #define U_BOUND_H
 
+extern long	bound_hits, bound_misses;	/* object bounds kept/recomputed */
+
 extern int	overlapping(int xmin1, int ymin1, int xmax1, int ymax1, int xmin2, int ymin2, int xmax2, int ymax2);
 extern int	floor_coords(int x);
 extern int	ceil_coords(int x);
 extern void arc_bound (F_arc *arc, int *xmin, int *ymin, int *xmax, int *ymax);
 extern void compound_bound (F_compound *compound, int *xmin, int *ymin, int *xmax, int *ymax);
+extern void invalidate_compound_bound (F_compound *compound);
+extern void translate_compound_bound (F_compound *compound, int dx, int dy);
 extern void ellipse_bound (F_ellipse *e, int *xmin, int *ymin, int *xmax, int *ymax);
 extern void line_bound (F_line *l, int *xmin, int *ymin, int *xmax, int *ymax);
 extern void spline_bound (F_spline *s, int *xmin, int *ymin, int *xmax, int *ymax);
@@ -31,6 +31,7 @@
 #include "e_scale.h"
 #include "u_free.h"
 #include "u_list.h"
+#include "u_pool.h"
 #include "w_cursor.h"
 #include "w_modepanel.h"
 #include "w_mousefun.h"
@@ -173,7 +174,7 @@ create_point(void)
 {
     F_point	   *p;
 
-    if ((p = (F_point *) malloc(POINT_SIZE)) == NULL) {
+    if ((p = (F_point *) pool_alloc(&point_pool)) == NULL) {
 	put_msg(Err_mem);
 	return NULL;
     }
@@ -188,7 +189,7 @@ create_sfactor(void)
 {
     F_sfactor	   *cp;
 
-    if ((cp = (F_sfactor *) malloc(CONTROL_SIZE)) == NULL) {
+    if ((cp = (F_sfactor *) pool_alloc(&sfactor_pool)) == NULL) {
 	put_msg(Err_mem);
 	return NULL;
     }
@@ -317,12 +318,13 @@ create_arc(void)
 {
     F_arc	   *a;
 
-    if ((a = (F_arc *) malloc(ARCOBJ_SIZE)) == NULL) {
+    if ((a = (F_arc *) pool_alloc(&arc_pool)) == NULL) {
 	put_msg(Err_mem);
 	return NULL;
     }
     a->tagged = 0;
-    a->next = NULL;
+    a->prev = a->next = NULL;
+    a->bound.nkey = 0;
     a->type = 0;
     a->for_arrow = NULL;
     a->back_arrow = NULL;
@@ -352,14 +354,14 @@ copy_arc(F_arc *a)
 
     /* copy static items first */
     *arc = *a;
-    arc->next = NULL;
+    arc->prev = arc->next = NULL;
 
     /* do comments next */
     copy_comments(&a->comments, &arc->comments);
 
     if (a->for_arrow) {
 	if ((arrow = create_arrow()) == NULL) {
-	    free((char *) arc);
+	    pool_free(&arc_pool, arc);
 	    return NULL;
 	}
 	arc->for_arrow = arrow;
@@ -367,7 +369,7 @@ copy_arc(F_arc *a)
     }
     if (a->back_arrow) {
 	if ((arrow = create_arrow()) == NULL) {
-	    free((char *) arc);
+	    pool_free(&arc_pool, arc);
 	    return NULL;
 	}
 	arc->back_arrow = arrow;
@@ -383,12 +385,13 @@ create_ellipse(void)
 {
     F_ellipse	   *e;
 
-    if ((e = (F_ellipse *) malloc(ELLOBJ_SIZE)) == NULL) {
+    if ((e = (F_ellipse *) pool_alloc(&ellipse_pool)) == NULL) {
 	put_msg(Err_mem);
 	return NULL;
     }
     e->tagged = 0;
-    e->next = NULL;
+    e->prev = e->next = NULL;
+    e->bound.nkey = 0;
     e->comments = NULL;
     return e;
 }
@@ -403,7 +406,7 @@ copy_ellipse(F_ellipse *e)
 
     /* copy static items first */
     *ellipse = *e;
-    ellipse->next = NULL;
+    ellipse->prev = ellipse->next = NULL;
 
     /* do comments next */
     copy_comments(&e->comments, &ellipse->comments);
@@ -418,12 +421,14 @@ create_line(void)
 {
     F_line	   *l;
 
-    if ((l = (F_line *) malloc(LINOBJ_SIZE)) == NULL) {
+    if ((l = (F_line *) pool_alloc(&line_pool)) == NULL) {
 	put_msg(Err_mem);
 	return NULL;
     }
     l->tagged = 0;
-    l->next = NULL;
+    l->prev = l->next = NULL;
+    l->bound = NULL;
+    l->vindex = NULL;
     l->pic = NULL;
     l->for_arrow = NULL;
     l->back_arrow = NULL;
@@ -442,6 +447,7 @@ create_pic(void)
 	put_msg(Err_mem);
 	return NULL;
     }
+    pic->pixmap = (Pixmap) 0;
     pic->mask = (Pixmap) 0;
     pic->New = False;
     pic->pic_cache = NULL;
@@ -462,6 +468,11 @@ create_picture_entry(void)
     picture->transp = TRANSP_NONE;
     picture->numcols = 0;
     picture->refcount = 0;
+    picture->bytes = 0;
+    picture->dropped = False;
+    picture->pending = False;
+    picture->drawn = 0;
+    picture->hnext = NULL;
     picture->prev = picture->next = NULL;
     if (appres.DEBUG)
 	fprintf(stderr,"create picture entry %x\n",(int) picture);
@@ -481,14 +492,16 @@ copy_line(F_line *l)
 
     /* copy static items first */
     *line = *l;
-    line->next = NULL;
+    line->prev = line->next = NULL;
+    line->bound = NULL;
+    line->vindex = NULL;
 
     /* do comments next */
     copy_comments(&l->comments, &line->comments);
 
     if (l->for_arrow) {
 	if ((arrow = create_arrow()) == NULL) {
-	    free((char *) line);
+	    pool_free(&line_pool, line);
 	    return NULL;
 	}
 	line->for_arrow = arrow;
@@ -496,7 +509,7 @@ copy_line(F_line *l)
     }
     if (l->back_arrow) {
 	if ((arrow = create_arrow()) == NULL) {
-	    free((char *) line);
+	    pool_free(&line_pool, line);
 	    return NULL;
 	}
 	line->back_arrow = arrow;
@@ -511,7 +524,7 @@ copy_line(F_line *l)
     /* copy picture information */
     if (l->pic) {
 	if ((line->pic = create_pic()) == NULL) {
-	    free((char *) line);
+	    pool_free(&line_pool, line);
 	    return NULL;
 	}
 	/* copy all the numbers and the pointer to the picture repository (pic->pic_cache) */
@@ -549,13 +562,16 @@ create_spline(void)
 {
     F_spline	   *s;
 
-    if ((s = (F_spline *) malloc(SPLOBJ_SIZE)) == NULL) {
+    if ((s = (F_spline *) pool_alloc(&spline_pool)) == NULL) {
 	put_msg(Err_mem);
 	return NULL;
     }
     s->tagged = 0;
-    s->next = NULL;
+    s->prev = s->next = NULL;
+    s->bound = NULL;
+    s->vindex = NULL;
     s->comments = NULL;
+    s->cache = NULL;
     return s;
 }
 
@@ -570,14 +586,17 @@ copy_spline(F_spline *s)
 
     /* copy static items first */
     *spline = *s;
-    spline->next = NULL;
+    spline->prev = spline->next = NULL;
+    spline->cache = NULL;
+    spline->bound = NULL;
+    spline->vindex = NULL;
 
     /* do comments next */
     copy_comments(&s->comments, &spline->comments);
 
     if (s->for_arrow) {
 	if ((arrow = create_arrow()) == NULL) {
-	    free((char *) spline);
+	    pool_free(&spline_pool, spline);
 	    return NULL;
 	}
 	spline->for_arrow = arrow;
@@ -585,7 +604,7 @@ copy_spline(F_spline *s)
     }
     if (s->back_arrow) {
 	if ((arrow = create_arrow()) == NULL) {
-	    free((char *) spline);
+	    pool_free(&spline_pool, spline);
 	    return NULL;
 	}
 	spline->back_arrow = arrow;
@@ -617,7 +636,7 @@ create_text(void)
 {
     F_text	   *t;
 
-    if ((t = (F_text *) malloc(TEXOBJ_SIZE)) == NULL) {
+    if ((t = (F_text *) pool_alloc(&text_pool)) == NULL) {
 	put_msg(Err_mem);
 	return NULL;
     }
@@ -625,7 +644,8 @@ create_text(void)
     t->fontstruct = 0;
     t->comments = NULL;
     t->cstring = NULL;
-    t->next = NULL;
+    t->prev = t->next = NULL;
+    t->bound.nkey = 0;
     return t;
 }
 
@@ -651,13 +671,13 @@ copy_text(F_text *t)
 
     /* copy static items first */
     *text = *t;
-    text->next = NULL;
+    text->prev = text->next = NULL;
 
     /* do comments next */
     copy_comments(&t->comments, &text->comments);
 
     if ((text->cstring = new_string(strlen(t->cstring))) == NULL) {
-	free((char *) text);
+	pool_free(&text_pool, text);
 	return NULL;
     }
     strcpy(text->cstring, t->cstring);
@@ -671,7 +691,7 @@ create_compound(void)
 {
     F_compound	   *c;
 
-    if ((c = (F_compound *) malloc(COMOBJ_SIZE)) == NULL) {
+    if ((c = (F_compound *) pool_alloc(&compound_pool)) == NULL) {
 	put_msg(Err_mem);
 	return NULL;
     }
@@ -690,82 +710,230 @@ create_compound(void)
     c->comments = NULL;
     c->parent = NULL;
     c->GABPtr = NULL;
-    c->next = NULL;
+    c->prev = c->next = NULL;
+    c->shared = NULL;
+    c->bound_key = 0;
 
     return c;
 }
 
-F_compound     *
-copy_compound(F_compound *c)
+/*
+ * A copy of a compound shares the objects inside it with the original
+ * until one of the two is changed.  All the compounds sharing a set of
+ * objects are linked in a ring through their "shared" pointers.  Code
+ * that changes the objects inside a compound, or moves them to another
+ * list, must call unshare_compound() first, which gives the others in
+ * the ring their own copy.  The objects of a nested compound are shared
+ * the same way, so only one level is copied at a time; code that changes
+ * a whole compound calls unshare_compound_tree() before it starts.
+ *
+ * The figure itself (objects) is never shared, because the list routines
+ * add and remove its objects in place.
+ */
+
+static Boolean
+copy_members(F_compound *c, F_compound *compound)
 {
     F_ellipse	   *e, *ee;
     F_arc	   *a, *aa;
     F_line	   *l, *ll;
     F_spline	   *s, *ss;
     F_text	   *t, *tt;
-    F_compound	   *cc, *ccc, *compound;
-
-    if ((compound = create_compound()) == NULL)
-	return NULL;
-
-    compound->nwcorner = c->nwcorner;
-    compound->secorner = c->secorner;
-    compound->arcs = NULL;
-    compound->ellipses = NULL;
-    compound->lines = NULL;
-    compound->splines = NULL;
-    compound->texts = NULL;
-    compound->compounds = NULL;
-    compound->next = NULL;
-
-    /* do comments first */
-    copy_comments(&c->comments, &compound->comments);
+    F_compound	   *cc, *ccc;
 
     for (e = c->ellipses; e != NULL; e = e->next) {
-	if (NULL == (ee = copy_ellipse(e))) {
-	    put_msg(Err_mem);
-	    return NULL;
-	}
+	if (NULL == (ee = copy_ellipse(e)))
+	    return False;
 	list_add_ellipse(&compound->ellipses, ee);
     }
     for (a = c->arcs; a != NULL; a = a->next) {
-	if (NULL == (aa = copy_arc(a))) {
-	    put_msg(Err_mem);
-	    return NULL;
-	}
+	if (NULL == (aa = copy_arc(a)))
+	    return False;
 	list_add_arc(&compound->arcs, aa);
     }
     for (l = c->lines; l != NULL; l = l->next) {
-	if (NULL == (ll = copy_line(l))) {
-	    put_msg(Err_mem);
-	    return NULL;
-	}
+	if (NULL == (ll = copy_line(l)))
+	    return False;
 	list_add_line(&compound->lines, ll);
     }
     for (s = c->splines; s != NULL; s = s->next) {
-	if (NULL == (ss = copy_spline(s))) {
-	    put_msg(Err_mem);
-	    return NULL;
-	}
+	if (NULL == (ss = copy_spline(s)))
+	    return False;
 	list_add_spline(&compound->splines, ss);
     }
     for (t = c->texts; t != NULL; t = t->next) {
-	if (NULL == (tt = copy_text(t))) {
-	    put_msg(Err_mem);
-	    return NULL;
-	}
+	if (NULL == (tt = copy_text(t)))
+	    return False;
 	list_add_text(&compound->texts, tt);
     }
     for (cc = c->compounds; cc != NULL; cc = cc->next) {
-	if (NULL == (ccc = copy_compound(cc))) {
+	if (NULL == (ccc = copy_compound(cc)))
+	    return False;
+	list_add_compound(&compound->compounds, ccc);
+    }
+    return True;
+}
+
+/* put compound c in the ring of o, whose objects it uses */
+
+static void
+share_compound(F_compound *c, F_compound *o)
+{
+    if (o == NULL)
+	return;
+    c->shared = o->shared ? o->shared : o;
+    o->shared = c;
+}
+
+F_compound     *
+copy_compound(F_compound *c)
+{
+    F_compound	   *compound;
+
+    if ((compound = create_compound()) == NULL)
+	return NULL;
+
+    compound->nwcorner = c->nwcorner;
+    compound->secorner = c->secorner;
+
+    /* do comments first */
+    copy_comments(&c->comments, &compound->comments);
+
+    if (c == &objects) {
+	if (!copy_members(c, compound)) {
 	    put_msg(Err_mem);
 	    return NULL;
 	}
-	list_add_compound(&compound->compounds, ccc);
+	return compound;
     }
+
+    compound->ellipses = c->ellipses;
+    compound->arcs = c->arcs;
+    compound->lines = c->lines;
+    compound->splines = c->splines;
+    compound->texts = c->texts;
+    compound->compounds = c->compounds;
+    compound->bound_key = c->bound_key;
+    share_compound(compound, c);
     return compound;
 }
 
+/*
+ * Take compound c out of its ring.  Returns True if other compounds
+ * still use its objects, so they mustn't be freed.
+ */
+
+Boolean
+release_shared_compound(F_compound *c)
+{
+    F_compound	   *p;
+
+    if (c->shared == NULL)
+	return False;
+    for (p = c->shared; p->shared != c; p = p->shared)
+	;
+    p->shared = (c->shared == p) ? NULL : c->shared;
+    c->shared = NULL;
+    return True;
+}
+
+/*
+ * Give the other compounds sharing the objects of c their own copy, so c
+ * can be changed.  c keeps the original objects, so references to them
+ * (the undo journal, the markers) stay good.  Returns False if there
+ * isn't memory for the copy, and c must be left as it is.
+ */
+
+Boolean
+unshare_compound(F_compound *c)
+{
+    F_compound	   *copy, *o;
+
+    if (c->shared == NULL)
+	return True;
+    if ((copy = create_compound()) == NULL)
+	return False;
+    if (!copy_members(c, copy)) {
+	put_msg(Err_mem);
+	free_compound(&copy);
+	return False;
+    }
+    for (o = c->shared; o != c; o = o->shared) {
+	o->ellipses = copy->ellipses;
+	o->arcs = copy->arcs;
+	o->lines = copy->lines;
+	o->splines = copy->splines;
+	o->texts = copy->texts;
+	o->compounds = copy->compounds;
+    }
+    (void) release_shared_compound(c);
+    pool_free(&compound_pool, copy);
+    return True;
+}
+
+/*
+ * Unshare c and every compound nested in it, before anything in them is
+ * changed.  Returns False if there isn't the memory; the figure is as it
+ * was then, only some of the compounds may have their own objects.
+ */
+
+Boolean
+unshare_compound_tree(F_compound *c)
+{
+    F_compound	   *cc;
+
+    if (!unshare_compound(c))
+	return False;
+    for (cc = c->compounds; cc != NULL; cc = cc->next)
+	if (!unshare_compound_tree(cc))
+	    return False;
+    return True;
+}
+
+/*
+ * Exchange the contents of compounds a and b, as the undo of an edit
+ * does, but keep each in its place in the object lists.  The objects
+ * move to the other compound, so it takes their place in the ring of
+ * the compounds sharing them.
+ */
+
+void
+exchange_compounds(F_compound *a, F_compound *b)
+{
+    F_compound	    swp, *o, *with_a, *with_b;
+    F_compound	   *next, *prev;
+    Boolean	    same;
+
+    /* compounds in the same ring hold the same objects, it stays as is */
+    same = False;
+    if (a->shared)
+	for (o = a->shared; o != a; o = o->shared)
+	    if (o == b)
+		same = True;
+    with_a = with_b = NULL;
+    if (!same) {
+	with_a = a->shared;
+	(void) release_shared_compound(a);
+	with_b = b->shared;
+	(void) release_shared_compound(b);
+    }
+    swp = *a;
+    *a = *b;
+    *b = swp;
+    /* but keep the next, prev and shared pointers unchanged */
+    next = a->next;
+    a->next = b->next;
+    b->next = next;
+    prev = a->prev;
+    a->prev = b->prev;
+    b->prev = prev;
+    o = a->shared;
+    a->shared = b->shared;
+    b->shared = o;
+    share_compound(a, with_b);
+    share_compound(b, with_a);
+}
+
 /********************** DIMENSION LINES **********************/
 
 /* Make a dimension line given an ordinary line
@@ -949,6 +1117,8 @@ create_dimline_ticks(F_line *line, F_line **tick1, F_line **tick2)
 	/* zero the arrows and next pointer */
 	tick->for_arrow = tick->back_arrow = (F_arrow *) NULL;
 	tick->next = (F_line *) NULL;
+	tick->bound = NULL;
+	tick->vindex = NULL;
 	pnt = create_point();
 	tick->points = pnt;
 	pnt->next = create_point();
@@ -967,6 +1137,8 @@ create_dimline_ticks(F_line *line, F_line **tick1, F_line **tick2)
 	/* zero the arrows and next pointer */
 	tick->for_arrow = tick->back_arrow = (F_arrow *) NULL;
 	tick->next = (F_line *) NULL;
+	tick->bound = NULL;
+	tick->vindex = NULL;
 	pnt = create_point();
 	tick->points = pnt;
 	pnt->next = create_point();
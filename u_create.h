@@ -37,6 +37,10 @@ extern F_line     *copy_line(F_line *l);
 extern F_spline   *copy_spline(F_spline *s);
 extern F_text     *copy_text(F_text *t);
 extern F_compound *copy_compound(F_compound *c);
+extern Boolean    unshare_compound(F_compound *c);
+extern Boolean    unshare_compound_tree(F_compound *c);
+extern Boolean    release_shared_compound(F_compound *c);
+extern void       exchange_compounds(F_compound *a, F_compound *b);
 
 extern void	  copy_comments(char **source, char **dest);
 extern F_point   *copy_points(F_point *orig_pt);
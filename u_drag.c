@@ -44,7 +44,8 @@ static void array_place_arc(int x, int y),      place_arc(int x, int y),      pl
 static void array_place_spline(int x, int y),   place_spline(int x, int y),   place_spline_x(int x, int y),   cancel_spline(void);
 static void array_place_ellipse(int x, int y),  place_ellipse(int x, int y),  place_ellipse_x(int x, int y),  cancel_ellipse(void);
 static void array_place_text(int x, int y),     place_text(int x, int y),     place_text_x(int x, int y),     cancel_text(void);
-static void array_place_compound(int x, int y), place_compound(int x, int y), place_compound_x(int x, int y), cancel_drag_compound(void);
+static void array_place_compound(int x, int y), place_compound(int x, int y), cancel_drag_compound(void), drop_drag_compound(void);
+static Boolean place_compound_x(int x, int y);
 
 /***************************** ellipse section ************************/
 
@@ -756,6 +757,14 @@ cancel_drag_compound(void)
     elastic_movebox();
     /* erase last lengths if appres.showlengths is true */
     erase_lengths();
+    drop_drag_compound();
+}
+
+/* give up the drag, leaving the compound where it was */
+
+static void
+drop_drag_compound(void)
+{
     free_linkinfo(&cur_links);
     if (return_proc == copy_selected) {
 	free_compound(&new_c);
@@ -773,8 +782,9 @@ static void
 array_place_compound(int x, int y)
 {
     int		    i, j, delta_x, delta_y, start_x, start_y;
-    int		    nx, ny;
+    int		    nx, ny, placed;
     F_compound	   *save_compound;
+    Boolean	    ok;
 
     elastic_movebox();
     /* erase last lengths if appres.showlengths is true */
@@ -790,13 +800,18 @@ array_place_compound(int x, int y)
 	delta_y = cur_y - fix_y;
 	start_x = cur_x - delta_x;
 	start_y = cur_y - delta_y;
+	/* stop at the first copy there isn't the memory to place */
+	ok = True;
+	placed = 0;
 	if ((cur_numxcopies < 2) && (cur_numycopies < 2)) {  /* special cases */
-	    if (cur_numxcopies > 0) {
-		place_compound_x(start_x+delta_x, start_y);
+	    if (cur_numxcopies > 0 &&
+		(ok = place_compound_x(start_x+delta_x, start_y))) {
+		placed++;
 		new_c = copy_compound(cur_c);
 	    }
-	    if (cur_numycopies > 0) {
-		place_compound_x(start_x, start_y+delta_y);
+	    if (ok && cur_numycopies > 0 &&
+		(ok = place_compound_x(start_x, start_y+delta_y))) {
+		placed++;
 		new_c = copy_compound(cur_c);
 	    }
 	} else {
@@ -806,15 +821,18 @@ array_place_compound(int x, int y)
 	    ny = cur_numycopies;
 	    if (ny == 0)
 		ny++;
-	    for (i = 0, x = start_x;  i < nx; i++, x+=delta_x) {
-		for (j = 0, y = start_y;  j < ny; j++, y+=delta_y) {
-		    if (i || j ) {
-			place_compound_x(x, y);
+	    for (i = 0, x = start_x;  ok && i < nx; i++, x+=delta_x) {
+		for (j = 0, y = start_y;  ok && j < ny; j++, y+=delta_y) {
+		    if ((i || j) && (ok = place_compound_x(x, y))) {
+			placed++;
 			new_c = copy_compound(cur_c);
 		    }
 		}
 	    }
 	}
+	/* the first one was dropped, there is nothing to undo */
+	if (placed == 0)
+	    return;
     }
     /* put all new compounds in the saved objects structure for undo */
     saved_objects.compounds = save_compound;
@@ -830,10 +848,15 @@ place_compound(int x, int y)
     elastic_movebox();
     /* erase last lengths if appres.showlengths is true */
     erase_lengths();
-    place_compound_x(x, y);
+    (void) place_compound_x(x, y);
 }
 
-static void
+/*
+ * Place new_c at (x, y).  Returns False, with the drag given up, if there
+ * isn't the memory to move it.
+ */
+
+static Boolean
 place_compound_x(int x, int y)
 {
     int		    dx, dy;
@@ -846,7 +869,11 @@ place_compound_x(int x, int y)
     adjust_pos(x, y, fix_x, fix_y, &x, &y);
     dx = x - fix_x;
     dy = y - fix_y;
-    translate_compound(new_c, dx, dy);
+    /* an array copy may not have been made */
+    if (new_c == NULL || !translate_compound(new_c, dx, dy)) {
+	drop_drag_compound();
+	return False;
+    }
     clean_up();
     set_latestcompound(new_c);
     if (return_proc == copy_selected) {
@@ -868,4 +895,5 @@ place_compound_x(int x, int y)
     update_markers(new_objmask);
     (*return_proc) ();
     draw_mousefun_canvas();
+    return True;
 }
@@ -24,6 +24,7 @@
 #include "object.h"
 #include "paintop.h"
 #include "d_text.h"
+#include "f_picobj.h"
 #include "f_util.h"
 #include "u_bound.h"
 #include "u_create.h"
@@ -43,6 +44,7 @@
 #include "w_zoom.h"
 #include "u_redraw.h"
 #include "w_cursor.h"
+#include "w_softdraw.h"
 
 static Boolean add_point(int x, int y);
 static void init_point_array(void);
@@ -605,11 +607,15 @@ void draw_line(F_line *line, int op)
     /* is it a picture object or a Fig figure? */
     if (line->type == T_PICTURE) {
 	if (line->pic->pic_cache) {
-	    if ((line->pic->pic_cache->bitmap != (Pixmap) NULL) && active_layer(line->depth)) {
+	    /* a bitmap freed to save memory is read again when needed,
+	       and one still being read is drawn as a placeholder */
+	    if ((line->pic->pic_cache->bitmap != (Pixmap) NULL ||
+		 line->pic->pic_cache->dropped || line->pic->pic_cache->pending) &&
+		 active_layer(line->depth)) {
 		/* only draw the picture if there is a pixmap AND this layer is active */
 		draw_pic_pixmap(line, op);
 		return;
-	    } else if (line->pic->pic_cache->bitmap != NULL) { 
+	    } else if (line->pic->pic_cache->bitmap != NULL || line->pic->pic_cache->dropped) { 
 		/* if there is a pixmap but the layer is not active, draw it as a filled box */
 		line->type = T_BOX;
 		line->fill_style = NUMSHADEPATS-1;	 /* fill it */
@@ -765,6 +771,8 @@ subset(int xmin1, int ymin1, int xmax1, int ymax1, int xmin2, int ymin2, int xma
            (ymin2 <= ymin1) && (ymax1 <= ymax2);
 }
 
+#define	PIC_WAIT_FILL	4	/* light gray box for a picture not read yet */
+
 void draw_pic_pixmap(F_line *box, int op)
 {
     int		    xmin, ymin;
@@ -789,6 +797,20 @@ void draw_pic_pixmap(F_line *box, int op)
 	clear_region(xmin, ymin, xmax, ymax);
 	return;
     }
+    /* still being read in the background, fill the box until it comes */
+    if (picture_waiting(box->pic->pic_cache)) {
+	F_point	   *p = box->points, *q = box->points->next->next;
+	zXPoint	    corners[5];
+
+	corners[0].x = corners[3].x = corners[4].x = p->x;
+	corners[0].y = corners[1].y = corners[4].y = p->y;
+	corners[1].x = corners[2].x = q->x;
+	corners[2].y = corners[3].y = q->y;
+	pw_lines(canvas_win, corners, 5, op, box->depth, box->thickness,
+		box->style, box->style_val, box->join_style, box->cap_style,
+		PIC_WAIT_FILL, box->pen_color, DEFAULT);
+	return;
+    }
     /* width is upper-lower+1 */
     width = abs(origin.x - opposite.x) + 1;
     height = abs(origin.y - opposite.y) + 1;
@@ -800,15 +822,24 @@ void draw_pic_pixmap(F_line *box, int op)
     if (origin.x <= opposite.x && origin.y > opposite.y)
 	rotation = 90;
 
+    touch_picture(box->pic->pic_cache);
     /* if something has changed regenerate the pixmap */
     if (box->pic->pixmap == 0 ||
 	box->pic->color != box->pen_color ||
 	box->pic->pix_rotation != rotation ||
 	abs(box->pic->pix_width - width) > 1 ||		/* rounding makes diff of 1 bit */
 	abs(box->pic->pix_height - height) > 1 ||
-	box->pic->pix_flipped != box->pic->flipped)
+	box->pic->pix_flipped != box->pic->flipped) {
+	    if (!load_picture_bitmap(box->pic)) {
+		/* the file has gone, label the box instead */
+		draw_line(box, op);
+		return;
+	    }
 	    create_pic_pixmap(box, rotation, width, height, box->pic->flipped);
+    }
 
+    /* the lines drawn so far must go out before the picture covers them */
+    flush_batch();
     if (box->pic->mask) {
       /* mask is in rectangle (xmin,ymin)...(xmax,ymax)
          clip to rectangle (clip_xmin,clip_ymin)...(clip_xmax,clip_ymax) */
@@ -846,6 +877,7 @@ void draw_pic_pixmap(F_line *box, int op)
       }
       XChangeGC(tool_d, gccache[op], GCClipMask|GCClipXOrigin|GCClipYOrigin, &gcv);
     }
+    touch_canvas(canvas_win);
     XCopyArea(tool_d, box->pic->pixmap, canvas_win, gccache[op],
 	      0, 0, width, height, xmin, ymin);
     if (box->pic->mask) {
@@ -1550,10 +1582,14 @@ void clip_arrows(F_line *obj, int objtype, int op, int skip)
 	}
     }
     /* now set the clipping region for the subsequent drawing of the object */
-    if (obj->for_arrow || obj->back_arrow) {
+    if ((obj->for_arrow || obj->back_arrow) && soft_drawing) {
+	soft_set_region(mainregion);
+	XDestroyRegion(mainregion);
+    } else if (obj->for_arrow || obj->back_arrow) {
 	/* install a temporary error handler to ignore any BadMatch error
 	   from the buggy R5 Xlib XSetRegion() */
 	XSetErrorHandler (tempXErrorHandler);
+	flush_batch();
 	XSetRegion(tool_d, gccache[op], mainregion);
 	/* restore original error handler */
 	if (!appres.DEBUG)
@@ -2035,6 +2071,173 @@ void debug_depth(int depth, int x, int y)
 /* include common spline routines */
 /**********************************/
 
+/*
+ * Cache of the flattened curve of a spline.  Evaluating the X-spline is
+ * expensive, so the points are kept with the spline, together with a copy
+ * of the control points and shape factors they came from.  The copy is
+ * checked each time the curve is wanted, so the many places that change a
+ * spline in place needn't know about the cache.  Hit-testing always uses
+ * HIGH_PRECISION, so there is one curve for each precision.
+ */
+
+typedef struct f_spline_cache {
+    int		    type;		/* open/closed, approx/interp/x */
+    int		    nctl;		/* number of control points */
+    int		    maxctl;		/* room in ctl and sf */
+    zXPoint	   *ctl;		/* control points ... */
+    double	   *sf;			/* ... and shape factors */
+    zXPoint	   *curve[2];		/* LOW_PRECISION, HIGH_PRECISION */
+    int		    ncurve[2];
+}
+	F_spline_cache;
+
+void
+free_spline_cache(F_spline *s)
+{
+    F_spline_cache *c;
+
+    if ((c = s->cache) == NULL)
+	return;
+    free((char *) c->ctl);
+    free((char *) c->sf);
+    if (c->curve[0])
+	free((char *) c->curve[0]);
+    if (c->curve[1])
+	free((char *) c->curve[1]);
+    free((char *) c);
+    s->cache = NULL;
+}
+
+/* return the cache for spline s, emptied if the spline has changed */
+
+static F_spline_cache *
+spline_cache(F_spline *s)
+{
+    F_spline_cache *c;
+    F_point	   *p;
+    F_sfactor	   *sf;
+    int		    i, n;
+
+    if ((c = s->cache) != NULL && c->type == s->type) {
+	for (i = 0, p = s->points, sf = s->sfactors; p != NULL && sf != NULL;
+	     i++, p = p->next, sf = sf->next) {
+	    if (i >= c->nctl || p->x != c->ctl[i].x || p->y != c->ctl[i].y ||
+		sf->s != c->sf[i])
+		    break;
+	}
+	if (p == NULL && sf == NULL && i == c->nctl)
+	    return c;
+    }
+
+    /* new or changed spline, (re)load the control points */
+    for (n = 0, p = s->points; p != NULL; p = p->next)
+	n++;
+    if (c == NULL) {
+	if ((c = (F_spline_cache *) malloc(sizeof(F_spline_cache))) == NULL)
+	    return NULL;
+	c->maxctl = 0;
+	c->ctl = NULL;
+	c->sf = NULL;
+	c->curve[0] = c->curve[1] = NULL;
+	s->cache = c;
+    }
+    if (n > c->maxctl) {
+	free((char *) c->ctl);
+	free((char *) c->sf);
+	c->ctl = (zXPoint *) malloc(n * sizeof(zXPoint));
+	c->sf = (double *) malloc(n * sizeof(double));
+	if (c->ctl == NULL || c->sf == NULL) {
+	    free_spline_cache(s);
+	    return NULL;
+	}
+	c->maxctl = n;
+    }
+    c->type = s->type;
+    for (i = 0, p = s->points, sf = s->sfactors; p != NULL && sf != NULL;
+	 i++, p = p->next, sf = sf->next) {
+	c->ctl[i].x = p->x;
+	c->ctl[i].y = p->y;
+	c->sf[i] = sf->s;
+    }
+    c->nctl = i;
+    for (i = 0; i < 2; i++) {
+	if (c->curve[i])
+	    free((char *) c->curve[i]);
+	c->curve[i] = NULL;
+    }
+    return c;
+}
+
+/* compute the curve for spline s into the point array and save it in c */
+
+static Boolean
+compute_spline_curve(F_spline *s, F_spline_cache *c, float precision)
+{
+    int		    k;
+    Boolean	    success;
+
+    if (open_spline(s))
+	success = compute_open_spline(s, precision);
+    else
+	success = compute_closed_spline(s, precision);
+    k = (precision == HIGH_PRECISION) ? 1 : 0;
+    if (success && c != NULL && npoints > 0 &&
+	(c->curve[k] = (zXPoint *) malloc(npoints * sizeof(zXPoint))) != NULL) {
+	    memcpy((char *) c->curve[k], (char *) points, npoints * sizeof(zXPoint));
+	    c->ncurve[k] = npoints;
+    }
+    return success;
+}
+
+/* put the curve for spline s in the point array, from the cache if we can */
+
+static Boolean
+get_spline_points(F_spline *s, float precision)
+{
+    F_spline_cache *c;
+    zXPoint	   *pts;
+    int		    i, k, n;
+
+    k = (precision == HIGH_PRECISION) ? 1 : 0;
+    if ((c = spline_cache(s)) == NULL || c->curve[k] == NULL)
+	return compute_spline_curve(s, c, precision);
+    pts = c->curve[k];
+    n = c->ncurve[k];
+    init_point_array();
+    for (i = 0; i < n; i++)
+	if (!add_point(pts[i].x, pts[i].y))
+	    return False;
+    return True;
+}
+
+/*
+ * Return the curve of spline s for hit-testing etc.  The points belong
+ * to the cache (or the point array) and are only good until the spline
+ * changes or the next spline is computed.
+ */
+
+zXPoint *
+spline_points(F_spline *s, float precision, int *npts)
+{
+    F_spline_cache *c;
+    int		    k;
+
+    k = (precision == HIGH_PRECISION) ? 1 : 0;
+    c = spline_cache(s);
+    if (c == NULL || c->curve[k] == NULL) {
+	if (!compute_spline_curve(s, c, precision)) {
+	    *npts = 0;
+	    return points;
+	}
+	if (c == NULL || c->curve[k] == NULL) {
+	    *npts = npoints;
+	    return points;
+	}
+    }
+    *npts = c->ncurve[k];
+    return c->curve[k];
+}
+
 void
 draw_spline(F_spline *spline, int op)
 {
@@ -2060,10 +2263,7 @@ draw_spline(F_spline *spline, int op)
 		roman_font, 0.0, bufx, RED, COLOR_NONE);
 	}
     }
-    if (open_spline(spline))
-	success = compute_open_spline(spline, precision);
-    else
-	success = compute_closed_spline(spline, precision);
+    success = get_spline_points(spline, precision);
     if (success) {
 	/* setup clipping so that spline doesn't protrude beyond arrowhead */
 	/* also create the arrowheads */
@@ -21,6 +21,11 @@
 
 #include "w_drawprim.h"
 
+/* precision of the curves computed for splines */
+#define HIGH_PRECISION		0.5
+#define LOW_PRECISION		1.0
+#define ZOOM_PRECISION		5.0	/* use HIGH_PRECISION from this zoom on */
+
 #define DRAW_POINTS		True
 #define DONT_DRAW_POINTS	False
 #define DRAW_CENTER		True
@@ -37,6 +42,8 @@ void	draw_compoundelements(F_compound *c, int op);
 
 void	draw_spline(F_spline *spline, int op);
 void	quick_draw_spline(F_spline *spline, int op);
+zXPoint	*spline_points(F_spline *s, float precision, int *npts);
+void	free_spline_cache(F_spline *s);
 
 /* curve routine needed by arc() and show_boxradius() */
 
@@ -31,9 +31,6 @@
 
 ***********************************************************************/
 
-#define         HIGH_PRECISION    0.5
-#define         LOW_PRECISION     1.0
-#define         ZOOM_PRECISION    5.0
 #define         ARROW_START       4
 #define         MAX_SPLINE_STEP   0.2
 
@@ -65,6 +65,7 @@ elastic_box(int x1, int y1, int x2, int y2)
 		INV_PAINT, DEFAULT);
     wid = abs(x2-x1)+1;
     ht = abs(y2-y1)+1;
+    touch_canvas(canvas_win);
     zXDrawRectangle(tool_d, canvas_win, gccache[INV_PAINT],min2(x1,x2),min2(y1,y2),wid,ht);
 }
 
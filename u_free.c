@@ -18,7 +18,13 @@
 #include "fig.h"
 #include "resources.h"
 #include "object.h"
+#include "f_picobj.h"
+#include "u_create.h"
+#include "u_draw.h"
 #include "u_fonts.h"
+#include "u_list.h"
+#include "u_pool.h"
+#include "u_vindex.h"
 #include "w_drawprim.h"
 
 
@@ -45,7 +51,8 @@ void free_arc(F_arc **list)
 	    free((char *) arc->back_arrow);
 	if (arc->comments)
 	    free(arc->comments);
-	free((char *) arc);
+	list_forget_object(arc);
+	pool_free(&arc_pool, arc);
     }
     *list = NULL;
 }
@@ -57,17 +64,21 @@ void free_compound(F_compound **list)
     for (c = *list; c != NULL;) {
 	compound = c;
 	c = c->next;
-	free_arc(&compound->arcs);
-	free_compound(&compound->compounds);
-	free_ellipse(&compound->ellipses);
-	free_line(&compound->lines);
-	free_spline(&compound->splines);
-	free_text(&compound->texts);
+	/* the objects are freed with the last compound sharing them */
+	if (!release_shared_compound(compound)) {
+	    free_arc(&compound->arcs);
+	    free_compound(&compound->compounds);
+	    free_ellipse(&compound->ellipses);
+	    free_line(&compound->lines);
+	    free_spline(&compound->splines);
+	    free_text(&compound->texts);
+	}
 	if (compound->comments) {
 	    free(compound->comments);
 	    compound->comments = NULL;
 	}
-	free((char *) compound);
+	list_forget_object(compound);
+	pool_free(&compound_pool, compound);
 	compound = NULL;
     }
     *list = NULL;
@@ -82,7 +93,8 @@ void free_ellipse(F_ellipse **list)
 	e = e->next;
 	if (ellipse->comments)
 	    free(ellipse->comments);
-	free((char *) ellipse);
+	list_forget_object(ellipse);
+	pool_free(&ellipse_pool, ellipse);
     }
     *list = NULL;
 }
@@ -109,7 +121,8 @@ void free_text(F_text **list)
 	free(text->cstring);
 	if (text->comments)
 	    free(text->comments);
-	free((char *) text);
+	list_forget_object(text);
+	pool_free(&text_pool, text);
     }
     *list = NULL;
 }
@@ -129,6 +142,10 @@ void free_spline(F_spline **list)
 void free_splinestorage(F_spline *s)
 {
 
+    free_spline_cache(s);
+    if (s->bound)
+	free((char *) s->bound);
+    vindex_free(&s->vindex);
     free_points(s->points);
     free_sfactors(s->sfactors);
     if (s->for_arrow)
@@ -137,17 +154,22 @@ void free_splinestorage(F_spline *s)
 	free((char *) s->back_arrow);
     if (s->comments)
 	free(s->comments);
-    free((char *) s);
+    list_forget_object(s);
+    pool_free(&spline_pool, s);
 }
 
 void free_linestorage(F_line *l)
 {
+    if (l->bound)
+	free((char *) l->bound);
+    vindex_free(&l->vindex);
     free_points(l->points);
     if (l->for_arrow)
 	free((char *) l->for_arrow);
     if (l->back_arrow)
 	free((char *) l->back_arrow);
     if (l->pic) {
+	cancel_picobj(l);
 	free_picture_entry(l->pic->pic_cache);
 	if (l->pic->pixmap != 0)
 	    XFreePixmap(tool_d, l->pic->pixmap);
@@ -159,7 +181,8 @@ void free_linestorage(F_line *l)
     }
     if (l->comments)
 	free(l->comments);
-    free((char *) l);
+    list_forget_object(l);
+    pool_free(&line_pool, l);
 }
 
 void free_picture_entry(struct _pics *picture)
@@ -177,19 +200,13 @@ void free_picture_entry(struct _pics *picture)
 	if (appres.DEBUG)
 	    fprintf(stderr,"Delete picture %x %s, refcount = %d\n",
 				picture, picture->file, picture->refcount);
+	/* unlink from the repository */
+	remove_picture_entry(picture);
 	if (picture->bitmap)
 	    free((char *) picture->bitmap);
 	free(picture->file);
 	if (picture->realname)
 	    free(picture->realname);
-	/* unlink from list */
-	if (picture->next)
-	    picture->next->prev = picture->prev;
-	if (picture->prev)
-	    picture->prev->next = picture->next;
-	/* at the head of the list */
-	if (picture->prev == NULL)
-	    pictures = NULL;
 	free(picture);
     } else {
 	if (appres.DEBUG)
@@ -204,7 +221,7 @@ void free_points(F_point *first_point)
 
     for (p = first_point; p != NULL; p = q) {
 	q = p->next;
-	free((char *) p);
+	pool_free(&point_pool, p);
     }
 }
 
@@ -213,7 +230,7 @@ void free_sfactors(F_sfactor *sf)
     F_sfactor	   *a, *b;
     for (a = sf; a != NULL; a = b) {
 	b = a->next;
-	free((char *) a);
+	pool_free(&sfactor_pool, a);
     }
 }
 
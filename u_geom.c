@@ -24,6 +24,7 @@
 #include "fig.h"
 #include "resources.h"
 #include "object.h"
+#include "u_draw.h"
 #include "u_geom.h"
 
 /*************************** ROTATE VECTOR **********************
@@ -531,82 +532,29 @@ close_to_float_vector(float x1, float y1, float x2, float y2, float xp, float yp
     return ok;
 }
 
-static int isfirst, prevx, prevy, firstx, firsty;
-static int tx, ty, td, px1, py1, px2, py2, foundx, foundy;
-
-/* dirty trick: redefine init_point_array to do nothing and 
-   add_point to check distance */
-
-/**********************************/
-/* include common spline routines */
-/**********************************/
-
-static Boolean	add_point(int x, int y);
-static void	init_point_array(void);
-static Boolean	add_closepoint(void);
-
-#include "u_draw_spline.c"
-
-static void
-init_point_array(void)
-{
-}
-
-static Boolean
-add_point(int x, int y)
-{
-    float ux, uy, lambda;
-
-    if (isfirst) {
-	firstx = x;
-	firsty = y;
-	isfirst = False;
-    } else {
-	if (close_to_float_vector((float)prevx, (float)prevy, (float)x, (float)y, 
-                              (float)tx, (float)ty, (float)td, &ux, &uy, &lambda)) {
-	    foundx = round(ux);
-	    foundy = round(uy);
-	    px1 = prevx;
-	    py1 = prevy;
-	    px2 = x;
-	    py2 = y;            
-	    DONE = True;
-	}
-    }
-    prevx = x;
-    prevy = y;
-
-    return True;
-}
-
-static Boolean
-add_closepoint(void) {
-    return add_point(firstx, firsty);
-}
-
 int
 close_to_spline(F_spline *spline, int xp, int yp, int d, int *px, int *py, int *lx1, int *ly1, int *lx2, int *ly2)
 {
-    float	precision;
-
-    tx = xp; ty = yp; /* test point */
-    td = d;           /* tolerance */
-    isfirst = True;
-    precision = HIGH_PRECISION;
-
-    if (open_spline(spline)) 
-	compute_open_spline(spline, precision);
-    else
-	compute_closed_spline(spline, precision);
-    if (DONE) {
-	*px = foundx;
-	*py = foundy;
-	*lx1 = px1;
-	*ly1 = py1;
-	*lx2 = px2;
-	*ly2 = py2;
+    zXPoint	   *p;
+    int		    i, n;
+    float	    ux, uy, lambda;
+
+    /* the curve is cached with the spline, see u_draw.c */
+    p = spline_points(spline, HIGH_PRECISION, &n);
+    for (i = 1; i < n; i++) {
+	if (close_to_float_vector((float)p[i-1].x, (float)p[i-1].y,
+				  (float)p[i].x, (float)p[i].y,
+				  (float)xp, (float)yp, (float)d, &ux, &uy, &lambda)) {
+	    *px = round(ux);
+	    *py = round(uy);
+	    *lx1 = p[i-1].x;
+	    *ly1 = p[i-1].y;
+	    *lx2 = p[i].x;
+	    *ly2 = p[i].y;
+	    return 1;
+	}
     }
-    return DONE;
+    return 0;
 }
 
 /********************* COMPUTE ANGLE ************************
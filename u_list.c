@@ -26,6 +26,7 @@
 #include "u_list.h"
 #include "u_elastic.h"
 #include "u_redraw.h"
+#include "u_rtree.h"
 #include "u_undo.h"
 #include "w_layers.h"
 #include "w_setup.h"
@@ -41,148 +42,411 @@
 int point_on_perim (F_point *p, int llx, int lly, int urx, int ury);
 int point_on_inside (F_point *p, int llx, int lly, int urx, int ury);
 
+/*
+ * The object lists are singly linked, but every object also keeps a prev
+ * pointer and the last object of each list in "objects" is remembered, so
+ * that deleting an object from the figure or appending one to it needn't
+ * walk the list.  Some code still splices the lists by hand (e_glue.c, the
+ * undo swaps), so neither is trusted before checking it against the next
+ * pointers; when the check fails we walk the list as before and set the
+ * prev pointers right on the way.  Only the lists in "objects" are kept
+ * this way, the prev pointers mean nothing in any other list.
+ */
+
+static F_compound fig_heads;	/* objects.xxx when fig_tails.xxx was set */
+static F_compound fig_tails;	/* last object of objects.xxx */
+
+static F_arc	       *
+figure_tail_arc(void)
+{
+    F_arc	   *t = fig_tails.arcs;
+
+    if (t == NULL || fig_heads.arcs != objects.arcs || t->next != NULL)
+	return NULL;
+    if (t->prev == NULL ? t != objects.arcs : t->prev->next != t)
+	return NULL;
+    return t;
+}
+
+static F_ellipse      *
+figure_tail_ellipse(void)
+{
+    F_ellipse	   *t = fig_tails.ellipses;
+
+    if (t == NULL || fig_heads.ellipses != objects.ellipses || t->next != NULL)
+	return NULL;
+    if (t->prev == NULL ? t != objects.ellipses : t->prev->next != t)
+	return NULL;
+    return t;
+}
+
+static F_line	       *
+figure_tail_line(void)
+{
+    F_line	   *t = fig_tails.lines;
+
+    if (t == NULL || fig_heads.lines != objects.lines || t->next != NULL)
+	return NULL;
+    if (t->prev == NULL ? t != objects.lines : t->prev->next != t)
+	return NULL;
+    return t;
+}
+
+static F_spline       *
+figure_tail_spline(void)
+{
+    F_spline	   *t = fig_tails.splines;
+
+    if (t == NULL || fig_heads.splines != objects.splines || t->next != NULL)
+	return NULL;
+    if (t->prev == NULL ? t != objects.splines : t->prev->next != t)
+	return NULL;
+    return t;
+}
+
+static F_text	       *
+figure_tail_text(void)
+{
+    F_text	   *t = fig_tails.texts;
+
+    if (t == NULL || fig_heads.texts != objects.texts || t->next != NULL)
+	return NULL;
+    if (t->prev == NULL ? t != objects.texts : t->prev->next != t)
+	return NULL;
+    return t;
+}
+
+static F_compound     *
+figure_tail_compound(void)
+{
+    F_compound	   *t = fig_tails.compounds;
+
+    if (t == NULL || fig_heads.compounds != objects.compounds || t->next != NULL)
+	return NULL;
+    if (t->prev == NULL ? t != objects.compounds : t->prev->next != t)
+	return NULL;
+    return t;
+}
+
+/* return the object before "obj" in "list", or NULL if "obj" is the first
+   one or isn't in the list at all */
+
+static F_arc	       *
+find_prev_arc(F_arc *list, F_arc *obj)
+{
+    F_arc	   *q, *r;
+
+    if (obj == list)
+	return NULL;
+    if (obj->prev != NULL && obj->prev->next == obj)
+	return obj->prev;
+    for (q = NULL, r = list; r != NULL && r != obj; q = r, r = r->next)
+	if (list == objects.arcs)
+	    r->prev = q;
+    if (r == NULL)
+	return NULL;
+    if (list == objects.arcs)
+	obj->prev = q;
+    return q;
+}
+
+static F_ellipse      *
+find_prev_ellipse(F_ellipse *list, F_ellipse *obj)
+{
+    F_ellipse	   *q, *r;
+
+    if (obj == list)
+	return NULL;
+    if (obj->prev != NULL && obj->prev->next == obj)
+	return obj->prev;
+    for (q = NULL, r = list; r != NULL && r != obj; q = r, r = r->next)
+	if (list == objects.ellipses)
+	    r->prev = q;
+    if (r == NULL)
+	return NULL;
+    if (list == objects.ellipses)
+	obj->prev = q;
+    return q;
+}
+
+static F_line	       *
+find_prev_line(F_line *list, F_line *obj)
+{
+    F_line	   *q, *r;
+
+    if (obj == list)
+	return NULL;
+    if (obj->prev != NULL && obj->prev->next == obj)
+	return obj->prev;
+    for (q = NULL, r = list; r != NULL && r != obj; q = r, r = r->next)
+	if (list == objects.lines)
+	    r->prev = q;
+    if (r == NULL)
+	return NULL;
+    if (list == objects.lines)
+	obj->prev = q;
+    return q;
+}
+
+static F_spline       *
+find_prev_spline(F_spline *list, F_spline *obj)
+{
+    F_spline	   *q, *r;
+
+    if (obj == list)
+	return NULL;
+    if (obj->prev != NULL && obj->prev->next == obj)
+	return obj->prev;
+    for (q = NULL, r = list; r != NULL && r != obj; q = r, r = r->next)
+	if (list == objects.splines)
+	    r->prev = q;
+    if (r == NULL)
+	return NULL;
+    if (list == objects.splines)
+	obj->prev = q;
+    return q;
+}
+
+static F_text	       *
+find_prev_text(F_text *list, F_text *obj)
+{
+    F_text	   *q, *r;
+
+    if (obj == list)
+	return NULL;
+    if (obj->prev != NULL && obj->prev->next == obj)
+	return obj->prev;
+    for (q = NULL, r = list; r != NULL && r != obj; q = r, r = r->next)
+	if (list == objects.texts)
+	    r->prev = q;
+    if (r == NULL)
+	return NULL;
+    if (list == objects.texts)
+	obj->prev = q;
+    return q;
+}
+
+static F_compound     *
+find_prev_compound(F_compound *list, F_compound *obj)
+{
+    F_compound	   *q, *r;
+
+    if (obj == list)
+	return NULL;
+    if (obj->prev != NULL && obj->prev->next == obj)
+	return obj->prev;
+    for (q = NULL, r = list; r != NULL && r != obj; q = r, r = r->next)
+	if (list == objects.compounds)
+	    r->prev = q;
+    if (r == NULL)
+	return NULL;
+    if (list == objects.compounds)
+	obj->prev = q;
+    return q;
+}
+
 void
 list_delete_arc(F_arc **arc_list, F_arc *arc)
 {
-    F_arc	   *a, *aa;
+    F_arc	   *q;
 
     if (*arc_list == NULL)
 	return;
     if (arc == NULL)
 	return;
 
-    if (arc_list == &objects.arcs)
+    if (arc_list == &objects.arcs) {
 	remove_depth(O_ARC, arc->depth);
-    for (a = aa = *arc_list; aa != NULL; a = aa, aa = aa->next) {
-	if (aa == arc) {
-	    if (aa == *arc_list)
-		*arc_list = (*arc_list)->next;
-	    else
-		a->next = aa->next;
-	    break;
-	}
+	rtree_remove_object(O_ARC, arc);
+    }
+    q = NULL;
+    if (arc == *arc_list)
+	*arc_list = arc->next;
+    else if ((q = find_prev_arc(*arc_list, arc)) != NULL)
+	q->next = arc->next;
+    else {
+	arc->next = NULL;	/* not in this list */
+	return;
     }
-    arc->next = NULL;
+    if (arc->next != NULL)
+	arc->next->prev = q;
+    if (arc_list == &objects.arcs) {
+	if (fig_heads.arcs == arc)
+	    fig_heads.arcs = *arc_list;
+	if (fig_tails.arcs == arc)
+	    fig_tails.arcs = q;
+    }
+    arc->prev = arc->next = NULL;
 }
 
 void
 list_delete_ellipse(F_ellipse **ellipse_list, F_ellipse *ellipse)
 {
-    F_ellipse	   *q, *r;
+    F_ellipse	   *q;
 
     if (*ellipse_list == NULL)
 	return;
     if (ellipse == NULL)
 	return;
 
-    if (ellipse_list == &objects.ellipses)
+    if (ellipse_list == &objects.ellipses) {
 	remove_depth(O_ELLIPSE, ellipse->depth);
-    for (q = r = *ellipse_list; r != NULL; q = r, r = r->next) {
-	if (r == ellipse) {
-	    if (r == *ellipse_list)
-		*ellipse_list = (*ellipse_list)->next;
-	    else
-		q->next = r->next;
-	    break;
-	}
+	rtree_remove_object(O_ELLIPSE, ellipse);
+    }
+    q = NULL;
+    if (ellipse == *ellipse_list)
+	*ellipse_list = ellipse->next;
+    else if ((q = find_prev_ellipse(*ellipse_list, ellipse)) != NULL)
+	q->next = ellipse->next;
+    else {
+	ellipse->next = NULL;	/* not in this list */
+	return;
     }
-    ellipse->next = NULL;
+    if (ellipse->next != NULL)
+	ellipse->next->prev = q;
+    if (ellipse_list == &objects.ellipses) {
+	if (fig_heads.ellipses == ellipse)
+	    fig_heads.ellipses = *ellipse_list;
+	if (fig_tails.ellipses == ellipse)
+	    fig_tails.ellipses = q;
+    }
+    ellipse->prev = ellipse->next = NULL;
 }
 
 void
 list_delete_line(F_line **line_list, F_line *line)
 {
-    F_line	   *q, *r;
+    F_line	   *q;
 
     if (*line_list == NULL)
 	return;
     if (line == NULL)
 	return;
 
-    if (line_list == &objects.lines)
+    if (line_list == &objects.lines) {
 	remove_depth(O_POLYLINE, line->depth);
-    for (q = r = *line_list; r != NULL; q = r, r = r->next) {
-	if (r == line) {
-	    if (r == *line_list)
-		*line_list = (*line_list)->next;
-	    else
-		q->next = r->next;
-	    break;
-	}
+	rtree_remove_object(O_POLYLINE, line);
+    }
+    q = NULL;
+    if (line == *line_list)
+	*line_list = line->next;
+    else if ((q = find_prev_line(*line_list, line)) != NULL)
+	q->next = line->next;
+    else {
+	line->next = NULL;	/* not in this list */
+	return;
     }
-    line->next = NULL;
+    if (line->next != NULL)
+	line->next->prev = q;
+    if (line_list == &objects.lines) {
+	if (fig_heads.lines == line)
+	    fig_heads.lines = *line_list;
+	if (fig_tails.lines == line)
+	    fig_tails.lines = q;
+    }
+    line->prev = line->next = NULL;
 }
 
 void
 list_delete_spline(F_spline **spline_list, F_spline *spline)
 {
-    F_spline	   *q, *r;
+    F_spline	   *q;
 
     if (*spline_list == NULL)
 	return;
     if (spline == NULL)
 	return;
 
-    if (spline_list == &objects.splines)
+    if (spline_list == &objects.splines) {
 	remove_depth(O_SPLINE, spline->depth);
-    for (q = r = *spline_list; r != NULL; q = r, r = r->next) {
-	if (r == spline) {
-	    if (r == *spline_list)
-		*spline_list = (*spline_list)->next;
-	    else
-		q->next = r->next;
-	    break;
-	}
+	rtree_remove_object(O_SPLINE, spline);
+    }
+    q = NULL;
+    if (spline == *spline_list)
+	*spline_list = spline->next;
+    else if ((q = find_prev_spline(*spline_list, spline)) != NULL)
+	q->next = spline->next;
+    else {
+	spline->next = NULL;	/* not in this list */
+	return;
+    }
+    if (spline->next != NULL)
+	spline->next->prev = q;
+    if (spline_list == &objects.splines) {
+	if (fig_heads.splines == spline)
+	    fig_heads.splines = *spline_list;
+	if (fig_tails.splines == spline)
+	    fig_tails.splines = q;
     }
-    spline->next = NULL;
+    spline->prev = spline->next = NULL;
 }
 
 void
 list_delete_text(F_text **text_list, F_text *text)
 {
-    F_text	   *q, *r;
+    F_text	   *q;
 
     if (*text_list == NULL)
 	return;
     if (text == NULL)
 	return;
 
-    if (text_list == &objects.texts)
+    if (text_list == &objects.texts) {
 	remove_depth(O_TEXT, text->depth);
-    for (q = r = *text_list; r != NULL; q = r, r = r->next)
-	if (r == text) {
-	    if (r == *text_list)
-		*text_list = text->next;
-	    else
-		q->next = text->next;
-	    break;
-	}
-    text->next = NULL;
+	rtree_remove_object(O_TEXT, text);
+    }
+    q = NULL;
+    if (text == *text_list)
+	*text_list = text->next;
+    else if ((q = find_prev_text(*text_list, text)) != NULL)
+	q->next = text->next;
+    else {
+	text->next = NULL;	/* not in this list */
+	return;
+    }
+    if (text->next != NULL)
+	text->next->prev = q;
+    if (text_list == &objects.texts) {
+	if (fig_heads.texts == text)
+	    fig_heads.texts = *text_list;
+	if (fig_tails.texts == text)
+	    fig_tails.texts = q;
+    }
+    text->prev = text->next = NULL;
 }
 
 void
 list_delete_compound(F_compound **list, F_compound *compound)
 {
-    F_compound	   *c, *cc;
+    F_compound	   *q;
 
     if (*list == NULL)
 	return;
     if (compound == NULL)
 	return;
 
-    if (list == &objects.compounds)
+    if (list == &objects.compounds) {
 	remove_compound_depth(compound);
-
-    for (cc = c = *list; c != NULL; cc = c, c = c->next) {
-	if (c == compound) {
-	    if (c == *list) 
-		*list = (*list)->next;
-	    else
-		cc->next = c->next;
-	    break;
-	}
+	rtree_remove_object(O_COMPOUND, compound);
+    }
+    q = NULL;
+    if (compound == *list)
+	*list = compound->next;
+    else if ((q = find_prev_compound(*list, compound)) != NULL)
+	q->next = compound->next;
+    else {
+	compound->next = NULL;	/* not in this list */
+	return;
+    }
+    if (compound->next != NULL)
+	compound->next->prev = q;
+    if (list == &objects.compounds) {
+	if (fig_heads.compounds == compound)
+	    fig_heads.compounds = *list;
+	if (fig_tails.compounds == compound)
+	    fig_tails.compounds = q;
     }
-    compound->next = NULL;
+    compound->prev = compound->next = NULL;
 }
 
 void
@@ -190,6 +454,7 @@ remove_depth(int type, int depth)
 {
     int		    i;
 
+    invalidate_display_list();
     object_depths[depth]--;
     if (appres.DEBUG)
 	fprintf(stderr,"remove depth %d, count=%d\n",depth,object_depths[depth]);
@@ -296,11 +561,16 @@ list_add_arc(F_arc **list, F_arc *a)
 	*list = a;
     else
 	aa->next = a;
-    if (list == &objects.arcs)
+    a->prev = aa;
+    if (list == &objects.arcs) {
+	fig_heads.arcs = *list;
+	fig_tails.arcs = a;
+	rtree_add_object(O_ARC, a);
 	while (a) {
 	    add_depth(O_ARC, a->depth);
 	    a = a->next;
 	}
+    }
 }
 
 void
@@ -313,11 +583,16 @@ list_add_ellipse(F_ellipse **list, F_ellipse *e)
 	*list = e;
     else
 	ee->next = e;
-    if (list == &objects.ellipses)
+    e->prev = ee;
+    if (list == &objects.ellipses) {
+	fig_heads.ellipses = *list;
+	fig_tails.ellipses = e;
+	rtree_add_object(O_ELLIPSE, e);
 	while (e) {
 	    add_depth(O_ELLIPSE, e->depth);
 	    e = e->next;
 	}
+    }
 }
 
 void
@@ -330,11 +605,16 @@ list_add_line(F_line **list, F_line *l)
 	*list = l;
     else
 	ll->next = l;
-    if (list == &objects.lines)
+    l->prev = ll;
+    if (list == &objects.lines) {
+	fig_heads.lines = *list;
+	fig_tails.lines = l;
+	rtree_add_object(O_POLYLINE, l);
 	while (l) {
 	    add_depth(O_POLYLINE, l->depth);
 	    l = l->next;
 	}
+    }
 }
 
 void
@@ -347,11 +627,16 @@ list_add_spline(F_spline **list, F_spline *s)
 	*list = s;
     else
 	ss->next = s;
-    if (list == &objects.splines)
+    s->prev = ss;
+    if (list == &objects.splines) {
+	fig_heads.splines = *list;
+	fig_tails.splines = s;
+	rtree_add_object(O_SPLINE, s);
 	while (s) {
 	    add_depth(O_SPLINE, s->depth);
 	    s = s->next;
 	}
+    }
 }
 
 void
@@ -364,11 +649,16 @@ list_add_text(F_text **list, F_text *t)
 	*list = t;
     else
 	tt->next = t;
-    if (list == &objects.texts)
+    t->prev = tt;
+    if (list == &objects.texts) {
+	fig_heads.texts = *list;
+	fig_tails.texts = t;
+	rtree_add_object(O_TEXT, t);
 	while (t) {
 	    add_depth(O_TEXT, t->depth);
 	    t = t->next;
 	}
+    }
 }
 
 void
@@ -381,8 +671,11 @@ list_add_compound(F_compound **list, F_compound *c)
 	*list = c;
     else
 	cc->next = c;
-    
+    c->prev = cc;
     if (list == &objects.compounds) {
+	fig_heads.compounds = *list;
+	fig_tails.compounds = c;
+	rtree_add_object(O_COMPOUND, c);
 	while (c) {
 	    add_compound_depth(c);
 	    c = c->next;
@@ -398,6 +691,7 @@ add_depth(int type, int depth)
 {
     int		    i;
 
+    invalidate_display_list();
     object_depths[depth]++;
 
     if (appres.DEBUG)
@@ -685,38 +979,12 @@ change_compound(F_compound *old_c, F_compound *new_c)
 
 void tail(F_compound *ob, F_compound *tails)
 {
-    F_arc	   *a;
-    F_compound	   *c;
-    F_ellipse	   *e;
-    F_line	   *l;
-    F_spline	   *s;
-    F_text	   *t;
-
-    if (NULL != (a = ob->arcs))
-	for (; a->next != NULL; a = a->next)
-		;
-    if (NULL != (c = ob->compounds))
-	for (; c->next != NULL; c = c->next)
-		;
-    if (NULL != (e = ob->ellipses))
-	for (; e->next != NULL; e = e->next)
-		;
-    if (NULL != (l = ob->lines))
-	for (; l->next != NULL; l = l->next)
-		;
-    if (NULL != (s = ob->splines))
-	for (; s->next != NULL; s = s->next)
-		;
-    if (NULL != (t = ob->texts))
-	for (; t->next != NULL; t = t->next)
-		;
-
-    tails->arcs = a;
-    tails->compounds = c;
-    tails->ellipses = e;
-    tails->lines = l;
-    tails->splines = s;
-    tails->texts = t;
+    tails->arcs = last_arc(ob->arcs);
+    tails->compounds = last_compound(ob->compounds);
+    tails->ellipses = last_ellipse(ob->ellipses);
+    tails->lines = last_line(ob->lines);
+    tails->splines = last_spline(ob->splines);
+    tails->texts = last_text(ob->texts);
 }
 
 /*
@@ -727,8 +995,24 @@ void tail(F_compound *ob, F_compound *tails)
 
 void append_objects(F_compound *l1, F_compound *l2, F_compound *tails)
 {
+    F_arc	   *a;
+    F_compound	   *c;
+    F_ellipse	   *e;
+    F_line	   *l;
+    F_spline	   *s;
+    F_text	   *t;
+
     /* don't forget to account for the depths */
     add_compound_depth(l2);
+    /* and the spatial index */
+    if (l1 == &objects) {
+	rtree_add_chain(O_ARC, l2->arcs);
+	rtree_add_chain(O_COMPOUND, l2->compounds);
+	rtree_add_chain(O_ELLIPSE, l2->ellipses);
+	rtree_add_chain(O_POLYLINE, l2->lines);
+	rtree_add_chain(O_SPLINE, l2->splines);
+	rtree_add_chain(O_TEXT, l2->texts);
+    }
 
     if (tails->arcs)
 	tails->arcs->next = l2->arcs;
@@ -754,56 +1038,134 @@ void append_objects(F_compound *l1, F_compound *l2, F_compound *tails)
 	tails->texts->next = l2->texts;
     else
 	l1->texts = l2->texts;
+
+    /* and the back links and tails of the figure */
+    if (l1 != &objects)
+	return;
+    if ((a = l2->arcs) != NULL) {
+	for (a->prev = tails->arcs; a->next != NULL; a = a->next)
+	    a->next->prev = a;
+	fig_heads.arcs = objects.arcs;
+	fig_tails.arcs = a;
+    }
+    if ((c = l2->compounds) != NULL) {
+	for (c->prev = tails->compounds; c->next != NULL; c = c->next)
+	    c->next->prev = c;
+	fig_heads.compounds = objects.compounds;
+	fig_tails.compounds = c;
+    }
+    if ((e = l2->ellipses) != NULL) {
+	for (e->prev = tails->ellipses; e->next != NULL; e = e->next)
+	    e->next->prev = e;
+	fig_heads.ellipses = objects.ellipses;
+	fig_tails.ellipses = e;
+    }
+    if ((l = l2->lines) != NULL) {
+	for (l->prev = tails->lines; l->next != NULL; l = l->next)
+	    l->next->prev = l;
+	fig_heads.lines = objects.lines;
+	fig_tails.lines = l;
+    }
+    if ((s = l2->splines) != NULL) {
+	for (s->prev = tails->splines; s->next != NULL; s = s->next)
+	    s->next->prev = s;
+	fig_heads.splines = objects.splines;
+	fig_tails.splines = s;
+    }
+    if ((t = l2->texts) != NULL) {
+	for (t->prev = tails->texts; t->next != NULL; t = t->next)
+	    t->next->prev = t;
+	fig_heads.texts = objects.texts;
+	fig_tails.texts = t;
+    }
 }
 
 /* Cut is the dual of append. */
 
 void cut_objects(F_compound *objects, F_compound *tails)
 {
+    /* the remembered tails may be cut off, find them again when needed */
+    fig_tails.arcs = NULL;
+    fig_tails.compounds = NULL;
+    fig_tails.ellipses = NULL;
+    fig_tails.lines = NULL;
+    fig_tails.splines = NULL;
+    fig_tails.texts = NULL;
+
     if (tails->arcs) {
 	remove_arc_depths(tails->arcs->next);
+	rtree_remove_chain(O_ARC, tails->arcs->next);
 	tails->arcs->next = NULL;
     } else if (objects->arcs) {
 	remove_arc_depths(objects->arcs);
+	rtree_remove_chain(O_ARC, objects->arcs);
 	objects->arcs = NULL;
     }
     if (tails->compounds) {
 	remove_compound_depth(tails->compounds->next);
+	rtree_remove_chain(O_COMPOUND, tails->compounds->next);
 	tails->compounds->next = NULL;
     } else if (objects->compounds) {
 	remove_compound_depth(objects->compounds);
+	rtree_remove_chain(O_COMPOUND, objects->compounds);
 	objects->compounds = NULL;
     }
     if (tails->ellipses) {
 	remove_ellipse_depths(tails->ellipses->next);
+	rtree_remove_chain(O_ELLIPSE, tails->ellipses->next);
 	tails->ellipses->next = NULL;
     } else if (objects->ellipses) {
 	remove_ellipse_depths(objects->ellipses);
+	rtree_remove_chain(O_ELLIPSE, objects->ellipses);
 	objects->ellipses = NULL;
     }
     if (tails->lines) {
 	remove_line_depths(tails->lines->next);
+	rtree_remove_chain(O_POLYLINE, tails->lines->next);
 	tails->lines->next = NULL;
     } else if (objects->lines) {
 	remove_line_depths(objects->lines);
+	rtree_remove_chain(O_POLYLINE, objects->lines);
 	objects->lines = NULL;
     }
     if (tails->splines) {
 	remove_spline_depths(tails->splines->next);
+	rtree_remove_chain(O_SPLINE, tails->splines->next);
 	tails->splines->next = NULL;
     } else if (objects->splines) {
 	remove_spline_depths(objects->splines);
+	rtree_remove_chain(O_SPLINE, objects->splines);
 	objects->splines = NULL;
     }
     if (tails->texts) {
 	remove_text_depths(tails->texts->next);
+	rtree_remove_chain(O_TEXT, tails->texts->next);
 	tails->texts->next = NULL;
     } else if (objects->texts) {
 	remove_text_depths(objects->texts);
+	rtree_remove_chain(O_TEXT, objects->texts);
 	objects->texts = NULL;
     }
 }
 
+/* "obj" is being freed, make sure we don't remember it as a head or tail */
+
+void list_forget_object(void *obj)
+{
+    if (obj == fig_heads.arcs || obj == fig_tails.arcs)
+	fig_tails.arcs = NULL;
+    if (obj == fig_heads.compounds || obj == fig_tails.compounds)
+	fig_tails.compounds = NULL;
+    if (obj == fig_heads.ellipses || obj == fig_tails.ellipses)
+	fig_tails.ellipses = NULL;
+    if (obj == fig_heads.lines || obj == fig_tails.lines)
+	fig_tails.lines = NULL;
+    if (obj == fig_heads.splines || obj == fig_tails.splines)
+	fig_tails.splines = NULL;
+    if (obj == fig_heads.texts || obj == fig_tails.texts)
+	fig_tails.texts = NULL;
+}
+
 void remove_arc_depths(F_arc *a)
 {
     for ( ; a; a= a->next)
@@ -918,6 +1280,15 @@ last_text(F_text *list)
     if (list == NULL)
 	return NULL;
 
+    if (list == objects.texts) {
+	if ((tt = figure_tail_text()) != NULL)
+	    return tt;
+	for (tt = list, tt->prev = NULL; tt->next != NULL; tt = tt->next)
+	    tt->next->prev = tt;
+	fig_heads.texts = list;
+	fig_tails.texts = tt;
+	return tt;
+    }
     for (tt = list; tt->next != NULL; tt = tt->next)
 	    ;
     return tt;
@@ -931,6 +1302,15 @@ last_line(F_line *list)
     if (list == NULL)
 	return NULL;
 
+    if (list == objects.lines) {
+	if ((ll = figure_tail_line()) != NULL)
+	    return ll;
+	for (ll = list, ll->prev = NULL; ll->next != NULL; ll = ll->next)
+	    ll->next->prev = ll;
+	fig_heads.lines = list;
+	fig_tails.lines = ll;
+	return ll;
+    }
     for (ll = list; ll->next != NULL; ll = ll->next)
 	    ;
     return ll;
@@ -944,6 +1324,15 @@ last_spline(F_spline *list)
     if (list == NULL)
 	return NULL;
 
+    if (list == objects.splines) {
+	if ((ss = figure_tail_spline()) != NULL)
+	    return ss;
+	for (ss = list, ss->prev = NULL; ss->next != NULL; ss = ss->next)
+	    ss->next->prev = ss;
+	fig_heads.splines = list;
+	fig_tails.splines = ss;
+	return ss;
+    }
     for (ss = list; ss->next != NULL; ss = ss->next)
 	    ;
     return ss;
@@ -957,6 +1346,15 @@ last_arc(F_arc *list)
     if (list == NULL)
 	return NULL;
 
+    if (list == objects.arcs) {
+	if ((tt = figure_tail_arc()) != NULL)
+	    return tt;
+	for (tt = list, tt->prev = NULL; tt->next != NULL; tt = tt->next)
+	    tt->next->prev = tt;
+	fig_heads.arcs = list;
+	fig_tails.arcs = tt;
+	return tt;
+    }
     for (tt = list; tt->next != NULL; tt = tt->next)
 	    ;
     return tt;
@@ -970,6 +1368,15 @@ last_ellipse(F_ellipse *list)
     if (list == NULL)
 	return NULL;
 
+    if (list == objects.ellipses) {
+	if ((tt = figure_tail_ellipse()) != NULL)
+	    return tt;
+	for (tt = list, tt->prev = NULL; tt->next != NULL; tt = tt->next)
+	    tt->next->prev = tt;
+	fig_heads.ellipses = list;
+	fig_tails.ellipses = tt;
+	return tt;
+    }
     for (tt = list; tt->next != NULL; tt = tt->next)
 	    ;
     return tt;
@@ -983,6 +1390,15 @@ last_compound(F_compound *list)
     if (list == NULL)
 	return NULL;
 
+    if (list == objects.compounds) {
+	if ((tt = figure_tail_compound()) != NULL)
+	    return tt;
+	for (tt = list, tt->prev = NULL; tt->next != NULL; tt = tt->next)
+	    tt->next->prev = tt;
+	fig_heads.compounds = list;
+	fig_tails.compounds = tt;
+	return tt;
+    }
     for (tt = list; tt->next != NULL; tt = tt->next)
 	    ;
     return tt;
@@ -1051,79 +1467,37 @@ search_sfactor(F_spline *spline, F_point *selected_point)
 F_arc	       *
 prev_arc(F_arc *list, F_arc *arc)
 {
-    F_arc	   *csr;
-
-    if (list == arc)
-	return NULL;
-
-    for (csr = list; csr->next != arc; csr = csr->next)
-	    ;
-    return csr;
+    return find_prev_arc(list, arc);
 }
 
 F_compound     *
 prev_compound(F_compound *list, F_compound *compound)
 {
-    F_compound	   *csr;
-
-    if (list == compound)
-	return NULL;
-
-    for (csr = list; csr->next != compound; csr = csr->next)
-	    ;
-    return csr;
+    return find_prev_compound(list, compound);
 }
 
 F_ellipse      *
 prev_ellipse(F_ellipse *list, F_ellipse *ellipse)
 {
-    F_ellipse	   *csr;
-
-    if (list == ellipse)
-	return NULL;
-
-    for (csr = list; csr->next != ellipse; csr = csr->next)
-	    ;
-    return csr;
+    return find_prev_ellipse(list, ellipse);
 }
 
 F_line	       *
 prev_line(F_line *list, F_line *line)
 {
-    F_line	   *csr;
-
-    if (list == line)
-	return NULL;
-
-    for (csr = list; csr->next != line; csr = csr->next)
-	    ;
-    return csr;
+    return find_prev_line(list, line);
 }
 
 F_spline       *
 prev_spline(F_spline *list, F_spline *spline)
 {
-    F_spline	   *csr;
-
-    if (list == spline)
-	return NULL;
-
-    for (csr = list; csr->next != spline; csr = csr->next)
-	    ;
-    return csr;
+    return find_prev_spline(list, spline);
 }
 
 F_text	       *
 prev_text(F_text *list, F_text *text)
 {
-    F_text	   *csr;
-
-    if (list == text)
-	return NULL;
-
-    for (csr = list; csr->next != text; csr = csr->next)
-	    ;
-    return csr;
+    return find_prev_text(list, text);
 }
 
 F_point	       *
@@ -1207,15 +1581,24 @@ void set_tags(F_compound *list, int tag)
     }
 }
 
+static int LINK_TOL = 3 * PIX_PER_INCH / DISPLAY_PIX_PER_INCH;
+
 void
 get_links(int llx, int lly, int urx, int ury)
 {
     F_line	   *l;
-    F_point	   *a;
+    F_point	   *a, *p, *pp;
     F_linkinfo	   *j, *k;
+    RT_hit	   *hits;
+    int		    i, nhits;
 
     j = NULL;
-    for (l = objects.lines; l != NULL; l = l->next)
+    /* only the lines whose bounds reach the box can end on it */
+    nhits = rtree_search(llx - LINK_TOL, lly - LINK_TOL,
+			 urx + LINK_TOL, ury + LINK_TOL, &hits);
+    i = 0;
+    l = NULL;
+    while ((l = (F_line *) rtree_hit_next(hits, nhits, O_POLYLINE, &i, l)) != NULL)
 	if (l->type == T_POLYLINE) {
 	    a = l->points;
 	    if (point_on_perim(a, llx, lly, urx, ury)) {
@@ -1232,9 +1615,13 @@ get_links(int llx, int lly, int urx, int ury)
 	    }
 	    if (a->next == NULL)/* single point, no need to check further */
 		continue;
-	    a = last_point(l->points);
+	    /* the last point, the one before it and the one before that */
+	    for (pp = NULL, p = a, a = a->next; a->next != NULL; a = a->next) {
+		pp = p;
+		p = a;
+	    }
 	    if (point_on_perim(a, llx, lly, urx, ury)) {
-		if ((k = new_link(l, a, prev_point(l->points, a))) == NULL)
+		if ((k = new_link(l, a, p)) == NULL)
 		    return;
 		if (j == NULL)
 		    cur_links = k;
@@ -1242,14 +1629,12 @@ get_links(int llx, int lly, int urx, int ury)
 		    j->next = k;
 		j = k;
 		if (k->prevpt != NULL)
-		    k->two_pts = (prev_point(l->points, k->prevpt) == NULL);
+		    k->two_pts = (pp == NULL);
 		continue;
 	    }
 	}
 }
 
-static int LINK_TOL = 3 * PIX_PER_INCH / DISPLAY_PIX_PER_INCH;
-
 int
 point_on_perim(F_point *p, int llx, int lly, int urx, int ury)
 {
@@ -1271,11 +1656,16 @@ void
 get_interior_links(int llx, int lly, int urx, int ury)
 {
     F_line	   *l;
-    F_point	   *a;
+    F_point	   *a, *p, *pp;
     F_linkinfo	   *j, *k;
+    RT_hit	   *hits;
+    int		    i, nhits;
 
     j = NULL;
-    for (l = objects.lines; l != NULL; l = l->next)
+    nhits = rtree_search(llx, lly, urx, ury, &hits);
+    i = 0;
+    l = NULL;
+    while ((l = (F_line *) rtree_hit_next(hits, nhits, O_POLYLINE, &i, l)) != NULL)
 	if (l->type == T_POLYLINE) {
 	    a = l->points;
 	    if (point_on_inside(a, llx, lly, urx, ury)) {
@@ -1292,9 +1682,13 @@ get_interior_links(int llx, int lly, int urx, int ury)
 	    }
 	    if (a->next == NULL)/* single point, no need to check further */
 		continue;
-	    a = last_point(l->points);
+	    /* the last point, the one before it and the one before that */
+	    for (pp = NULL, p = a, a = a->next; a->next != NULL; a = a->next) {
+		pp = p;
+		p = a;
+	    }
 	    if (point_on_inside(a, llx, lly, urx, ury)) {
-		if ((k = new_link(l, a, prev_point(l->points, a))) == NULL)
+		if ((k = new_link(l, a, p)) == NULL)
 		    return;
 		if (j == NULL)
 		    cur_links = k;
@@ -1302,7 +1696,7 @@ get_interior_links(int llx, int lly, int urx, int ury)
 		    j->next = k;
 		j = k;
 		if (k->prevpt != NULL)
-		    k->two_pts = (prev_point(l->points, k->prevpt) == NULL);
+		    k->two_pts = (pp == NULL);
 		continue;
 	    }
 	}
@@ -1345,6 +1739,7 @@ adjust_links(int mode, F_linkinfo *links, int dx, int dy, int cx, int cy, float
 	    }
 	    k->endpt->x += dx;
 	    k->endpt->y += dy;
+	    rtree_update_object(O_POLYLINE, k->line);
 	    draw_line(k->line, PAINT);
 	    mask_toggle_linemarker(k->line);
 	}
@@ -96,5 +96,6 @@ extern void remove_line_depths (F_line *l);
 extern void remove_spline_depths (F_spline *s);
 extern void remove_text_depths (F_text *t);
 extern void tail(F_compound *ob, F_compound *tails);
+extern void list_forget_object(void *obj);
 
 #endif /* U_LIST_H */
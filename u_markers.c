@@ -21,13 +21,17 @@
 #include "mode.h"
 #include "paintop.h"
 #include "u_markers.h"
+#include "w_canvas.h"
 #include "w_drawprim.h"
 #include "w_layers.h"
 #include "w_zoom.h"
+#include "w_softdraw.h"
 
+/* markers are only feedback for the user, there are none when drawing headless */
 #define set_marker(win,x,y,w,h) \
-	XDrawRectangle(tool_d,(win),gccache[INV_PAINT], \
-	     ZOOMX(x)-((w-1)/2),ZOOMY(y)-((w-1)/2),(w),(h))
+	(touch_canvas(win), soft_drawing? 0: \
+	 XDrawRectangle(tool_d,(win),gccache[INV_PAINT], \
+	     ZOOMX(x)-((w-1)/2),ZOOMY(y)-((w-1)/2),(w),(h)))
 
 #define CHANGED_MASK(msk) \
     ((oldmask & msk) != (newmask & msk))
@@ -0,0 +1,152 @@
+/*
+ * FIG : Facility for Interactive Generation of figures
+ * Copyright (c) 1985-1988 by Supoj Sutanthavibul
+ * Parts Copyright (c) 1989-2002 by Brian V. Smith
+ * Parts Copyright (c) 1991 by Paul King
+ *
+ * Any party obtaining a copy of these files is granted, free of charge, a
+ * full and unrestricted irrevocable, world-wide, paid up, royalty-free,
+ * nonexclusive right and license to deal in this software and documentation
+ * files (the "Software"), including without limitation the rights to use,
+ * copy, modify, merge, publish distribute, sublicense and/or sell copies of
+ * the Software, and to permit persons who receive copies from any such
+ * party to do so, with the only requirement being that the above copyright
+ * and this permission notice remain intact.
+ *
+ */
+#include "fig.h"
+#include "resources.h"
+#include "object.h"
+#include "u_pool.h"
+
+#define POOL_BLOCK_SIZE	16384		/* bytes per block, about */
+#define POOL_ALIGN	sizeof(double)	/* node alignment */
+
+typedef union pool_block_head {
+    struct pool_block *next;
+    double	    align;
+}
+	pool_block_head;
+
+typedef struct pool_block {
+    pool_block_head h;			/* nodes follow */
+}
+	pool_block;
+
+#define block_next(b)	((b)->h.next)
+#define block_nodes(b)	((char *) ((b) + 1))
+
+#ifdef USE_THREADS
+#define POOL(name, type) { name, sizeof(type), 0, NULL, NULL, NULL, NULL, \
+			    0, 0, 0, 0, 0, 0, PTHREAD_MUTEX_INITIALIZER }
+#define	pool_lock(p)	pthread_mutex_lock(&(p)->lock)
+#define	pool_unlock(p)	pthread_mutex_unlock(&(p)->lock)
+#else
+#define POOL(name, type) { name, sizeof(type), 0, NULL, NULL, NULL, NULL, \
+			    0, 0, 0, 0, 0, 0 }
+#define	pool_lock(p)
+#define	pool_unlock(p)
+#endif /* USE_THREADS */
+
+obj_pool	point_pool = POOL("points", F_point);
+obj_pool	sfactor_pool = POOL("sfactors", F_sfactor);
+obj_pool	arc_pool = POOL("arcs", F_arc);
+obj_pool	compound_pool = POOL("compounds", F_compound);
+obj_pool	ellipse_pool = POOL("ellipses", F_ellipse);
+obj_pool	line_pool = POOL("lines", F_line);
+obj_pool	spline_pool = POOL("splines", F_spline);
+obj_pool	text_pool = POOL("texts", F_text);
+
+obj_pool	*obj_pools[] = {
+		    &point_pool, &sfactor_pool, &arc_pool, &compound_pool,
+		    &ellipse_pool, &line_pool, &spline_pool, &text_pool, NULL };
+
+static Boolean	new_block(obj_pool *pool);
+static void	release_blocks(obj_pool *pool);
+
+/* get a node from pool, NULL if out of memory */
+
+void *
+pool_alloc(obj_pool *pool)
+{
+    char	   *node;
+
+    pool_lock(pool);
+    if ((node = pool->free_list) != NULL) {
+	pool->free_list = *(char **) node;
+    } else {
+	if (pool->next == pool->end && !new_block(pool)) {
+	    pool_unlock(pool);
+	    return NULL;
+	}
+	node = pool->next;
+	pool->next += pool->size;
+    }
+    pool->allocs++;
+    if (++pool->in_use > pool->peak)
+	pool->peak = pool->in_use;
+    pool_unlock(pool);
+    return (void *) node;
+}
+
+/* give a node back to its pool */
+
+void
+pool_free(obj_pool *pool, void *node)
+{
+    if (node == NULL)
+	return;
+    pool_lock(pool);
+    *(char **) node = pool->free_list;
+    pool->free_list = (char *) node;
+    pool->frees++;
+    if (--pool->in_use == 0 && pool->nblocks > 1)
+	release_blocks(pool);
+    pool_unlock(pool);
+}
+
+static Boolean
+new_block(obj_pool *pool)
+{
+    pool_block	   *b;
+
+    if (pool->per_block == 0) {
+	/* first use, round the node size up so every node is aligned */
+	pool->size = (pool->size + POOL_ALIGN - 1) / POOL_ALIGN * POOL_ALIGN;
+	pool->per_block = max2(16, POOL_BLOCK_SIZE / pool->size);
+    }
+    b = (pool_block *) malloc(sizeof(pool_block) + pool->per_block * pool->size);
+    if (b == NULL)
+	return False;
+    block_next(b) = pool->blocks;
+    pool->blocks = b;
+    pool->nblocks++;
+    pool->next = block_nodes(b);
+    pool->end = pool->next + pool->per_block * pool->size;
+    return True;
+}
+
+/*
+ * All nodes of the pool are free: give back all blocks except the newest,
+ * which is kept for the next nodes so a pool that is emptied and filled
+ * again all the time doesn't malloc() and free() a block each time.
+ * A block with some nodes still in use is never given back, even if it
+ * is otherwise empty.
+ */
+
+static void
+release_blocks(obj_pool *pool)
+{
+    pool_block	   *b, *next;
+
+    for (b = block_next(pool->blocks); b != NULL; b = next) {
+	next = block_next(b);
+	free((char *) b);
+    }
+    block_next(pool->blocks) = NULL;
+    pool->nblocks = 1;
+    pool->free_list = NULL;
+    pool->next = block_nodes(pool->blocks);
+    pool->end = pool->next + pool->per_block * pool->size;
+    pool->releases++;
+}
@@ -0,0 +1,61 @@
+/*
+ * FIG : Facility for Interactive Generation of figures
+ * Copyright (c) 1985-1988 by Supoj Sutanthavibul
+ * Parts Copyright (c) 1989-2002 by Brian V. Smith
+ * Parts Copyright (c) 1991 by Paul King
+ *
+ * Any party obtaining a copy of these files is granted, free of charge, a
+ * full and unrestricted irrevocable, world-wide, paid up, royalty-free,
+ * nonexclusive right and license to deal in this software and documentation
+ * files (the "Software"), including without limitation the rights to use,
+ * copy, modify, merge, publish distribute, sublicense and/or sell copies of
+ * the Software, and to permit persons who receive copies from any such
+ * party to do so, with the only requirement being that the above copyright
+ * and this permission notice remain intact.
+ *
+ */
+#ifndef U_POOL_H
+#define U_POOL_H
+
+#ifdef USE_THREADS
+#include <pthread.h>
+#endif
+
+/*
+ * Pools of fixed size nodes for the figure objects and their points.
+ * Nodes are carved from large blocks and freed nodes go on a free list
+ * for reuse, so reading or deleting a big figure doesn't do millions of
+ * small malloc()/free() calls.
+ *
+ * This is not an arena per figure: the pools are shared by the figure,
+ * the undo journal (which keeps the previous figure after New or a load),
+ * the cut buffer and the library objects.  Discarding a figure still
+ * frees its nodes one at a time with free_compound(), and they only go
+ * back on the free lists.  Blocks are given back to malloc() only when
+ * the last node of a pool is freed, which seldom happens while xfig runs.
+ */
+
+typedef struct obj_pool {
+    char	   *name;
+    int		    size;		/* node size, rounded for alignment */
+    int		    per_block;		/* nodes per block */
+    char	   *free_list;		/* freed nodes */
+    char	   *next, *end;		/* unused part of newest block */
+    struct pool_block *blocks;
+    long	    allocs, frees;	/* statistics */
+    long	    in_use, peak;
+    int		    nblocks, releases;
+#ifdef USE_THREADS
+    pthread_mutex_t lock;		/* objects are read by several threads */
+#endif
+}
+	obj_pool;
+
+extern obj_pool	point_pool, sfactor_pool;
+extern obj_pool	arc_pool, compound_pool, ellipse_pool, line_pool, spline_pool, text_pool;
+extern obj_pool	*obj_pools[];		/* all of the above, NULL terminated */
+
+extern void    *pool_alloc(obj_pool *pool);
+extern void	pool_free(obj_pool *pool, void *node);
+
+#endif /* U_POOL_H */
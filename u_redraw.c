@@ -23,8 +23,10 @@
 #include "d_arc.h"
 #include "e_flip.h"
 #include "e_rotate.h"
+#include "f_picobj.h"
 #include "u_draw.h"
 #include "u_redraw.h"
+#include "u_rtree.h"
 #include "w_canvas.h"
 #include "w_drawprim.h"
 #include "w_file.h"
@@ -77,6 +79,8 @@ void redisplay_splineobject (F_spline *splines, int depth);
 void redisplay_textobject (F_text *texts, int depth);
 void redraw_pageborder (void);
 void draw_pb (int x, int y, int w, int h);
+static void redisplay_depth (F_compound *cmpnd, int depth);
+static void draw_region (int xmin, int ymin, int xmax, int ymax);
 
 void
 clearallcounts(void)
@@ -91,6 +95,9 @@ clearallcounts(void)
 	cp->num_texts = 0;
     }
     clearcounts();
+    /* new figure, so the spatial index and display list must be rebuilt */
+    rtree_invalidate();
+    invalidate_display_list();
 }
 
 /*
@@ -111,67 +118,324 @@ clearcounts(void)
     }
 }
 
+/*
+ * Display lists.  Rather than walking every object list once for each depth
+ * in use, the primitive objects (compounds are flattened) are put in one
+ * array and sorted by depth, deepest first.  The sort is stable and the
+ * objects are collected in the same order as the depth loop used to visit
+ * them (arcs, compounds, ellipses, lines, splines, texts), so the drawing
+ * order is unchanged.  The list for the whole figure is kept between
+ * redraws and thrown away by invalidate_display_list(), which add_depth()
+ * and remove_depth() call whenever an object comes or goes or changes depth.
+ */
+
+typedef struct dl_entry {
+    int		    type;
+    void	   *obj;
+    int		    depth;
+}
+	DL_entry;
+
+typedef struct dl_list {
+    DL_entry	   *entries;
+    int		    count;
+    int		    size;
+}
+	DL_list;
+
+static DL_list	dl_figure;		/* cached list for "objects" */
+static DL_list	dl_temp;		/* anything else, rebuilt each time */
+static DL_entry	*dl_sorted;		/* scratch space for the sort */
+static int	dl_sorted_size = 0;
+static Boolean	dl_valid = False;
+static F_compound dl_heads;		/* list heads of "objects" when built */
+static int	dl_bucket[MAX_DEPTH + 2];
+
+void
+invalidate_display_list(void)
+{
+    dl_valid = False;
+}
+
+static Boolean
+dl_add(DL_list *dl, int type, void *obj, int depth)
+{
+    DL_entry	   *e;
+    int		    size;
+
+    if (dl->count >= dl->size) {
+	size = dl->size ? 2 * dl->size : 256;
+	e = (DL_entry *) realloc(dl->entries, size * sizeof(DL_entry));
+	if (e == NULL)
+	    return False;
+	dl->entries = e;
+	dl->size = size;
+    }
+    e = &dl->entries[dl->count++];
+    e->type = type;
+    e->obj = obj;
+    e->depth = min2(depth, MAX_DEPTH);
+    return True;
+}
+
+/* add the primitive objects in the lists of compound c */
+
+static Boolean
+dl_add_lists(DL_list *dl, F_compound *c)
+{
+    F_arc	   *a;
+    F_compound	   *cc;
+    F_ellipse	   *e;
+    F_line	   *l;
+    F_spline	   *s;
+    F_text	   *t;
+
+    for (a = c->arcs; a != NULL; a = a->next)
+	if (!dl_add(dl, O_ARC, (void *) a, a->depth))
+	    return False;
+    for (cc = c->compounds; cc != NULL; cc = cc->next)
+	if (!dl_add_lists(dl, cc))
+	    return False;
+    for (e = c->ellipses; e != NULL; e = e->next)
+	if (!dl_add(dl, O_ELLIPSE, (void *) e, e->depth))
+	    return False;
+    for (l = c->lines; l != NULL; l = l->next)
+	if (!dl_add(dl, O_POLYLINE, (void *) l, l->depth))
+	    return False;
+    for (s = c->splines; s != NULL; s = s->next)
+	if (!dl_add(dl, O_SPLINE, (void *) s, s->depth))
+	    return False;
+    for (t = c->texts; t != NULL; t = t->next)
+	if (!dl_add(dl, O_TEXT, (void *) t, t->depth))
+	    return False;
+    return True;
+}
+
+/* stable counting sort of the list on depth, deepest first */
+
+static Boolean
+dl_sort(DL_list *dl)
+{
+    DL_entry	   *e;
+    int		    i, d, n;
+
+    if (dl->count < 2)
+	return True;
+    if (dl_sorted_size < dl->count) {
+	e = (DL_entry *) realloc(dl_sorted, dl->size * sizeof(DL_entry));
+	if (e == NULL)
+	    return False;
+	dl_sorted = e;
+	dl_sorted_size = dl->size;
+    }
+    for (d = 0; d <= MAX_DEPTH + 1; d++)
+	dl_bucket[d] = 0;
+    /* bucket MAX_DEPTH - depth comes first */
+    for (i = 0; i < dl->count; i++)
+	dl_bucket[MAX_DEPTH - dl->entries[i].depth + 1]++;
+    for (d = 1; d <= MAX_DEPTH + 1; d++)
+	dl_bucket[d] += dl_bucket[d - 1];
+    for (i = 0; i < dl->count; i++) {
+	n = dl_bucket[MAX_DEPTH - dl->entries[i].depth]++;
+	dl_sorted[n] = dl->entries[i];
+    }
+    /* swap the arrays, the old one becomes the scratch space */
+    e = dl->entries;
+    dl->entries = dl_sorted;
+    dl_sorted = e;
+    n = dl->size;
+    dl->size = dl_sorted_size;
+    dl_sorted_size = n;
+    return True;
+}
+
+/*
+ * Return the display list for compound c, or for just the objects in
+ * hits if culled is set.  Returns NULL if there isn't enough memory.
+ */
+
+static DL_list *
+get_display_list(F_compound *c, Boolean culled, RT_hit *hits, int nhits)
+{
+    DL_list	   *dl;
+    int		    i;
+    Boolean	    ok;
+
+    if (!culled && c == &objects) {
+	if (dl_valid && dl_heads.arcs == objects.arcs &&
+	    dl_heads.compounds == objects.compounds &&
+	    dl_heads.ellipses == objects.ellipses &&
+	    dl_heads.lines == objects.lines &&
+	    dl_heads.splines == objects.splines &&
+	    dl_heads.texts == objects.texts)
+		return &dl_figure;
+	dl = &dl_figure;
+    } else {
+	dl = &dl_temp;
+    }
+
+    dl->count = 0;
+    if (culled) {
+	ok = True;
+	for (i = 0; ok && i < nhits; i++) {
+	    switch (hits[i].type) {
+	      case O_ARC:
+		ok = dl_add(dl, O_ARC, hits[i].obj,
+			    ((F_arc *) hits[i].obj)->depth);
+		break;
+	      case O_COMPOUND:
+		ok = dl_add_lists(dl, (F_compound *) hits[i].obj);
+		break;
+	      case O_ELLIPSE:
+		ok = dl_add(dl, O_ELLIPSE, hits[i].obj,
+			    ((F_ellipse *) hits[i].obj)->depth);
+		break;
+	      case O_POLYLINE:
+		ok = dl_add(dl, O_POLYLINE, hits[i].obj,
+			    ((F_line *) hits[i].obj)->depth);
+		break;
+	      case O_SPLINE:
+		ok = dl_add(dl, O_SPLINE, hits[i].obj,
+			    ((F_spline *) hits[i].obj)->depth);
+		break;
+	      case O_TEXT:
+		ok = dl_add(dl, O_TEXT, hits[i].obj,
+			    ((F_text *) hits[i].obj)->depth);
+		break;
+	    }
+	}
+    } else {
+	ok = dl_add_lists(dl, c);
+    }
+    if (ok)
+	ok = dl_sort(dl);
+    if (dl == &dl_figure) {
+	dl_valid = ok;
+	dl_heads = objects;
+    }
+    return ok ? dl : (DL_list *) NULL;
+}
+
+/* draw the objects in the list on active (or inactive) layers */
+
+static void
+draw_display_list(DL_list *dl, Boolean active)
+{
+    DL_entry	   *e, *end;
+
+    end = dl->entries + dl->count;
+    for (e = dl->entries; e < end; e++) {
+	if (!draw_parent_gray &&
+	    (active ? !active_layer(e->depth) : active_layer(e->depth)))
+		continue;
+	switch (e->type) {
+	  case O_ARC:
+	    draw_arc((F_arc *) e->obj, PAINT);
+	    break;
+	  case O_ELLIPSE:
+	    draw_ellipse((F_ellipse *) e->obj, PAINT);
+	    break;
+	  case O_POLYLINE:
+	    draw_line((F_line *) e->obj, PAINT);
+	    break;
+	  case O_SPLINE:
+	    draw_spline((F_spline *) e->obj, PAINT);
+	    break;
+	  case O_TEXT:
+	    draw_text((F_text *) e->obj, PAINT);
+	    break;
+	}
+    }
+}
+
 void redisplay_objects(F_compound *active_objects)
 {
     int		    depth;
-    F_compound	   *objects, *save_objects;
+    F_compound	   *cmpnd, *save_objects;
+    DL_list	   *dl;
+    RT_hit	   *hits;
+    int		    nhits, margin;
+    Boolean	    culled;
   
-    objects = active_objects;
+    cmpnd = active_objects;
     save_objects = (F_compound *) NULL;
 
     draw_parent_gray = False;
 
-    if (objects == NULL)
+    if (cmpnd == NULL)
 	return;
 
     /*
      * Opened compound with `keep parent visible'?
      */
-    for (; (objects->parent != NULL) && (objects->draw_parent); ) {
+    for (; (cmpnd->parent != NULL) && (cmpnd->draw_parent); ) {
 	if (!save_objects)
-	    save_objects = objects;
+	    save_objects = cmpnd;
 	/* put in any changes */
-	*((F_compound*)objects->GABPtr) = *objects;            
+	*((F_compound*)cmpnd->GABPtr) = *cmpnd;            
+	invalidate_compound_bound((F_compound*)cmpnd->GABPtr);
 	/* follow parent to the top */
-	objects = objects->parent;
+	cmpnd = cmpnd->parent;
 	/* instruct lower level procs to draw gray */
 	draw_parent_gray = True;
     }
 
-    clearcounts();
-
-    /* if user wants gray inactive layers, draw them first */
-    if (gray_layers || draw_parent_gray) {
-	for (depth = max_depth; depth >= min_depth; --depth) {
-	    if (!active_layer(depth) || draw_parent_gray) {
-		redisplay_arcobject(objects->arcs, depth);
-		redisplay_compoundobject(objects->compounds, depth);
-		redisplay_ellipseobject(objects->ellipses, depth);
-		redisplay_lineobject(objects->lines, depth);
-		redisplay_splineobject(objects->splines, depth);
-		redisplay_textobject(objects->texts, depth);
-	    }
-	}
-    }
-
     if (draw_parent_gray) {
+	/* draw the whole parent in gray first */
+	if ((dl = get_display_list(cmpnd, False, NULL, 0)) != NULL) {
+	    draw_display_list(dl, False);
+	} else {
+	    clearcounts();
+	    for (depth = max_depth; depth >= min_depth; --depth)
+		redisplay_depth(cmpnd, depth);
+	}
 	/* now point to just the open compound and (re)draw it */
-	clearcounts();
-	objects = save_objects;
+	cmpnd = save_objects;
 	draw_parent_gray = False;
     }
 
-    /* now draw the active layers in their normal colors */
-    for (depth = max_depth; depth >= min_depth; --depth) {
-	if (active_layer(depth)) {
-	    redisplay_arcobject(objects->arcs, depth);
-	    redisplay_compoundobject(objects->compounds, depth);
-	    redisplay_ellipseobject(objects->ellipses, depth);
-	    redisplay_lineobject(objects->lines, depth);
-	    redisplay_splineobject(objects->splines, depth);
-	    redisplay_textobject(objects->texts, depth);
+    /*
+     * If we are drawing the figure itself, only look at the objects
+     * whose bounds fall inside the clip window.
+     */
+    hits = (RT_hit *) NULL;
+    nhits = 0;
+    culled = False;
+    /* a full redraw uses the list kept for the whole figure instead */
+    if (active_objects == &objects &&
+	(clip_xmin > 0 || clip_ymin > 0 ||
+	 clip_xmax < CANVAS_WD || clip_ymax < CANVAS_HT)) {
+	culled = True;
+	margin = (int) (2.0 / zoomscale) + 1;
+	nhits = rtree_search(BACKX(clip_xmin) - margin, BACKY(clip_ymin) - margin,
+			     BACKX(clip_xmax) + margin, BACKY(clip_ymax) + margin,
+			     &hits);
+	/* no memory to collect them, draw them all */
+	if (nhits < 0)
+	    culled = False;
+    }
+
+    /* send the lines of the figure to the server in batches */
+    begin_batch();
+    if ((dl = get_display_list(cmpnd, culled, hits, nhits)) != NULL) {
+	/* if user wants gray inactive layers, draw them first */
+	if (gray_layers)
+	    draw_display_list(dl, False);
+	/* now draw the active layers in their normal colors */
+	draw_display_list(dl, True);
+    } else {
+	/* no memory for the display list, look at each depth in turn */
+	clearcounts();
+	if (gray_layers) {
+	    for (depth = max_depth; depth >= min_depth; --depth)
+		if (!active_layer(depth))
+		    redisplay_depth(cmpnd, depth);
 	}
+	for (depth = max_depth; depth >= min_depth; --depth)
+	    if (active_layer(depth))
+		redisplay_depth(cmpnd, depth);
     }
+    end_batch();
 
     /*
      * Point markers and compounds, not being ``real objects'', are handled
@@ -188,6 +452,17 @@ void redisplay_objects(F_compound *active_objects)
 	center_marker(setanchor_x, setanchor_y);
 }
 
+static void
+redisplay_depth(F_compound *cmpnd, int depth)
+{
+    redisplay_arcobject(cmpnd->arcs, depth);
+    redisplay_compoundobject(cmpnd->compounds, depth);
+    redisplay_ellipseobject(cmpnd->ellipses, depth);
+    redisplay_lineobject(cmpnd->lines, depth);
+    redisplay_splineobject(cmpnd->splines, depth);
+    redisplay_textobject(cmpnd->texts, depth);
+}
+
 /*
  * Redisplay a list of arcs.  Only display arcs of the correct depth.
  * For each arc drawn, update the count for the appropriate depth in
@@ -459,12 +734,65 @@ void redisplay_region(int xmin, int ymin, int xmax, int ymax)
     ymin -= 10;
     xmax += 10;
     ymax += 10;
+    draw_region(xmin, ymin, xmax, ymax);
+    reset_cursor();
+}
+
+/*
+ * Draw the objects in the region, by way of the canvas buffer if we are
+ * drawing on the canvas.
+ */
+
+static void
+draw_region(int xmin, int ymin, int xmax, int ymax)
+{
+    Boolean	    buffered;
+
+    buffered = (canvas_win == main_canvas && begin_canvas_buffer());
     set_clip_window(xmin, ymin, xmax, ymax);
     clear_canvas();
     redisplay_objects(&objects);
     redisplay_curobj();
     reset_clip_window();
-    reset_cursor();
+    if (buffered)
+	end_canvas_buffer(xmin, ymin, xmax, ymax);
+    /* every picture on the screen has been drawn now */
+    if (canvas_win == main_canvas && xmin <= 0 && ymin <= 0 &&
+	xmax >= CANVAS_WD && ymax >= CANVAS_HT)
+	    pictures_shown();
+}
+
+/*
+ * The canvas was exposed (or panned).  If the canvas buffer is still
+ * good, bring it up to date with the pan offsets, drawing only the strips
+ * that have scrolled into view, and copy it to the window.  Otherwise
+ * redraw the region from the objects.
+ */
+
+void restore_region(int xmin, int ymin, int xmax, int ymax)
+{
+    int		    dx, dy;
+
+    if (preview_in_progress || canvas_win != main_canvas ||
+	!canvas_buffer_shift(&dx, &dy)) {
+	    redisplay_region(xmin, ymin, xmax, ymax);
+	    return;
+    }
+    if (dx != 0 || dy != 0) {
+	set_temp_cursor(wait_cursor);
+	shift_canvas_buffer(dx, dy);
+	if (dx > 0)
+	    draw_region(0, 0, dx - 1, CANVAS_HT);
+	else if (dx < 0)
+	    draw_region(CANVAS_WD + dx, 0, CANVAS_WD, CANVAS_HT);
+	if (dy > 0)
+	    draw_region(0, 0, CANVAS_WD, dy - 1);
+	else if (dy < 0)
+	    draw_region(0, CANVAS_HT + dy, CANVAS_WD, CANVAS_HT);
+	reset_cursor();
+    }
+    copy_canvas_buffer(max2(xmin, 0), max2(ymin, 0),
+		       min2(xmax, CANVAS_WD), min2(ymax, CANVAS_HT));
 }
 
 /* update page border with new page size */
@@ -484,6 +812,7 @@ void update_pageborder(void)
 void redisplay_pageborder(void)
 {
 
+    touch_canvas(canvas_win);
     set_clip_window(clip_xmin, clip_ymin, clip_xmax, clip_ymax);
     /* first the axis lines */
     if (appres.showaxislines) {
@@ -578,10 +907,18 @@ void redisplay_zoomed_region(int xmin, int ymin, int xmax, int ymax)
     redisplay_region(ZOOMX(xmin), ZOOMY(ymin), ZOOMX(xmax), ZOOMY(ymax));
 }
 
+/*
+ * The redisplay_xxx() routines are called after an object has been
+ * changed, often in place, so they also keep its entry in the spatial
+ * index current.
+ */
+
 void redisplay_ellipse(F_ellipse *e)
 {
     int		    xmin, ymin, xmax, ymax;
 
+    rtree_update_object(O_ELLIPSE, e);
+
     ellipse_bound(e, &xmin, &ymin, &xmax, &ymax);
     redisplay_zoomed_region(xmin, ymin, xmax, ymax);
 }
@@ -591,6 +928,9 @@ void redisplay_ellipses(F_ellipse *e1, F_ellipse *e2)
     int		    xmin1, ymin1, xmax1, ymax1;
     int		    xmin2, ymin2, xmax2, ymax2;
 
+    rtree_update_object(O_ELLIPSE, e1);
+    rtree_update_object(O_ELLIPSE, e2);
+
     ellipse_bound(e1, &xmin1, &ymin1, &xmax1, &ymax1);
     ellipse_bound(e2, &xmin2, &ymin2, &xmax2, &ymax2);
     redisplay_regions(xmin1, ymin1, xmax1, ymax1, xmin2, ymin2, xmax2, ymax2);
@@ -601,6 +941,8 @@ void redisplay_arc(F_arc *a)
     int		    xmin, ymin, xmax, ymax;
     int		    cx, cy;
 
+    rtree_update_object(O_ARC, a);
+
     arc_bound(a, &xmin, &ymin, &xmax, &ymax);
     /* if vertices (and center point) are shown, make sure to include them in the clip area */
     if (appres.shownums) {
@@ -630,6 +972,9 @@ void redisplay_arcs(F_arc *a1, F_arc *a2)
     int		    xmin1, ymin1, xmax1, ymax1;
     int		    xmin2, ymin2, xmax2, ymax2;
 
+    rtree_update_object(O_ARC, a1);
+    rtree_update_object(O_ARC, a2);
+
     arc_bound(a1, &xmin1, &ymin1, &xmax1, &ymax1);
     arc_bound(a2, &xmin2, &ymin2, &xmax2, &ymax2);
     redisplay_regions(xmin1, ymin1, xmax1, ymax1, xmin2, ymin2, xmax2, ymax2);
@@ -639,6 +984,8 @@ void redisplay_spline(F_spline *s)
 {
     int		    xmin, ymin, xmax, ymax;
 
+    rtree_update_object(O_SPLINE, s);
+
     spline_bound(s, &xmin, &ymin, &xmax, &ymax);
     redisplay_zoomed_region(xmin, ymin, xmax, ymax);
 }
@@ -648,6 +995,9 @@ void redisplay_splines(F_spline *s1, F_spline *s2)
     int		    xmin1, ymin1, xmax1, ymax1;
     int		    xmin2, ymin2, xmax2, ymax2;
 
+    rtree_update_object(O_SPLINE, s1);
+    rtree_update_object(O_SPLINE, s2);
+
     spline_bound(s1, &xmin1, &ymin1, &xmax1, &ymax1);
     spline_bound(s2, &xmin2, &ymin2, &xmax2, &ymax2);
     redisplay_regions(xmin1, ymin1, xmax1, ymax1, xmin2, ymin2, xmax2, ymax2);
@@ -657,6 +1007,8 @@ void redisplay_line(F_line *l)
 {
     int		    xmin, ymin, xmax, ymax;
 
+    rtree_update_object(O_POLYLINE, l);
+
     line_bound(l, &xmin, &ymin, &xmax, &ymax);
     redisplay_zoomed_region(xmin, ymin, xmax, ymax);
 }
@@ -666,6 +1018,9 @@ void redisplay_lines(F_line *l1, F_line *l2)
     int		    xmin1, ymin1, xmax1, ymax1;
     int		    xmin2, ymin2, xmax2, ymax2;
 
+    rtree_update_object(O_POLYLINE, l1);
+    rtree_update_object(O_POLYLINE, l2);
+
     line_bound(l1, &xmin1, &ymin1, &xmax1, &ymax1);
     line_bound(l2, &xmin2, &ymin2, &xmax2, &ymax2);
     redisplay_regions(xmin1, ymin1, xmax1, ymax1, xmin2, ymin2, xmax2, ymax2);
@@ -673,12 +1028,17 @@ void redisplay_lines(F_line *l1, F_line *l2)
 
 void redisplay_compound(F_compound *c)
 {
+    rtree_update_object(O_COMPOUND, c);
+
     redisplay_zoomed_region(c->nwcorner.x, c->nwcorner.y,
 			    c->secorner.x, c->secorner.y);
 }
 
 void redisplay_compounds(F_compound *c1, F_compound *c2)
 {
+    rtree_update_object(O_COMPOUND, c1);
+    rtree_update_object(O_COMPOUND, c2);
+
     redisplay_regions(c1->nwcorner.x, c1->nwcorner.y,
 		      c1->secorner.x, c1->secorner.y,
 		      c2->nwcorner.x, c2->nwcorner.y,
@@ -690,6 +1050,8 @@ void redisplay_text(F_text *t)
     int		    xmin, ymin, xmax, ymax;
     int		    dum;
 
+    rtree_update_object(O_TEXT, t);
+
     text_bound(t, &xmin, &ymin, &xmax, &ymax,
 		&dum,&dum,&dum,&dum,&dum,&dum,&dum,&dum);
     redisplay_zoomed_region(xmin, ymin, xmax, ymax);
@@ -701,6 +1063,9 @@ void redisplay_texts(F_text *t1, F_text *t2)
     int		    xmin2, ymin2, xmax2, ymax2;
     int		    dum;
 
+    rtree_update_object(O_TEXT, t1);
+    rtree_update_object(O_TEXT, t2);
+
     text_bound(t1, &xmin1, &ymin1, &xmax1, &ymax1,
 		&dum,&dum,&dum,&dum,&dum,&dum,&dum,&dum);
     text_bound(t2, &xmin2, &ymin2, &xmax2, &ymax2,
@@ -711,17 +1076,94 @@ void redisplay_texts(F_text *t1, F_text *t2)
 
 void redisplay_regions(int xmin1, int ymin1, int xmax1, int ymax1, int xmin2, int ymin2, int xmax2, int ymax2)
 {
-    if (xmin1 == xmin2 && ymin1 == ymin2 && xmax1 == xmax2 && ymax1 == ymax2) {
-	redisplay_zoomed_region(xmin1, ymin1, xmax1, ymax1);
-	return;
+    add_damage(ZOOMX(xmin1), ZOOMY(ymin1), ZOOMX(xmax1), ZOOMY(ymax1));
+    add_damage(ZOOMX(xmin2), ZOOMY(ymin2), ZOOMX(xmax2), ZOOMY(ymax2));
+    redisplay_damage();
+}
+
+/*
+ * Damaged parts of the canvas are collected in a short list of rectangles
+ * (screen coordinates) and repaired together.  A rectangle that overlaps
+ * or touches one already in the list is merged with it, so the pieces of
+ * an expose, or the old and new place of a moved object, are drawn in one
+ * pass over the objects instead of one pass each.  Rectangles apart from
+ * each other are still drawn separately; drawing their bounding box could
+ * cost far more than drawing each of them.
+ */
+
+#define		MAX_DAMAGE	16
+
+static struct {
+    int		    xmin, ymin, xmax, ymax;
+}		damage[MAX_DAMAGE];
+static int	ndamage = 0;
+
+void add_damage(int xmin, int ymin, int xmax, int ymax)
+{
+    int		    i;
+
+    /* the merged rectangle may now reach others, so start over after each */
+    for (i = 0; i < ndamage; ) {
+	if (overlapping(xmin, ymin, xmax, ymax, damage[i].xmin, damage[i].ymin,
+			damage[i].xmax, damage[i].ymax)) {
+	    xmin = min2(xmin, damage[i].xmin);
+	    ymin = min2(ymin, damage[i].ymin);
+	    xmax = max2(xmax, damage[i].xmax);
+	    ymax = max2(ymax, damage[i].ymax);
+	    damage[i] = damage[--ndamage];
+	    i = 0;
+	} else {
+	    i++;
+	}
     }
-    /* below is easier than sending clip rectangle array to X */
-    if (overlapping(xmin1, ymin1, xmax1, ymax1, xmin2, ymin2, xmax2, ymax2)) {
-	redisplay_zoomed_region(min2(xmin1, xmin2), min2(ymin1, ymin2),
-				max2(xmax1, xmax2), max2(ymax1, ymax2));
-    } else {
-	redisplay_zoomed_region(xmin1, ymin1, xmax1, ymax1);
-	redisplay_zoomed_region(xmin2, ymin2, xmax2, ymax2);
+    /* too many pieces, take the lot */
+    if (ndamage == MAX_DAMAGE) {
+	for (i = 0; i < ndamage; i++) {
+	    xmin = min2(xmin, damage[i].xmin);
+	    ymin = min2(ymin, damage[i].ymin);
+	    xmax = max2(xmax, damage[i].xmax);
+	    ymax = max2(ymax, damage[i].ymax);
+	}
+	ndamage = 0;
     }
+    damage[ndamage].xmin = xmin;
+    damage[ndamage].ymin = ymin;
+    damage[ndamage].xmax = xmax;
+    damage[ndamage].ymax = ymax;
+    ndamage++;
+}
+
+/* forget the damage, e.g. for the exposes we get at start up */
+
+void discard_damage(void)
+{
+    ndamage = 0;
+}
+
+/* redraw the damaged rectangles from the objects */
+
+void redisplay_damage(void)
+{
+    int		    i, n;
+
+    /* redisplay_region() may come back here through redisplay_curobj() */
+    n = ndamage;
+    ndamage = 0;
+    for (i = 0; i < n; i++)
+	redisplay_region(damage[i].xmin, damage[i].ymin,
+			 damage[i].xmax, damage[i].ymax);
+}
+
+/* bring back the damaged rectangles, from the canvas buffer if it's good */
+
+void restore_damage(void)
+{
+    int		    i, n;
+
+    n = ndamage;
+    ndamage = 0;
+    for (i = 0; i < n; i++)
+	restore_region(damage[i].xmin, damage[i].ymin,
+		       damage[i].xmax, damage[i].ymax);
 }
 
@@ -20,6 +20,7 @@ extern Boolean	request_redraw;		/* set in redisplay_region if called when
 					   preview_in_progress is true */
 extern void	clearcounts(void);		/* clear object counters for each depth */
 extern void	clearallcounts(void);	/* clear all object counters for each depth */
+extern void	invalidate_display_list(void);	/* objects added, removed or moved in depth */
 
 /*
  * Support for rendering based on correct object depth.	 A simple depth based
@@ -66,4 +67,9 @@ extern void redisplay_zoomed_region (int xmin, int ymin, int xmax, int ymax);
 extern void update_pageborder (void);
 
 extern void redisplay_region (int xmin, int ymin, int xmax, int ymax);
+extern void restore_region (int xmin, int ymin, int xmax, int ymax);
 extern void redisplay_regions (int xmin1, int ymin1, int xmax1, int ymax1, int xmin2, int ymin2, int xmax2, int ymax2);
+extern void add_damage (int xmin, int ymin, int xmax, int ymax);
+extern void discard_damage (void);
+extern void redisplay_damage (void);
+extern void restore_damage (void);
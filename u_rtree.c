@@ -0,0 +1,996 @@
+/*
+ * FIG : Facility for Interactive Generation of figures
+ * Copyright (c) 1985-1988 by Supoj Sutanthavibul
+ * Parts Copyright (c) 1989-2002 by Brian V. Smith
+ * Parts Copyright (c) 1991 by Paul King
+ *
+ * Any party obtaining a copy of these files is granted, free of charge, a
+ * full and unrestricted irrevocable, world-wide, paid up, royalty-free,
+ * nonexclusive right and license to deal in this software and documentation
+ * files (the "Software"), including without limitation the rights to use,
+ * copy, modify, merge, publish distribute, sublicense and/or sell copies of
+ * the Software, and to permit persons who receive copies from any such
+ * party to do so, with the only requirement being that the above copyright
+ * and this permission notice remain intact.
+ *
+ */
+
+/*
+ * Spatial index of the top-level objects of the figure, so that redrawing
+ * a small part of the canvas only has to look at the objects that are
+ * actually there.
+ *
+ * Each object in the objects lists has an entry holding its bounding box
+ * and a sequence number giving its position in its list.  The entries are
+ * found by object pointer through a hash table and by area through an
+ * R-tree (Guttman's quadratic split).  Removing objects leaves underfull
+ * nodes behind; when too many have accumulated, or the index has been
+ * invalidated, the whole tree is rebuilt on the next search.  The point
+ * grids of long lines and splines (u_vindex.c) are dropped along with it.
+ */
+
+#include "fig.h"
+#include "resources.h"
+#include "object.h"
+#include "u_bound.h"
+#include "u_list.h"
+#include "u_rtree.h"
+#include "u_vindex.h"
+#include "w_zoom.h"
+
+#define RT_MAXENT	8		/* max children per node */
+#define RT_MINENT	3		/* min children per node after split */
+#define RT_HASHSIZE	1024		/* initial size of hash table (power of 2) */
+
+typedef struct rt_rect {
+    int		    xmin, ymin, xmax, ymax;
+}
+	RT_rect;
+
+typedef struct rt_entry {
+    int		     type;
+    void	    *obj;
+    unsigned	     seq;
+    RT_rect	     r;
+    struct rt_node  *leaf;		/* leaf node holding this entry */
+    struct rt_entry *hnext;		/* hash chain */
+}
+	RT_entry;
+
+typedef struct rt_node {
+    int		     leaf;		/* children are entries, not nodes */
+    int		     count;
+    RT_rect	     r;
+    struct rt_node  *parent;
+    void	    *child[RT_MAXENT + 1];
+}
+	RT_node;
+
+static RT_node	 *rt_root = NULL;
+static RT_entry **rt_hash = NULL;
+static int	  rt_hashsize = 0;
+static int	  rt_entries = 0;
+static int	  rt_removed = 0;	/* removals since last rebuild */
+static unsigned	  rt_seq = 0;
+static Boolean	  rt_valid = False;
+static float	  rt_zoom = 0.0;	/* text bounds depend on zoom */
+
+static RT_hit	 *rt_hits = NULL;
+static int	  rt_nhits, rt_maxhits = 0;
+static int	  rt_limit = 0;		/* give up searching after this many hits */
+static Boolean	  rt_nomem;		/* no memory to collect all the hits */
+
+static void	rtree_rebuild(void);
+static void	insert_entry(RT_entry *e);
+static void	delete_entry(RT_entry *e);
+
+/* order in which redisplay_objects() draws the object lists */
+
+static int
+type_rank(int type)
+{
+    switch (type) {
+      case O_ARC:	return 0;
+      case O_COMPOUND:	return 1;
+      case O_ELLIPSE:	return 2;
+      case O_POLYLINE:	return 3;
+      case O_SPLINE:	return 4;
+      default:		return 5;
+    }
+}
+
+static void
+rect_add_point(RT_rect *r, int x, int y)
+{
+    r->xmin = min2(r->xmin, x);
+    r->ymin = min2(r->ymin, y);
+    r->xmax = max2(r->xmax, x);
+    r->ymax = max2(r->ymax, y);
+}
+
+static void
+object_rect(int type, void *obj, RT_rect *r)
+{
+    F_ellipse	   *e;
+    F_arc	   *a;
+    double	    dx, dy;
+    int		    dum, i;
+
+    switch (type) {
+      case O_ARC:
+	a = (F_arc *) obj;
+	arc_bound(a, &r->xmin, &r->ymin, &r->xmax, &r->ymax);
+	/* the point search looks at the three points */
+	for (i = 0; i < 3; i++)
+	    rect_add_point(r, a->point[i].x, a->point[i].y);
+	break;
+      case O_COMPOUND:
+	compound_bound((F_compound *) obj, &r->xmin, &r->ymin, &r->xmax, &r->ymax);
+	/* the object search looks at the corners */
+	rect_add_point(r, ((F_compound *) obj)->nwcorner.x, ((F_compound *) obj)->nwcorner.y);
+	rect_add_point(r, ((F_compound *) obj)->secorner.x, ((F_compound *) obj)->secorner.y);
+	break;
+      case O_ELLIPSE:
+	e = (F_ellipse *) obj;
+	ellipse_bound(e, &r->xmin, &r->ymin, &r->xmax, &r->ymax);
+	/* ellipse_bound() works to screen precision, but the object search
+	   wants all of the true curve and the start and end points as well */
+	dx = hypot(e->radiuses.x * cos(e->angle), e->radiuses.y * sin(e->angle));
+	dy = hypot(e->radiuses.x * sin(e->angle), e->radiuses.y * cos(e->angle));
+	rect_add_point(r, e->center.x - (int) dx - 1, e->center.y - (int) dy - 1);
+	rect_add_point(r, e->center.x + (int) dx + 1, e->center.y + (int) dy + 1);
+	rect_add_point(r, e->start.x, e->start.y);
+	rect_add_point(r, e->end.x, e->end.y);
+	break;
+      case O_POLYLINE:
+	line_bound((F_line *) obj, &r->xmin, &r->ymin, &r->xmax, &r->ymax);
+	break;
+      case O_SPLINE:
+	spline_bound((F_spline *) obj, &r->xmin, &r->ymin, &r->xmax, &r->ymax);
+	break;
+      case O_TEXT:
+	text_bound((F_text *) obj, &r->xmin, &r->ymin, &r->xmax, &r->ymax,
+		   &dum,&dum,&dum,&dum,&dum,&dum,&dum,&dum);
+	break;
+    }
+}
+
+/********************** rectangle helpers **********************/
+
+static void
+rect_union(RT_rect *a, RT_rect *b)
+{
+    a->xmin = min2(a->xmin, b->xmin);
+    a->ymin = min2(a->ymin, b->ymin);
+    a->xmax = max2(a->xmax, b->xmax);
+    a->ymax = max2(a->ymax, b->ymax);
+}
+
+static double
+rect_area(RT_rect *r)
+{
+    return (double) (r->xmax - r->xmin) * (double) (r->ymax - r->ymin);
+}
+
+static double
+rect_growth(RT_rect *r, RT_rect *add)
+{
+    RT_rect	    u;
+
+    u = *r;
+    rect_union(&u, add);
+    return rect_area(&u) - rect_area(r);
+}
+
+static int
+rect_overlap(RT_rect *a, RT_rect *b)
+{
+    return (a->xmin <= b->xmax && b->xmin <= a->xmax &&
+	    a->ymin <= b->ymax && b->ymin <= a->ymax);
+}
+
+static RT_rect *
+child_rect(RT_node *n, int i)
+{
+    if (n->leaf)
+	return &((RT_entry *) n->child[i])->r;
+    return &((RT_node *) n->child[i])->r;
+}
+
+static void
+set_owner(RT_node *n, void *child)
+{
+    if (n->leaf)
+	((RT_entry *) child)->leaf = n;
+    else
+	((RT_node *) child)->parent = n;
+}
+
+static void
+node_bound(RT_node *n)
+{
+    int		    i;
+
+    if (n->count == 0) {
+	n->r.xmin = n->r.ymin = n->r.xmax = n->r.ymax = 0;
+	return;
+    }
+    n->r = *child_rect(n, 0);
+    for (i = 1; i < n->count; i++)
+	rect_union(&n->r, child_rect(n, i));
+}
+
+static void
+adjust_upwards(RT_node *n)
+{
+    for ( ; n != NULL; n = n->parent)
+	node_bound(n);
+}
+
+static RT_node *
+new_node(int leaf)
+{
+    RT_node	   *n;
+
+    if ((n = (RT_node *) malloc(sizeof(RT_node))) == NULL)
+	return NULL;
+    n->leaf = leaf;
+    n->count = 0;
+    n->parent = NULL;
+    n->r.xmin = n->r.ymin = n->r.xmax = n->r.ymax = 0;
+    return n;
+}
+
+static void
+free_nodes(RT_node *n)
+{
+    int		    i;
+
+    if (n == NULL)
+	return;
+    if (!n->leaf)
+	for (i = 0; i < n->count; i++)
+	    free_nodes((RT_node *) n->child[i]);
+    free((char *) n);
+}
+
+/********************** hash table of entries **********************/
+
+static unsigned
+hash_obj(void *obj)
+{
+    unsigned long   h = (unsigned long) obj;
+
+    return (unsigned) ((h >> 4) ^ (h >> 14)) & (rt_hashsize - 1);
+}
+
+static RT_entry *
+find_entry(void *obj)
+{
+    RT_entry	   *e;
+
+    if (rt_hash == NULL)
+	return NULL;
+    for (e = rt_hash[hash_obj(obj)]; e != NULL; e = e->hnext)
+	if (e->obj == obj)
+	    return e;
+    return NULL;
+}
+
+static void
+hash_grow(void)
+{
+    RT_entry	  **old = rt_hash;
+    RT_entry	   *e, *next;
+    int		    oldsize = rt_hashsize;
+    int		    i;
+    unsigned	    h;
+
+    rt_hashsize = (oldsize == 0 ? RT_HASHSIZE : oldsize * 2);
+    rt_hash = (RT_entry **) calloc(rt_hashsize, sizeof(RT_entry *));
+    if (rt_hash == NULL) {
+	rt_hash = old;
+	rt_hashsize = oldsize;
+	return;
+    }
+    for (i = 0; i < oldsize; i++)
+	for (e = old[i]; e != NULL; e = next) {
+	    next = e->hnext;
+	    h = hash_obj(e->obj);
+	    e->hnext = rt_hash[h];
+	    rt_hash[h] = e;
+	}
+    if (old)
+	free((char *) old);
+}
+
+static void
+hash_add(RT_entry *e)
+{
+    unsigned	    h;
+
+    if (rt_entries >= 2 * rt_hashsize)
+	hash_grow();
+    h = hash_obj(e->obj);
+    e->hnext = rt_hash[h];
+    rt_hash[h] = e;
+    rt_entries++;
+}
+
+static void
+hash_remove(RT_entry *e)
+{
+    RT_entry	  **ep;
+
+    for (ep = &rt_hash[hash_obj(e->obj)]; *ep != NULL; ep = &(*ep)->hnext)
+	if (*ep == e) {
+	    *ep = e->hnext;
+	    rt_entries--;
+	    return;
+	}
+}
+
+static void
+free_entries(void)
+{
+    RT_entry	   *e, *next;
+    int		    i;
+
+    for (i = 0; i < rt_hashsize; i++) {
+	for (e = rt_hash[i]; e != NULL; e = next) {
+	    next = e->hnext;
+	    free((char *) e);
+	}
+	rt_hash[i] = NULL;
+    }
+    rt_entries = 0;
+}
+
+/********************** tree insertion **********************/
+
+static RT_node *
+choose_leaf(RT_rect *r)
+{
+    RT_node	   *n;
+    RT_rect	   *cr;
+    double	    growth, best_growth, area, best_area;
+    int		    i, best;
+
+    for (n = rt_root; !n->leaf; n = (RT_node *) n->child[best]) {
+	best = 0;
+	best_growth = best_area = 0.0;
+	for (i = 0; i < n->count; i++) {
+	    cr = child_rect(n, i);
+	    growth = rect_growth(cr, r);
+	    area = rect_area(cr);
+	    if (i == 0 || growth < best_growth ||
+		(growth == best_growth && area < best_area)) {
+		best = i;
+		best_growth = growth;
+		best_area = area;
+	    }
+	}
+    }
+    return n;
+}
+
+static void add_child(RT_node *n, void *child);
+
+/*
+ * No memory for a new node: give back the child just added to n, so that
+ * it has no more than RT_MAXENT again.  What it leaves out isn't in the
+ * tree any more, so the tree is rebuilt before the next search.
+ */
+
+static void
+drop_last_child(RT_node *n)
+{
+    void	   *child;
+
+    child = n->child[--n->count];
+    if (n->leaf)
+	((RT_entry *) child)->leaf = NULL;
+    else
+	free_nodes((RT_node *) child);
+    adjust_upwards(n);
+    rt_valid = False;
+}
+
+/* split the RT_MAXENT+1 children of n between n and a new sibling */
+
+static void
+split_node(RT_node *n)
+{
+    void	   *child[RT_MAXENT + 1];
+    RT_rect	    ra, rb, u;
+    RT_node	   *nn, *root;
+    double	    waste, worst, ga, gb;
+    int		    total, i, j, sa, sb, left;
+
+    if ((nn = new_node(n->leaf)) == NULL) {
+	drop_last_child(n);
+	return;
+    }
+    total = n->count;
+    for (i = 0; i < total; i++)
+	child[i] = n->child[i];
+
+    /* pick the two seeds that would waste the most area together */
+    sa = 0;
+    sb = 1;
+    worst = -1.0;
+    for (i = 0; i < total - 1; i++)
+	for (j = i + 1; j < total; j++) {
+	    u = *child_rect(n, i);
+	    rect_union(&u, child_rect(n, j));
+	    waste = rect_area(&u) - rect_area(child_rect(n, i)) -
+				    rect_area(child_rect(n, j));
+	    if (waste > worst) {
+		worst = waste;
+		sa = i;
+		sb = j;
+	    }
+	}
+    ra = *child_rect(n, sa);
+    rb = *child_rect(n, sb);
+
+    n->count = 0;
+    n->child[n->count++] = child[sa];
+    nn->child[nn->count++] = child[sb];
+    left = total - 2;
+    for (i = 0; i < total; i++) {
+	RT_rect	   *cr;
+
+	if (i == sa || i == sb)
+	    continue;
+	cr = (n->leaf ? &((RT_entry *) child[i])->r : &((RT_node *) child[i])->r);
+	/* make sure both groups end up with at least RT_MINENT children */
+	if (n->count + left <= RT_MINENT) {
+	    n->child[n->count++] = child[i];
+	    rect_union(&ra, cr);
+	} else if (nn->count + left <= RT_MINENT) {
+	    nn->child[nn->count++] = child[i];
+	    rect_union(&rb, cr);
+	} else {
+	    ga = rect_growth(&ra, cr);
+	    gb = rect_growth(&rb, cr);
+	    if (ga < gb || (ga == gb && n->count <= nn->count)) {
+		n->child[n->count++] = child[i];
+		rect_union(&ra, cr);
+	    } else {
+		nn->child[nn->count++] = child[i];
+		rect_union(&rb, cr);
+	    }
+	}
+	left--;
+    }
+    for (i = 0; i < n->count; i++)
+	set_owner(n, n->child[i]);
+    for (i = 0; i < nn->count; i++)
+	set_owner(nn, nn->child[i]);
+    n->r = ra;
+    nn->r = rb;
+
+    if (n->parent == NULL) {
+	/* splitting the root, grow the tree by one level */
+	if ((root = new_node(0)) == NULL) {
+	    /* the entries under nn are lost, rebuild */
+	    free_nodes(nn);
+	    rt_valid = False;
+	    return;
+	}
+	root->child[root->count++] = n;
+	root->child[root->count++] = nn;
+	n->parent = nn->parent = root;
+	node_bound(root);
+	rt_root = root;
+    } else {
+	add_child(n->parent, nn);
+    }
+}
+
+static void
+add_child(RT_node *n, void *child)
+{
+    n->child[n->count++] = child;
+    set_owner(n, child);
+    if (n->count > RT_MAXENT)
+	split_node(n);
+    else
+	adjust_upwards(n);
+}
+
+static void
+insert_entry(RT_entry *e)
+{
+    if (rt_root == NULL && (rt_root = new_node(1)) == NULL) {
+	rt_valid = False;
+	return;
+    }
+    add_child(choose_leaf(&e->r), e);
+}
+
+/********************** tree deletion **********************/
+
+static void
+remove_child(RT_node *n, void *child)
+{
+    int		    i;
+
+    for (i = 0; i < n->count; i++)
+	if (n->child[i] == child) {
+	    n->child[i] = n->child[--n->count];
+	    return;
+	}
+}
+
+static void
+delete_entry(RT_entry *e)
+{
+    RT_node	   *n, *p;
+
+    if ((n = e->leaf) == NULL)
+	return;
+    remove_child(n, e);
+    e->leaf = NULL;
+    /* drop nodes that have become empty */
+    while (n->count == 0 && n->parent != NULL) {
+	p = n->parent;
+	remove_child(p, n);
+	free((char *) n);
+	n = p;
+    }
+    adjust_upwards(n);
+    /* and shorten the tree if the root has only one child left */
+    while (!rt_root->leaf && rt_root->count == 1) {
+	n = (RT_node *) rt_root->child[0];
+	free((char *) rt_root);
+	rt_root = n;
+	rt_root->parent = NULL;
+    }
+    if (rt_root->count == 0)
+	rt_root->leaf = 1;
+}
+
+/********************** rebuild **********************/
+
+static void
+add_new_entry(int type, void *obj)
+{
+    RT_entry	   *e;
+
+    if ((e = (RT_entry *) malloc(sizeof(RT_entry))) == NULL) {
+	/* can't index everything, fall back to rebuilding next time */
+	rt_valid = False;
+	return;
+    }
+    e->type = type;
+    e->obj = obj;
+    e->seq = rt_seq++;
+    e->leaf = NULL;
+    object_rect(type, obj, &e->r);
+    hash_add(e);
+    insert_entry(e);
+}
+
+static void
+rtree_rebuild(void)
+{
+    F_arc	   *a;
+    F_compound	   *c;
+    F_ellipse	   *e;
+    F_line	   *l;
+    F_spline	   *s;
+    F_text	   *t;
+
+    free_nodes(rt_root);
+    rt_root = NULL;
+    if (rt_hash == NULL)
+	hash_grow();
+    free_entries();
+    rt_seq = 0;
+    rt_removed = 0;
+    rt_zoom = zoomscale;
+    rt_valid = True;
+    vindex_invalidate();
+
+    for (a = objects.arcs; a != NULL; a = a->next)
+	add_new_entry(O_ARC, a);
+    for (c = objects.compounds; c != NULL; c = c->next)
+	add_new_entry(O_COMPOUND, c);
+    for (e = objects.ellipses; e != NULL; e = e->next)
+	add_new_entry(O_ELLIPSE, e);
+    for (l = objects.lines; l != NULL; l = l->next)
+	add_new_entry(O_POLYLINE, l);
+    for (s = objects.splines; s != NULL; s = s->next)
+	add_new_entry(O_SPLINE, s);
+    for (t = objects.texts; t != NULL; t = t->next)
+	add_new_entry(O_TEXT, t);
+}
+
+/********************** exported routines **********************/
+
+/* forget everything, the tree is rebuilt from "objects" when next needed */
+
+void
+rtree_invalidate(void)
+{
+    rt_valid = False;
+}
+
+/* a new object has been appended to one of the objects lists */
+
+void
+rtree_add_object(int type, void *obj)
+{
+    /* it may have been changed while out of the lists */
+    vindex_forget(type, obj);
+    if (!rt_valid || obj == NULL || find_entry(obj) != NULL)
+	return;
+    add_new_entry(type, obj);
+}
+
+/* an object has been taken out of the objects lists */
+
+void
+rtree_remove_object(int type, void *obj)
+{
+    RT_entry	   *e;
+
+    if (!rt_valid || (e = find_entry(obj)) == NULL)
+	return;
+    delete_entry(e);
+    hash_remove(e);
+    free((char *) e);
+    /* rebuild when the tree is mostly made of underfull nodes */
+    if (++rt_removed > 1000 && rt_removed > rt_entries)
+	rt_valid = False;
+}
+
+/* the geometry of an object has changed in place */
+
+void
+rtree_update_object(int type, void *obj)
+{
+    RT_entry	   *e;
+    RT_rect	    r;
+
+    vindex_forget(type, obj);
+    if (!rt_valid || (e = find_entry(obj)) == NULL)
+	return;
+    object_rect(type, obj, &r);
+    if (r.xmin == e->r.xmin && r.ymin == e->r.ymin &&
+	r.xmax == e->r.xmax && r.ymax == e->r.ymax)
+	    return;
+    delete_entry(e);
+    e->r = r;
+    insert_entry(e);
+}
+
+/* add or remove a whole chain of objects starting at first */
+
+void
+rtree_add_chain(int type, void *first)
+{
+    F_arc	   *a;
+    F_compound	   *c;
+    F_ellipse	   *e;
+    F_line	   *l;
+    F_spline	   *s;
+    F_text	   *t;
+
+    switch (type) {
+      case O_ARC:
+	for (a = (F_arc *) first; a != NULL; a = a->next)
+	    rtree_add_object(O_ARC, a);
+	break;
+      case O_COMPOUND:
+	for (c = (F_compound *) first; c != NULL; c = c->next)
+	    rtree_add_object(O_COMPOUND, c);
+	break;
+      case O_ELLIPSE:
+	for (e = (F_ellipse *) first; e != NULL; e = e->next)
+	    rtree_add_object(O_ELLIPSE, e);
+	break;
+      case O_POLYLINE:
+	for (l = (F_line *) first; l != NULL; l = l->next)
+	    rtree_add_object(O_POLYLINE, l);
+	break;
+      case O_SPLINE:
+	for (s = (F_spline *) first; s != NULL; s = s->next)
+	    rtree_add_object(O_SPLINE, s);
+	break;
+      case O_TEXT:
+	for (t = (F_text *) first; t != NULL; t = t->next)
+	    rtree_add_object(O_TEXT, t);
+	break;
+    }
+}
+
+void
+rtree_remove_chain(int type, void *first)
+{
+    F_arc	   *a;
+    F_compound	   *c;
+    F_ellipse	   *e;
+    F_line	   *l;
+    F_spline	   *s;
+    F_text	   *t;
+
+    switch (type) {
+      case O_ARC:
+	for (a = (F_arc *) first; a != NULL; a = a->next)
+	    rtree_remove_object(O_ARC, a);
+	break;
+      case O_COMPOUND:
+	for (c = (F_compound *) first; c != NULL; c = c->next)
+	    rtree_remove_object(O_COMPOUND, c);
+	break;
+      case O_ELLIPSE:
+	for (e = (F_ellipse *) first; e != NULL; e = e->next)
+	    rtree_remove_object(O_ELLIPSE, e);
+	break;
+      case O_POLYLINE:
+	for (l = (F_line *) first; l != NULL; l = l->next)
+	    rtree_remove_object(O_POLYLINE, l);
+	break;
+      case O_SPLINE:
+	for (s = (F_spline *) first; s != NULL; s = s->next)
+	    rtree_remove_object(O_SPLINE, s);
+	break;
+      case O_TEXT:
+	for (t = (F_text *) first; t != NULL; t = t->next)
+	    rtree_remove_object(O_TEXT, t);
+	break;
+    }
+}
+
+static void
+add_hit(RT_entry *e)
+{
+    RT_hit	   *tmp;
+    int		    n;
+
+    if (rt_nhits >= rt_maxhits) {
+	n = (rt_maxhits == 0 ? 256 : 2 * rt_maxhits);
+	if ((tmp = (RT_hit *) realloc(rt_hits, n * sizeof(RT_hit))) == NULL) {
+	    rt_nomem = True;
+	    return;
+	}
+	rt_hits = tmp;
+	rt_maxhits = n;
+    }
+    rt_hits[rt_nhits].type = e->type;
+    rt_hits[rt_nhits].obj = e->obj;
+    rt_hits[rt_nhits].seq = e->seq;
+    rt_nhits++;
+}
+
+static void
+search_node(RT_node *n, RT_rect *r)
+{
+    int		    i;
+
+    for (i = 0; i < n->count; i++) {
+	if (rt_nomem || (rt_limit > 0 && rt_nhits > rt_limit))
+	    return;
+	if (!rect_overlap(child_rect(n, i), r))
+	    continue;
+	if (n->leaf)
+	    add_hit((RT_entry *) n->child[i]);
+	else
+	    search_node((RT_node *) n->child[i], r);
+    }
+}
+
+static int
+compare_hits(const void *a, const void *b)
+{
+    const RT_hit   *ha = (const RT_hit *) a;
+    const RT_hit   *hb = (const RT_hit *) b;
+    int		    ra = type_rank(ha->type);
+    int		    rb = type_rank(hb->type);
+
+    if (ra != rb)
+	return ra - rb;
+    return (ha->seq < hb->seq ? -1 : (ha->seq > hb->seq ? 1 : 0));
+}
+
+/*
+ * Find all top-level objects whose bounds overlap the given rectangle
+ * (Fig units).  The hits are returned in the order that the objects
+ * appear in the objects lists, and are only valid until the next search.
+ * Returns -1 if there isn't the memory to index or collect them all, and
+ * the caller must look at every object instead; rtree_hit_next() does
+ * either.
+ */
+
+int
+rtree_search(int xmin, int ymin, int xmax, int ymax, RT_hit **hits)
+{
+    RT_rect	    r;
+
+    if (!rt_valid || rt_zoom != zoomscale)
+	rtree_rebuild();
+    *hits = rt_hits;
+    /* short of memory, not every object made it into the tree */
+    if (!rt_valid)
+	return -1;
+    r.xmin = xmin;
+    r.ymin = ymin;
+    r.xmax = xmax;
+    r.ymax = ymax;
+    rt_nhits = 0;
+    rt_nomem = False;
+    if (rt_root != NULL)
+	search_node(rt_root, &r);
+    *hits = rt_hits;
+    if (rt_nomem)
+	return -1;
+    if (rt_nhits > 1 && (rt_limit == 0 || rt_nhits <= rt_limit))
+	qsort(rt_hits, rt_nhits, sizeof(RT_hit), compare_hits);
+    return rt_nhits;
+}
+
+/*
+ * Object picking for the object and point searches of u_search.c and
+ * u_smartsearch.c.  rtree_pick() collects the top-level objects whose
+ * bounds come within "tol" of (x, y), and rtree_pick_next() steps through
+ * those of one type in list order, forwards or backwards, starting after
+ * "obj" (or at the first/last one if obj is NULL).  obj itself needn't be near (x, y), so
+ * the searches can go on cycling from the object they found last time.
+ *
+ * When very many objects are near (x, y), as with big objects all across
+ * the canvas, collecting and sorting the hits costs more than walking the
+ * lists up to the first object that is really hit.  rtree_pick() then
+ * gives up and returns -1, and rtree_pick_next() just steps through the
+ * objects lists.
+ */
+
+#define PK_MAXHITS	1024		/* most hits worth collecting */
+
+static RT_hit	 *pk_hits = NULL;
+static int	  pk_nhits, pk_maxhits = 0;
+static int	  pk_cur = -1;		/* hit returned last by rtree_pick_next() */
+static Boolean	  pk_lists = False;	/* step through the lists instead */
+
+int
+rtree_pick(int x, int y, int tol, RT_hit **hits)
+{
+    RT_hit	   *found, *tmp;
+    int		    nfound;
+
+    rt_limit = PK_MAXHITS;
+    nfound = rtree_search(x - tol, y - tol, x + tol, y + tol, &found);
+    pk_lists = (nfound < 0 || nfound > rt_limit);
+    rt_limit = 0;
+    pk_nhits = 0;
+    pk_cur = -1;
+    *hits = pk_hits;
+    if (pk_lists)
+	return -1;
+    if (nfound > pk_maxhits) {
+	if ((tmp = (RT_hit *) realloc(pk_hits, nfound * sizeof(RT_hit))) == NULL) {
+	    pk_lists = True;
+	    return -1;
+	}
+	pk_hits = tmp;
+	pk_maxhits = nfound;
+    }
+    if (nfound > 0)
+	bcopy((char *) found, (char *) pk_hits, nfound * sizeof(RT_hit));
+    pk_nhits = nfound;
+    *hits = pk_hits;
+    return pk_nhits;
+}
+
+/* next or previous object of the given type in the objects lists */
+
+static void *
+list_next(int type, void *obj, Boolean backward)
+{
+    switch (type) {
+      case O_ARC:
+	if (obj == NULL)
+	    return (backward? (void *) last_arc(objects.arcs): (void *) objects.arcs);
+	return (backward? (void *) prev_arc(objects.arcs, (F_arc *) obj):
+			  (void *) ((F_arc *) obj)->next);
+      case O_COMPOUND:
+	if (obj == NULL)
+	    return (backward? (void *) last_compound(objects.compounds):
+			      (void *) objects.compounds);
+	return (backward? (void *) prev_compound(objects.compounds, (F_compound *) obj):
+			  (void *) ((F_compound *) obj)->next);
+      case O_ELLIPSE:
+	if (obj == NULL)
+	    return (backward? (void *) last_ellipse(objects.ellipses):
+			      (void *) objects.ellipses);
+	return (backward? (void *) prev_ellipse(objects.ellipses, (F_ellipse *) obj):
+			  (void *) ((F_ellipse *) obj)->next);
+      case O_POLYLINE:
+	if (obj == NULL)
+	    return (backward? (void *) last_line(objects.lines): (void *) objects.lines);
+	return (backward? (void *) prev_line(objects.lines, (F_line *) obj):
+			  (void *) ((F_line *) obj)->next);
+      case O_SPLINE:
+	if (obj == NULL)
+	    return (backward? (void *) last_spline(objects.splines):
+			      (void *) objects.splines);
+	return (backward? (void *) prev_spline(objects.splines, (F_spline *) obj):
+			  (void *) ((F_spline *) obj)->next);
+      case O_TEXT:
+	if (obj == NULL)
+	    return (backward? (void *) last_text(objects.texts): (void *) objects.texts);
+	return (backward? (void *) prev_text(objects.texts, (F_text *) obj):
+			  (void *) ((F_text *) obj)->next);
+    }
+    return NULL;
+}
+
+/* index of the first pick hit at or after position seq of the given type */
+
+static int
+pick_index(int type, unsigned seq)
+{
+    int		    lo, hi, mid, rank, r;
+
+    rank = type_rank(type);
+    lo = 0;
+    hi = pk_nhits;
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	r = type_rank(pk_hits[mid].type);
+	if (r < rank || (r == rank && pk_hits[mid].seq < seq))
+	    lo = mid + 1;
+	else
+	    hi = mid;
+    }
+    return lo;
+}
+
+void *
+rtree_pick_next(int type, void *obj, Boolean backward)
+{
+    RT_entry	   *e;
+    int		    i;
+
+    if (pk_lists)
+	return list_next(type, obj, backward);
+    if (obj == NULL) {
+	i = (backward? pick_index(type, ~0U) - 1: pick_index(type, 0));
+    } else {
+	/* usually obj is the hit we returned last */
+	if (pk_cur >= 0 && pk_cur < pk_nhits && pk_hits[pk_cur].obj == obj)
+	    i = pk_cur;
+	else if ((e = find_entry(obj)) != NULL)
+	    i = pick_index(type, e->seq);
+	else
+	    return NULL;	/* not in the figure any more */
+	if (backward)
+	    i--;
+	else if (i < pk_nhits && pk_hits[i].obj == obj)
+	    i++;
+    }
+    if (i < 0 || i >= pk_nhits || pk_hits[i].type != type)
+	return NULL;
+    pk_cur = i;
+    return pk_hits[i].obj;
+}
+
+/*
+ * Step through the objects of one type among the nhits hits returned by
+ * rtree_search(), in list order, or through the objects list if the
+ * search returned -1.  *i is the position in hits, start with obj NULL
+ * and *i 0.
+ */
+
+void *
+rtree_hit_next(RT_hit *hits, int nhits, int type, int *i, void *obj)
+{
+    if (nhits < 0)
+	return list_next(type, obj, False);
+    for ( ; *i < nhits; (*i)++)
+	if (hits[*i].type == type)
+	    return hits[(*i)++].obj;
+    return NULL;
+}
@@ -0,0 +1,46 @@
+/*
+ * FIG : Facility for Interactive Generation of figures
+ * Copyright (c) 1985-1988 by Supoj Sutanthavibul
+ * Parts Copyright (c) 1989-2002 by Brian V. Smith
+ * Parts Copyright (c) 1991 by Paul King
+ *
+ * Any party obtaining a copy of these files is granted, free of charge, a
+ * full and unrestricted irrevocable, world-wide, paid up, royalty-free,
+ * nonexclusive right and license to deal in this software and documentation
+ * files (the "Software"), including without limitation the rights to use,
+ * copy, modify, merge, publish distribute, sublicense and/or sell copies of
+ * the Software, and to permit persons who receive copies from any such
+ * party to do so, with the only requirement being that the above copyright
+ * and this permission notice remain intact.
+ *
+ */
+
+#ifndef U_RTREE_H
+#define U_RTREE_H
+
+/*
+ * R-tree over the bounding boxes (Fig units) of the top-level objects in
+ * "objects".  It is kept up to date by the list_add_xxx/list_delete_xxx
+ * routines, append_objects()/cut_objects() and the redisplay_xxx()
+ * routines, and is rebuilt from scratch after rtree_invalidate().
+ */
+
+typedef struct rt_hit {
+    int		    type;		/* O_ARC, O_COMPOUND, O_ELLIPSE ... */
+    void	   *obj;
+    unsigned	    seq;		/* position of object in its list */
+}
+	RT_hit;
+
+extern void	rtree_invalidate(void);
+extern void	rtree_add_object(int type, void *obj);
+extern void	rtree_remove_object(int type, void *obj);
+extern void	rtree_update_object(int type, void *obj);
+extern void	rtree_add_chain(int type, void *first);
+extern void	rtree_remove_chain(int type, void *first);
+extern int	rtree_search(int xmin, int ymin, int xmax, int ymax, RT_hit **hits);
+extern void    *rtree_hit_next(RT_hit *hits, int nhits, int type, int *i, void *obj);
+extern int	rtree_pick(int x, int y, int tol, RT_hit **hits);
+extern void    *rtree_pick_next(int type, void *obj, Boolean backward);
+
+#endif /* U_RTREE_H */
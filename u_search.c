@@ -20,7 +20,9 @@
 #include "object.h"
 #include "mode.h"
 #include "u_list.h"
+#include "u_rtree.h"
 #include "u_search.h"
+#include "u_vindex.h"
 #include "w_drawprim.h"
 #include "w_layers.h"
 #include "w_setup.h"
@@ -68,14 +70,11 @@ next_arc_found(int x, int y, int tolerance, int *px, int *py, int shift)
     if (!arc_in_mask())
 	return False;
     if (a == NULL)
-	if (shift)
-	    a = last_arc(objects.arcs);
-    	else
-	    a = objects.arcs;
+	a = (F_arc *) rtree_pick_next(O_ARC, NULL, shift);
     else if (shift)
-	a = prev_arc(objects.arcs, a);
+	a = (F_arc *) rtree_pick_next(O_ARC, a, True);
 
-    for (; a != NULL; a = (shift? prev_arc(objects.arcs, a): a->next), n++) {
+    for (; a != NULL; a = (F_arc *) rtree_pick_next(O_ARC, a, shift), n++) {
 	if (!active_layer(a->depth))
 	    continue;
 	for (i = 0; i < 3; i++) {
@@ -149,15 +148,12 @@ next_ellipse_found(int x, int y, int tolerance, int *px, int *py, int shift)
     if (!ellipse_in_mask())
 	return False;
     if (e == NULL)
-	if (shift)
-	    e = last_ellipse(objects.ellipses);
-    	else
-	    e = objects.ellipses;
+	e = (F_ellipse *) rtree_pick_next(O_ELLIPSE, NULL, shift);
     else if (shift)
-	e = prev_ellipse(objects.ellipses, e);
+	e = (F_ellipse *) rtree_pick_next(O_ELLIPSE, e, True);
 
     tol = (double) tolerance;
-    for (; e != NULL; e = (shift? prev_ellipse(objects.ellipses, e): e->next), n++) {
+    for (; e != NULL; e = (F_ellipse *) rtree_pick_next(O_ELLIPSE, e, shift), n++) {
 	if (!active_layer(e->depth))
 	    continue;
 	dx = x - e->center.x;
@@ -218,14 +214,11 @@ next_line_found(int x, int y, int tolerance, int *px, int *py, int shift)
     if (!anyline_in_mask())
 	return False;
     if (l == NULL)
-	if (shift)
-	    l = last_line(objects.lines);
-    	else
-	    l = objects.lines;
+	l = (F_line *) rtree_pick_next(O_POLYLINE, NULL, shift);
     else if (shift)
-	l = prev_line(objects.lines, l);
+	l = (F_line *) rtree_pick_next(O_POLYLINE, l, True);
 
-    for (; l != NULL; l = (shift? prev_line(objects.lines, l): l->next), n++) {
+    for (; l != NULL; l = (F_line *) rtree_pick_next(O_POLYLINE, l, shift), n++) {
 	if (!active_layer(l->depth))
 	    continue;
 	if (validline_in_mask(l)) {
@@ -266,16 +259,13 @@ next_spline_found(int x, int y, int tolerance, int *px, int *py, int shift)
     if (!anyspline_in_mask())
 	return False;
     if (s == NULL)
-	if (shift)
-	    s = last_spline(objects.splines);
-    	else
-	    s = objects.splines;
+	s = (F_spline *) rtree_pick_next(O_SPLINE, NULL, shift);
     else if (shift)
-	s = prev_spline(objects.splines, s);
+	s = (F_spline *) rtree_pick_next(O_SPLINE, s, True);
 
     tol2 = (float) tolerance *tolerance;
 
-    for (; s != NULL; s = (shift? prev_spline(objects.splines, s): s->next), n++) {
+    for (; s != NULL; s = (F_spline *) rtree_pick_next(O_SPLINE, s, shift), n++) {
 	if (!active_layer(s->depth))
 	    continue;
 	if (validspline_in_mask(s)) {
@@ -304,14 +294,11 @@ next_text_found(int x, int y, int tolerance, int *px, int *py, int shift)
     if (!anytext_in_mask())
 	return False;
     if (t == NULL)
-	if (shift)
-	    t = last_text(objects.texts);
-    	else
-	    t = objects.texts;
+	t = (F_text *) rtree_pick_next(O_TEXT, NULL, shift);
     else if (shift)
-	t = prev_text(objects.texts, t);
+	t = (F_text *) rtree_pick_next(O_TEXT, t, True);
 
-    for (; t != NULL; t = (shift? prev_text(objects.texts, t): t->next), n++) {
+    for (; t != NULL; t = (F_text *) rtree_pick_next(O_TEXT, t, shift), n++) {
 	if (!active_layer(t->depth))
 	    continue;
 	if (validtext_in_mask(t)) {
@@ -333,16 +320,13 @@ next_compound_found(int x, int y, int tolerance, int *px, int *py, int shift)
     if (!compound_in_mask())
 	return False;
     if (c == NULL)
-	if (shift)
-	    c = last_compound(objects.compounds);
-    	else
-	    c = objects.compounds;
+	c = (F_compound *) rtree_pick_next(O_COMPOUND, NULL, shift);
     else if (shift)
-	c = prev_compound(objects.compounds, c);
+	c = (F_compound *) rtree_pick_next(O_COMPOUND, c, True);
 
     tol2 = tolerance * tolerance;
 
-    for (; c != NULL; c = (shift? prev_compound(objects.compounds, c): c->next), n++) {
+    for (; c != NULL; c = (F_compound *) rtree_pick_next(O_COMPOUND, c, shift), n++) {
 	if (!any_active_in_compound(c))
 		continue;
 	if (close_to_vector(c->nwcorner.x, c->nwcorner.y, c->nwcorner.x,
@@ -407,39 +391,107 @@ void toggle_objecthighlight(void)
     }
 }
 
+/* count all the objects that can be picked */
+
+static long
+count_objects(void)
+{
+    F_arc	   *aa;
+    F_ellipse	   *ee;
+    F_line	   *ll;
+    F_spline	   *ss;
+    F_text	   *tt;
+    F_compound	   *cc;
+    long	    count;
+
+    count = 0;
+    if (ellipse_in_mask())
+	for (ee = objects.ellipses; ee != NULL; ee = ee->next)
+	    count++;
+    if (anyline_in_mask())
+	for (ll = objects.lines; ll != NULL; ll = ll->next)
+	    if (validline_in_mask(ll))
+		count++;
+    if (anyspline_in_mask())
+	for (ss = objects.splines; ss != NULL; ss = ss->next)
+	    if (validspline_in_mask(ss))
+		count++;
+    if (anytext_in_mask())
+	for (tt = objects.texts; tt != NULL; tt = tt->next)
+	    if (validtext_in_mask(tt))
+		count++;
+    if (arc_in_mask())
+	for (aa = objects.arcs; aa != NULL; aa = aa->next)
+	    count++;
+    if (compound_in_mask())
+	for (cc = objects.compounds; cc != NULL; cc = cc->next)
+	    count++;
+    return count;
+}
+
 static void
 init_search(void)
 {
     if (highlighting)
 	erase_objecthighlight();
     else {
-	objectcount = 0;
-	if (ellipse_in_mask())
-	    for (e = objects.ellipses; e != NULL; e = e->next)
-		objectcount++;
-	if (anyline_in_mask())
-	    for (l = objects.lines; l != NULL; l = l->next)
-		if (validline_in_mask(l))
-		    objectcount++;
-	if (anyspline_in_mask())
-	    for (s = objects.splines; s != NULL; s = s->next)
-		if (validspline_in_mask(s))
-		    objectcount++;
-	if (anytext_in_mask())
-	    for (t = objects.texts; t != NULL; t = t->next)
-		if (validtext_in_mask(t))
-		    objectcount++;
-	if (arc_in_mask())
-	    for (a = objects.arcs; a != NULL; a = a->next)
-		objectcount++;
-	if (compound_in_mask())
-	    for (c = objects.compounds; c != NULL; c = c->next)
-		objectcount++;
 	e = NULL;
 	type = O_ELLIPSE;
     }
 }
 
+/*
+ * Only the objects whose bounds come near (x, y) need to be looked at.
+ * The next_xxx_found() routines step through those of each type with
+ * rtree_pick_next(), in list order like they used to step through the
+ * whole lists, so clicking with shift still cycles through the objects
+ * under the cursor.  If too many objects are near, the index isn't used
+ * and all of them are looked at as before.  The bounds hold all the
+ * points of an object, so the point search (which has no texts to look
+ * at) uses the same candidates.
+ */
+
+static long
+count_candidates(int x, int y, Boolean texts)
+{
+    RT_hit	   *hits;
+    int		    i, nhits;
+    long	    count;
+
+    if ((nhits = rtree_pick(x, y, TOLERANCE, &hits)) < 0)
+	return count_objects();		/* look at them all */
+    count = 0;
+    for (i = 0; i < nhits; i++)
+	switch (hits[i].type) {
+	  case O_ELLIPSE:
+	    if (ellipse_in_mask())
+		count++;
+	    break;
+	  case O_POLYLINE:
+	    if (anyline_in_mask() && validline_in_mask((F_line *) hits[i].obj))
+		count++;
+	    break;
+	  case O_SPLINE:
+	    if (anyspline_in_mask() && validspline_in_mask((F_spline *) hits[i].obj))
+		count++;
+	    break;
+	  case O_TEXT:
+	    if (texts && anytext_in_mask() && validtext_in_mask((F_text *) hits[i].obj))
+		count++;
+	    break;
+	  case O_ARC:
+	    if (arc_in_mask())
+		count++;
+	    break;
+	  case O_COMPOUND:
+	    if (compound_in_mask())
+		count++;
+	    break;
+	}
+    /* the object found last time is looked at too, and needn't be near */
+    return (count > 0? count + 1: 0);
+}
+
 void
 do_object_search(int x, int y, unsigned int shift)
        		         
@@ -449,6 +501,7 @@ do_object_search(int x, int y, unsigned int shift)
     Boolean	    found = False;
 
     init_search();
+    objectcount = count_candidates(x, y, True);
     for (n = 0; n < objectcount;) {
 	switch (type) {
 	  case O_ELLIPSE:
@@ -570,14 +623,11 @@ next_arc_point_found(int x, int y, int tol, int *point_num, int shift)
     if (!arc_in_mask())
 	return False;
     if (a == NULL)
-	if (shift)
-	    a = last_arc(objects.arcs);
-    	else
-	    a = objects.arcs;
+	a = (F_arc *) rtree_pick_next(O_ARC, NULL, shift);
     else if (shift)
-	a = prev_arc(objects.arcs, a);
+	a = (F_arc *) rtree_pick_next(O_ARC, a, True);
 
-    for (; a != NULL; a = (shift? prev_arc(objects.arcs, a): a->next), n++) {
+    for (; a != NULL; a = (F_arc *) rtree_pick_next(O_ARC, a, shift), n++) {
 	if (!active_layer(a->depth))
 	    continue;
 	for (i = 0; i < 3; i++) {
@@ -600,14 +650,11 @@ next_ellipse_point_found(int x, int y, int tol, int *point_num, int shift)
     if (!ellipse_in_mask())
 	return False;
     if (e == NULL)
-	if (shift)
-	    e = last_ellipse(objects.ellipses);
-    	else
-	    e = objects.ellipses;
+	e = (F_ellipse *) rtree_pick_next(O_ELLIPSE, NULL, shift);
     else if (shift)
-	e = prev_ellipse(objects.ellipses, e);
+	e = (F_ellipse *) rtree_pick_next(O_ELLIPSE, e, True);
 
-    for (; e != NULL; e = (shift? prev_ellipse(objects.ellipses, e): e->next), n++) {
+    for (; e != NULL; e = (F_ellipse *) rtree_pick_next(O_ELLIPSE, e, shift), n++) {
 	if (!active_layer(e->depth))
 	    continue;
 	if (abs(e->start.x - x) <= tol && abs(e->start.y - y) <= tol) {
@@ -625,30 +672,20 @@ next_ellipse_point_found(int x, int y, int tol, int *point_num, int shift)
 Boolean
 next_line_point_found(int x, int y, int tol, F_point **p, F_point **q, int shift)
 {
-    F_point	   *a, *b;
-
     if (!anyline_in_mask())
 	return False;
     if (l == NULL)
-	if (shift)
-	    l = last_line(objects.lines);
-    	else
-	    l = objects.lines;
+	l = (F_line *) rtree_pick_next(O_POLYLINE, NULL, shift);
     else if (shift)
-	l = prev_line(objects.lines, l);
+	l = (F_line *) rtree_pick_next(O_POLYLINE, l, True);
 
-    for (; l != NULL; l = (shift? prev_line(objects.lines, l): l->next)) {
+    for (; l != NULL; l = (F_line *) rtree_pick_next(O_POLYLINE, l, shift)) {
 	if (!active_layer(l->depth))
 	    continue;
 	if (validline_in_mask(l)) {
 	    n++;
-	    for (a = NULL, b = l->points; b != NULL; a = b, b = b->next) {
-		if (abs(b->x - x) <= tol && abs(b->y - y) <= tol) {
-		    *p = a;
-		    *q = b;
-		    return True;
-		}
-	    }
+	    if (vindex_within(l->points, &l->vindex, x, y, tol, p, q))
+		return True;
 	}
     }
     return False;
@@ -660,23 +697,17 @@ next_spline_point_found(int x, int y, int tol, F_point **p, F_point **q, int shi
     if (!anyspline_in_mask())
 	return False;
     if (s == NULL)
-	if (shift)
-	    s = last_spline(objects.splines);
-    	else
-	    s = objects.splines;
+	s = (F_spline *) rtree_pick_next(O_SPLINE, NULL, shift);
     else if (shift)
-	s = prev_spline(objects.splines, s);
+	s = (F_spline *) rtree_pick_next(O_SPLINE, s, True);
 
-    for (; s != NULL; s = (shift? prev_spline(objects.splines, s): s->next)) {
+    for (; s != NULL; s = (F_spline *) rtree_pick_next(O_SPLINE, s, shift)) {
 	if (!active_layer(s->depth))
 	    continue;
 	if (validspline_in_mask(s)) {
 	    n++;
-	    *p = NULL;
-	    for (*q = s->points; *q != NULL; *p = *q, *q = (*q)->next) {
-		if ((abs((*q)->x - x) <= tol) && (abs((*q)->y - y) <= tol))
-		    return True;
-	    }
+	    if (vindex_within(s->points, &s->vindex, x, y, tol, p, q))
+		return True;
 	}
     }
     return False;
@@ -690,14 +721,11 @@ next_compound_point_found(int x, int y, int tol, int *p, int *q, int shift)
     if (!compound_in_mask())
 	return False;
     if (c == NULL)
-	if (shift)
-	    c = last_compound(objects.compounds);
-    	else
-	    c = objects.compounds;
+	c = (F_compound *) rtree_pick_next(O_COMPOUND, NULL, shift);
     else if (shift)
-	c = prev_compound(objects.compounds, c);
+	c = (F_compound *) rtree_pick_next(O_COMPOUND, c, True);
 
-    for (; c != NULL; c = (shift? prev_compound(objects.compounds, c): c->next), n++) {
+    for (; c != NULL; c = (F_compound *) rtree_pick_next(O_COMPOUND, c, shift), n++) {
 	if (!any_active_in_compound(c))
 		continue;
 	if (abs(c->nwcorner.x - x) <= tol &&
@@ -757,6 +785,7 @@ do_point_search(int x, int y, unsigned int shift)
     px = &point1;
     py = &point2;
     init_search();
+    objectcount = count_candidates(x, y, False);
     for (n = 0; n < objectcount;) {
 	switch (type) {
 	case O_ELLIPSE:
@@ -17,6 +17,7 @@
 #include "object.h"
 #include "mode.h"
 #include "u_list.h"
+#include "u_rtree.h"
 #include "w_setup.h"
 #include "w_zoom.h"
 
@@ -130,39 +131,97 @@ set_smart_points(int x1, int y1, int x2, int y2)
     smart_point2.y = y2;
 }
 
+/* count all the objects that can be picked */
+
+static long
+count_objects(void)
+{
+    F_arc	   *aa;
+    F_ellipse	   *ee;
+    F_line	   *ll;
+    F_spline	   *ss;
+    F_text	   *tt;
+    F_compound	   *cc;
+    long	    count;
+
+    count = 0;
+    if (ellipse_in_mask())
+	for (ee = objects.ellipses; ee != NULL; ee = ee->next)
+	    count++;
+    if (anyline_in_mask())
+	for (ll = objects.lines; ll != NULL; ll = ll->next)
+	    if (validline_in_mask(ll))
+		count++;
+    if (anyspline_in_mask())
+	for (ss = objects.splines; ss != NULL; ss = ss->next)
+	    if (validspline_in_mask(ss))
+		count++;
+    if (anytext_in_mask())
+	for (tt = objects.texts; tt != NULL; tt = tt->next)
+	    if (validtext_in_mask(tt))
+		count++;
+    if (arc_in_mask())
+	for (aa = objects.arcs; aa != NULL; aa = aa->next)
+	    count++;
+    if (compound_in_mask())
+	for (cc = objects.compounds; cc != NULL; cc = cc->next)
+	    count++;
+    return count;
+}
+
 static void
 init_smart_search(void)
 {
     if (highlighting)
 	smart_erase_objecthighlight();
     else {
-	objectcount = 0;
-	if (ellipse_in_mask())
-	    for (e = objects.ellipses; e != NULL; e = e->next)
-		objectcount++;
-	if (anyline_in_mask())
-	    for (l = objects.lines; l != NULL; l = l->next)
-		if (validline_in_mask(l))
-		    objectcount++;
-	if (anyspline_in_mask())
-	    for (s = objects.splines; s != NULL; s = s->next)
-		if (validspline_in_mask(s))
-		    objectcount++;
-	if (anytext_in_mask())
-	    for (t = objects.texts; t != NULL; t = t->next)
-		if (validtext_in_mask(t))
-		    objectcount++;
-	if (arc_in_mask())
-	    for (a = objects.arcs; a != NULL; a = a->next)
-		objectcount++;
-	if (compound_in_mask())
-	    for (c = objects.compounds; c != NULL; c = c->next)
-		objectcount++;
 	e = NULL;
 	type = O_ELLIPSE;
     }
 }
 
+/* only the objects near (x, y) are looked at, see u_search.c */
+
+static long
+count_smart_candidates(int x, int y)
+{
+    RT_hit	   *hits;
+    int		    i, nhits;
+    long	    count;
+
+    if ((nhits = rtree_pick(x, y, TOLERANCE, &hits)) < 0)
+	return count_objects();		/* look at them all */
+    count = 0;
+    for (i = 0; i < nhits; i++)
+	switch (hits[i].type) {
+	case O_ELLIPSE:
+	    if (ellipse_in_mask())
+		count++;
+	    break;
+	case O_POLYLINE:
+	    if (anyline_in_mask() && validline_in_mask((F_line *) hits[i].obj))
+		count++;
+	    break;
+	case O_SPLINE:
+	    if (anyspline_in_mask() && validspline_in_mask((F_spline *) hits[i].obj))
+		count++;
+	    break;
+	case O_TEXT:
+	    if (anytext_in_mask() && validtext_in_mask((F_text *) hits[i].obj))
+		count++;
+	    break;
+	case O_ARC:
+	    if (arc_in_mask())
+		count++;
+	    break;
+	case O_COMPOUND:
+	    if (compound_in_mask())
+		count++;
+	    break;
+	}
+    return (count > 0? count + 1: 0);
+}
+
 void
 do_smart_object_search(int x, int y, unsigned int shift)
        		         
@@ -172,6 +231,7 @@ do_smart_object_search(int x, int y, unsigned int shift)
     Boolean	    found = False;
 
     init_smart_search();
+    objectcount = count_smart_candidates(x, y);
     for (n = 0; n < objectcount;) {
 	switch (type) {
 	case O_ELLIPSE:
@@ -270,11 +330,11 @@ smart_next_arc_found(int x, int y, int tolerance, int *px, int *py, int shift)
    if (!arc_in_mask())
      return 0;
    if (a == NULL)
-     a = last_arc(objects.arcs);
+     a = (F_arc *) rtree_pick_next(O_ARC, NULL, True);
    else if (shift)
-     a = prev_arc(objects.arcs, a);
+     a = (F_arc *) rtree_pick_next(O_ARC, a, True);
 
-   for (; a != NULL; a = prev_arc(objects.arcs, a), n++) {
+   for (; a != NULL; a = (F_arc *) rtree_pick_next(O_ARC, a, True), n++) {
      if (!close_to_arc(a, x, y, tolerance, &ax, &ay))
        continue;
      /* point found */
@@ -297,10 +357,10 @@ smart_next_ellipse_found(int x, int y, int tolerance, int *px, int *py, int shif
    if (!ellipse_in_mask())
         return (0);
    if (e == NULL)
-	e = last_ellipse(objects.ellipses);
+	e = (F_ellipse *) rtree_pick_next(O_ELLIPSE, NULL, True);
    else if (shift)
-	e = prev_ellipse(objects.ellipses, e);
-   for (; e != NULL; e = prev_ellipse(objects.ellipses, e), n++) {
+	e = (F_ellipse *) rtree_pick_next(O_ELLIPSE, e, True);
+   for (; e != NULL; e = (F_ellipse *) rtree_pick_next(O_ELLIPSE, e, True), n++) {
       if (!close_to_ellipse(e, x, y, tolerance, &ex, &ey, &vx, &vy))
         continue;
       *px = round(ex);
@@ -336,11 +396,11 @@ smart_next_line_found(int x, int y, int tolerance, int *px, int *py, int shift)
     if (!anyline_in_mask())
 	return (0);
     if (l == NULL)
-	l = last_line(objects.lines);
+	l = (F_line *) rtree_pick_next(O_POLYLINE, NULL, True);
     else if (shift)
-	l = prev_line(objects.lines, l);
+	l = (F_line *) rtree_pick_next(O_POLYLINE, l, True);
 
-    for (; l != NULL; l = prev_line(objects.lines, l)) {
+    for (; l != NULL; l = (F_line *) rtree_pick_next(O_POLYLINE, l, True)) {
 	if (validline_in_mask(l)) {
 	    n++;
             if (close_to_polyline(l, x, y, tolerance, SING_TOLERANCE, px, py,
@@ -366,11 +426,11 @@ smart_next_spline_found(int x, int y, int tolerance, int *px, int *py, int shift
     if (!anyspline_in_mask())
 	return (0);
     if (s == NULL)
-	s = last_spline(objects.splines);
+	s = (F_spline *) rtree_pick_next(O_SPLINE, NULL, True);
     else if (shift)
-	s = prev_spline(objects.splines, s);
+	s = (F_spline *) rtree_pick_next(O_SPLINE, s, True);
 
-    for (; s != NULL; s = prev_spline(objects.splines, s)) {
+    for (; s != NULL; s = (F_spline *) rtree_pick_next(O_SPLINE, s, True)) {
 	if (validspline_in_mask(s)) {
 	    n++;
             if (close_to_spline(s, x, y, tolerance, px, py, 
@@ -393,11 +453,11 @@ smart_next_text_found(int x, int y, int tolerance, int *px, int *py, int shift)
     if (!anytext_in_mask())
 	return (0);
     if (t == NULL)
-	t = last_text(objects.texts);
+	t = (F_text *) rtree_pick_next(O_TEXT, NULL, True);
     else if (shift)
-	t = prev_text(objects.texts, t);
+	t = (F_text *) rtree_pick_next(O_TEXT, t, True);
 
-    for (; t != NULL; t = prev_text(objects.texts, t))
+    for (; t != NULL; t = (F_text *) rtree_pick_next(O_TEXT, t, True))
 	if (validtext_in_mask(t)) {
 	    n++;
 	    if (in_text_bound(t, x, y, &dum, False)) {
@@ -421,13 +481,13 @@ smart_next_compound_found(int x, int y, int tolerance, int *px, int *py, int shi
     if (!compound_in_mask())
 	return (0);
     if (c == NULL)
-	c = last_compound(objects.compounds);
+	c = (F_compound *) rtree_pick_next(O_COMPOUND, NULL, True);
     else if (shift)
-	c = prev_compound(objects.compounds, c);
+	c = (F_compound *) rtree_pick_next(O_COMPOUND, c, True);
 
     tol2 = tolerance * tolerance;
 
-    for (; c != NULL; c = prev_compound(objects.compounds, c), n++) {
+    for (; c != NULL; c = (F_compound *) rtree_pick_next(O_COMPOUND, c, True), n++) {
 	if (close_to_vector(c->nwcorner.x, c->nwcorner.y, c->nwcorner.x,
 			    c->secorner.y, x, y, tolerance, tol2, px, py)) {
             set_smart_points(c->nwcorner.x, c->nwcorner.y, c->nwcorner.x, c->secorner.y);
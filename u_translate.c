@@ -18,6 +18,8 @@
 #include "fig.h"
 #include "resources.h"
 #include "object.h"
+#include "u_bound.h"
+#include "u_create.h"
 
 
 void translate_lines (F_line *lines, int dx, int dy);
@@ -76,12 +78,17 @@ void translate_spline(F_spline *spline, int dx, int dy)
 
 }
 
-void translate_compound(F_compound *compound, int dx, int dy)
+/*
+ * Move compound c and everything in it.  Returns False, with the
+ * compound left where it was, if there isn't the memory to unshare it.
+ */
+
+Boolean translate_compound(F_compound *compound, int dx, int dy)
 {
-    compound->nwcorner.x += dx;
-    compound->nwcorner.y += dy;
-    compound->secorner.x += dx;
-    compound->secorner.y += dy;
+    /* unshare it all before anything is moved */
+    if (!unshare_compound_tree(compound))
+	return False;
+    translate_compound_bound(compound, dx, dy);
 
     translate_lines(compound->lines, dx, dy);
     translate_splines(compound->splines, dx, dy);
@@ -89,6 +96,7 @@ void translate_compound(F_compound *compound, int dx, int dy)
     translate_arcs(compound->arcs, dx, dy);
     translate_texts(compound->texts, dx, dy);
     translate_compounds(compound->compounds, dx, dy);
+    return True;
 }
 
 void translate_arcs(F_arc *arcs, int dx, int dy)
@@ -104,7 +112,7 @@ void translate_compounds(F_compound *compounds, int dx, int dy)
     F_compound	   *c;
 
     for (c = compounds; c != NULL; c = c->next)
-	translate_compound(c, dx, dy);
+	(void) translate_compound(c, dx, dy);	/* already unshared */
 }
 
 void translate_ellipses(F_ellipse *ellipses, int dx, int dy)
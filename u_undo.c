@@ -26,10 +26,12 @@
 #include "e_addpt.h"
 #include "e_arrow.h"
 #include "e_convert.h"
+#include "u_create.h"
 #include "u_draw.h"
 #include "u_elastic.h"
 #include "u_list.h"
 #include "u_redraw.h"
+#include "u_rtree.h"
 #include "u_undo.h"
 #include "w_canvas.h"
 #include "w_drawprim.h"
@@ -44,6 +46,7 @@
 #include "u_bound.h"
 #include "u_free.h"
 #include "u_markers.h"
+#include "u_pool.h"
 #include "u_translate.h"
 #include "w_cmdpanel.h"
 #include "w_indpanel.h"
@@ -103,12 +106,907 @@ void undo_join_split (void);
 void set_action_object (int action, int object);
 void swap_newp_lastp (void);
 
+/*
+ * The undo journal.
+ *
+ * The variables above describe the most recent action.  When the next action
+ * calls clean_up(), that description is not freed but pushed as a record on
+ * the undo list, and undo() loads the records back one at a time.  Undoing
+ * an action leaves its inverse in the variables, as it always has, and that
+ * is pushed on the redo list for redo().  A new action discards the redo list.
+ *
+ * A record is small except for the objects it saves (deleted objects, the
+ * original of an edited object, the previous figure of a load), and only
+ * those are counted against appres.undo_memory.  When the records hold more
+ * than that, the oldest ones are released, keeping at least the last action.
+ *
+ * The records refer to the objects of the figure by pointer, so undoing an
+ * action must give back the objects the older records refer to.  Most undo
+ * routines do.  An edit swaps the contents of the original and the changed
+ * object, so fix_edit_refs() makes the other records follow the contents.
+ * Converting, joining and splitting make new objects, undoing or redoing
+ * these forgets the rest of the journal.  Before a record from the journal
+ * is undone, record_valid() checks that its objects are still where it
+ * expects them and the journal is cut there if they aren't.
+ */
+
+#define		DEF_UNDO_MEMORY		4096	/* Kbytes, if appres.undo_memory isn't set */
+
+typedef struct undo_rec {
+    int		    action, object;
+    F_compound	    saved, tails;
+    F_pos	    last_position, new_position;
+    int		    arcpointnum;
+    F_point	   *prev_point, *selected_point, *next_point;
+    F_sfactor	   *selected_sfactor;
+    F_linkinfo	   *links;
+    int		    linkmode;
+    F_arrow	   *for_arrow, *back_arrow;
+    F_arrow	   *saved_for_arrow, *saved_back_arrow;
+    double	    origin_tension, extremity_tension;
+    F_line	   *latest_line;
+    F_spline	   *latest_spline;
+    char	   *filename;		/* save_filename of a load or "new" */
+    int		    counts[6];		/* objects to cut off after tails */
+    long	    bytes;		/* memory held by the saved objects */
+    struct undo_rec *older, *newer;
+}
+	U_record;
+
+static U_record *undo_newest = NULL, *undo_oldest = NULL;
+static U_record *redo_newest = NULL;
+static long	journal_bytes = 0;
+static Boolean	undo_busy = False;	/* clean_up() only releases while undoing */
+
+static int	list_types[6] = { O_ARC, O_COMPOUND, O_ELLIPSE,
+				  O_POLYLINE, O_SPLINE, O_TEXT };
+
+static void	release_record(void);
+static Boolean	undo_action(void);
+
+/* copy the description of the current action to/from a record */
+
+static void
+save_record(U_record *r)
+{
+    r->action = last_action;
+    r->object = last_object;
+    r->saved = saved_objects;
+    r->tails = object_tails;
+    r->last_position = last_position;
+    r->new_position = new_position;
+    r->arcpointnum = last_arcpointnum;
+    r->prev_point = last_prev_point;
+    r->selected_point = last_selected_point;
+    r->next_point = last_next_point;
+    r->selected_sfactor = last_selected_sfactor;
+    r->links = last_links;
+    r->linkmode = last_linkmode;
+    r->for_arrow = last_for_arrow;
+    r->back_arrow = last_back_arrow;
+    r->saved_for_arrow = saved_for_arrow;
+    r->saved_back_arrow = saved_back_arrow;
+    r->origin_tension = last_origin_tension;
+    r->extremity_tension = last_extremity_tension;
+    r->latest_line = latest_line;
+    r->latest_spline = latest_spline;
+}
+
+static void
+load_record(U_record *r)
+{
+    last_action = r->action;
+    last_object = r->object;
+    saved_objects = r->saved;
+    object_tails = r->tails;
+    last_position = r->last_position;
+    new_position = r->new_position;
+    last_arcpointnum = r->arcpointnum;
+    last_prev_point = r->prev_point;
+    last_selected_point = r->selected_point;
+    last_next_point = r->next_point;
+    last_selected_sfactor = r->selected_sfactor;
+    last_links = r->links;
+    last_linkmode = r->linkmode;
+    last_for_arrow = r->for_arrow;
+    last_back_arrow = r->back_arrow;
+    saved_for_arrow = r->saved_for_arrow;
+    saved_back_arrow = r->saved_back_arrow;
+    last_origin_tension = r->origin_tension;
+    last_extremity_tension = r->extremity_tension;
+    latest_line = r->latest_line;
+    latest_spline = r->latest_spline;
+}
+
+/* forget the current action once it is in a record */
+
+static void
+clear_current(void)
+{
+    static F_compound empty;
+
+    saved_objects = empty;
+    last_prev_point = last_selected_point = last_next_point = NULL;
+    last_selected_sfactor = NULL;
+    last_links = NULL;
+    last_for_arrow = last_back_arrow = NULL;
+    last_action = F_NULL;
+}
+
+static void *
+list_head(F_compound *c, int type)
+{
+    switch (type) {
+      case O_ARC:
+	return (void *) c->arcs;
+      case O_COMPOUND:
+	return (void *) c->compounds;
+      case O_ELLIPSE:
+	return (void *) c->ellipses;
+      case O_POLYLINE:
+	return (void *) c->lines;
+      case O_SPLINE:
+	return (void *) c->splines;
+      case O_TEXT:
+	return (void *) c->texts;
+    }
+    return NULL;
+}
+
+static void
+set_list_head(F_compound *c, int type, void *obj)
+{
+    switch (type) {
+      case O_ARC:
+	c->arcs = (F_arc *) obj;
+	break;
+      case O_COMPOUND:
+	c->compounds = (F_compound *) obj;
+	break;
+      case O_ELLIPSE:
+	c->ellipses = (F_ellipse *) obj;
+	break;
+      case O_POLYLINE:
+	c->lines = (F_line *) obj;
+	break;
+      case O_SPLINE:
+	c->splines = (F_spline *) obj;
+	break;
+      case O_TEXT:
+	c->texts = (F_text *) obj;
+	break;
+    }
+}
+
+/*
+ * Return the number of objects from "obj" to the end of its list in the
+ * figure (0 if it isn't in the figure) and the object before it in *before.
+ */
+
+static int
+figure_position(int type, void *obj, void **before)
+{
+    F_arc	   *a;
+    F_compound	   *c;
+    F_ellipse	   *e;
+    F_line	   *l;
+    F_spline	   *s;
+    F_text	   *t;
+    int		    n;
+
+    *before = NULL;
+    n = 0;
+    switch (type) {
+      case O_ARC:
+	for (a = objects.arcs; a && a != obj; a = a->next)
+	    *before = (void *) a;
+	for ( ; a; a = a->next)
+	    n++;
+	break;
+      case O_COMPOUND:
+	for (c = objects.compounds; c && c != obj; c = c->next)
+	    *before = (void *) c;
+	for ( ; c; c = c->next)
+	    n++;
+	break;
+      case O_ELLIPSE:
+	for (e = objects.ellipses; e && e != obj; e = e->next)
+	    *before = (void *) e;
+	for ( ; e; e = e->next)
+	    n++;
+	break;
+      case O_POLYLINE:
+	for (l = objects.lines; l && l != obj; l = l->next)
+	    *before = (void *) l;
+	for ( ; l; l = l->next)
+	    n++;
+	break;
+      case O_SPLINE:
+	for (s = objects.splines; s && s != obj; s = s->next)
+	    *before = (void *) s;
+	for ( ; s; s = s->next)
+	    n++;
+	break;
+      case O_TEXT:
+	for (t = objects.texts; t && t != obj; t = t->next)
+	    *before = (void *) t;
+	for ( ; t; t = t->next)
+	    n++;
+	break;
+    }
+    return n;
+}
+
+static Boolean
+in_figure(int type, void *obj)
+{
+    void	   *dum;
+
+    return obj != NULL && figure_position(type, obj, &dum) > 0;
+}
+
+static Boolean
+point_in(F_point *p, F_point *points)
+{
+    for ( ; points; points = points->next)
+	if (points == p)
+	    return True;
+    return False;
+}
+
+/*
+ * The undo of an action that added a group of objects cuts the lists of
+ * the figure after object_tails.  Find the tails in front of the group
+ * again, and check that nothing else has been appended to it since.
+ */
+
+static Boolean
+find_tails(F_compound *added, int *counts)
+{
+    void	   *head, *before;
+    int		    i;
+
+    tail(&objects, &object_tails);
+    for (i = 0; i < 6; i++) {
+	if ((head = list_head(added, list_types[i])) == NULL) {
+	    if (counts[i] != 0)
+		return False;
+	    continue;
+	}
+	if (figure_position(list_types[i], head, &before) != counts[i])
+	    return False;
+	set_list_head(&object_tails, list_types[i], before);
+    }
+    return True;
+}
+
+static void
+count_added(F_compound *added, int *counts)
+{
+    void	   *head, *before;
+    int		    i;
+
+    for (i = 0; i < 6; i++) {
+	head = list_head(added, list_types[i]);
+	counts[i] = head? figure_position(list_types[i], head, &before): 0;
+    }
+}
+
+/* check a record loaded from the journal against the figure */
+
+static Boolean
+record_valid(U_record *r)
+{
+    void	   *obj;
+    F_point	   *points;
+
+    if (last_object == O_ALL_OBJECT) {
+	if (last_action == F_ADD)
+	    return find_tails(&saved_objects, r->counts);
+	return True;
+    }
+    if (last_object == O_FIGURE)
+	return True;
+    obj = list_head(&saved_objects, last_object);
+    switch (last_action) {
+      case F_ADD:
+      case F_MOVE:
+      case F_OPEN_CLOSE:
+      case F_ADD_ARROW_HEAD:
+      case F_DELETE_ARROW_HEAD:
+      case F_GLUE:
+	return in_figure(last_object, obj);
+      case F_DELETE:
+	return obj != NULL && !in_figure(last_object, obj);
+      case F_BREAK:
+	return obj != NULL && !in_figure(O_COMPOUND, obj) &&
+		find_tails(saved_objects.compounds, r->counts);
+      case F_EDIT:
+	if (obj == NULL)
+	    return False;
+	switch (last_object) {
+	  case O_ARC:
+	    return in_figure(O_ARC, saved_objects.arcs->next);
+	  case O_COMPOUND:
+	    return in_figure(O_COMPOUND, saved_objects.compounds->next);
+	  case O_ELLIPSE:
+	    return in_figure(O_ELLIPSE, saved_objects.ellipses->next);
+	  case O_POLYLINE:
+	    return in_figure(O_POLYLINE, saved_objects.lines->next);
+	  case O_SPLINE:
+	    return in_figure(O_SPLINE, saved_objects.splines->next);
+	  case O_TEXT:
+	    return in_figure(O_TEXT, saved_objects.texts->next);
+	}
+	return False;
+      case F_ADD_POINT:
+      case F_DELETE_POINT:
+	if (!in_figure(last_object, obj))
+	    return False;
+	points = last_object == O_POLYLINE? saved_objects.lines->points:
+					    saved_objects.splines->points;
+	if (last_prev_point && !point_in(last_prev_point, points))
+	    return False;
+	return point_in(last_selected_point, points) == (last_action == F_ADD_POINT);
+    }
+    return True;
+}
+
+/*
+ * Approximate memory held by saved objects, for the journal's budget.
+ */
+
+static long
+arrow_bytes(F_arrow *for_arrow, F_arrow *back_arrow)
+{
+    return (for_arrow? sizeof(F_arrow): 0) + (back_arrow? sizeof(F_arrow): 0);
+}
+
+static long
+comment_bytes(char *comments)
+{
+    return comments? strlen(comments) + 1: 0;
+}
+
+static long	all_bytes(F_compound *c);
+
+static long
+object_bytes(int type, void *obj)
+{
+    F_arc	   *a;
+    F_compound	   *c;
+    F_ellipse	   *e;
+    F_line	   *l;
+    F_spline	   *s;
+    F_text	   *t;
+    F_point	   *p;
+    F_sfactor	   *f;
+    long	    n;
+
+    n = 0;
+    switch (type) {
+      case O_ARC:
+	a = (F_arc *) obj;
+	n = sizeof(F_arc) + arrow_bytes(a->for_arrow, a->back_arrow) +
+		comment_bytes(a->comments);
+	break;
+      case O_COMPOUND:
+	c = (F_compound *) obj;
+	n = sizeof(F_compound) + comment_bytes(c->comments);
+	/* objects shared with another compound cost nothing more */
+	if (c->shared == NULL)
+	    n += all_bytes(c);
+	break;
+      case O_ELLIPSE:
+	e = (F_ellipse *) obj;
+	n = sizeof(F_ellipse) + comment_bytes(e->comments);
+	break;
+      case O_POLYLINE:
+	l = (F_line *) obj;
+	n = sizeof(F_line) + arrow_bytes(l->for_arrow, l->back_arrow) +
+		comment_bytes(l->comments) + (l->pic? sizeof(F_pic): 0);
+	for (p = l->points; p; p = p->next)
+	    n += sizeof(F_point);
+	break;
+      case O_SPLINE:
+	s = (F_spline *) obj;
+	n = sizeof(F_spline) + arrow_bytes(s->for_arrow, s->back_arrow) +
+		comment_bytes(s->comments);
+	for (p = s->points; p; p = p->next)
+	    n += sizeof(F_point);
+	for (f = s->sfactors; f; f = f->next)
+	    n += sizeof(F_sfactor);
+	break;
+      case O_TEXT:
+	t = (F_text *) obj;
+	n = sizeof(F_text) + comment_bytes(t->cstring) + comment_bytes(t->comments);
+	break;
+    }
+    return n;
+}
+
+static long
+list_bytes(F_compound *c, int type)
+{
+    F_arc	   *a;
+    F_compound	   *cc;
+    F_ellipse	   *e;
+    F_line	   *l;
+    F_spline	   *s;
+    F_text	   *t;
+    long	    n;
+
+    n = 0;
+    switch (type) {
+      case O_ARC:
+	for (a = c->arcs; a; a = a->next)
+	    n += object_bytes(O_ARC, a);
+	break;
+      case O_COMPOUND:
+	for (cc = c->compounds; cc; cc = cc->next)
+	    n += object_bytes(O_COMPOUND, cc);
+	break;
+      case O_ELLIPSE:
+	for (e = c->ellipses; e; e = e->next)
+	    n += object_bytes(O_ELLIPSE, e);
+	break;
+      case O_POLYLINE:
+	for (l = c->lines; l; l = l->next)
+	    n += object_bytes(O_POLYLINE, l);
+	break;
+      case O_SPLINE:
+	for (s = c->splines; s; s = s->next)
+	    n += object_bytes(O_SPLINE, s);
+	break;
+      case O_TEXT:
+	for (t = c->texts; t; t = t->next)
+	    n += object_bytes(O_TEXT, t);
+	break;
+    }
+    return n;
+}
+
+static long
+all_bytes(F_compound *c)
+{
+    long	    n;
+    int		    i;
+
+    for (i = 0, n = 0; i < 6; i++)
+	n += list_bytes(c, list_types[i]);
+    return n;
+}
+
+/* the memory that releasing the current action would free */
+
+static long
+current_bytes(void)
+{
+    void	   *obj;
+
+    if (last_object == O_ALL_OBJECT) {
+	if (last_action == F_DELETE || last_action == F_LOAD || last_action == F_EDIT)
+	    return all_bytes(&saved_objects);
+	return 0;
+    }
+    switch (last_action) {
+      case F_LOAD:
+	return all_bytes(&saved_objects);
+      case F_DELETE:
+      case F_JOIN:
+      case F_SPLIT:
+	return list_bytes(&saved_objects, last_object);
+      case F_EDIT:
+	if (last_object == O_FIGURE)
+	    return comment_bytes(saved_objects.comments);
+	/* only the original, saved_objects.xxx->next is in the figure */
+	if ((obj = list_head(&saved_objects, last_object)) == NULL)
+	    return 0;
+	return object_bytes(last_object, obj);
+      case F_BREAK:
+	return sizeof(F_compound);
+    }
+    return 0;
+}
+
+/*
+ * An edit swapped the contents of saved_objects.xxx and the object
+ * saved_objects.xxx->next in the figure.  The journal must refer to the
+ * one in the figure, and to the points and members it now holds.
+ */
+
+static void
+remap_record(U_record *r, void *from, void *to)
+{
+    F_linkinfo	   *k;
+    void	   *obj;
+    int		    i;
+
+    for (i = 0; i < 6; i++) {
+	if (list_head(&r->saved, list_types[i]) == from)
+	    set_list_head(&r->saved, list_types[i], to);
+	if (list_head(&r->tails, list_types[i]) == from)
+	    set_list_head(&r->tails, list_types[i], to);
+    }
+    /* an edit keeps the object in the figure in saved_objects.xxx->next */
+    if (r->action == F_EDIT && (obj = list_head(&r->saved, r->object)) != NULL)
+	switch (r->object) {
+	  case O_ARC:
+	    if (((F_arc *) obj)->next == from)
+		((F_arc *) obj)->next = (F_arc *) to;
+	    break;
+	  case O_COMPOUND:
+	    if (((F_compound *) obj)->next == from)
+		((F_compound *) obj)->next = (F_compound *) to;
+	    break;
+	  case O_ELLIPSE:
+	    if (((F_ellipse *) obj)->next == from)
+		((F_ellipse *) obj)->next = (F_ellipse *) to;
+	    break;
+	  case O_POLYLINE:
+	    if (((F_line *) obj)->next == from)
+		((F_line *) obj)->next = (F_line *) to;
+	    break;
+	  case O_SPLINE:
+	    if (((F_spline *) obj)->next == from)
+		((F_spline *) obj)->next = (F_spline *) to;
+	    break;
+	  case O_TEXT:
+	    if (((F_text *) obj)->next == from)
+		((F_text *) obj)->next = (F_text *) to;
+	    break;
+	}
+    if (r->latest_line == from)
+	r->latest_line = (F_line *) to;
+    if (r->latest_spline == from)
+	r->latest_spline = (F_spline *) to;
+    if (r->prev_point == from)
+	r->prev_point = (F_point *) to;
+    if (r->selected_point == from)
+	r->selected_point = (F_point *) to;
+    if (r->next_point == from)
+	r->next_point = (F_point *) to;
+    if (r->selected_sfactor == from)
+	r->selected_sfactor = (F_sfactor *) to;
+    for (k = r->links; k; k = k->next) {
+	if (k->line == from)
+	    k->line = (F_line *) to;
+	if (k->endpt == from)
+	    k->endpt = (F_point *) to;
+	if (k->prevpt == from)
+	    k->prevpt = (F_point *) to;
+    }
+}
+
+static void
+remap(void *from, void *to)
+{
+    U_record	   *r;
+
+    if (from == to)
+	return;
+    for (r = undo_newest; r; r = r->older)
+	remap_record(r, from, to);
+    for (r = redo_newest; r; r = r->older)
+	remap_record(r, from, to);
+}
+
+static void
+remap_points(F_point *from, F_point *to)
+{
+    for ( ; from && to; from = from->next, to = to->next)
+	remap(from, to);
+}
+
+static void
+remap_compound(F_compound *from, F_compound *to)
+{
+    F_arc	   *a, *aa;
+    F_compound	   *c, *cc;
+    F_ellipse	   *e, *ee;
+    F_line	   *l, *ll;
+    F_spline	   *s, *ss;
+    F_sfactor	   *f, *ff;
+    F_text	   *t, *tt;
+
+    remap(from, to);
+    for (a = from->arcs, aa = to->arcs; a && aa; a = a->next, aa = aa->next)
+	remap(a, aa);
+    for (c = from->compounds, cc = to->compounds; c && cc; c = c->next, cc = cc->next)
+	remap_compound(c, cc);
+    for (e = from->ellipses, ee = to->ellipses; e && ee; e = e->next, ee = ee->next)
+	remap(e, ee);
+    for (l = from->lines, ll = to->lines; l && ll; l = l->next, ll = ll->next) {
+	remap(l, ll);
+	remap_points(l->points, ll->points);
+    }
+    for (s = from->splines, ss = to->splines; s && ss; s = s->next, ss = ss->next) {
+	remap(s, ss);
+	remap_points(s->points, ss->points);
+	for (f = s->sfactors, ff = ss->sfactors; f && ff; f = f->next, ff = ff->next)
+	    remap(f, ff);
+    }
+    for (t = from->texts, tt = to->texts; t && tt; t = t->next, tt = tt->next)
+	remap(t, tt);
+}
+
+static void
+fix_edit_refs(void)
+{
+    F_sfactor	   *f, *ff;
+
+    if (last_action != F_EDIT || list_head(&saved_objects, last_object) == NULL)
+	return;
+    switch (last_object) {
+      case O_ARC:
+	remap(saved_objects.arcs, saved_objects.arcs->next);
+	break;
+      case O_COMPOUND:
+	remap_compound(saved_objects.compounds, saved_objects.compounds->next);
+	break;
+      case O_ELLIPSE:
+	remap(saved_objects.ellipses, saved_objects.ellipses->next);
+	break;
+      case O_POLYLINE:
+	remap(saved_objects.lines, saved_objects.lines->next);
+	remap_points(saved_objects.lines->points, saved_objects.lines->next->points);
+	break;
+      case O_SPLINE:
+	remap(saved_objects.splines, saved_objects.splines->next);
+	remap_points(saved_objects.splines->points, saved_objects.splines->next->points);
+	for (f = saved_objects.splines->sfactors, ff = saved_objects.splines->next->sfactors;
+	     f && ff; f = f->next, ff = ff->next)
+	    remap(f, ff);
+	break;
+      case O_TEXT:
+	remap(saved_objects.texts, saved_objects.texts->next);
+	break;
+    }
+}
+
+/* undoing these makes new objects that the rest of the journal doesn't know */
+
+static Boolean
+breaks_journal(void)
+{
+    return last_action == F_CONVERT || last_action == F_JOIN ||
+	   last_action == F_SPLIT ||
+	   (last_action == F_EDIT && last_object == O_ALL_OBJECT);
+}
+
+/* release the objects held by a record and free it */
+
+static void
+free_record(U_record *r)
+{
+    U_record	    cur;
+
+    journal_bytes -= r->bytes;
+    save_record(&cur);
+    load_record(r);
+    release_record();
+    load_record(&cur);
+    free(r->filename);
+    free((char *) r);
+}
+
+/* release "r" and all the records older than it on the undo list */
+
+static void
+discard_undo(U_record *r)
+{
+    U_record	   *older;
+
+    if (r->newer)
+	r->newer->older = NULL;
+    else
+	undo_newest = NULL;
+    undo_oldest = r->newer;
+    for ( ; r; r = older) {
+	older = r->older;
+	free_record(r);
+    }
+}
+
+static void
+discard_redo(void)
+{
+    U_record	   *r;
+
+    while ((r = redo_newest) != NULL) {
+	redo_newest = r->older;
+	free_record(r);
+    }
+}
+
+static void
+discard_journal(void)
+{
+    if (undo_newest)
+	discard_undo(undo_newest);
+    discard_redo();
+}
+
+/* make a record of the current action */
+
+static U_record *
+new_record(void)
+{
+    U_record	   *r;
+
+    if ((r = (U_record *) malloc(sizeof(U_record))) == NULL)
+	return NULL;
+    save_record(r);
+    r->filename = NULL;
+    if (last_action == F_LOAD || last_object == O_ALL_OBJECT) {
+	r->filename = (char *) malloc(strlen(save_filename) + 1);
+	if (r->filename == NULL) {
+	    free((char *) r);
+	    return NULL;
+	}
+	strcpy(r->filename, save_filename);
+    }
+    if (last_action == F_ADD && last_object == O_ALL_OBJECT)
+	count_added(&saved_objects, r->counts);
+    else if (last_action == F_BREAK)
+	count_added(saved_objects.compounds, r->counts);
+    r->bytes = sizeof(U_record) + current_bytes();
+    r->older = r->newer = NULL;
+    return r;
+}
+
+/* the current action becomes the newest record of the undo list */
+
+static void
+push_undo(void)
+{
+    U_record	   *r;
+    long	    budget;
+
+    fix_edit_refs();
+    /* the user colors only remember the figure before the last load */
+    if (last_action == F_LOAD)
+	for (r = undo_newest; r; r = r->older)
+	    if (r->action == F_LOAD) {
+		discard_undo(r);
+		break;
+	    }
+    if ((r = new_record()) == NULL) {
+	release_record();
+	return;
+    }
+    if ((r->older = undo_newest) != NULL)
+	undo_newest->newer = r;
+    else
+	undo_oldest = r;
+    undo_newest = r;
+    journal_bytes += r->bytes;
+
+    budget = (appres.undo_memory > 0? appres.undo_memory: DEF_UNDO_MEMORY) * 1024L;
+    while (journal_bytes > budget && undo_oldest != undo_newest) {
+	r = undo_oldest;
+	undo_oldest = r->newer;
+	undo_oldest->older = NULL;
+	free_record(r);
+    }
+}
+
+static void
+push_redo(void)
+{
+    U_record	   *r;
+
+    if ((r = new_record()) == NULL) {
+	release_record();
+	return;
+    }
+    r->older = redo_newest;
+    redo_newest = r;
+    journal_bytes += r->bytes;
+}
+
+/* make the newest record of a list the current action */
+
+static Boolean
+pop_record(U_record **list, Boolean redo)
+{
+    U_record	   *r;
+    void	   *obj;
+    Boolean	    valid;
+
+    r = *list;
+    if ((*list = r->older) != NULL)
+	(*list)->newer = NULL;
+    else if (!redo)
+	undo_oldest = NULL;
+    journal_bytes -= r->bytes;
+    load_record(r);
+    if (r->filename)
+	strcpy(save_filename, r->filename);
+    valid = record_valid(r);
+    free(r->filename);
+    free((char *) r);
+    if (!valid) {
+	/* don't know what it holds any more, let it go, freeing its
+	   objects unless they are back in the figure */
+	obj = list_head(&saved_objects, last_object);
+	if (obj != NULL && !in_figure(last_object, obj))
+	    release_record();
+	clear_current();
+	if (redo)
+	    discard_redo();
+	else if (undo_newest)
+	    discard_undo(undo_newest);
+    }
+    return valid;
+}
+
 void
 undo(void)
 {
     /* turn off Compose key LED */
     setCompLED(0);
 
+    if (last_action == F_NULL) {
+	if (undo_newest == NULL) {
+	    put_msg("Nothing to UNDO");
+	    return;
+	}
+	if (!pop_record(&undo_newest, False)) {
+	    put_msg("The figure has changed since, can't UNDO any further");
+	    return;
+	}
+    }
+    /* undo_action() tells why if it can't */
+    if (!undo_action())
+	return;
+    /* keep the inverse for redo */
+    push_redo();
+    clear_current();
+    put_msg("Undo complete");
+}
+
+void
+redo(void)
+{
+    /* turn off Compose key LED */
+    setCompLED(0);
+
+    if (redo_newest == NULL) {
+	put_msg("Nothing to REDO");
+	return;
+    }
+    if (last_action != F_NULL) {
+	push_undo();
+	clear_current();
+    }
+    if (!pop_record(&redo_newest, True)) {
+	put_msg("The figure has changed since, can't REDO any further");
+	return;
+    }
+    if (!undo_action()) {
+	/* not redone, keep it for another try */
+	push_redo();
+	clear_current();
+	return;
+    }
+    /* leave it as the current action, the next undo() will undo it again */
+    put_msg("Redo complete");
+}
+
+/*
+ * Perform the inverse of the current action.  Returns False, having told
+ * the user why, if there is nothing to undo or not the memory to do it.
+ */
+
+static Boolean
+undo_action(void)
+{
+    Boolean	    forget;
+
+    forget = breaks_journal();
+    fix_edit_refs();
+    undo_busy = True;
     switch (last_action) {
       case F_ADD:
 	undo_add();
@@ -117,12 +1015,23 @@ undo(void)
 	undo_delete();
 	break;
       case F_MOVE:
+	/* a compound is moved as a whole, unshare it all first */
+	if (last_object == O_COMPOUND &&
+	    !unshare_compound_tree(saved_objects.compounds)) {
+	    undo_busy = False;
+	    return False;
+	}
 	undo_move();
 	break;
       case F_EDIT:
 	undo_change();
 	break;
       case F_GLUE:
+	/* its objects go back into the figure, they can't stay shared */
+	if (!unshare_compound(saved_objects.compounds)) {
+	    undo_busy = False;
+	    return False;
+	}
 	undo_glue();
 	break;
       case F_BREAK:
@@ -157,10 +1066,15 @@ undo(void)
 	undo_join_split();
 	break;
     default:
+	undo_busy = False;
 	put_msg("Nothing to UNDO");
-	return;
+	return False;
     }
-    put_msg("Undo complete");
+    undo_busy = False;
+    fix_edit_refs();
+    if (forget)
+	discard_journal();
+    return True;
 }
 
 void undo_join_split(void)
@@ -343,10 +1257,13 @@ void undo_change(void)
 	bcopy((char*)old_l, (char*)&swp_l, sizeof(F_line));
 	bcopy((char*)new_l, (char*)old_l, sizeof(F_line));
 	bcopy((char*)&swp_l, (char*)new_l, sizeof(F_line));
-	/* but keep the next pointers unchanged */
+	/* but keep the next and prev pointers unchanged */
 	swp_l.next = old_l->next;
 	old_l->next = new_l->next;
 	new_l->next = swp_l.next;
+	swp_l.prev = old_l->prev;
+	old_l->prev = new_l->prev;
+	new_l->prev = swp_l.prev;
 	set_action_object(F_EDIT, O_POLYLINE);
 	redisplay_lines(new_l, old_l);
 	break;
@@ -360,10 +1277,13 @@ void undo_change(void)
 	bcopy((char*)old_e, (char*)&swp_e, sizeof(F_ellipse));
 	bcopy((char*)new_e, (char*)old_e, sizeof(F_ellipse));
 	bcopy((char*)&swp_e, (char*)new_e, sizeof(F_ellipse));
-	/* but keep the next pointers unchanged */
+	/* but keep the next and prev pointers unchanged */
 	swp_e.next = old_e->next;
 	old_e->next = new_e->next;
 	new_e->next = swp_e.next;
+	swp_e.prev = old_e->prev;
+	old_e->prev = new_e->prev;
+	new_e->prev = swp_e.prev;
 	set_action_object(F_EDIT, O_ELLIPSE);
 	redisplay_ellipses(new_e, old_e);
 	break;
@@ -377,10 +1297,13 @@ void undo_change(void)
 	bcopy((char*)old_t, (char*)&swp_t, sizeof(F_text));
 	bcopy((char*)new_t, (char*)old_t, sizeof(F_text));
 	bcopy((char*)&swp_t, (char*)new_t, sizeof(F_text));
-	/* but keep the next pointers unchanged */
+	/* but keep the next and prev pointers unchanged */
 	swp_t.next = old_t->next;
 	old_t->next = new_t->next;
 	new_t->next = swp_t.next;
+	swp_t.prev = old_t->prev;
+	old_t->prev = new_t->prev;
+	new_t->prev = swp_t.prev;
 	set_action_object(F_EDIT, O_TEXT);
 	redisplay_texts(new_t, old_t);
 	break;
@@ -394,10 +1317,13 @@ void undo_change(void)
 	bcopy((char*)old_s, (char*)&swp_s, sizeof(F_spline));
 	bcopy((char*)new_s, (char*)old_s, sizeof(F_spline));
 	bcopy((char*)&swp_s, (char*)new_s, sizeof(F_spline));
-	/* but keep the next pointers unchanged */
+	/* but keep the next and prev pointers unchanged */
 	swp_s.next = old_s->next;
 	old_s->next = new_s->next;
 	new_s->next = swp_s.next;
+	swp_s.prev = old_s->prev;
+	old_s->prev = new_s->prev;
+	new_s->prev = swp_s.prev;
 	set_action_object(F_EDIT, O_SPLINE);
 	redisplay_splines(new_s, old_s);
 	break;
@@ -411,10 +1337,13 @@ void undo_change(void)
 	bcopy((char*)old_a, (char*)&swp_a, sizeof(F_arc));
 	bcopy((char*)new_a, (char*)old_a, sizeof(F_arc));
 	bcopy((char*)&swp_a, (char*)new_a, sizeof(F_arc));
-	/* but keep the next pointers unchanged */
+	/* but keep the next and prev pointers unchanged */
 	swp_a.next = old_a->next;
 	old_a->next = new_a->next;
 	new_a->next = swp_a.next;
+	swp_a.prev = old_a->prev;
+	old_a->prev = new_a->prev;
+	new_a->prev = swp_a.prev;
 	set_action_object(F_EDIT, O_ARC);
 	redisplay_arcs(new_a, old_a);
 	break;
@@ -424,14 +1353,8 @@ void undo_change(void)
 	/* account for depths */
 	remove_compound_depth(old_c);
 	add_compound_depth(new_c);
-	/* swap old with new */
-	bcopy((char*)old_c, (char*)&swp_c, sizeof(F_compound));
-	bcopy((char*)new_c, (char*)old_c, sizeof(F_compound));
-	bcopy((char*)&swp_c, (char*)new_c, sizeof(F_compound));
-	/* but keep the next pointers unchanged */
-	swp_c.next = old_c->next;
-	old_c->next = new_c->next;
-	new_c->next = swp_c.next;
+	/* swap old with new, keeping the rings of shared objects */
+	exchange_compounds(old_c, new_c);
 	set_action_object(F_EDIT, O_COMPOUND);
 	redisplay_compounds(new_c, old_c);
 	break;
@@ -446,6 +1369,7 @@ void undo_change(void)
 	swp_c = objects;
 	objects = saved_objects;
 	saved_objects = swp_c;
+	rtree_invalidate();
 	new_c = &objects;
 	old_c = &saved_objects;
 	/* account for depths */
@@ -576,6 +1500,7 @@ void undo_move(void)
       case O_POLYLINE:
 	line_bound(saved_objects.lines, &xmin1, &ymin1, &xmax1, &ymax1);
 	translate_line(saved_objects.lines, dx, dy);
+	rtree_update_object(O_POLYLINE, saved_objects.lines);
 	line_bound(saved_objects.lines, &xmin2, &ymin2, &xmax2, &ymax2);
 	adjust_links(last_linkmode, last_links, dx, dy, 0, 0, 1.0, 1.0, False);
 	redisplay_regions(xmin1, ymin1, xmax1, ymax1,
@@ -584,6 +1509,7 @@ void undo_move(void)
       case O_ELLIPSE:
 	ellipse_bound(saved_objects.ellipses, &xmin1, &ymin1, &xmax1, &ymax1);
 	translate_ellipse(saved_objects.ellipses, dx, dy);
+	rtree_update_object(O_ELLIPSE, saved_objects.ellipses);
 	ellipse_bound(saved_objects.ellipses, &xmin2, &ymin2, &xmax2, &ymax2);
 	redisplay_regions(xmin1, ymin1, xmax1, ymax1,
 			  xmin2, ymin2, xmax2, ymax2);
@@ -592,6 +1518,7 @@ void undo_move(void)
 	text_bound(saved_objects.texts, &xmin1, &ymin1, &xmax1, &ymax1,
 		&dum,&dum,&dum,&dum,&dum,&dum,&dum,&dum);
 	translate_text(saved_objects.texts, dx, dy);
+	rtree_update_object(O_TEXT, saved_objects.texts);
 	text_bound(saved_objects.texts, &xmin2, &ymin2, &xmax2, &ymax2,
 		&dum,&dum,&dum,&dum,&dum,&dum,&dum,&dum);
 	redisplay_regions(xmin1, ymin1, xmax1, ymax1,
@@ -600,6 +1527,7 @@ void undo_move(void)
       case O_SPLINE:
 	spline_bound(saved_objects.splines, &xmin1, &ymin1, &xmax1, &ymax1);
 	translate_spline(saved_objects.splines, dx, dy);
+	rtree_update_object(O_SPLINE, saved_objects.splines);
 	spline_bound(saved_objects.splines, &xmin2, &ymin2, &xmax2, &ymax2);
 	redisplay_regions(xmin1, ymin1, xmax1, ymax1,
 			  xmin2, ymin2, xmax2, ymax2);
@@ -607,13 +1535,15 @@ void undo_move(void)
       case O_ARC:
 	arc_bound(saved_objects.arcs, &xmin1, &ymin1, &xmax1, &ymax1);
 	translate_arc(saved_objects.arcs, dx, dy);
+	rtree_update_object(O_ARC, saved_objects.arcs);
 	arc_bound(saved_objects.arcs, &xmin2, &ymin2, &xmax2, &ymax2);
 	redisplay_regions(xmin1, ymin1, xmax1, ymax1,
 			  xmin2, ymin2, xmax2, ymax2);
 	break;
       case O_COMPOUND:
 	compound_bound(saved_objects.compounds, &xmin1, &ymin1, &xmax1, &ymax1);
-	translate_compound(saved_objects.compounds, dx, dy);
+	(void) translate_compound(saved_objects.compounds, dx, dy);	/* already unshared */
+	rtree_update_object(O_COMPOUND, saved_objects.compounds);
 	compound_bound(saved_objects.compounds, &xmin2, &ymin2, &xmax2, &ymax2);
 	adjust_links(last_linkmode, last_links, dx, dy, 0, 0, 1.0, 1.0, False);
 	redisplay_regions(xmin1, ymin1, xmax1, ymax1,
@@ -632,6 +1562,7 @@ void undo_load(void)
     temp = objects;
     objects = saved_objects;
     saved_objects = temp;
+    rtree_invalidate();
     /* swap filenames */
     strcpy(ctemp, cur_filename);
     update_cur_filename(save_filename);
@@ -658,6 +1589,7 @@ void undo_scale(void)
     scalex = ((float) (last_position.x - fix_x)) / (new_position.x - fix_x);
     scaley = ((float) (last_position.y - fix_y)) / (new_position.y - fix_y);
     scale_compound(saved_objects.compounds, scalex, scaley, fix_x, fix_y);
+    rtree_update_object(O_COMPOUND, saved_objects.compounds);
     compound_bound(saved_objects.compounds, &xmin2, &ymin2, &xmax2, &ymax2);
     redisplay_regions(xmin1, ymin1, xmax1, ymax1,
 			  xmin2, ymin2, xmax2, ymax2);
@@ -714,14 +1646,61 @@ void swap_newp_lastp(void)
 }
 
 /*
- * Clean_up should be called before committing a user's request. Clean_up
- * will attempt to free all the allocated memories which resulted from
- * delete/remove action.  It will set the last_action to F_NULL.  Thus this
- * routine should be before set_action_object() and set_last_arrows(),
- * if they are to be called in the same routine.
+ * Clean_up should be called before committing a user's request.  It puts
+ * the last action in the undo journal and discards the redo list.  It will
+ * set the last_action to F_NULL.  Thus this routine should be before
+ * set_action_object() and set_last_arrows(), if they are to be called in
+ * the same routine.
  */
 
 void clean_up(void)
+{
+    /* the undo routines themselves call clean_up() to drop the action they undo */
+    if (undo_busy) {
+	release_record();
+	return;
+    }
+    discard_redo();
+    if (last_action != F_NULL)
+	push_undo();
+    clear_current();
+}
+
+static void
+free_saved_arrows(void)
+{
+    F_arrow	   *for_arrow, *back_arrow;
+
+    switch (last_object) {
+      case O_POLYLINE:
+	for_arrow = saved_objects.lines->for_arrow;
+	back_arrow = saved_objects.lines->back_arrow;
+	break;
+      case O_SPLINE:
+	for_arrow = saved_objects.splines->for_arrow;
+	back_arrow = saved_objects.splines->back_arrow;
+	break;
+      case O_ARC:
+	for_arrow = saved_objects.arcs->for_arrow;
+	back_arrow = saved_objects.arcs->back_arrow;
+	break;
+      default:
+	return;
+    }
+    if (saved_for_arrow && saved_for_arrow != for_arrow)
+	free((char *) saved_for_arrow);
+    if (saved_back_arrow && saved_back_arrow != back_arrow)
+	free((char *) saved_back_arrow);
+    saved_for_arrow = saved_back_arrow = NULL;
+}
+
+/*
+ * Free all the allocated memories which resulted from the current action,
+ * when it falls off the undo journal, and set the last_action to F_NULL.
+ */
+
+static void
+release_record(void)
 {
     if (last_action == F_EDIT) {
 	switch (last_object) {
@@ -808,7 +1787,7 @@ void clean_up(void)
     } else if (last_action == F_GLUE) {
 	saved_objects.compounds = NULL;
     } else if (last_action == F_BREAK) {
-	free((char *) saved_objects.compounds);
+	pool_free(&compound_pool, saved_objects.compounds);
 	saved_objects.compounds = NULL;
     } else if (last_action == F_ADD || last_action == F_MOVE) {
 	saved_objects.arcs = NULL;
@@ -830,6 +1809,9 @@ void clean_up(void)
 	free((char *) last_back_arrow);
     } else if (last_action == F_ADD_ARROW_HEAD ||
 	       last_action == F_DELETE_ARROW_HEAD) {
+	/* free the arrowheads taken off the object */
+	if (last_action == F_DELETE_ARROW_HEAD)
+	    free_saved_arrows();
 	saved_objects.splines = NULL;
 	saved_objects.lines = NULL;
 	saved_objects.arcs = NULL;
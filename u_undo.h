@@ -27,6 +27,7 @@ extern F_arrow		*saved_back_arrow;
 extern F_line		*latest_line;		/* for undo_join (line) */
 extern F_spline		*latest_spline;		/* for undo_join (spline) */
 extern void		 undo(void);
+extern void		 redo(void);
 extern void clean_up (void);
 extern void set_action (int action);
 extern void set_action_object (int action, int object);
@@ -0,0 +1,419 @@
+/*
+ * FIG : Facility for Interactive Generation of figures
+ * Copyright (c) 1985-1988 by Supoj Sutanthavibul
+ * Parts Copyright (c) 1989-2002 by Brian V. Smith
+ * Parts Copyright (c) 1991 by Paul King
+ *
+ * Any party obtaining a copy of these files is granted, free of charge, a
+ * full and unrestricted irrevocable, world-wide, paid up, royalty-free,
+ * nonexclusive right and license to deal in this software and documentation
+ * files (the "Software"), including without limitation the rights to use,
+ * copy, modify, merge, publish distribute, sublicense and/or sell copies of
+ * the Software, and to permit persons who receive copies from any such
+ * party to do so, with the only requirement being that the above copyright
+ * and this permission notice remain intact.
+ *
+ */
+
+/*
+ * Vertex grids of long lines and splines, for the point search and for
+ * snapping.  The R-tree of u_rtree.c finds the objects near the cursor,
+ * but then all the points of each one were looked at, which is slow for a
+ * line of many thousand points, as an imported map or plot can have.
+ *
+ * An object of at least VX_MINPOINTS points gets a uniform grid over its
+ * points the first time it is searched, and another over the middles of
+ * its segments when snapping to them.  The sites of a grid are sorted by
+ * cell, those of cell i being first[i] to first[i+1]-1, and hold twice the
+ * coordinates so that the middles stay exact.  The grids are freed when
+ * the object changes, and all of them go stale when the R-tree is rebuilt.
+ * The queries give the same point as scanning the list would: the first
+ * in list order among those equally good.
+ */
+
+#include "fig.h"
+#include "resources.h"
+#include "object.h"
+#include "u_vindex.h"
+
+#define VX_MINPOINTS	64		/* shorter lists are just scanned */
+#define VX_PERCELL	2		/* average number of sites per cell */
+
+typedef struct vx_site {
+    int		    x, y;		/* twice the coordinates */
+    int		    seq;		/* position in the list of points */
+    F_point	   *prev, *p;		/* the point (or segment end) and the one before */
+}
+	VX_site;
+
+typedef struct vx_grid {
+    int		    xmin, ymin;		/* corner of cell 0 */
+    int		    cell;		/* size of the cells */
+    int		    ncols, nrows;
+    int		   *first;
+    VX_site	   *sites;
+}
+	VX_grid;
+
+struct vx_index {
+    F_point	   *points;		/* list the grids were made from */
+    unsigned	    epoch;
+    int		    npoints;
+    VX_grid	   *vertices;		/* NULL until needed */
+    VX_grid	   *middles;
+};
+
+static unsigned	  vx_epoch = 0;
+
+/********************** building **********************/
+
+/* count the points in a list, stopping at "most" if it isn't 0 */
+
+static int
+count_points(F_point *p, int most)
+{
+    int		    n;
+
+    for (n = 0; p != NULL && (most == 0 || n < most); p = p->next)
+	n++;
+    return n;
+}
+
+static void
+free_grid(VX_grid *g)
+{
+    if (g == NULL)
+	return;
+    free((char *) g->first);
+    free((char *) g->sites);
+    free((char *) g);
+}
+
+static int
+grid_col(VX_grid *g, int x)
+{
+    int		    i;
+
+    i = (x - g->xmin) / g->cell;
+    return (i < 0? 0: i >= g->ncols? g->ncols - 1: i);
+}
+
+static int
+grid_row(VX_grid *g, int y)
+{
+    int		    j;
+
+    j = (y - g->ymin) / g->cell;
+    return (j < 0? 0: j >= g->nrows? g->nrows - 1: j);
+}
+
+static int
+site_cell(VX_grid *g, VX_site *s)
+{
+    return grid_row(g, s->y) * g->ncols + grid_col(g, s->x);
+}
+
+/* make a grid over the n points, or over the middles of the segments */
+
+static VX_grid *
+build_grid(F_point *points, int n, Boolean middles)
+{
+    VX_grid	   *g;
+    VX_site	   *tmp, *s;
+    F_point	   *prev, *p;
+    int		    i, nsites, ncells, xmax, ymax;
+    double	    w, h, cell;
+
+    nsites = middles? n - 1: n;
+    if ((g = (VX_grid *) malloc(sizeof(VX_grid))) == NULL)
+	return NULL;
+    g->first = NULL;
+    g->sites = (VX_site *) malloc(nsites * sizeof(VX_site));
+    tmp = (VX_site *) malloc(nsites * sizeof(VX_site));
+    if (g->sites == NULL || tmp == NULL) {
+	free((char *) tmp);
+	free_grid(g);
+	return NULL;
+    }
+
+    s = tmp;
+    for (i = 0, prev = NULL, p = points; p != NULL; i++, prev = p, p = p->next) {
+	if (middles) {
+	    if (prev == NULL)
+		continue;
+	    s->x = prev->x + p->x;
+	    s->y = prev->y + p->y;
+	} else {
+	    s->x = 2 * p->x;
+	    s->y = 2 * p->y;
+	}
+	s->seq = i;
+	s->prev = prev;
+	s->p = p;
+	s++;
+    }
+    g->xmin = xmax = tmp[0].x;
+    g->ymin = ymax = tmp[0].y;
+    for (i = 1; i < nsites; i++) {
+	g->xmin = min2(g->xmin, tmp[i].x);
+	g->ymin = min2(g->ymin, tmp[i].y);
+	xmax = max2(xmax, tmp[i].x);
+	ymax = max2(ymax, tmp[i].y);
+    }
+
+    /* square cells, but no more of them than the sites call for, even if
+       the points are all in a row */
+    ncells = max2(nsites / VX_PERCELL, 1);
+    w = (double) xmax - g->xmin;
+    h = (double) ymax - g->ymin;
+    cell = max2(sqrt(w * h / ncells), max2(w, h) / ncells);
+    g->cell = max2((int) ceil(cell), 1);
+    g->ncols = (int) (w / g->cell) + 1;
+    g->nrows = (int) (h / g->cell) + 1;
+    ncells = g->ncols * g->nrows;
+
+    /* sort the sites by cell */
+    if ((g->first = (int *) malloc((ncells + 1) * sizeof(int))) == NULL) {
+	free((char *) tmp);
+	free_grid(g);
+	return NULL;
+    }
+    for (i = 0; i <= ncells; i++)
+	g->first[i] = 0;
+    for (i = 0; i < nsites; i++)
+	g->first[site_cell(g, &tmp[i]) + 1]++;
+    for (i = 0; i < ncells; i++)
+	g->first[i + 1] += g->first[i];
+    for (i = 0; i < nsites; i++)
+	g->sites[g->first[site_cell(g, &tmp[i])]++] = tmp[i];
+    /* each first[] has moved on to the start of the next cell */
+    for (i = ncells; i > 0; i--)
+	g->first[i] = g->first[i - 1];
+    g->first[0] = 0;
+
+    free((char *) tmp);
+    return g;
+}
+
+/*
+ * The grid over the points (or the middles) of a list, or NULL if the list
+ * is short or there is no memory, when the caller scans it instead.
+ */
+
+static VX_grid *
+get_grid(F_point *points, struct vx_index **vx, Boolean middles)
+{
+    struct vx_index *v;
+    VX_grid	  **g;
+
+    if (*vx != NULL && ((*vx)->points != points || (*vx)->epoch != vx_epoch))
+	vindex_free(vx);
+    if ((v = *vx) == NULL) {
+	if (count_points(points, VX_MINPOINTS) < VX_MINPOINTS)
+	    return NULL;
+	if ((v = (struct vx_index *) malloc(sizeof(struct vx_index))) == NULL)
+	    return NULL;
+	v->points = points;
+	v->epoch = vx_epoch;
+	v->npoints = count_points(points, 0);
+	v->vertices = v->middles = NULL;
+	*vx = v;
+    }
+    g = middles? &v->middles: &v->vertices;
+    if (*g == NULL)
+	*g = build_grid(points, v->npoints, middles);
+    return *g;
+}
+
+/********************** queries **********************/
+
+/*
+ * The site nearest (qx, qy), looking at the cells in rings around the one
+ * it is in until the ring is farther away than the best site so far.
+ */
+
+static VX_site *
+grid_nearest(VX_grid *g, int qx, int qy)
+{
+    VX_site	   *s, *best;
+    double	    d, bestd, dx, dy, gap;
+    int		    ci, cj, i, j, k, r, step;
+
+    best = NULL;
+    bestd = 0.0;
+    ci = grid_col(g, qx);
+    cj = grid_row(g, qy);
+    for (r = 0; r < max2(g->ncols, g->nrows); r++) {
+	if (best != NULL && r > 0) {
+	    gap = (double) (r - 1) * g->cell;
+	    if (gap * gap > bestd)
+		break;
+	}
+	for (j = cj - r; j <= cj + r; j++) {
+	    if (j < 0 || j >= g->nrows)
+		continue;
+	    /* whole rows at the top and bottom of the ring, the ends of the others */
+	    step = (j == cj - r || j == cj + r || r == 0)? 1: 2 * r;
+	    for (i = ci - r; i <= ci + r; i += step) {
+		if (i < 0 || i >= g->ncols)
+		    continue;
+		k = j * g->ncols + i;
+		for (s = &g->sites[g->first[k]]; s < &g->sites[g->first[k + 1]]; s++) {
+		    dx = (double) s->x - qx;
+		    dy = (double) s->y - qy;
+		    d = dx * dx + dy * dy;
+		    if (best == NULL || d < bestd || (d == bestd && s->seq < best->seq)) {
+			best = s;
+			bestd = d;
+		    }
+		}
+	    }
+	}
+    }
+    return best;
+}
+
+/*
+ * Find the first point of the list within tol of (x, y) in both directions,
+ * giving it in *found and the one before it in *prev.
+ */
+
+Boolean
+vindex_within(F_point *points, struct vx_index **vx, int x, int y, int tol,
+	      F_point **prev, F_point **found)
+{
+    VX_grid	   *g;
+    VX_site	   *s, *best;
+    F_point	   *a, *b;
+    int		    i, j, i1, j1, t;
+
+    if ((g = get_grid(points, vx, False)) == NULL) {
+	for (a = NULL, b = points; b != NULL; a = b, b = b->next)
+	    if (abs(b->x - x) <= tol && abs(b->y - y) <= tol) {
+		*prev = a;
+		*found = b;
+		return True;
+	    }
+	return False;
+    }
+
+    x *= 2;
+    y *= 2;
+    t = 2 * tol;
+    best = NULL;
+    i1 = grid_col(g, x + t);
+    j1 = grid_row(g, y + t);
+    for (j = grid_row(g, y - t); j <= j1; j++)
+	for (i = grid_col(g, x - t); i <= i1; i++)
+	    for (s = &g->sites[g->first[j * g->ncols + i]];
+		 s < &g->sites[g->first[j * g->ncols + i + 1]]; s++)
+		if (abs(s->x - x) <= t && abs(s->y - y) <= t &&
+		    (best == NULL || s->seq < best->seq))
+			best = s;
+    if (best == NULL)
+	return False;
+    *prev = best->prev;
+    *found = best->p;
+    return True;
+}
+
+/* the point of the list nearest (x, y), NULL if there are none */
+
+F_point *
+vindex_nearest(F_point *points, struct vx_index **vx, int x, int y)
+{
+    VX_grid	   *g;
+    VX_site	   *s;
+    F_point	   *p, *best;
+    double	    d, bestd, dx, dy;
+
+    if ((g = get_grid(points, vx, False)) == NULL) {
+	best = NULL;
+	bestd = 0.0;
+	for (p = points; p != NULL; p = p->next) {
+	    dx = (double) p->x - x;
+	    dy = (double) p->y - y;
+	    d = dx * dx + dy * dy;
+	    if (best == NULL || d < bestd) {
+		best = p;
+		bestd = d;
+	    }
+	}
+	return best;
+    }
+    s = grid_nearest(g, 2 * x, 2 * y);
+    return (s? s->p: (F_point *) NULL);
+}
+
+/*
+ * The segment of the list whose middle is nearest (x, y), as its end point
+ * with the one before it in *prev, NULL if there are no segments.
+ */
+
+F_point *
+vindex_nearest_middle(F_point *points, struct vx_index **vx, int x, int y,
+		      F_point **prev)
+{
+    VX_grid	   *g;
+    VX_site	   *s;
+    F_point	   *a, *b, *best;
+    double	    d, bestd, dx, dy;
+
+    if ((g = get_grid(points, vx, True)) == NULL) {
+	best = NULL;
+	bestd = 0.0;
+	for (a = points, b = points? points->next: NULL; b != NULL; a = b, b = b->next) {
+	    dx = (double) a->x + b->x - 2.0 * x;
+	    dy = (double) a->y + b->y - 2.0 * y;
+	    d = dx * dx + dy * dy;
+	    if (best == NULL || d < bestd) {
+		best = b;
+		*prev = a;
+		bestd = d;
+	    }
+	}
+	return best;
+    }
+    if ((s = grid_nearest(g, 2 * x, 2 * y)) == NULL)
+	return NULL;
+    *prev = s->prev;
+    return s->p;
+}
+
+/********************** upkeep **********************/
+
+void
+vindex_free(struct vx_index **vx)
+{
+    if (*vx == NULL)
+	return;
+    free_grid((*vx)->vertices);
+    free_grid((*vx)->middles);
+    free((char *) *vx);
+    *vx = NULL;
+}
+
+/* the points of an object may have changed */
+
+void
+vindex_forget(int type, void *obj)
+{
+    if (obj == NULL)
+	return;
+    switch (type) {
+      case O_POLYLINE:
+	vindex_free(&((F_line *) obj)->vindex);
+	break;
+      case O_SPLINE:
+	vindex_free(&((F_spline *) obj)->vindex);
+	break;
+    }
+}
+
+/* any object may have changed, the grids are made again when next needed */
+
+void
+vindex_invalidate(void)
+{
+    vx_epoch++;
+}
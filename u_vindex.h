@@ -0,0 +1,38 @@
+/*
+ * FIG : Facility for Interactive Generation of figures
+ * Copyright (c) 1985-1988 by Supoj Sutanthavibul
+ * Parts Copyright (c) 1989-2002 by Brian V. Smith
+ * Parts Copyright (c) 1991 by Paul King
+ *
+ * Any party obtaining a copy of these files is granted, free of charge, a
+ * full and unrestricted irrevocable, world-wide, paid up, royalty-free,
+ * nonexclusive right and license to deal in this software and documentation
+ * files (the "Software"), including without limitation the rights to use,
+ * copy, modify, merge, publish distribute, sublicense and/or sell copies of
+ * the Software, and to permit persons who receive copies from any such
+ * party to do so, with the only requirement being that the above copyright
+ * and this permission notice remain intact.
+ *
+ */
+
+#ifndef U_VINDEX_H
+#define U_VINDEX_H
+
+/*
+ * Grids over the points of the long lines and splines of the figure, kept
+ * in their "vindex" member.  They are built when first searched and
+ * dropped with vindex_forget() whenever the spatial index of u_rtree.c
+ * hears that the object has changed.  Shorter point lists are just
+ * scanned.
+ */
+
+extern Boolean	vindex_within(F_point *points, struct vx_index **vx, int x, int y,
+			      int tol, F_point **prev, F_point **found);
+extern F_point *vindex_nearest(F_point *points, struct vx_index **vx, int x, int y);
+extern F_point *vindex_nearest_middle(F_point *points, struct vx_index **vx,
+				      int x, int y, F_point **prev);
+extern void	vindex_forget(int type, void *obj);
+extern void	vindex_invalidate(void);
+extern void	vindex_free(struct vx_index **vx);
+
+#endif /* U_VINDEX_H */
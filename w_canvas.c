@@ -120,27 +120,26 @@ null_proc(int a, int b)
 static void
 canvas_exposed(Widget tool, XEvent *event, String *params, Cardinal *nparams)
 {
-    static int	    xmin = 9999, xmax = -9999, ymin = 9999, ymax = -9999;
     XExposeEvent   *xe = (XExposeEvent *) event;
-    register int    tmp;
-
-    if (xe->x < xmin)
-	xmin = xe->x;
-    if (xe->y < ymin)
-	ymin = xe->y;
-    if ((tmp = xe->x + xe->width) > xmax)
-	xmax = tmp;
-    if ((tmp = xe->y + xe->height) > ymax)
-	ymax = tmp;
+    XEvent	    ev;
+
+    add_damage(xe->x, xe->y, xe->x + xe->width, xe->y + xe->height);
     if (xe->count > 0)
 	return;
 
     /* kludge to stop getting extra redraws at start up */
-    if (ignore_exp_cnt)
+    if (ignore_exp_cnt) {
 	ignore_exp_cnt--;
-    else
-	redisplay_region(xmin, ymin, xmax, ymax);
-    xmin = 9999, xmax = -9999, ymin = 9999, ymax = -9999;
+	discard_damage();
+	return;
+    }
+    /* take in the exposes already queued for the canvas as well, so
+       uncovering it bit by bit is repaired in one go */
+    while (XCheckTypedWindowEvent(tool_d, XtWindow(tool), Expose, &ev)) {
+	xe = (XExposeEvent *) &ev;
+	add_damage(xe->x, xe->y, xe->x + xe->width, xe->y + xe->height);
+    }
+    restore_damage();
 }
 
 static void canvas_paste(Widget w, XKeyEvent *paste_event);
@@ -623,17 +622,145 @@ reset_click_counter(widget, closure, event, continue_to_dispatch)
 }
 #endif /* SEL_TEXT */
 
-/* clear the canvas - this can't be called to clear a pixmap, only a window */
+/*
+ * The canvas buffer is an off-screen copy of the canvas.  redisplay_region()
+ * draws into it and then copies the result to the window, so that exposes
+ * can be served from it and panning need only draw the strip that comes
+ * into view.  Anything drawn straight on the canvas window (rubber-banding,
+ * markers, objects drawn outside of a redisplay) makes it stale, and it
+ * stays that way until the next redisplay of the whole canvas.
+ */
+
+static Pixmap	canvas_buffer = 0;
+static GC	canvas_buffer_gc;
+static int	canvas_buffer_wd, canvas_buffer_ht;
+static Boolean	canvas_buffer_valid = False;
+static float	canvas_buffer_zoom;		/* zoom and pan when drawn */
+static int	canvas_buffer_xoff, canvas_buffer_yoff;
+
+/* something was drawn on window w, if it's the canvas the buffer is stale */
+
+void
+touch_canvas(Window w)
+{
+    if (w == main_canvas)
+	canvas_buffer_valid = False;
+}
+
+/*
+ * Make the canvas buffer the drawing window.  Returns False if there is
+ * no buffer, in which case drawing goes straight to the canvas as before.
+ */
+
+Boolean
+begin_canvas_buffer(void)
+{
+    XGCValues	    gcv;
+
+    if (canvas_buffer == 0 || canvas_buffer_wd != CANVAS_WD ||
+	canvas_buffer_ht != CANVAS_HT) {
+	    if (canvas_buffer)
+		XFreePixmap(tool_d, canvas_buffer);
+	    canvas_buffer = XCreatePixmap(tool_d, main_canvas,
+					  CANVAS_WD, CANVAS_HT, tool_dpth);
+	    if (canvas_buffer == 0)
+		return False;
+	    canvas_buffer_wd = CANVAS_WD;
+	    canvas_buffer_ht = CANVAS_HT;
+	    canvas_buffer_valid = False;
+    }
+    if (canvas_buffer_gc == 0) {
+	gcv.graphics_exposures = False;
+	gcv.fill_style = FillTiled;
+	canvas_buffer_gc = XCreateGC(tool_d, main_canvas,
+				     GCGraphicsExposures | GCFillStyle, &gcv);
+    }
+    canvas_win = (Window) canvas_buffer;
+    return True;
+}
+
+/*
+ * Done drawing into the buffer, copy the area to the canvas.  Drawing the
+ * whole canvas makes the buffer good for later exposes and pans.
+ */
+
+void
+end_canvas_buffer(int xmin, int ymin, int xmax, int ymax)
+{
+    canvas_win = main_canvas;
+    copy_canvas_buffer(xmin, ymin, xmax, ymax);
+    if (xmin <= 0 && ymin <= 0 && xmax >= CANVAS_WD && ymax >= CANVAS_HT) {
+	canvas_buffer_valid = True;
+	canvas_buffer_zoom = zoomscale;
+	canvas_buffer_xoff = zoomxoff;
+	canvas_buffer_yoff = zoomyoff;
+    }
+}
+
+void
+copy_canvas_buffer(int xmin, int ymin, int xmax, int ymax)
+{
+    XCopyArea(tool_d, canvas_buffer, main_canvas, canvas_buffer_gc,
+	      xmin, ymin, xmax - xmin + 1, ymax - ymin + 1, xmin, ymin);
+}
+
+/*
+ * If the buffer is good, find how far (in pixels) the canvas has been
+ * panned since it was drawn.  Returns False if the buffer is stale, the
+ * zoom has changed, or the pan isn't a whole number of pixels.
+ */
+
+Boolean
+canvas_buffer_shift(int *dx, int *dy)
+{
+    float	    fx, fy;
+
+    if (!canvas_buffer_valid || canvas_buffer_zoom != zoomscale ||
+	canvas_buffer_wd != CANVAS_WD || canvas_buffer_ht != CANVAS_HT)
+	    return False;
+    fx = (canvas_buffer_xoff - zoomxoff) * zoomscale;
+    fy = (canvas_buffer_yoff - zoomyoff) * zoomscale;
+    *dx = round(fx);
+    *dy = round(fy);
+    if (fabs(fx - *dx) > 0.01 || fabs(fy - *dy) > 0.01)
+	return False;
+    if (abs(*dx) >= CANVAS_WD || abs(*dy) >= CANVAS_HT)
+	return False;
+    return True;
+}
+
+/* move the contents of the buffer by (dx, dy) after a pan */
+
+void
+shift_canvas_buffer(int dx, int dy)
+{
+    XCopyArea(tool_d, canvas_buffer, canvas_buffer, canvas_buffer_gc,
+	      max2(0, -dx), max2(0, -dy),
+	      CANVAS_WD - abs(dx), CANVAS_HT - abs(dy),
+	      max2(0, dx), max2(0, dy));
+    canvas_buffer_xoff = zoomxoff;
+    canvas_buffer_yoff = zoomyoff;
+}
+
+/* clear the canvas (or the canvas buffer) inside the clip window */
 
 void clear_canvas(void)
 {
     /* clear the splash graphic if it is still on the screen */
     if (splash_onscreen) {
 	splash_onscreen = False;
-	XClearArea(tool_d, canvas_win, 0, 0, CANVAS_WD, CANVAS_HT, False);
+	XClearArea(tool_d, main_canvas, 0, 0, CANVAS_WD, CANVAS_HT, False);
+	touch_canvas(main_canvas);
+    }
+    if (canvas_buffer && canvas_win == (Window) canvas_buffer) {
+	/* a pixmap has no background, so tile it with the grid ourselves */
+	XSetTile(tool_d, canvas_buffer_gc, canvas_background());
+	XFillRectangle(tool_d, canvas_buffer, canvas_buffer_gc, clip_xmin, clip_ymin,
+	       clip_width, clip_height);
     } else {
 	XClearArea(tool_d, canvas_win, clip_xmin, clip_ymin,
 	       clip_width, clip_height, False);
+	touch_canvas(canvas_win);
     }
     /* redraw any page border */
     redisplay_pageborder();
@@ -643,6 +770,7 @@ void clear_region(int xmin, int ymin, int xmax, int ymax)
 {
     XClearArea(tool_d, canvas_win, xmin, ymin,
 	       xmax - xmin + 1, ymax - ymin + 1, False);
+    touch_canvas(canvas_win);
 }
 
 static void get_canvas_clipboard(Widget w, XtPointer client_data, Atom *selection, Atom *type, XtPointer buf, long unsigned int *length, int *format);
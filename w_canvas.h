@@ -42,6 +42,13 @@ extern void setup_canvas(void);
 extern void clear_region(int xmin, int ymin, int xmax, int ymax);
 extern void clear_canvas(void);
 
+extern void	touch_canvas(Window w);
+extern Boolean	begin_canvas_buffer(void);
+extern void	end_canvas_buffer(int xmin, int ymin, int xmax, int ymax);
+extern void	copy_canvas_buffer(int xmin, int ymin, int xmax, int ymax);
+extern Boolean	canvas_buffer_shift(int *dx, int *dy);
+extern void	shift_canvas_buffer(int dx, int dy);
+
 extern int	clip_xmin, clip_ymin, clip_xmax, clip_ymax;
 extern int	clip_width, clip_height;
 extern int	cur_x, cur_y;
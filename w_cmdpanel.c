@@ -173,6 +173,7 @@ menu_def file_menu_items[] = {
 
 menu_def edit_menu_items[] = {
 	{"Undo               (Meta-U) ", 0, undo, False},
+	{"Redo         (Shift-Meta-U) ", 0, redo, False},
 	{"Paste Objects      (Meta-T) ", 0, paste, False},
 	{"Paste Text         (F18/F20)", 6, paste_primary_selection, False},
 	{"Search/Replace...  (Meta-I) ", -1, popup_search_panel, False},
@@ -658,8 +659,8 @@ paste(Widget w, XtPointer closure, XtPointer call_data)
 		orig_paste_x = cur_c->nwcorner.x;
 		orig_paste_y = cur_c->nwcorner.y;
 
-		/* make it relative for mouse positioning */
-		translate_compound(cur_c, -cur_c->nwcorner.x, -cur_c->nwcorner.y);
+		/* make it relative for mouse positioning (just read, so not shared) */
+		(void) translate_compound(cur_c, -cur_c->nwcorner.x, -cur_c->nwcorner.y);
 	} else {
 		/* an error reading the .xfig file */
 		if (stat(cut_buf_name, &file_status) == 0) {	/* file exists */
@@ -679,6 +680,15 @@ paste(Widget w, XtPointer closure, XtPointer call_data)
 
 	put_msg("Reading objects from \"%s\" ...Done", cut_buf_name);
 	new_c=copy_compound(cur_c);
+	/* it is moved about until placed, so it gets its own objects now */
+	if (new_c == NULL || !unshare_compound_tree(new_c)) {
+		reset_action_on();
+		turn_off_current();
+		set_cursor(arrow_cursor);
+		free_compound(&new_c);
+		free_compound(&cur_c);
+		return;
+	}
 	/* add it to the depths so it is displayed */
 	add_compound_depth(new_c);
 	off_paste_x=new_c->secorner.x;
@@ -746,7 +756,7 @@ move_paste_object(int x, int y)
     paste_draw(ERASE);  
     dx=x-cur_x;
     dy=y-cur_y;
-    translate_compound(new_c,dx,dy);
+    (void) translate_compound(new_c,dx,dy);	/* already unshared */
     cur_x=x;
     cur_y=y;
     paste_draw(PAINT);
@@ -759,7 +769,7 @@ init_move_paste_object(int x, int y)
 {	
     cur_x=x;
     cur_y=y;
-    translate_compound(new_c,x,y);
+    (void) translate_compound(new_c,x,y);	/* already unshared */
     
     paste_draw(PAINT);
     canvas_locmove_proc = move_paste_object;
@@ -791,7 +801,7 @@ place_object_orig_posn(int x, int y, unsigned int shift)
     /* move back to original position */
     dx = orig_paste_x-x;
     dy = orig_paste_y-y;
-    translate_compound(new_c,dx,dy);
+    (void) translate_compound(new_c,dx,dy);	/* already unshared */
     add_compound(new_c);
     set_modifiedflag();
     redisplay_compound(new_c);
@@ -49,6 +49,7 @@
 #include "w_cursor.h"
 #include "w_file.h"
 #include "w_rottext.h"
+#include "w_softdraw.h"
 
 /* EXPORTS */
 
@@ -69,6 +70,18 @@ static XRectangle clip[1];
 static int	parsesize(char *name);
 static Boolean	openwinfonts;
 
+/* storage for conversion of data points to screen coords (zXDrawLines, zXFillPolygon
+   and the panel lines of pw_lines) */
+
+static XPoint	*_pp_ = (XPoint *) NULL;	/* data pointer itself */
+static int	 _npp_ = 0;			/* number of points currently allocated */
+static Boolean	 _noalloc_ = False;		/* signals previous failed alloc */
+static XPoint	*_clp_ = (XPoint *) NULL;	/* clip_poly() output */
+static int	 _nclp_ = 0;			/* number of points allocated there */
+static Boolean	 chkalloc(int n);
+static XPoint	*clipalloc(int n);
+static void	 convert_sh(zXPoint *p, int n);
+
 #define MAXNAMES 35
 
 static struct {
@@ -247,6 +260,10 @@ lookfont(int fnum, int size)
 	if (appres.correct_font_size)
 	    size = round(size*80.0/72.0);
 
+	/* no X server to ask, use the built-in face */
+	if (soft_drawing)
+	    return soft_font(size);
+
 	/* see if we've already loaded that font size 'size'
 	   from the font family 'fnum' */
 
@@ -400,12 +417,19 @@ pw_text(Window w, int x, int y, int op, int depth, XFontStruct *fstruct,
 	fprintf(stderr,"Error, in pw_text, fstruct==NULL\n");
 	return;
     }
+    touch_canvas(w);
 
     /* if this depth is inactive, draw the text in gray */
     /* if depth == MAX_DEPTH+1 then the caller wants the original color no matter what */
     if (draw_parent_gray || (depth < MAX_DEPTH+1 && !active_layer(depth)))
 	color = MED_GRAY;
 
+    if (soft_drawing) {
+	soft_text(x, y, op, fstruct, angle, string, color, background);
+	return;
+    }
+    flush_batch();
+
     /* get the X colors */
     xfg = x_color(color);
     xbg = x_color(background);
@@ -468,6 +492,23 @@ static int	gc_thickness[NUMOPS],
 		gc_join_style[NUMOPS],
 		gc_cap_style[NUMOPS];
 
+/* the dashes last set in each gc, up to 8 for DASH_3_DOTS_LINE */
+static unsigned char dash_list[NUMOPS][8];
+static int	gc_ndashes[NUMOPS];
+
+/*
+ * What was last put in each fill gc, so that set_fill_gc() only sends
+ * the parts that change from one object to the next.
+ */
+
+static struct fill_state {
+    Boolean	    known;
+    Pixel	    fg, bg;
+    Pixmap	    stipple;
+    int		    xorg, yorg;
+    XRectangle	    clip;
+}		fill_gc_state[NUMFILLPATS];
+
 GC
 makegc(int op, Pixel fg, Pixel bg)
 {
@@ -529,6 +570,8 @@ fprintf(stderr,"color = '%s'\n",appres.grid_color);
 	gc_thickness[i] = -1;
 	gc_line_style[i] = -1;
 	gc_join_style[i] = -1;
+	gc_cap_style[i] = -1;
+	gc_ndashes[i] = 0;
     }
     /* gc for page border and axis lines */
     border_gc = DefaultGC(tool_d, tool_sn);
@@ -567,6 +610,7 @@ void init_fill_gc(void)
 	    mask |= GCStipple;
 	}
 	XChangeGC(tool_d, fill_gc[i], mask, &gcv);
+	fill_gc_state[i].known = False;
     }
 }
 
@@ -1004,12 +1048,118 @@ void init_fill_pm(void)
     }
 }
 
+/*
+ * Line segment batching.
+ *
+ * Between begin_batch() and end_batch() (redisplay_objects() brackets the
+ * drawing of the figure with them) pw_vector() and the thin solid lines of
+ * pw_lines() don't go to the server one request at a time.  Their segments,
+ * already in screen coordinates, collect in batch_seg for as long as they
+ * are drawn in the same window with the same line attributes, and go out in
+ * one XDrawSegments.  X has no request for several polylines, so wide or
+ * dashed polylines (whose joins and dash phase would change if they were
+ * cut into segments) and xor lines are still drawn whole.
+ *
+ * Anything that draws in another way or changes the gcs must call
+ * flush_batch() first so the drawing order stays the same.  All the pw_xxx(),
+ * set_xxx() and clip functions here do; draw_pic() and clip_arrows() in
+ * u_draw.c do it before they use gccache[] themselves.
+ */
+
+#define BATCH_SIZE	256
+
+static int	batching = 0;		/* depth of begin_batch() calls */
+static int	nbatch = 0;		/* segments waiting in batch_seg */
+static XSegment	batch_seg[BATCH_SIZE];
+static struct {
+    Window	w;
+    int		op, width, style, join_style, cap_style, color;
+    float	style_val;
+} batch_key;
+
+void
+begin_batch(void)
+{
+    batching++;
+}
+
+void
+end_batch(void)
+{
+    flush_batch();
+    if (batching > 0)
+	batching--;
+}
+
+void
+flush_batch(void)
+{
+    int		    n;
+
+    if (nbatch == 0)
+	return;
+    /* empty the batch first, set_line_stuff() calls us too */
+    n = nbatch;
+    nbatch = 0;
+    set_line_stuff(batch_key.width, batch_key.style, batch_key.style_val,
+		batch_key.join_style, batch_key.cap_style, batch_key.op,
+		batch_key.color);
+    XDrawSegments(tool_d, batch_key.w, gccache[batch_key.op], batch_seg, n);
+}
+
+/* make room for nseg segments drawn with these attributes, flushing the batch
+   if they differ from those of the segments already in it */
+
+static void
+start_batch(Window w, int nseg, int op, int width, int style, float style_val,
+	    int join_style, int cap_style, int color)
+{
+    if (nbatch > 0 &&
+	(nbatch + nseg > BATCH_SIZE || w != batch_key.w || op != batch_key.op ||
+	 width != batch_key.width || style != batch_key.style ||
+	 style_val != batch_key.style_val || join_style != batch_key.join_style ||
+	 cap_style != batch_key.cap_style || color != batch_key.color))
+	    flush_batch();
+    batch_key.w = w;
+    batch_key.op = op;
+    batch_key.width = width;
+    batch_key.style = style;
+    batch_key.style_val = style_val;
+    batch_key.join_style = join_style;
+    batch_key.cap_style = cap_style;
+    batch_key.color = color;
+}
+
 void
 pw_vector(Window w, int x1, int y1, int x2, int y2, int op,
 	  int line_width, int line_style, float style_val, Color color)
 {
+    XSegment	   *s;
+
     if (line_width == 0)
 	return;
+    touch_canvas(w);
+    if (soft_drawing) {
+	soft_vector(x1, y1, x2, y2, op, line_width, line_style, style_val, color);
+	return;
+    }
+    if (batching) {
+	start_batch(w, 1, op, line_width, line_style, style_val,
+		    JOIN_MITER, CAP_BUTT, color);
+	s = &batch_seg[nbatch++];
+	if (line_style == PANEL_LINE) {
+	    s->x1 = x1;
+	    s->y1 = y1;
+	    s->x2 = x2;
+	    s->y2 = y2;
+	} else {
+	    s->x1 = ZOOMX(x1);
+	    s->y1 = ZOOMY(y1);
+	    s->x2 = ZOOMX(x2);
+	    s->y2 = ZOOMY(y2);
+	}
+	return;
+    }
     set_line_stuff(line_width, line_style, style_val, JOIN_MITER, CAP_BUTT, op, color);
     if (line_style == PANEL_LINE)
 	XDrawLine(tool_d, w, gccache[op], x1, y1, x2, y2);
@@ -1025,6 +1175,7 @@ pw_curve(Window w, int xstart, int ystart, int xend, int yend,
     int		    xmin, ymin;
     unsigned int    wd, ht;
 
+    touch_canvas(w);
     /* if this depth is inactive, draw the curve and any fill in gray */
     /* if depth == MAX_DEPTH+1 then the caller wants the original color no matter what */
     if (draw_parent_gray || (depth < MAX_DEPTH+1 && !active_layer(depth))) {
@@ -1032,6 +1183,13 @@ pw_curve(Window w, int xstart, int ystart, int xend, int yend,
 	fill_color = LT_GRAY;
     }
 
+    if (soft_drawing) {
+	soft_curve(xstart, ystart, xend, yend, op, linewidth, style, style_val,
+		   fill_style, pen_color, fill_color, cap_style);
+	return;
+    }
+    flush_batch();
+
     xmin = min2(xstart, xend);
     ymin = min2(ystart, yend);
     wd = (unsigned int) abs(xstart - xend);
@@ -1065,10 +1223,17 @@ pw_point(Window w, int x, int y, int op, int depth, int line_width,
 {
     int		    hf_wid;
 
+    touch_canvas(w);
     /* if this depth is inactive, draw the point in gray */
     if (draw_parent_gray || !active_layer(depth))
 	color = MED_GRAY;
 
+    if (soft_drawing) {
+	soft_point(x, y, op, line_width, color, cap_style);
+	return;
+    }
+    flush_batch();
+
     /* pw_point doesn't use line_style or fill_style but needs color */
     set_line_stuff(line_width, SOLID_LINE, 0.0, JOIN_MITER, cap_style,
 		op, color);
@@ -1088,12 +1253,20 @@ pw_arcbox(Window w, int xmin, int ymin, int xmax, int ymax, int radius,
     GC		    gc;
     int		    diam = 2 * radius;
 
+    touch_canvas(w);
     /* if this depth is inactive, draw the arcbox in gray */
     if (draw_parent_gray || (depth < MAX_DEPTH+1 && !active_layer(depth))) {
 	pen_color = MED_GRAY;
 	fill_color = LT_GRAY;
     }
 
+    if (soft_drawing) {
+	soft_arcbox(xmin, ymin, xmax, ymax, radius, op, line_width, line_style,
+		    style_val, fill_style, pen_color, fill_color);
+	return;
+    }
+    flush_batch();
+
     /* if it's a fill pat we know about */
     if (fill_style >= 0 && fill_style < NUMFILLPATS) {
 	set_fill_gc(fill_style, op, pen_color, fill_color, xmin, ymin);
@@ -1143,7 +1316,9 @@ pw_lines(Window w, zXPoint *points, int npoints, int op, int depth,
 {
     register int i;
     register XPoint *p;
+    XSegment	   *s;
 
+    touch_canvas(w);
     /* if this depth is inactive, draw the line in gray */
     if (draw_parent_gray || (depth < MAX_DEPTH+1 && !active_layer(depth))) {
 	pen_color = MED_GRAY;
@@ -1160,10 +1335,41 @@ pw_lines(Window w, zXPoint *points, int npoints, int op, int depth,
 	    pw_point(w, points[0].x, points[0].y, op, depth, line_width, pen_color, cap_style);
 	    return;
     }
-	
+
+    if (soft_drawing) {
+	soft_lines(points, npoints, op, line_width, line_style, style_val,
+		   join_style, cap_style, fill_style, pen_color, fill_color);
+	return;
+    }
+
+    /* an unfilled thin solid line looks the same drawn as separate segments,
+       so it can go in the batch */
+    if (batching && line_style == SOLID_LINE && op != INV_PAINT &&
+	(fill_style < 0 || fill_style >= NUMFILLPATS) && line_width != 0 &&
+	round(display_zoomscale * line_width) <= 1 && npoints - 1 <= BATCH_SIZE) {
+	    start_batch(w, npoints - 1, op, line_width, line_style, style_val,
+			join_style, cap_style, pen_color);
+	    s = &batch_seg[nbatch];
+	    s->x1 = ZOOMX(points[0].x);
+	    s->y1 = ZOOMY(points[0].y);
+	    for (i=1; i<npoints; i++, s++) {
+		s->x2 = ZOOMX(points[i].x);
+		s->y2 = ZOOMY(points[i].y);
+		if (i < npoints - 1) {
+		    s[1].x1 = s->x2;
+		    s[1].y1 = s->y2;
+		}
+	    }
+	    nbatch += npoints - 1;
+	    return;
+    }
+    flush_batch();
+
     if (line_style == PANEL_LINE) {
 	/* must use XPoint, not our zXPoint */
-	p = (XPoint *) malloc(npoints * sizeof(XPoint));
+	if (!chkalloc(npoints))
+	    return;
+	p = _pp_;
 	for (i=0; i<npoints; i++) {
 	    p[i].x = (short) points[i].x;
 	    p[i].y = (short) points[i].y;
@@ -1194,7 +1400,6 @@ pw_lines(Window w, zXPoint *points, int npoints, int op, int depth,
 			op, pen_color);
     if (line_style == PANEL_LINE) {
 	XDrawLines(tool_d, w, gccache[op], p, npoints, CoordModeOrigin);
-	free((char *) p);
     } else {
 	zXDrawLines(tool_d, w, gccache[op], points, npoints, CoordModeOrigin);
     }
@@ -1208,6 +1413,12 @@ void set_clip_window(int xmin, int ymin, int xmax, int ymax)
     clip_ymax = ymax;
     clip_width = clip[0].width = xmax - xmin + 1;
     clip_height = clip[0].height = ymax - ymin + 1;
+    if (soft_drawing) {
+	/* drop any arrowhead clipping too */
+	soft_set_region((Region) NULL);
+	return;
+    }
+    flush_batch();
     XSetClipRectangles(tool_d, border_gc, 0, 0, clip, 1, YXBanded);
     XSetClipRectangles(tool_d, gccache[PAINT], 0, 0, clip, 1, YXBanded);
     XSetClipRectangles(tool_d, gccache[INV_PAINT], 0, 0, clip, 1, YXBanded);
@@ -1227,6 +1438,14 @@ void reset_clip_window(void)
 void set_fill_gc(int fill_style, int op, int pencolor, int fillcolor, int xorg, int yorg)
 {
     Color	    fg, bg;
+    XGCValues	    gcv;
+    unsigned long   mask;
+    struct fill_state *st;
+
+    /* no GCs without a display, w_softdraw.c does its own */
+    if (soft_drawing)
+	return;
+    flush_batch();
 
     /* see if we need to create this fill style if it is a pattern.
        This might have happened if there was a change of zoom. */
@@ -1256,25 +1475,39 @@ void set_fill_gc(int fill_style, int op, int pencolor, int fillcolor, int xorg,
 	fg = x_bg_color.pixel;   /* un-fill */
 	bg = x_bg_color.pixel;
     }
-    XSetForeground(tool_d,fillgc,fg);
-    XSetBackground(tool_d,fillgc,bg);
+    /* only send what differs from the gc */
+    st = &fill_gc_state[fill_style];
+    mask = 0;
+    if (!st->known || fg != st->fg) {
+	gcv.foreground = st->fg = fg;
+	mask |= GCForeground;
+    }
+    if (!st->known || bg != st->bg) {
+	gcv.background = st->bg = bg;
+	mask |= GCBackground;
+    }
     /* set stipple from the fill_pm array */
-    XSetStipple(tool_d, fillgc, fill_pm[fill_style]);
+    if (!st->known || fill_pm[fill_style] != st->stipple) {
+	gcv.stipple = st->stipple = fill_pm[fill_style];
+	mask |= GCStipple;
+    }
     /* set origin of pattern relative to object itself */
-    XSetTSOrigin(tool_d, fillgc, ZOOMX(xorg), ZOOMY(yorg));
-    XSetClipRectangles(tool_d, fillgc, 0, 0, clip, 1, YXBanded);
+    if (!st->known || ZOOMX(xorg) != st->xorg || ZOOMY(yorg) != st->yorg) {
+	gcv.ts_x_origin = st->xorg = ZOOMX(xorg);
+	gcv.ts_y_origin = st->yorg = ZOOMY(yorg);
+	mask |= GCTileStipXOrigin | GCTileStipYOrigin;
+    }
+    if (mask != 0)
+	XChangeGC(tool_d, fillgc, mask, &gcv);
+    if (!st->known || clip[0].x != st->clip.x || clip[0].y != st->clip.y ||
+	clip[0].width != st->clip.width || clip[0].height != st->clip.height) {
+	    st->clip = clip[0];
+	    XSetClipRectangles(tool_d, fillgc, 0, 0, clip, 1, YXBanded);
+    }
+    st->known = True;
 }
 
 
-static unsigned char dash_list[16][2] = {{255, 255}, {255, 255},
-					{255, 255}, {255, 255},
-					{255, 255}, {255, 255},
-					{255, 255}, {255, 255},
-					{255, 255}, {255, 255},
-					{255, 255}, {255, 255},
-					{255, 255}, {255, 255},
-					{255, 255}, {255, 255}};
-
 static int join_styles[3] = { JoinMiter, JoinRound, JoinBevel };
 static int cap_styles[3] = { CapButt, CapRound, CapProjecting };
 
@@ -1290,6 +1523,13 @@ void set_line_stuff(int width, int style, float style_val, int join_style, int c
 {
     XGCValues	    gcv;
     unsigned long   mask;
+    Boolean	    dashed;
+    unsigned char   dashes[8];
+    int		    ndashes;
+
+    if (soft_drawing)
+	return;
+    flush_batch();
 
     switch (style) {
       case RUBBER_LINE:
@@ -1311,82 +1551,93 @@ void set_line_stuff(int width, int style, float style_val, int join_style, int c
     if (width == 0 && style != SOLID_LINE)
 	width = 1;
 
-    /* see if all gc stuff is already correct */
-
-    if (width == gc_thickness[op] && style == gc_line_style[op] &&
-	join_style == gc_join_style[op] &&
-	cap_style == gc_cap_style[op] &&
-	(x_color(color) == gc_color[op]) &&
-	((style != DASH_LINE && style != DOTTED_LINE &&
-          style != DASH_DOT_LINE && style != DASH_2_DOTS_LINE &&
-          style != DASH_3_DOTS_LINE) ||
-	 dash_list[op][1] == (unsigned char) round(style_val * display_zoomscale)))
-	    return;			/* no need to change anything */
-
-    gcv.line_width = width;
-    mask = GCLineWidth | GCLineStyle | GCCapStyle | GCJoinStyle;
-    if (op == PAINT) {
-	gcv.foreground = x_color(color);
-	mask |= GCForeground;
-    } else if (op == INV_PAINT) {
-	gcv.foreground = x_color(color) ^ x_bg_color.pixel;
-	mask |= GCForeground;
-    }
-    gcv.join_style = join_styles[join_style];
-    gcv.cap_style = cap_styles[cap_style];
-    gcv.line_style = (style == DASH_LINE || style == DOTTED_LINE ||
-             style == DASH_DOT_LINE || style == DASH_2_DOTS_LINE ||
-             style == DASH_3_DOTS_LINE) ?
-	LineOnOffDash : LineSolid;
-
-    XChangeGC(tool_d, gccache[op], mask, &gcv);
-    if (style_val > 0.0) {	/* style_val of 0.0 causes problems */
+    dashed = (style == DASH_LINE || style == DOTTED_LINE ||
+	      style == DASH_DOT_LINE || style == DASH_2_DOTS_LINE ||
+	      style == DASH_3_DOTS_LINE);
+
+    /* work out the dashes first so they can be compared with the gc's */
+    ndashes = 0;
+    if (dashed && style_val > 0.0) {	/* style_val of 0.0 causes problems */
 	if (style == DASH_LINE || style == DOTTED_LINE) {
 	    /* length of ON/OFF pixels */
 	    if (style_val * display_zoomscale > 255.0)
-		dash_list[op][0] = dash_list[op][1] = (char) 255;	/* too large for X! */
+		dashes[0] = dashes[1] = (char) 255;	/* too large for X! */
 	    else
-	        dash_list[op][0] = dash_list[op][1] = 
+	        dashes[0] = dashes[1] = 
 				(char) round(style_val * display_zoomscale);
 	    /* length of ON pixels for dotted */
 	    if (style == DOTTED_LINE)
-		dash_list[op][0] = (char)display_zoomscale;
-
-	    if (dash_list[op][0]==0)		/* take care for rounding to zero ! */
-		dash_list[op][0]=1;
-	    if (dash_list[op][1]==0)		/* take care for rounding to zero ! */
-		dash_list[op][1]=1;
-	    XSetDashes(tool_d, gccache[op], 0, (char *) dash_list[op], 2);
-	} else if (style == DASH_DOT_LINE || style == DASH_2_DOTS_LINE ||
-		  style == DASH_3_DOTS_LINE) {
-            int il, nd;
+		dashes[0] = (char)display_zoomscale;
+
+	    if (dashes[0]==0)		/* take care for rounding to zero ! */
+		dashes[0]=1;
+	    if (dashes[1]==0)		/* take care for rounding to zero ! */
+		dashes[1]=1;
+	    ndashes = 2;
+	} else {
+            int il;
             float *fl;
             if (style == DASH_2_DOTS_LINE) {
 		fl=dash_2dots;
-		nd=ndash_2dots;
+		ndashes=ndash_2dots;
 	    } else if (style == DASH_3_DOTS_LINE) {
 		fl=dash_3dots;
-		nd=ndash_3dots;
+		ndashes=ndash_3dots;
 	    } else {
 		fl=dash_dot;
-		nd=ndash_dot;
+		ndashes=ndash_dot;
 	    }
-	    for (il =0; il<nd; il ++) {
+	    for (il =0; il<ndashes; il ++) {
                 if (fl[il] != 0.) {
 		    if (fl[il] * style_val * display_zoomscale > 255.0)
-			dash_list[op][il] = (char) 255;	/* too large for X! */
+			dashes[il] = (char) 255;	/* too large for X! */
 	    	    else
-	        	dash_list[op][il] = (char) round(fl[il] * style_val * 
+	        	dashes[il] = (char) round(fl[il] * style_val * 
 					display_zoomscale);
 		} else {
-		    dash_list[op][il] = (char)display_zoomscale;
+		    dashes[il] = (char)display_zoomscale;
 		}
-		if (dash_list[op][il]==0)	/* take care for rounding to zero ! */
-			dash_list[op][il]=1;
+		if (dashes[il]==0)	/* take care for rounding to zero ! */
+			dashes[il]=1;
 	    }
-	    XSetDashes(tool_d, gccache[op], 0, (char *) dash_list[op], nd);
 	}
     }
+
+    /* only send what differs from the gc */
+    mask = 0;
+    if (width != gc_thickness[op]) {
+	gcv.line_width = width;
+	mask |= GCLineWidth;
+    }
+    if (style != gc_line_style[op]) {
+	gcv.line_style = dashed ? LineOnOffDash : LineSolid;
+	mask |= GCLineStyle;
+    }
+    if (join_style != gc_join_style[op]) {
+	gcv.join_style = join_styles[join_style];
+	mask |= GCJoinStyle;
+    }
+    if (cap_style != gc_cap_style[op]) {
+	gcv.cap_style = cap_styles[cap_style];
+	mask |= GCCapStyle;
+    }
+    if (x_color(color) != gc_color[op]) {
+	if (op == PAINT) {
+	    gcv.foreground = x_color(color);
+	    mask |= GCForeground;
+	} else if (op == INV_PAINT) {
+	    gcv.foreground = x_color(color) ^ x_bg_color.pixel;
+	    mask |= GCForeground;
+	}
+    }
+    if (mask != 0)
+	XChangeGC(tool_d, gccache[op], mask, &gcv);
+    if (ndashes != 0 && (ndashes != gc_ndashes[op] ||
+	bcmp((char *) dashes, (char *) dash_list[op], ndashes) != 0)) {
+	    bcopy((char *) dashes, (char *) dash_list[op], ndashes);
+	    gc_ndashes[op] = ndashes;
+	    XSetDashes(tool_d, gccache[op], 0, (char *) dash_list[op], ndashes);
+    }
     gc_thickness[op] = width;
     gc_line_style[op] = style;
     gc_join_style[op] = join_style;
@@ -1456,6 +1707,7 @@ void rescale_pattern(int patnum)
 	if (fill_gc[patnum]) {
 	    gcv.stipple = fill_pm[patnum];
 	    XChangeGC(tool_d, fill_gc[patnum], GCStipple, &gcv);
+	    fill_gc_state[patnum].stipple = fill_pm[patnum];
 	}
 	reset_cursor();
 }
@@ -1529,14 +1781,6 @@ void scale_pattern(int indx)
     pattern_images[indx].cheight = nheight;
 }
 
-/* storage for conversion of data points to screen coords (zXDrawLines and zXFillPolygon) */
-
-static XPoint	*_pp_ = (XPoint *) NULL;	/* data pointer itself */
-static int	 _npp_ = 0;			/* number of points currently allocated */
-static Boolean	 _noalloc_ = False;		/* signals previous failed alloc */
-static Boolean	 chkalloc(int n);
-static void	 convert_sh(zXPoint *p, int n);
-
 void zXDrawLines(Display *d, Window w, GC gc, zXPoint *points, int n, int coordmode)
 {
 #ifdef CLIP_LINE
@@ -1550,7 +1794,8 @@ void zXDrawLines(Display *d, Window w, GC gc, zXPoint *points, int n, int coordm
     /* now convert each point to short into _pp_ */
     convert_sh(points, n);
 #ifdef CLIP_LINE
-    outp = (XPoint *) malloc(2*n*sizeof(XPoint));
+    if ((outp = clipalloc(2*n)) == NULL)
+	return;
     n = clip_poly(_pp_, n, outp);
     XDrawLines(d, w, gc, outp, n, coordmode);
 #else
@@ -1568,10 +1813,10 @@ void zXFillPolygon(Display *d, Window w, GC gc, zXPoint *points, int n, int comp
     }
     /* now convert each point to short into _pp_ */
     convert_sh(points, n);
-    outp = (XPoint *) malloc(2*n*sizeof(XPoint));
+    if ((outp = clipalloc(2*n)) == NULL)
+	return;
     n = clip_poly(_pp_, n, outp);
     XFillPolygon(d, w, gc, outp, n, complex, coordmode);
-    free(outp);
 }
 
 /* convert each point to short */
@@ -1619,6 +1864,27 @@ chkalloc(int n)
     return True;
 }
 
+/* return the output array for clip_poly(), with room for at least n points.
+   It is kept from call to call like _pp_. */
+
+static XPoint *
+clipalloc(int n)
+{
+    int		 i;
+    XPoint	*tpp;
+
+    if (n > _nclp_) {
+	i = max2(n+100, 1000);
+	if ((tpp = (XPoint *) realloc(_clp_, i * sizeof(XPoint))) == 0) {
+	    file_msg("Can't alloc memory for %d point array",i);
+	    return (XPoint *) NULL;
+	}
+	_clp_ = tpp;
+	_nclp_ = i;
+    }
+    return _clp_;
+}
+
 /*
  * clip_poly - This procedure performs the Sutherland-Hodgman polygon clipping
  * on the inVertices array, putting the resultant points into the outVertices array,
@@ -51,6 +51,10 @@ extern void set_fill_gc (int fill_style, int op, int pencolor, int fillcolor, in
 extern void set_line_stuff (int width, int style, float style_val, int join_style, int cap_style, int op, int color);
 extern int x_color (int col);
 extern void init_gc(void);
+extern void begin_batch (void);
+extern void flush_batch (void);
+extern void end_batch (void);
+extern void scale_pattern (int indx);
 
 /* convert Fig units to pixels at current zoom */
 
@@ -34,6 +34,7 @@
 static char	null_bits[null_width * null_height / 8] = {0};
 
 static Pixmap	null_pm, grid_pm = 0;
+static Pixmap	background_pm = 0;	/* current background of the canvas */
 static unsigned long bg, fg;
 
 
@@ -68,7 +69,7 @@ void setup_grid(void)
     grid = cur_gridmode;
 
     if (grid == GRID_0) {
-	FirstArg(XtNbackgroundPixmap, null_pm);
+	FirstArg(XtNbackgroundPixmap, background_pm = null_pm);
     } else {
 	grid_unit = cur_gridunit;
 	/* user scale not = 1.0, use tenths of inch if inch scale */
@@ -84,7 +85,7 @@ void setup_grid(void)
 
 	if (spacing <= 4.0) {
 	    /* too small at this zoom, no grid */
-	    FirstArg(XtNbackgroundPixmap, null_pm);
+	    FirstArg(XtNbackgroundPixmap, background_pm = null_pm);
 	    redisplay_canvas();
 	} else {
 		/* size of the pixmap equal to 1 inch or 2 cm to reset any 
@@ -121,11 +122,20 @@ void setup_grid(void)
 		for (y = y0c; y < dim; y += spacing)
 		    XDrawLine(tool_d, grid_pm, grid_gc, 0, (int) round(y), dim, (int) round(y));
 
-		FirstArg(XtNbackgroundPixmap, grid_pm);
+		FirstArg(XtNbackgroundPixmap, background_pm = grid_pm);
 	}
     }
     SetValues(canvas_sw);
+    /* no expose when the background doesn't change, so redraw ourselves */
     if (prev_grid == GRID_0 && grid == GRID_0)
-	redisplay_canvas();
+	restore_region(0, 0, CANVAS_WD, CANVAS_HT);
     prev_grid = grid;
 }
+
+/* the canvas background (grid or plain), for clearing the canvas buffer */
+
+Pixmap
+canvas_background(void)
+{
+    return background_pm ? background_pm : null_pm;
+}
@@ -1,2 +1,3 @@
 extern int init_grid (void);
 extern int setup_grid (void);
+extern Pixmap canvas_background (void);
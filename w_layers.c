@@ -35,6 +35,7 @@
 #include "w_cmdpanel.h"
 #include "w_msgpanel.h"
 #include "w_canvas.h"
+#include "w_softdraw.h"
 
 /* EXPORTS */
 
@@ -399,7 +400,7 @@ update_layers(void)
     int		 i, height;
 
     /* don't update depth panel when previewing or reading in a Fig file */
-    if (preview_in_progress || defer_update_layers)
+    if (preview_in_progress || defer_update_layers || soft_drawing)
 	return;
 
     XClearWindow(tool_d, w);
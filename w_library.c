@@ -45,6 +45,7 @@
 #include "u_free.h"
 #include "u_list.h"
 #include "u_markers.h"
+#include "u_pool.h"
 #include "u_translate.h"
 #include "w_color.h"
 #include "w_cursor.h"
@@ -445,7 +446,7 @@ load_lib_obj(int obj)
 			 free((char *) c2->comments);
 		    c2->comments = c->comments;
 		    /* free the toplevel */
-		    free((char *) c);
+		    pool_free(&compound_pool, c);
 		    /* make the embedded compound the toplevel */
 	            c = c2;
 		    lib_compounds[obj]->compound = c;
@@ -454,8 +455,8 @@ load_lib_obj(int obj)
 	    /* save the upper-left corner before we translate it to 0,0 */
 	    lib_compounds[obj]->corner.x = lib_compounds[obj]->compound->nwcorner.x;
 	    lib_compounds[obj]->corner.y = lib_compounds[obj]->compound->nwcorner.y;
-	    /* now translate it to 0,0 */
-	    translate_compound(lib_compounds[obj]->compound,
+	    /* now translate it to 0,0 (just read, nothing shared) */
+	    (void) translate_compound(lib_compounds[obj]->compound,
 			 -lib_compounds[obj]->compound->nwcorner.x,
 			 -lib_compounds[obj]->compound->nwcorner.y);
 	    status = True;
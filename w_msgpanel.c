@@ -41,6 +41,7 @@
 
 #include "u_geom.h"
 #include "w_color.h"
+#include "w_softdraw.h"
 
 /********************* EXPORTS *******************/
 
@@ -120,7 +121,7 @@ put_msg(const char *format,...)
     va_start(ap, format);
     vsprintf(prompt, format, ap );
     va_end(ap);
-    if (update_figs) {
+    if (update_figs || soft_drawing) {
 	fprintf(stderr,"%s\n",prompt);
     } else {
 	FirstArg(XtNstring, prompt);
@@ -572,7 +573,7 @@ file_msg(char *format,...)
     XawTextBlock block;
     va_list ap;
 
-    if (!update_figs) {
+    if (!update_figs && !soft_drawing) {
 	popup_file_msg();
 	if (first_file_msg) {
 	    first_file_msg = False;
@@ -587,7 +588,7 @@ file_msg(char *format,...)
     va_end(ap);
 
     strcat(tmpstr,"\n");
-    if (update_figs) {
+    if (update_figs || soft_drawing) {
 	fprintf(stderr,tmpstr);
     } else {
 	/* append this message to the file message widget string */
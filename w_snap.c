@@ -28,6 +28,7 @@
 #include "w_indpanel.h"
 #include "w_util.h"
 #include "u_quartic.h"
+#include "u_vindex.h"
 #include <math.h>
 #include <alloca.h>
 
@@ -112,16 +113,12 @@ snap_polyline_endpoint_handler(l, x, y)
      int x;
      int y;
 {
-  struct f_point * point;
-  double mind = HUGE_VAL;
-  for (point = l->points; point != NULL; point = point->next) {
-    double dist = hypot((double)(point->x - x), (double)(point->y - y));
-    if (dist < mind) {
-      mind = dist;
-      snap_gx = point->x;
-      snap_gy = point->y;
-      snap_found = True;
-    }
+  /* a long line keeps its points in a grid (u_vindex.c) */
+  struct f_point * point = vindex_nearest(l->points, &l->vindex, x, y);
+  if (NULL != point) {
+    snap_gx = point->x;
+    snap_gy = point->y;
+    snap_found = True;
   }
 }
 
@@ -165,22 +162,13 @@ snap_polyline_midpoint_handler(l, x, y)
      int x;
      int y;
 {
-  struct f_point * prev_point = NULL;
+  struct f_point * prev_point;
   struct f_point * point;
-  double mind = HUGE_VAL;
-  for (point = l->points; point != NULL; point = point->next) {
-    if (NULL != prev_point) {
-      double mpx = ((double)(point->x + prev_point->x))/2.0;
-      double mpy = ((double)(point->y + prev_point->y))/2.0;
-      double dist = hypot(mpx - (double)x, mpy - (double)y);
-      if (dist < mind) {
-            mind = dist;
-            snap_gx = (int)lrint(mpx);
-            snap_gy = (int)lrint(mpy);
-            snap_found = True;
-      }
-    }
-    prev_point = point;
+  point = vindex_nearest_middle(l->points, &l->vindex, x, y, &prev_point);
+  if (NULL != point) {
+    snap_gx = (int)lrint(((double)(point->x + prev_point->x))/2.0);
+    snap_gy = (int)lrint(((double)(point->y + prev_point->y))/2.0);
+    snap_found = True;
   }
 }
 
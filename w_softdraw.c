@@ -0,0 +1,1069 @@
+/*
+ * FIG : Facility for Interactive Generation of figures
+ * Copyright (c) 1985-1988 by Supoj Sutanthavibul
+ * Parts Copyright (c) 1989-2002 by Brian V. Smith
+ * Parts Copyright (c) 1991 by Paul King
+ *
+ * Any party obtaining a copy of these files is granted, free of charge, a
+ * full and unrestricted irrevocable, world-wide, paid up, royalty-free,
+ * nonexclusive right and license to deal in this software and documentation
+ * files (the "Software"), including without limitation the rights to use,
+ * copy, modify, merge, publish distribute, sublicense and/or sell copies of
+ * the Software, and to permit persons who receive copies from any such
+ * party to do so, with the only requirement being that the above copyright
+ * and this permission notice remain intact.
+ *
+ */
+
+/*
+ * This file is a software version of the drawing primitives in
+ * w_drawprim.c.  Instead of sending requests to the X server it draws
+ * into an RGBA image in memory, so figures can be rendered without a
+ * display.  It follows the X semantics closely enough that the result
+ * looks like the canvas:
+ *
+ * LINES	- widths, dash lists, cap and join styles as set_line_stuff()
+ * SHADING	- opaque stipples from shade_images[] and pattern_images[],
+ *		  colored as in set_fill_gc(), even-odd polygon fill rule
+ * FONTS	- one built-in 5x7 face, scaled to the point size and rotated
+ *
+ * Pixel centers are at integer coordinates, like the X server.
+ */
+
+/* IMPORTS */
+
+#include "fig.h"
+#include "resources.h"
+#include "paintop.h"
+#include "object.h"
+#include "w_canvas.h"
+#include "w_drawprim.h"
+#include "w_softdraw.h"
+#include "w_zoom.h"
+#include "f_wrpng.h"
+
+/* EXPORTS */
+
+Boolean		soft_drawing = False;
+
+/* LOCAL */
+
+/* convert Fig units to (unrounded) pixels at current zoom */
+#define SZX(x)	(zoomscale*((x)-zoomxoff))
+#define SZY(y)	(zoomscale*((y)-zoomyoff))
+
+typedef struct {
+	unsigned char	r, g, b;
+    } soft_color;
+
+/* what to put in each pixel of a span */
+typedef struct {
+	soft_color	 fg, bg;
+	unsigned char	*bits;		/* stipple (LSB first), NULL for solid fg */
+	int		 bwidth, bheight;
+	int		 xorg, yorg;	/* stipple origin */
+    } soft_paint;
+
+static unsigned char *soft_pixels = (unsigned char *) NULL;	/* RGBA */
+static int	soft_width, soft_height;
+static soft_color soft_background;
+static Region	soft_region = (Region) NULL;	/* extra clip set by clip_arrows() */
+
+static soft_color std_colors[NUM_STD_COLS];
+
+static struct {
+	char	       *name;
+	unsigned char	r, g, b;
+    } named_colors[] = {
+	{"black",	0,   0,   0},
+	{"blue",	0,   0,   255},
+	{"green",	0,   255, 0},
+	{"cyan",	0,   255, 255},
+	{"red",		255, 0,   0},
+	{"magenta",	255, 0,   255},
+	{"yellow",	255, 255, 0},
+	{"white",	255, 255, 255},
+	{"gold",	255, 215, 0},
+    };
+#define NUM_NAMED_COLORS (sizeof(named_colors)/sizeof(named_colors[0]))
+
+/* the grays used for inactive layers etc. (see init_grays in w_util.c) */
+#define DARK_GRAY_LEVEL	166	/* gray65 */
+#define MED_GRAY_LEVEL	204	/* gray80 */
+#define LT_GRAY_LEVEL	229	/* gray90 */
+
+static XFontStruct *soft_fonts[MAX_X_FONT_SIZE+1];
+
+/* scratch arrays for polygons and scan line crossings */
+static double  *poly_x = (double *) NULL, *poly_y = (double *) NULL;
+static int	poly_size = 0;
+static double  *cross_x = (double *) NULL;
+static int	cross_size = 0;
+
+/* 5x7 font for ASCII 32..126, one byte per column, bit 0 is the top row */
+static unsigned char font5x7[95][5] = {
+	{0x00,0x00,0x00,0x00,0x00}, {0x00,0x00,0x5f,0x00,0x00},
+	{0x00,0x07,0x00,0x07,0x00}, {0x14,0x7f,0x14,0x7f,0x14},
+	{0x24,0x2a,0x7f,0x2a,0x12}, {0x23,0x13,0x08,0x64,0x62},
+	{0x36,0x49,0x55,0x22,0x50}, {0x00,0x05,0x03,0x00,0x00},
+	{0x00,0x1c,0x22,0x41,0x00}, {0x00,0x41,0x22,0x1c,0x00},
+	{0x08,0x2a,0x1c,0x2a,0x08}, {0x08,0x08,0x3e,0x08,0x08},
+	{0x00,0x50,0x30,0x00,0x00}, {0x08,0x08,0x08,0x08,0x08},
+	{0x00,0x60,0x60,0x00,0x00}, {0x20,0x10,0x08,0x04,0x02},
+	{0x3e,0x51,0x49,0x45,0x3e}, {0x00,0x42,0x7f,0x40,0x00},
+	{0x42,0x61,0x51,0x49,0x46}, {0x21,0x41,0x45,0x4b,0x31},
+	{0x18,0x14,0x12,0x7f,0x10}, {0x27,0x45,0x45,0x45,0x39},
+	{0x3c,0x4a,0x49,0x49,0x30}, {0x01,0x71,0x09,0x05,0x03},
+	{0x36,0x49,0x49,0x49,0x36}, {0x06,0x49,0x49,0x29,0x1e},
+	{0x00,0x36,0x36,0x00,0x00}, {0x00,0x56,0x36,0x00,0x00},
+	{0x08,0x14,0x22,0x41,0x00}, {0x14,0x14,0x14,0x14,0x14},
+	{0x00,0x41,0x22,0x14,0x08}, {0x02,0x01,0x51,0x09,0x06},
+	{0x32,0x49,0x79,0x41,0x3e}, {0x7e,0x11,0x11,0x11,0x7e},
+	{0x7f,0x49,0x49,0x49,0x36}, {0x3e,0x41,0x41,0x41,0x22},
+	{0x7f,0x41,0x41,0x22,0x1c}, {0x7f,0x49,0x49,0x49,0x41},
+	{0x7f,0x09,0x09,0x01,0x01}, {0x3e,0x41,0x41,0x51,0x32},
+	{0x7f,0x08,0x08,0x08,0x7f}, {0x00,0x41,0x7f,0x41,0x00},
+	{0x20,0x40,0x41,0x3f,0x01}, {0x7f,0x08,0x14,0x22,0x41},
+	{0x7f,0x40,0x40,0x40,0x40}, {0x7f,0x02,0x04,0x02,0x7f},
+	{0x7f,0x04,0x08,0x10,0x7f}, {0x3e,0x41,0x41,0x41,0x3e},
+	{0x7f,0x09,0x09,0x09,0x06}, {0x3e,0x41,0x51,0x21,0x5e},
+	{0x7f,0x09,0x19,0x29,0x46}, {0x46,0x49,0x49,0x49,0x31},
+	{0x01,0x01,0x7f,0x01,0x01}, {0x3f,0x40,0x40,0x40,0x3f},
+	{0x1f,0x20,0x40,0x20,0x1f}, {0x7f,0x20,0x18,0x20,0x7f},
+	{0x63,0x14,0x08,0x14,0x63}, {0x03,0x04,0x78,0x04,0x03},
+	{0x61,0x51,0x49,0x45,0x43}, {0x00,0x7f,0x41,0x41,0x00},
+	{0x02,0x04,0x08,0x10,0x20}, {0x00,0x41,0x41,0x7f,0x00},
+	{0x04,0x02,0x01,0x02,0x04}, {0x40,0x40,0x40,0x40,0x40},
+	{0x00,0x01,0x02,0x04,0x00}, {0x20,0x54,0x54,0x54,0x78},
+	{0x7f,0x48,0x44,0x44,0x38}, {0x38,0x44,0x44,0x44,0x20},
+	{0x38,0x44,0x44,0x48,0x7f}, {0x38,0x54,0x54,0x54,0x18},
+	{0x08,0x7e,0x09,0x01,0x02}, {0x08,0x54,0x54,0x54,0x3c},
+	{0x7f,0x08,0x04,0x04,0x78}, {0x00,0x44,0x7d,0x40,0x00},
+	{0x20,0x40,0x44,0x3d,0x00}, {0x00,0x7f,0x10,0x28,0x44},
+	{0x00,0x41,0x7f,0x40,0x00}, {0x7c,0x04,0x18,0x04,0x78},
+	{0x7c,0x08,0x04,0x04,0x78}, {0x38,0x44,0x44,0x44,0x38},
+	{0x7c,0x14,0x14,0x14,0x08}, {0x08,0x14,0x14,0x18,0x7c},
+	{0x7c,0x08,0x04,0x04,0x08}, {0x48,0x54,0x54,0x54,0x20},
+	{0x04,0x3f,0x44,0x40,0x20}, {0x3c,0x40,0x40,0x20,0x7c},
+	{0x1c,0x20,0x40,0x20,0x1c}, {0x3c,0x40,0x30,0x40,0x3c},
+	{0x44,0x28,0x10,0x28,0x44}, {0x0c,0x50,0x50,0x50,0x3c},
+	{0x44,0x64,0x54,0x4c,0x44}, {0x00,0x08,0x36,0x41,0x00},
+	{0x00,0x00,0x7f,0x00,0x00}, {0x00,0x41,0x36,0x08,0x00},
+	{0x02,0x01,0x02,0x04,0x02},
+    };
+
+/* glyph cell in font units: 5x7 glyph plus one column and two rows of space */
+#define GLYPH_WD	6
+#define GLYPH_HT	9
+#define GLYPH_ASC	7
+
+static soft_color	soft_color_of(Color col);
+static void		soft_span(int y, int x1, int x2, soft_paint *p);
+static void		soft_fill_polygon(double *xs, double *ys, int n, soft_paint *p);
+static void		soft_stroke(double *xs, double *ys, int n, int width,
+				int style, float style_val, int join_style,
+				int cap_style, soft_paint *p);
+static Boolean		grow_poly(int n);
+
+/*
+ * Set up a width x height canvas cleared to "background".
+ * Returns False if there is no memory for it.
+ */
+
+Boolean
+soft_open(int width, int height, Color background)
+{
+    int		    i, j, r, g, b;
+    char	   *name;
+    unsigned char  *pix;
+
+    soft_close();
+    if (width <= 0 || height <= 0)
+	return False;
+    soft_pixels = (unsigned char *) malloc(width * height * 4);
+    if (soft_pixels == NULL)
+	return False;
+    soft_width = width;
+    soft_height = height;
+
+    /* convert the standard color names once */
+    for (i = 0; i < NUM_STD_COLS; i++) {
+	name = colorNames[i+1].rgb;
+	r = g = b = 0;
+	if (name[0] == '#') {
+	    sscanf(&name[1], "%2x%2x%2x", &r, &g, &b);
+	} else {
+	    for (j = 0; j < NUM_NAMED_COLORS; j++)
+		if (strcasecmp(name, named_colors[j].name) == 0) {
+		    r = named_colors[j].r;
+		    g = named_colors[j].g;
+		    b = named_colors[j].b;
+		    break;
+		}
+	}
+	std_colors[i].r = r;
+	std_colors[i].g = g;
+	std_colors[i].b = b;
+    }
+
+    soft_background = soft_color_of(background);
+    for (i = width * height, pix = soft_pixels; i > 0; i--) {
+	*pix++ = soft_background.r;
+	*pix++ = soft_background.g;
+	*pix++ = soft_background.b;
+	*pix++ = 255;
+    }
+    return True;
+}
+
+void
+soft_close(void)
+{
+    if (soft_pixels)
+	free((char *) soft_pixels);
+    soft_pixels = (unsigned char *) NULL;
+    soft_width = soft_height = 0;
+    soft_set_region((Region) NULL);
+}
+
+/* further restrict drawing to "region" (pixels), or remove it if NULL */
+
+void
+soft_set_region(Region region)
+{
+    if (soft_region)
+	XDestroyRegion(soft_region);
+    soft_region = (Region) NULL;
+    if (region) {
+	soft_region = XCreateRegion();
+	XUnionRegion(region, soft_region, soft_region);
+    }
+}
+
+/* write the canvas as a 24-bit PNG file */
+
+Boolean
+soft_write_png(FILE *file)
+{
+    unsigned char  *rgb, *src, *dst;
+    int		    i;
+    Boolean	    status;
+
+    if ((rgb = (unsigned char *) malloc(soft_width * soft_height * 3)) == NULL)
+	return False;
+    for (i = soft_width * soft_height, src = soft_pixels, dst = rgb; i > 0; i--) {
+	*dst++ = *src++;
+	*dst++ = *src++;
+	*dst++ = *src++;
+	src++;
+    }
+    status = write_png(file, rgb, IMAGE_RGB, (unsigned char *) NULL,
+		(unsigned char *) NULL, (unsigned char *) NULL, 0,
+		soft_width, soft_height);
+    free((char *) rgb);
+    return status;
+}
+
+/* write the canvas as a binary (P6) PPM file */
+
+Boolean
+soft_write_ppm(FILE *file)
+{
+    unsigned char  *src;
+    int		    i;
+
+    fprintf(file, "P6\n%d %d\n255\n", soft_width, soft_height);
+    for (i = soft_width * soft_height, src = soft_pixels; i > 0; i--, src += 4)
+	if (fwrite(src, 1, 3, file) != 3)
+	    return False;
+    return (ferror(file) == 0);
+}
+
+/* same decisions as x_color() */
+
+static soft_color
+soft_color_of(Color col)
+{
+    soft_color	    c;
+    int		    gray;
+
+    gray = -1;
+    if (col == LT_GRAY)
+	gray = LT_GRAY_LEVEL;
+    else if (col == DARK_GRAY)
+	gray = DARK_GRAY_LEVEL;
+    else if (col == MED_GRAY || col == TRANSP_BACKGROUND)
+	gray = MED_GRAY_LEVEL;
+    else if (col == COLOR_NONE)
+	col = WHITE;
+    else if (col == DEFAULT)
+	col = BLACK;
+    else if (col == CANVAS_BG)
+	return soft_background;
+    if (gray >= 0) {
+	c.r = c.g = c.b = gray;
+	return c;
+    }
+
+    if (col < 0 || col >= NUM_STD_COLS+num_usr_cols)
+	col = BLACK;
+    if (col < NUM_STD_COLS)
+	return std_colors[col];
+    c.r = user_colors[col-NUM_STD_COLS].red >> 8;
+    c.g = user_colors[col-NUM_STD_COLS].green >> 8;
+    c.b = user_colors[col-NUM_STD_COLS].blue >> 8;
+    return c;
+}
+
+/* GRAPHICS CONTEXTS */
+
+static void
+set_solid(soft_paint *p, int op, Color color)
+{
+    if (op == ERASE)
+	p->fg = soft_background;
+    else
+	p->fg = soft_color_of(color);
+    p->bits = (unsigned char *) NULL;
+}
+
+/* stipple and colors for fill_style, as set_fill_gc() does */
+
+static void
+set_fill(soft_paint *p, int fill_style, int op, Color pencolor, Color fillcolor,
+	int xorg, int yorg)
+{
+    int		    j;
+
+    if (fill_style >= NUMSHADEPATS+NUMTINTPATS) {
+	/* bricks, shingles etc. at the current zoom */
+	j = fill_style - (NUMSHADEPATS+NUMTINTPATS);
+	scale_pattern(j);
+	p->bits = (unsigned char *) pattern_images[j].cdata;
+	p->bwidth = pattern_images[j].cwidth;
+	p->bheight = pattern_images[j].cheight;
+	p->fg = soft_color_of(pencolor);
+	p->bg = soft_color_of(fillcolor);
+    } else {
+	/* tints use the shade patterns in reverse order */
+	if (fill_style < NUMSHADEPATS)
+	    p->bits = shade_images[fill_style];
+	else
+	    p->bits = shade_images[NUMSHADEPATS+NUMTINTPATS-fill_style-1];
+	p->bwidth = p->bheight = SHADE_IM_SIZE;
+	if (fillcolor == BLACK) {
+	    p->fg = soft_color_of(BLACK);
+	    p->bg = soft_color_of(WHITE);
+	} else if (fillcolor == DEFAULT) {
+	    p->fg = soft_color_of(DEFAULT);
+	    p->bg = soft_background;
+	} else {
+	    p->fg = soft_color_of(fillcolor);
+	    p->bg = soft_color_of(fill_style < NUMSHADEPATS? BLACK: WHITE);
+	}
+    }
+    if (op == ERASE)
+	p->fg = p->bg = soft_background;
+    p->xorg = round(SZX(xorg));
+    p->yorg = round(SZY(yorg));
+}
+
+/* the X line width for "width" in style "style" (see set_line_stuff()) */
+
+static int
+soft_line_width(int width, int style)
+{
+    if (style == RUBBER_LINE)
+	return 0;
+    if (style != PANEL_LINE)
+	width = round(display_zoomscale * width);
+    return width;
+}
+
+/* PIXELS */
+
+static void
+soft_span(int y, int x1, int x2, soft_paint *p)
+{
+    unsigned char  *pix, *row;
+    soft_color	   *c;
+    int		    x, bx, by, rbytes;
+
+    if (y < clip_ymin || y > clip_ymax || y < 0 || y >= soft_height)
+	return;
+    x1 = max2(x1, max2(clip_xmin, 0));
+    x2 = min2(x2, min2(clip_xmax, soft_width-1));
+    if (x1 > x2)
+	return;
+
+    row = (unsigned char *) NULL;
+    rbytes = 0;
+    if (p->bits) {
+	rbytes = (p->bwidth + 7) / 8;
+	by = (y - p->yorg) % p->bheight;
+	if (by < 0)
+	    by += p->bheight;
+	row = p->bits + by * rbytes;
+    }
+    pix = soft_pixels + (y * soft_width + x1) * 4;
+    for (x = x1; x <= x2; x++, pix += 4) {
+	if (soft_region && !XPointInRegion(soft_region, x, y))
+	    continue;
+	c = &p->fg;
+	if (row) {
+	    bx = (x - p->xorg) % p->bwidth;
+	    if (bx < 0)
+		bx += p->bwidth;
+	    if ((row[bx / 8] & (1 << (bx & 7))) == 0)
+		c = &p->bg;
+	}
+	pix[0] = c->r;
+	pix[1] = c->g;
+	pix[2] = c->b;
+	pix[3] = 255;
+    }
+}
+
+static Boolean
+grow_poly(int n)
+{
+    double	   *nx, *ny;
+
+    if (n <= poly_size)
+	return True;
+    n = max2(n, 2 * poly_size);
+    nx = (double *) realloc(poly_x, n * sizeof(double));
+    if (nx == NULL)
+	return False;
+    poly_x = nx;
+    ny = (double *) realloc(poly_y, n * sizeof(double));
+    if (ny == NULL)
+	return False;
+    poly_y = ny;
+    poly_size = n;
+    return True;
+}
+
+static int
+cmp_double(const void *a, const void *b)
+{
+    double	    da = *(double *) a, db = *(double *) b;
+
+    return (da < db? -1: (da > db? 1: 0));
+}
+
+/* even-odd scan conversion, sampling each pixel at its center */
+
+static void
+soft_fill_polygon(double *xs, double *ys, int n, soft_paint *p)
+{
+    double	    ymin, ymax, yc, *nc;
+    int		    i, j, y, y1, y2, ncross;
+
+    if (n < 3)
+	return;
+    if (cross_size < n) {
+	nc = (double *) realloc(cross_x, n * sizeof(double));
+	if (nc == NULL)
+	    return;
+	cross_x = nc;
+	cross_size = n;
+    }
+    ymin = ymax = ys[0];
+    for (i = 1; i < n; i++) {
+	ymin = min2(ymin, ys[i]);
+	ymax = max2(ymax, ys[i]);
+    }
+    y1 = max2((int) ceil(ymin), max2(clip_ymin, 0));
+    y2 = min2((int) ceil(ymax) - 1, min2(clip_ymax, soft_height-1));
+
+    for (y = y1; y <= y2; y++) {
+	yc = y;
+	ncross = 0;
+	for (i = 0, j = n-1; i < n; j = i++)
+	    if ((ys[i] <= yc) != (ys[j] <= yc))
+		cross_x[ncross++] = xs[j] + (yc-ys[j]) * (xs[i]-xs[j]) / (ys[i]-ys[j]);
+	if (ncross > 2)
+	    qsort(cross_x, ncross, sizeof(double), cmp_double);
+	else if (ncross == 2 && cross_x[0] > cross_x[1]) {
+	    yc = cross_x[0];
+	    cross_x[0] = cross_x[1];
+	    cross_x[1] = yc;
+	}
+	for (i = 0; i+1 < ncross; i += 2)
+	    soft_span(y, (int) ceil(cross_x[i]), (int) ceil(cross_x[i+1]) - 1, p);
+    }
+}
+
+static void
+soft_disc(double cx, double cy, double r, soft_paint *p)
+{
+    int		    y, y1, y2;
+    double	    dx, dy;
+
+    y1 = (int) ceil(cy - r);
+    y2 = (int) ceil(cy + r) - 1;
+    for (y = y1; y <= y2; y++) {
+	dy = y - cy;
+	if (dy * dy > r * r)
+	    continue;
+	dx = sqrt(r * r - dy * dy);
+	soft_span(y, (int) ceil(cx - dx), (int) ceil(cx + dx) - 1, p);
+    }
+}
+
+static void
+soft_quad(double x1, double y1, double x2, double y2,
+	  double x3, double y3, double x4, double y4, soft_paint *p)
+{
+    double	    qx[4], qy[4];
+
+    qx[0] = x1; qy[0] = y1;
+    qx[1] = x2; qy[1] = y2;
+    qx[2] = x3; qy[2] = y3;
+    qx[3] = x4; qy[3] = y4;
+    soft_fill_polygon(qx, qy, 4, p);
+}
+
+/* a zero-width line, like the server draws it */
+
+static void
+soft_thin_line(double fx1, double fy1, double fx2, double fy2, soft_paint *p)
+{
+    int		    x1, y1, x2, y2, dx, dy, sx, sy, err, e2;
+
+    x1 = round(fx1);
+    y1 = round(fy1);
+    x2 = round(fx2);
+    y2 = round(fy2);
+    dx = abs(x2 - x1);
+    dy = -abs(y2 - y1);
+    sx = (x1 < x2? 1: -1);
+    sy = (y1 < y2? 1: -1);
+    err = dx + dy;
+    for (;;) {
+	soft_span(y1, x1, x1, p);
+	if (x1 == x2 && y1 == y2)
+	    break;
+	e2 = 2 * err;
+	if (e2 >= dy) {
+	    err += dy;
+	    x1 += sx;
+	}
+	if (e2 <= dx) {
+	    err += dx;
+	    y1 += sy;
+	}
+    }
+}
+
+/*
+ * A solid wide polyline: one quad per segment, the joins filled in
+ * according to join_style and the ends according to cap_style.
+ * If the first and last points are the same the line is closed with
+ * a join, as XDrawLines() does.
+ */
+
+static void
+soft_wide_lines(double *xs, double *ys, int n, int width, int join_style,
+		int cap_style, soft_paint *p)
+{
+    double	    h, len, dx, dy, nx, ny, px, py, dot, f;
+    double	    sx1, sy1, sx2, sy2;
+    int		    i, last;
+    Boolean	    closed, have_prev;
+    double	    pnx, pny;
+
+    if (width <= 1) {
+	for (i = 1; i < n; i++)
+	    soft_thin_line(xs[i-1], ys[i-1], xs[i], ys[i], p);
+	if (n == 1)
+	    soft_thin_line(xs[0], ys[0], xs[0], ys[0], p);
+	return;
+    }
+    h = width / 2.0;
+    closed = (n > 2 && xs[0] == xs[n-1] && ys[0] == ys[n-1]);
+    last = n - 1;
+    have_prev = False;
+    pnx = pny = 0.0;
+
+    /* a closed line joins the last segment to the first one */
+    if (closed)
+	for (i = n-1; i > 0; i--) {
+	    dx = xs[i] - xs[i-1];
+	    dy = ys[i] - ys[i-1];
+	    if ((len = sqrt(dx * dx + dy * dy)) > 0.0) {
+		pnx = -dy / len * h;
+		pny = dx / len * h;
+		have_prev = True;
+		break;
+	    }
+	}
+
+    for (i = 1; i <= last; i++) {
+	dx = xs[i] - xs[i-1];
+	dy = ys[i] - ys[i-1];
+	if ((len = sqrt(dx * dx + dy * dy)) == 0.0)
+	    continue;
+	nx = -dy / len * h;
+	ny = dx / len * h;
+	sx1 = xs[i-1];
+	sy1 = ys[i-1];
+	sx2 = xs[i];
+	sy2 = ys[i];
+	if (cap_style == CAP_PROJECT && !closed) {
+	    if (i == 1) {
+		sx1 -= dx / len * h;
+		sy1 -= dy / len * h;
+	    }
+	    if (i == last) {
+		sx2 += dx / len * h;
+		sy2 += dy / len * h;
+	    }
+	}
+	soft_quad(sx1+nx, sy1+ny, sx2+nx, sy2+ny, sx2-nx, sy2-ny, sx1-nx, sy1-ny, p);
+
+	/* join to the previous segment */
+	if (have_prev) {
+	    px = xs[i-1];
+	    py = ys[i-1];
+	    if (join_style == JOIN_ROUND) {
+		soft_disc(px, py, h, p);
+	    } else {
+		dot = pnx * nx + pny * ny;
+		/* X gives up mitering below 11 degrees */
+		if (join_style == JOIN_MITER && h * h + dot > 0.0185 * h * h) {
+		    f = h * h / (h * h + dot);
+		    soft_quad(px, py, px+pnx, py+pny,
+			      px+(pnx+nx)*f, py+(pny+ny)*f, px+nx, py+ny, p);
+		    soft_quad(px, py, px-pnx, py-pny,
+			      px-(pnx+nx)*f, py-(pny+ny)*f, px-nx, py-ny, p);
+		} else {
+		    soft_quad(px, py, px+pnx, py+pny, px+nx, py+ny, px, py, p);
+		    soft_quad(px, py, px-pnx, py-pny, px-nx, py-ny, px, py, p);
+		}
+	    }
+	}
+	pnx = nx;
+	pny = ny;
+	have_prev = True;
+    }
+
+    if (cap_style == CAP_ROUND && !closed) {
+	soft_disc(xs[0], ys[0], h, p);
+	soft_disc(xs[n-1], ys[n-1], h, p);
+    }
+}
+
+/*
+ * Stroke a polyline (pixels) in the given X width and Fig line style.
+ * Dashed lines are cut into their "on" pieces, the dash pattern
+ * continuing around corners like the server's.
+ */
+
+static void
+soft_stroke(double *xs, double *ys, int n, int width, int style,
+	    float style_val, int join_style, int cap_style, soft_paint *p)
+{
+    static double  *px = (double *) NULL, *py = (double *) NULL;
+    static int	    psize = 0;
+    double	    dash[8], left, dx, dy, len, pos, step;
+    float	   *fl;
+    int		    ndash, idash, np, i, il;
+    Boolean	    on;
+
+    if (n <= 0)
+	return;
+    /* solid lines one pixel wide are drawn zero-width for speed */
+    if (width == 1 && style == SOLID_LINE)
+	width = 0;
+    if (width == 0 && style != SOLID_LINE && style != RUBBER_LINE &&
+	style != PANEL_LINE)
+	width = 1;
+
+    ndash = 0;
+    if (style == DASH_LINE || style == DOTTED_LINE || style == DASH_DOT_LINE ||
+	style == DASH_2_DOTS_LINE || style == DASH_3_DOTS_LINE) {
+	if (style_val <= 0.0) {
+	    /* the default X dash list */
+	    dash[0] = dash[1] = 4;
+	    ndash = 2;
+	} else if (style == DASH_LINE || style == DOTTED_LINE) {
+	    dash[0] = dash[1] = min2(255, round(style_val * display_zoomscale));
+	    if (style == DOTTED_LINE)
+		dash[0] = (int) display_zoomscale;
+	    ndash = 2;
+	} else {
+	    static float dash_dot[4] = { 1., 0.5, 0., 0.5 };
+	    static float dash_2dots[6] = { 1., 0.45, 0., 0.333, 0., 0.45 };
+	    static float dash_3dots[8] = { 1., 0.4, 0., 0.3, 0., 0.3, 0., 0.4 };
+
+	    if (style == DASH_2_DOTS_LINE) {
+		fl = dash_2dots;
+		ndash = 6;
+	    } else if (style == DASH_3_DOTS_LINE) {
+		fl = dash_3dots;
+		ndash = 8;
+	    } else {
+		fl = dash_dot;
+		ndash = 4;
+	    }
+	    for (il = 0; il < ndash; il++)
+		if (fl[il] != 0.0)
+		    dash[il] = min2(255, round(fl[il] * style_val * display_zoomscale));
+		else
+		    dash[il] = (int) display_zoomscale;
+	}
+	for (il = 0; il < ndash; il++)
+	    if (dash[il] < 1)
+		dash[il] = 1;
+    }
+
+    if (ndash == 0) {
+	soft_wide_lines(xs, ys, n, width, join_style, cap_style, p);
+	return;
+    }
+
+    /* collect each "on" piece and draw it as a solid line */
+    if (psize < n + 2) {
+	psize = n + 2;
+	px = (double *) realloc(px, psize * sizeof(double));
+	py = (double *) realloc(py, psize * sizeof(double));
+	if (px == NULL || py == NULL) {
+	    psize = 0;
+	    return;
+	}
+    }
+    idash = 0;
+    left = dash[0];
+    on = True;
+    px[0] = xs[0];
+    py[0] = ys[0];
+    np = 1;
+    for (i = 1; i < n; i++) {
+	dx = xs[i] - xs[i-1];
+	dy = ys[i] - ys[i-1];
+	len = sqrt(dx * dx + dy * dy);
+	pos = 0.0;
+	while (len - pos > left) {
+	    pos += left;
+	    step = pos / len;
+	    if (on) {
+		px[np] = xs[i-1] + dx * step;
+		py[np] = ys[i-1] + dy * step;
+		soft_wide_lines(px, py, np+1, width, join_style, cap_style, p);
+	    } else {
+		px[0] = xs[i-1] + dx * step;
+		py[0] = ys[i-1] + dy * step;
+		np = 1;
+	    }
+	    on = !on;
+	    idash = (idash + 1) % ndash;
+	    left = dash[idash];
+	}
+	left -= len - pos;
+	if (on) {
+	    px[np] = xs[i];
+	    py[np] = ys[i];
+	    np++;
+	}
+    }
+    if (on && np > 1)
+	soft_wide_lines(px, py, np, width, join_style, cap_style, p);
+}
+
+/* FONTS */
+
+/*
+ * A font structure describing the built-in face at "size" pixels.
+ * Only the metrics are used, by textsize() and soft_text().
+ */
+
+XFontStruct *
+soft_font(int size)
+{
+    XFontStruct	   *fs;
+    int		    asc, desc, wid;
+
+    if (size < MIN_X_FONT_SIZE)
+	size = MIN_X_FONT_SIZE;
+    else if (size > MAX_X_FONT_SIZE)
+	size = MAX_X_FONT_SIZE;
+    if (soft_fonts[size])
+	return soft_fonts[size];
+
+    if ((fs = (XFontStruct *) malloc(sizeof(XFontStruct))) == NULL)
+	return soft_fonts[MIN_X_FONT_SIZE];
+    bzero((char *) fs, sizeof(XFontStruct));
+    asc = round(size * GLYPH_ASC / (double) GLYPH_HT);
+    desc = size - asc;
+    wid = max2(1, round(size * GLYPH_WD / (double) GLYPH_HT));
+    fs->min_char_or_byte2 = 0;
+    fs->max_char_or_byte2 = 255;
+    fs->default_char = ' ';
+    fs->all_chars_exist = True;
+    fs->per_char = (XCharStruct *) NULL;
+    fs->ascent = fs->max_bounds.ascent = fs->min_bounds.ascent = asc;
+    fs->descent = fs->max_bounds.descent = fs->min_bounds.descent = desc;
+    fs->max_bounds.width = fs->min_bounds.width = wid;
+    fs->max_bounds.rbearing = fs->min_bounds.rbearing = wid;
+    soft_fonts[size] = fs;
+    return fs;
+}
+
+/*
+ * Draw "string" with its baseline starting at (x,y) (Fig units) at
+ * "angle" (radians), filling the text box with "background" first
+ * unless that is COLOR_NONE.
+ */
+
+void
+soft_text(int x, int y, int op, XFontStruct *fstruct, float angle,
+	  char *string, Color color, Color background)
+{
+    soft_paint	    p;
+    double	    px, py, cosa, sina, adv, ht, asc, length;
+    double	    bx[4], by[4], gx, gy, dx, dy;
+    int		    n, i, xs, ys, xmin, ymin, xmax, ymax;
+    int		    ch, col, row;
+
+    if ((n = strlen(string)) == 0)
+	return;
+    asc = fstruct->max_bounds.ascent;
+    ht = asc + fstruct->max_bounds.descent;
+    adv = fstruct->max_bounds.width;
+    length = n * adv;
+    px = SZX(x);
+    py = SZY(y);
+    cosa = cos(angle);
+    sina = sin(angle);
+
+    /* corners of the text box, measured along and below the baseline */
+    for (i = 0; i < 4; i++) {
+	gx = (i == 1 || i == 2)? length: 0.0;
+	gy = (i < 2)? -asc: ht - asc;
+	bx[i] = px + gx * cosa + gy * sina;
+	by[i] = py - gx * sina + gy * cosa;
+    }
+    if (background != COLOR_NONE) {
+	set_solid(&p, op, background);
+	soft_fill_polygon(bx, by, 4, &p);
+    }
+
+    xmin = xmax = round(bx[0]);
+    ymin = ymax = round(by[0]);
+    for (i = 1; i < 4; i++) {
+	xmin = min2(xmin, round(bx[i]));
+	xmax = max2(xmax, round(bx[i]));
+	ymin = min2(ymin, round(by[i]));
+	ymax = max2(ymax, round(by[i]));
+    }
+    xmin = max2(xmin, clip_xmin);
+    xmax = min2(xmax, clip_xmax);
+    ymin = max2(ymin, clip_ymin);
+    ymax = min2(ymax, clip_ymax);
+
+    /* map each pixel back into the string and look up its glyph bit */
+    set_solid(&p, op, color);
+    for (ys = ymin; ys <= ymax; ys++)
+	for (xs = xmin; xs <= xmax; xs++) {
+	    dx = xs - px;
+	    dy = ys - py;
+	    gx = dx * cosa - dy * sina;
+	    gy = dx * sina + dy * cosa + asc;
+	    if (gx < 0.0 || gx >= length || gy < 0.0 || gy >= ht)
+		continue;
+	    i = (int) (gx / adv);
+	    col = (int) ((gx - i * adv) / adv * GLYPH_WD);
+	    row = (int) (gy / ht * GLYPH_HT);
+	    if (col >= 5 || row >= GLYPH_ASC)
+		continue;
+	    ch = (unsigned char) string[i];
+	    if (ch < ' ' || ch > '~')
+		ch = '?';
+	    if (font5x7[ch - ' '][col] & (1 << row))
+		soft_span(ys, xs, xs, &p);
+	}
+}
+
+/* LINES */
+
+void
+soft_vector(int x1, int y1, int x2, int y2, int op,
+	    int line_width, int line_style, float style_val, Color color)
+{
+    soft_paint	    p;
+    double	    xs[2], ys[2];
+
+    if (line_style == PANEL_LINE) {
+	xs[0] = x1; ys[0] = y1;
+	xs[1] = x2; ys[1] = y2;
+    } else {
+	xs[0] = SZX(x1); ys[0] = SZY(y1);
+	xs[1] = SZX(x2); ys[1] = SZY(y2);
+    }
+    set_solid(&p, op, color);
+    soft_stroke(xs, ys, 2, soft_line_width(line_width, line_style), line_style,
+		style_val, JOIN_MITER, CAP_BUTT, &p);
+}
+
+/* points around the ellipse in the box (x,y) (w,h), in pixels */
+
+static int
+ellipse_points(double x, double y, double w, double h)
+{
+    int		    i, n;
+    double	    a;
+
+    n = max2(16, min2(2000, (int) ((w + h) * 1.6)));
+    if (!grow_poly(n + 1))
+	return 0;
+    for (i = 0; i < n; i++) {
+	a = 2.0 * M_PI * i / n;
+	poly_x[i] = x + w / 2.0 * (1.0 + cos(a));
+	poly_y[i] = y + h / 2.0 * (1.0 - sin(a));
+    }
+    poly_x[n] = poly_x[0];
+    poly_y[n] = poly_y[0];
+    return n + 1;
+}
+
+void
+soft_curve(int xstart, int ystart, int xend, int yend,
+	   int op, int linewidth, int style, float style_val, int fill_style,
+	   Color pen_color, Color fill_color, int cap_style)
+{
+    soft_paint	    p;
+    double	    x, y, w, h;
+    int		    n;
+
+    x = SZX(min2(xstart, xend));
+    y = SZY(min2(ystart, yend));
+    w = zoomscale * abs(xstart - xend);
+    h = zoomscale * abs(ystart - yend);
+    if ((n = ellipse_points(x, y, w, h)) == 0)
+	return;
+
+    if (fill_style >= 0 && fill_style < NUMFILLPATS) {
+	set_fill(&p, fill_style, op, pen_color, fill_color, xstart, ystart);
+	soft_fill_polygon(poly_x, poly_y, n - 1, &p);
+    }
+    if (linewidth == 0)
+	return;
+    set_solid(&p, op, pen_color);
+    soft_stroke(poly_x, poly_y, n, soft_line_width(linewidth, style), style,
+		style_val, JOIN_MITER, cap_style, &p);
+}
+
+void
+soft_point(int x, int y, int op, int line_width, Color color, int cap_style)
+{
+    soft_paint	    p;
+    double	    xs[2], ys[2];
+    int		    hf_wid;
+
+    if (cap_style > 0)
+	hf_wid = 0;
+    else
+	hf_wid = (int)(ZOOM_FACTOR*line_width/2);
+    xs[0] = SZX(x - hf_wid);
+    xs[1] = SZX(x + hf_wid + (line_width % 2));
+    ys[0] = ys[1] = SZY(y);
+    set_solid(&p, op, color);
+    soft_stroke(xs, ys, 2, soft_line_width(line_width, SOLID_LINE), SOLID_LINE,
+		0.0, JOIN_MITER, cap_style, &p);
+}
+
+/* add a quarter circle from angle a (degrees) to the polygon */
+
+static int
+add_corner(int n, double cx, double cy, double r, int a, int nseg)
+{
+    int		    i;
+    double	    t;
+
+    for (i = 0; i <= nseg; i++) {
+	t = (a + 90.0 * i / nseg) * M_PI / 180.0;
+	poly_x[n] = cx + r * cos(t);
+	poly_y[n] = cy - r * sin(t);
+	n++;
+    }
+    return n;
+}
+
+void
+soft_arcbox(int xmin, int ymin, int xmax, int ymax, int radius,
+	    int op, int line_width, int line_style,
+	    float style_val, int fill_style, Color pen_color, Color fill_color)
+{
+    soft_paint	    p;
+    double	    x1, y1, x2, y2, r;
+    int		    n, nseg;
+
+    x1 = SZX(xmin);
+    y1 = SZY(ymin);
+    x2 = SZX(xmax);
+    y2 = SZY(ymax);
+    r = zoomscale * radius;
+    r = min2(r, min2(x2 - x1, y2 - y1) / 2.0);
+    nseg = max2(2, min2(200, (int) r));
+    if (!grow_poly(4 * (nseg + 1) + 1))
+	return;
+
+    n = add_corner(0, x2 - r, y1 + r, r, 0, nseg);	/* upper right */
+    n = add_corner(n, x1 + r, y1 + r, r, 90, nseg);	/* upper left */
+    n = add_corner(n, x1 + r, y2 - r, r, 180, nseg);	/* lower left */
+    n = add_corner(n, x2 - r, y2 - r, r, 270, nseg);	/* lower right */
+    poly_x[n] = poly_x[0];
+    poly_y[n] = poly_y[0];
+
+    if (fill_style >= 0 && fill_style < NUMFILLPATS) {
+	set_fill(&p, fill_style, op, pen_color, fill_color, xmin, ymin);
+	soft_fill_polygon(poly_x, poly_y, n, &p);
+    }
+    if (line_width == 0)
+	return;
+    set_solid(&p, op, pen_color);
+    soft_stroke(poly_x, poly_y, n + 1, soft_line_width(line_width, line_style),
+		line_style, style_val, JOIN_MITER, CAP_BUTT, &p);
+}
+
+void
+soft_lines(zXPoint *points, int npoints, int op,
+	   int line_width, int line_style, float style_val,
+	   int join_style, int cap_style, int fill_style,
+	   Color pen_color, Color fill_color)
+{
+    soft_paint	    p;
+    int		    i, xmin, ymin;
+
+    if (!grow_poly(npoints))
+	return;
+    for (i = 0; i < npoints; i++) {
+	if (line_style == PANEL_LINE) {
+	    poly_x[i] = points[i].x;
+	    poly_y[i] = points[i].y;
+	} else {
+	    poly_x[i] = SZX(points[i].x);
+	    poly_y[i] = SZY(points[i].y);
+	}
+    }
+
+    /* patterns start at the upper-left corner of the object */
+    if (fill_style >= 0 && fill_style < NUMFILLPATS) {
+	xmin = ymin = 100000;
+	if (fill_style >= NUMTINTPATS+NUMSHADEPATS) {
+	    for (i = 0; i < npoints; i++) {
+		xmin = min2(xmin, points[i].x);
+		ymin = min2(ymin, points[i].y);
+	    }
+	}
+	set_fill(&p, fill_style, op, pen_color, fill_color, xmin, ymin);
+	soft_fill_polygon(poly_x, poly_y, npoints, &p);
+    }
+    if (line_width == 0)
+	return;
+    set_solid(&p, op, pen_color);
+    soft_stroke(poly_x, poly_y, npoints, soft_line_width(line_width, line_style),
+		line_style, style_val, join_style, cap_style, &p);
+}
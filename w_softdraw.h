@@ -0,0 +1,58 @@
+/*
+ * FIG : Facility for Interactive Generation of figures
+ * Copyright (c) 1985-1988 by Supoj Sutanthavibul
+ * Parts Copyright (c) 1989-2002 by Brian V. Smith
+ * Parts Copyright (c) 1991 by Paul King
+ *
+ * Any party obtaining a copy of these files is granted, free of charge, a
+ * full and unrestricted irrevocable, world-wide, paid up, royalty-free,
+ * nonexclusive right and license to deal in this software and documentation
+ * files (the "Software"), including without limitation the rights to use,
+ * copy, modify, merge, publish distribute, sublicense and/or sell copies of
+ * the Software, and to permit persons who receive copies from any such
+ * party to do so, with the only requirement being that the above copyright
+ * and this permission notice remain intact.
+ *
+ */
+
+#ifndef W_SOFTDRAW_H
+#define W_SOFTDRAW_H
+
+#include "w_drawprim.h"
+
+/*
+ * Software rasterizer used instead of the X server when soft_drawing is
+ * set.  The pw_xxx() primitives hand their (already grayed) arguments to
+ * the soft_xxx() routines, which draw into an in-memory RGBA image the
+ * size of the canvas.  Used by xfig-render to convert figures without a
+ * display.
+ */
+
+extern Boolean	soft_drawing;
+
+extern Boolean	soft_open(int width, int height, Color background);
+extern void	soft_close(void);
+extern void	soft_set_region(Region region);
+extern Boolean	soft_write_png(FILE *file);
+extern Boolean	soft_write_ppm(FILE *file);
+
+extern XFontStruct *soft_font(int size);
+
+extern void	soft_text(int x, int y, int op, XFontStruct *fstruct,
+		    float angle, char *string, Color color, Color background);
+extern void	soft_vector(int x1, int y1, int x2, int y2, int op,
+		    int line_width, int line_style, float style_val, Color color);
+extern void	soft_curve(int xstart, int ystart, int xend, int yend,
+		    int op, int linewidth, int style, float style_val, int fill_style,
+		    Color pen_color, Color fill_color, int cap_style);
+extern void	soft_point(int x, int y, int op, int line_width,
+		    Color color, int cap_style);
+extern void	soft_arcbox(int xmin, int ymin, int xmax, int ymax, int radius,
+		    int op, int line_width, int line_style,
+		    float style_val, int fill_style, Color pen_color, Color fill_color);
+extern void	soft_lines(zXPoint *points, int npoints, int op,
+		    int line_width, int line_style, float style_val,
+		    int join_style, int cap_style, int fill_style,
+		    Color pen_color, Color fill_color);
+
+#endif /* W_SOFTDRAW_H */
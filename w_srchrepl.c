@@ -60,6 +60,7 @@ There is currently no way to undo replace/update operations.
 #include "u_bound.h"
 #include "u_fonts.h"
 #include "u_redraw.h"
+#include "u_rtree.h"
 #include "w_canvas.h"
 #include "w_color.h"
 
@@ -167,6 +168,7 @@ do_replace(Widget widget, XtPointer closure, XtPointer call_data)
     replace_text_in_compound(&objects, panel_get_value(search_text_widget),
 				panel_get_value(replace_text_widget));
     found_text_panel_dismiss();
+    rtree_invalidate();
     redisplay_canvas();
     set_modifiedflag();
     cnt = found_text_cnt;
@@ -190,6 +192,9 @@ replace_text_in_compound(F_compound *com, char *pattern, char *dst)
 	return False;
 
   processed = False;
+  if (!unshare_compound(com))
+	return False;
+  invalidate_compound_bound(com);
   for (c = com->compounds; c != NULL; c = c->next) {
     if (replace_text_in_compound(c, pattern, dst)) 
 	processed = True;
@@ -247,6 +252,7 @@ do_update(Widget widget, XtPointer closure, XtPointer call_data)
     search_text_in_compound(&objects,
             panel_get_value(search_text_widget), update_text);
     found_text_panel_dismiss();
+    rtree_invalidate();
     redisplay_canvas();
     set_modifiedflag();
     show_search_msg("%d object%s updated", 
@@ -904,6 +910,7 @@ spell_correct_word(Widget widget, XtPointer closure, XtPointer call_data)
     FirstArg(XtNstring, &corrected_word);
     GetValues(correct_word);
     replace_text_in_compound(&objects, selected_word, corrected_word);
+    rtree_invalidate();
     redisplay_canvas();
 }
 
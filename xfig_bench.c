@@ -0,0 +1,549 @@
+/*
+ * FIG : Facility for Interactive Generation of figures
+ * Copyright (c) 1985-1988 by Supoj Sutanthavibul
+ * Parts Copyright (c) 1989-2002 by Brian V. Smith
+ * Parts Copyright (c) 1991 by Paul King
+ *
+ * Any party obtaining a copy of these files is granted, free of charge, a
+ * full and unrestricted irrevocable, world-wide, paid up, royalty-free,
+ * nonexclusive right and license to deal in this software and documentation
+ * files (the "Software"), including without limitation the rights to use,
+ * copy, modify, merge, publish distribute, sublicense and/or sell copies of
+ * the Software, and to permit persons who receive copies from any such
+ * party to do so, with the only requirement being that the above copyright
+ * and this permission notice remain intact.
+ *
+ */
+
+/*
+ * xfig-bench: time the main figure operations on a generated figure.
+ *
+ *	xfig-bench [-n objects] [-r repeats] [-z zoom] [-o file.fig]
+ *
+ * A figure with "objects" top-level objects is generated (polylines with
+ * and without arrows, filled boxes, splines with many control points,
+ * texts, ellipses, arcs, pictures and nested compounds, laid out on a
+ * grid) and then read_fig(), free_compound(), write_file(),
+ * redisplay_objects(), do_object_search(), compound_bound() and
+ * copy_compound() are each timed "repeats" times.  Drawing is done by the
+ * software renderer (w_softdraw.c), so no display is needed.  Last,
+ * _read_pcx() is timed on generated PCX_W x PCX_H images, 8-bit and 4-plane,
+ * and its throughput given in megapixels per second.
+ *
+ * Results go to stdout, one tab separated line per test:
+ *
+ *	name  objects  repeats  total_seconds  usec_per_repeat
+ *
+ * Lines starting with '#' are comments; at the end they give the
+ * statistics of the node pools (u_pool.c), with "idle" the nodes that
+ * the blocks hold but aren't in use.  Messages from the figure code
+ * go to stderr.  The generated files are removed unless -o is given.
+ * Like xfig-render it is linked with all the xfig objects except main.
+ */
+
+#include "fig.h"
+#include "resources.h"
+#include "mode.h"
+#include "object.h"
+#include "f_read.h"
+#include "f_readpcx.h"
+#include "f_save.h"
+#include "u_bound.h"
+#include "u_create.h"
+#include "u_free.h"
+#include "u_pool.h"
+#include "u_redraw.h"
+#include "u_search.h"
+#include "version.h"
+#include "w_drawprim.h"
+#include "w_layers.h"
+#include "w_setup.h"
+#include "w_softdraw.h"
+#include "w_zoom.h"
+#include <sys/time.h>
+
+#define CELL		1200	/* grid spacing of the objects (Fig units) */
+#define CELL_USE	1000	/* part of the cell an object may cover */
+#define SPLINE_PTS	40	/* control points per spline */
+#define NEST_DEPTH	3	/* depth of nested compounds */
+#define GROUP		16	/* objects per compound */
+#define SEARCHES	100	/* object searches per repeat */
+#define CANVAS_W	1024
+#define CANVAS_H	768
+#define PCX_W		2048	/* size of the PCX images */
+#define PCX_H		1536
+
+static unsigned long	bench_seed = 1;
+static int		bench_hits;
+
+static int
+bench_rand(int n)
+{
+    bench_seed = bench_seed * 1103515245 + 12345;
+    return (int) ((bench_seed >> 16) % n);
+}
+
+static double
+bench_time(void)
+{
+    struct timeval  tv;
+
+    gettimeofday(&tv, (struct timezone *) NULL);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static void
+report(char *name, int nobj, int reps, double secs)
+{
+    printf("%s\t%d\t%d\t%.6f\t%.1f\n", name, nobj, reps, secs, secs * 1e6 / reps);
+    fflush(stdout);
+}
+
+/* time _read_pcx() on "file", return the seconds */
+
+static double
+time_pcx(char *file, int reps)
+{
+    F_pic	    pic;
+    struct _pics    cache;
+    FILE	   *fp;
+    double	    t, total;
+    int		    r, status;
+
+    total = 0.0;
+    for (r = 0; r < reps; r++) {
+	if ((fp = fopen(file, "rb")) == NULL)
+	    return -1.0;
+	memset(&cache, 0, sizeof(cache));
+	pic.pic_cache = &cache;
+	t = bench_time();
+	status = _read_pcx(fp, &pic);
+	total += bench_time() - t;
+	fclose(fp);
+	free(cache.bitmap);
+	if (status != PicSuccess)
+	    return -1.0;
+    }
+    return total;
+}
+
+/* called by do_object_search() for each object found */
+
+static int
+bench_found(void *obj, int type, int x, int y, int px, int py)
+{
+    bench_hits++;
+    return 0;
+}
+
+/* FIGURE GENERATOR */
+
+static void
+gen_points(FILE *fp, int *x, int *y, int n)
+{
+    int		    i;
+
+    for (i = 0; i < n; i++)
+	fprintf(fp, "%s%d %d", (i % 6 == 0)? "\n\t": " ", x[i], y[i]);
+    fprintf(fp, "\n");
+}
+
+static void
+gen_object(FILE *fp, int i, int ox, int oy, char *picfile)
+{
+    int		    x[SPLINE_PTS+1], y[SPLINE_PTS+1];
+    int		    j, n, cx, cy, color, depth, style;
+
+    color = bench_rand(NUM_STD_COLS + 2) - 1;	/* includes DEFAULT and a user color */
+    depth = 10 + bench_rand(90);
+    cx = ox + CELL_USE / 2;
+    cy = oy + CELL_USE / 2;
+
+    switch (i % 8) {
+      case 0:
+      case 1:
+      case 2:
+	/* open polyline, some dashed, some with arrows */
+	n = 2 + bench_rand(18);
+	for (j = 0; j < n; j++) {
+	    x[j] = ox + bench_rand(CELL_USE);
+	    y[j] = oy + bench_rand(CELL_USE);
+	}
+	style = bench_rand(6);
+	fprintf(fp, "2 1 %d %d %d 7 %d -1 -1 %.3f %d %d -1 %d %d %d",
+		style, 1 + bench_rand(4), color, depth, style? 4.0: 0.0,
+		bench_rand(3), bench_rand(3), i % 3 == 0, i % 3 == 1, n);
+	if (i % 3 == 0)
+	    fprintf(fp, "\n\t1 1 1.00 60.00 120.00");
+	if (i % 3 == 1)
+	    fprintf(fp, "\n\t0 0 1.00 60.00 120.00");
+	gen_points(fp, x, y, n);
+	break;
+      case 3:
+	/* filled box with a shade, tint or pattern */
+	x[0] = x[3] = x[4] = ox;
+	x[1] = x[2] = ox + CELL_USE;
+	y[0] = y[1] = y[4] = oy;
+	y[2] = y[3] = oy + CELL_USE;
+	fprintf(fp, "2 2 0 1 %d %d %d -1 %d 0.000 0 0 -1 0 0 5",
+		color, (color + 3) % NUM_STD_COLS, depth, bench_rand(NUMFILLPATS));
+	gen_points(fp, x, y, 5);
+	break;
+      case 4:
+	/* X-spline with many control points */
+	for (j = 0; j < SPLINE_PTS; j++) {
+	    x[j] = ox + j * CELL_USE / SPLINE_PTS;
+	    y[j] = oy + bench_rand(CELL_USE);
+	}
+	fprintf(fp, "3 4 0 1 %d 7 %d -1 -1 0.000 0 0 0 %d", color, depth, SPLINE_PTS);
+	gen_points(fp, x, y, SPLINE_PTS);
+	fprintf(fp, "\t");
+	for (j = 0; j < SPLINE_PTS; j++)
+	    fprintf(fp, " %.3f", (j == 0 || j == SPLINE_PTS-1)? 0.0: (j % 2? 1.0: -0.5));
+	fprintf(fp, "\n");
+	break;
+      case 5:
+	/* text, some of it rotated */
+	fprintf(fp, "4 0 %d %d -1 %d %d %.4f 4 135 900 %d %d Object number %d\\001\n",
+		color, depth, bench_rand(35), 8 + bench_rand(16),
+		(i % 5 == 0)? 0.5236: 0.0, ox, cy, i);
+	break;
+      case 6:
+	/* ellipse, filled every other time */
+	fprintf(fp, "1 1 0 2 %d %d %d -1 %d 0.000 1 0.0000 %d %d %d %d %d %d %d %d\n",
+		color, (color + 5) % NUM_STD_COLS, depth, (i % 16 == 6)? 20: -1,
+		cx, cy, 100 + bench_rand(400), 100 + bench_rand(400),
+		cx, cy, cx + 400, cy + 400);
+	break;
+      case 7:
+	if (picfile && i % 64 == 7) {
+	    /* picture */
+	    x[0] = x[3] = x[4] = ox;
+	    x[1] = x[2] = ox + CELL_USE;
+	    y[0] = y[1] = y[4] = oy;
+	    y[2] = y[3] = oy + CELL_USE;
+	    fprintf(fp, "2 5 0 1 0 -1 %d -1 -1 0.000 0 0 -1 0 0 5\n\t0 %s", depth, picfile);
+	    gen_points(fp, x, y, 5);
+	} else {
+	    /* arc with an arrow */
+	    fprintf(fp, "5 1 0 2 %d 7 %d -1 -1 0.000 0 0 1 0 %.3f %.3f %d %d %d %d %d %d\n",
+		    color, depth, (double) cx, (double) cy,
+		    cx - 400, cy, cx, cy - 400, cx + 400, cy);
+	    fprintf(fp, "\t1 1 1.00 60.00 120.00\n");
+	}
+	break;
+    }
+}
+
+/*
+ * Write a figure with "nobj" top-level objects to "file".  Every fourth
+ * group of GROUP objects is put inside NEST_DEPTH nested compounds.
+ * Returns False if the file can't be written.
+ */
+
+static Boolean
+gen_figure(char *file, int nobj, char *picfile)
+{
+    FILE	   *fp;
+    int		    i, j, k, cols, ox, oy, grp, row;
+
+    if ((fp = fopen(file, "w")) == NULL)
+	return False;
+    fprintf(fp, "#FIG %s\nLandscape\nCenter\nInches\nLetter\n100.00\nSingle\n-2\n",
+		PROTOCOL_VERSION);
+    fprintf(fp, "# generated by xfig-bench\n1200 2\n");
+    fprintf(fp, "0 %d #a0522d\n", NUM_STD_COLS);
+
+    for (cols = 1; cols * cols < nobj; cols++)
+	;
+    for (i = 0; i < nobj; i = j) {
+	grp = i / GROUP;
+	j = min2(i + GROUP, nobj);
+	if (grp % 4 == 3) {
+	    /* nested compounds around the whole group, bounds from its rows */
+	    row = i / cols;
+	    for (k = 0; k < NEST_DEPTH; k++)
+		fprintf(fp, "6 0 %d %d %d\n", row * CELL,
+			cols * CELL, ((j - 1) / cols + 1) * CELL);
+	}
+	for (k = i; k < j; k++) {
+	    ox = (k % cols) * CELL + (CELL - CELL_USE) / 2;
+	    oy = (k / cols) * CELL + (CELL - CELL_USE) / 2;
+	    gen_object(fp, k, ox, oy, picfile);
+	}
+	if (grp % 4 == 3)
+	    for (k = 0; k < NEST_DEPTH; k++)
+		fprintf(fp, "-6\n");
+    }
+    if (fclose(fp) != 0)
+	return False;
+
+    /* a small gray ramp for the pictures */
+    if (picfile && (fp = fopen(picfile, "w")) != NULL) {
+	fprintf(fp, "P2\n16 16\n255\n");
+	for (i = 0; i < 16 * 16; i++)
+	    fprintf(fp, "%d%c", (i % 16) * 16, (i % 16 == 15)? '\n': ' ');
+	fclose(fp);
+    }
+    return True;
+}
+
+/*
+ * Write a PCX_W x PCX_H PCX image to "file", 8-bit with its colormap if
+ * planes is 1, 4 bit-planes of a 16 color image if it is 4.  The picture is
+ * bands of color, which compress into runs, sprinkled with single pixels.
+ */
+
+static Boolean
+gen_pcx(char *file, int planes)
+{
+    FILE	   *fp;
+    unsigned char   hdr[128], *line, *p;
+    int		    x, y, i, n, v, byteline, nbytes;
+
+    byteline = (planes == 1)? PCX_W: (PCX_W + 15) / 16 * 2;
+    nbytes = byteline * planes;
+    if ((line = (unsigned char *) malloc(nbytes)) == NULL)
+	return False;
+    if ((fp = fopen(file, "wb")) == NULL) {
+	free(line);
+	return False;
+    }
+    memset(hdr, 0, sizeof(hdr));
+    hdr[0] = 10;		/* manufacturer */
+    hdr[1] = 5;			/* version */
+    hdr[2] = 1;			/* RLE */
+    hdr[3] = (planes == 1)? 8: 1;
+    hdr[8] = (PCX_W - 1) & 0xff;
+    hdr[9] = (PCX_W - 1) >> 8;
+    hdr[10] = (PCX_H - 1) & 0xff;
+    hdr[11] = (PCX_H - 1) >> 8;
+    for (i = 0; i < 48; i++)
+	hdr[16 + i] = i * 5;
+    hdr[65] = planes;
+    hdr[66] = byteline & 0xff;
+    hdr[67] = byteline >> 8;
+    fwrite(hdr, 1, sizeof(hdr), fp);
+
+    bench_seed = 1;
+    for (y = 0; y < PCX_H; y++) {
+	memset(line, 0, nbytes);
+	for (x = 0; x < PCX_W; x++) {
+	    v = (x / 24 + y / 16) % 16;
+	    if (bench_rand(8) == 0)
+		v = bench_rand(16);
+	    if (planes == 1)
+		line[x] = v * 16;
+	    else
+		for (i = 0; i < 4; i++)
+		    if (v & (1 << i))
+			line[i * byteline + x / 8] |= 0x80 >> (x % 8);
+	}
+	/* runs of up to 63 equal bytes, and single bytes below 0xc0 */
+	for (p = line; p < line + nbytes; p += n) {
+	    for (n = 1; n < 63 && p + n < line + nbytes && p[n] == p[0]; n++)
+		;
+	    if (n > 1 || p[0] >= 0xc0)
+		putc(0xc0 | n, fp);
+	    putc(p[0], fp);
+	}
+    }
+    if (planes == 1) {
+	/* gray colormap */
+	putc(12, fp);
+	for (i = 0; i < 768; i++)
+	    putc(i / 3, fp);
+    }
+    free(line);
+    return fclose(fp) == 0;
+}
+
+int
+main(int argc, char **argv)
+{
+    fig_settings    settings;
+    F_compound	   *c;
+    char	    figfile[PATH_MAX], outfile[PATH_MAX], picfile[PATH_MAX];
+    char	    pcxfile[PATH_MAX];
+    char	   *keep;
+    float	    zoom;
+    int		    nobj, reps, i, r, status;
+    int		    xmin, ymin, xmax, ymax;
+    double	    t, total, total_free;
+
+    nobj = 10000;
+    reps = 5;
+    zoom = 1.0;
+    keep = NULL;
+    for (i = 1; i < argc; i++) {
+	if (strcmp(argv[i], "-n") == 0 && i+1 < argc)
+	    nobj = atoi(argv[++i]);
+	else if (strcmp(argv[i], "-r") == 0 && i+1 < argc)
+	    reps = atoi(argv[++i]);
+	else if (strcmp(argv[i], "-z") == 0 && i+1 < argc)
+	    zoom = atof(argv[++i]);
+	else if (strcmp(argv[i], "-o") == 0 && i+1 < argc)
+	    keep = argv[++i];
+	else {
+	    fprintf(stderr, "usage: %s [-n objects] [-r repeats] [-z zoom] [-o file.fig]\n",
+			argv[0]);
+	    exit(1);
+	}
+    }
+    if (nobj <= 0 || reps <= 0 || zoom <= 0.0) {
+	fprintf(stderr, "%s: objects, repeats and zoom must be positive\n", argv[0]);
+	exit(1);
+    }
+
+    /* the settings main() would make, minus the display */
+    soft_drawing = True;
+    appres.allownegcoords = True;
+    appres.magnification = 100.0;
+    appres.INCHES = True;
+    warnexist = False;
+    if ((TMPDIR = getenv("XFIGTMPDIR")) == NULL)
+	TMPDIR = "/tmp";
+    ZOOM_FACTOR = PIX_PER_INCH/DISPLAY_PIX_PER_INCH;
+    display_zoomscale = zoom;
+    zoomscale = display_zoomscale/ZOOM_FACTOR;
+    for (i = 0; i <= MAX_DEPTH; i++)
+	active_layers[i] = True;
+
+    if (keep)
+	strcpy(figfile, keep);
+    else
+	sprintf(figfile, "%s/xfig-bench%06d.fig", TMPDIR, getpid());
+    sprintf(outfile, "%s/xfig-bench%06d-out.fig", TMPDIR, getpid());
+    sprintf(picfile, "%s.pgm", figfile);
+    if (!gen_figure(figfile, nobj, picfile)) {
+	fprintf(stderr, "%s: can't write %s: %s\n", argv[0], figfile, strerror(errno));
+	exit(1);
+    }
+
+    printf("# xfig-bench objects=%d repeats=%d zoom=%.2f\n", nobj, reps, zoom);
+    printf("# name\tobjects\trepeats\ttotal_seconds\tusec_per_repeat\n");
+
+    /* read_fig, and free_compound of the figure read */
+    total = total_free = 0.0;
+    for (r = 0; r < reps; r++) {
+	c = create_compound();
+	n_num_usr_cols = -1;
+	t = bench_time();
+	status = read_fig(figfile, c, DONT_MERGE, 0, 0, &settings);
+	total += bench_time() - t;
+	t = bench_time();
+	free_compound(&c);
+	total_free += bench_time() - t;
+	if (status != 0) {
+	    fprintf(stderr, "%s: can't read back %s (%d)\n", argv[0], figfile, status);
+	    exit(1);
+	}
+    }
+    report("read_fig", nobj, reps, total);
+    report("free_compound", nobj, reps, total_free);
+    printf("# free_compound: nodes are freed one at a time.  The blocks are given back\n");
+    printf("#   here only because nothing else holds nodes; in xfig the undo journal,\n");
+    printf("#   cut buffer or library usually do and the blocks stay (\"idle\" below)\n");
+
+    /* keep one copy as the figure for the rest */
+    n_num_usr_cols = -1;
+    read_fig(figfile, &objects, DONT_MERGE, 0, 0, &settings);
+    for (i = 0; i < n_num_usr_cols; i++)
+	user_colors[i] = n_user_colors[i];
+    num_usr_cols = max2(n_num_usr_cols, 0);
+
+    /* write_file */
+    t = bench_time();
+    for (r = 0; r < reps; r++)
+	write_file(outfile, False);
+    report("write_file", nobj, reps, bench_time() - t);
+    unlink(outfile);
+
+    /* compound_bound, the first pass computes the bounds of the objects */
+    bound_hits = bound_misses = 0;
+    t = bench_time();
+    for (r = 0; r < reps; r++)
+	compound_bound(&objects, &xmin, &ymin, &xmax, &ymax);
+    report("compound_bound", nobj, reps, bench_time() - t);
+    printf("# compound_bound: %ld object bounds kept, %ld computed\n",
+		bound_hits, bound_misses);
+
+    /* copy_compound */
+    total = 0.0;
+    for (r = 0; r < reps; r++) {
+	t = bench_time();
+	c = copy_compound(&objects);
+	total += bench_time() - t;
+	free_compound(&c);
+    }
+    report("copy_compound", nobj, reps, total);
+
+    /* redisplay_objects, whole canvas and a small damaged area */
+    CANVAS_WD = CANVAS_W;
+    CANVAS_HT = CANVAS_H;
+    zoomxoff = xmin;
+    zoomyoff = ymin;
+    if (!soft_open(CANVAS_WD, CANVAS_HT, WHITE)) {
+	fprintf(stderr, "%s: no memory for the canvas\n", argv[0]);
+	exit(1);
+    }
+    reset_clip_window();
+    t = bench_time();
+    for (r = 0; r < reps; r++)
+	redisplay_objects(&objects);
+    report("redisplay_objects", nobj, reps, bench_time() - t);
+
+    set_clip_window(CANVAS_WD/4, CANVAS_HT/4, CANVAS_WD/4 + 255, CANVAS_HT/4 + 255);
+    t = bench_time();
+    for (r = 0; r < reps; r++)
+	redisplay_objects(&objects);
+    report("redisplay_objects_region", nobj, reps, bench_time() - t);
+    reset_clip_window();
+    soft_close();
+
+    /* do_object_search, at points scattered over the whole figure */
+    cur_objmask = M_ALL;
+    init_searchproc_left(bench_found);
+    bench_seed = 1;
+    bench_hits = 0;
+    t = bench_time();
+    for (r = 0; r < reps; r++)
+	for (i = 0; i < SEARCHES; i++)
+	    object_search_left(xmin + bench_rand(max2(1, xmax - xmin)),
+			       ymin + bench_rand(max2(1, ymax - ymin)), 0);
+    report("do_object_search", nobj, reps, bench_time() - t);
+    printf("# do_object_search: %d searches per repeat, %d hits\n", SEARCHES, bench_hits);
+
+    /* _read_pcx, on a color display so no mapping to black and white */
+    tool_cells = 256;
+    sprintf(pcxfile, "%s/xfig-bench%06d.pcx", TMPDIR, getpid());
+    for (i = 1; i <= 4; i += 3) {
+	if (!gen_pcx(pcxfile, i)) {
+	    fprintf(stderr, "%s: can't write %s: %s\n", argv[0], pcxfile, strerror(errno));
+	    exit(1);
+	}
+	if ((t = time_pcx(pcxfile, reps)) < 0.0) {
+	    fprintf(stderr, "%s: can't read back %s\n", argv[0], pcxfile);
+	    exit(1);
+	}
+	report(i == 1? "read_pcx_8bit": "read_pcx_4plane", 1, reps, t);
+	printf("# read_pcx: %dx%d %s image, %.1f Mpixels/s\n", PCX_W, PCX_H,
+		i == 1? "8-bit": "4-plane", (double) PCX_W * PCX_H * reps / t / 1e6);
+    }
+    unlink(pcxfile);
+
+    /* node allocator statistics, the figure is still loaded */
+    printf("# pool\tnode_size\tin_use\tidle\tpeak\tblocks\tallocs\tfrees\treleases\n");
+    for (i = 0; obj_pools[i] != NULL; i++)
+	printf("# %s\t%d\t%ld\t%ld\t%ld\t%d\t%ld\t%ld\t%d\n", obj_pools[i]->name,
+		obj_pools[i]->size, obj_pools[i]->in_use,
+		(long) obj_pools[i]->nblocks * obj_pools[i]->per_block - obj_pools[i]->in_use,
+		obj_pools[i]->peak, obj_pools[i]->nblocks, obj_pools[i]->allocs,
+		obj_pools[i]->frees, obj_pools[i]->releases);
+
+    if (!keep) {
+	unlink(figfile);
+	unlink(picfile);
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+/*
+ * FIG : Facility for Interactive Generation of figures
+ * Copyright (c) 1985-1988 by Supoj Sutanthavibul
+ * Parts Copyright (c) 1989-2002 by Brian V. Smith
+ * Parts Copyright (c) 1991 by Paul King
+ *
+ * Any party obtaining a copy of these files is granted, free of charge, a
+ * full and unrestricted irrevocable, world-wide, paid up, royalty-free,
+ * nonexclusive right and license to deal in this software and documentation
+ * files (the "Software"), including without limitation the rights to use,
+ * copy, modify, merge, publish distribute, sublicense and/or sell copies of
+ * the Software, and to permit persons who receive copies from any such
+ * party to do so, with the only requirement being that the above copyright
+ * and this permission notice remain intact.
+ *
+ */
+
+/*
+ * xfig-render: draw a Fig file into a PNG or PPM image without an X server.
+ *
+ *	xfig-render [-z zoom] [-b border] file.fig image.png|image.ppm
+ *
+ * The figure is read with read_fig() and drawn with redisplay_objects()
+ * exactly as on the canvas, but with soft_drawing set so the pw_xxx()
+ * primitives draw into the software canvas of w_softdraw.c.  The image
+ * covers the bounding box of the figure plus "border" pixels all around,
+ * at "zoom" times the normal screen size.  It is linked with all the xfig
+ * objects except main.
+ */
+
+#include "fig.h"
+#include "resources.h"
+#include "object.h"
+#include "f_read.h"
+#include "u_bound.h"
+#include "u_redraw.h"
+#include "w_drawprim.h"
+#include "w_layers.h"
+#include "w_setup.h"
+#include "w_softdraw.h"
+#include "w_zoom.h"
+
+static void
+usage(char *prog)
+{
+    fprintf(stderr, "usage: %s [-z zoom] [-b border] file.fig image.png|image.ppm\n",
+		prog);
+    exit(1);
+}
+
+int
+main(int argc, char **argv)
+{
+    fig_settings    settings;
+    char	   *infile, *outfile, *suffix;
+    float	    zoom;
+    int		    border, i, status;
+    int		    xmin, ymin, xmax, ymax, width, height;
+    FILE	   *fp;
+    Boolean	    ok;
+
+    zoom = 1.0;
+    border = 4;
+    for (i = 1; i < argc && argv[i][0] == '-'; i++) {
+	if (strcmp(argv[i], "-z") == 0 && i+1 < argc)
+	    zoom = atof(argv[++i]);
+	else if (strcmp(argv[i], "-b") == 0 && i+1 < argc)
+	    border = atoi(argv[++i]);
+	else
+	    usage(argv[0]);
+    }
+    if (argc - i != 2 || zoom <= 0.0 || border < 0)
+	usage(argv[0]);
+    infile = argv[i];
+    outfile = argv[i+1];
+
+    /* the settings main() would make, minus the display */
+    soft_drawing = True;
+    appres.allownegcoords = True;	/* don't offer to shift the figure */
+    ZOOM_FACTOR = PIX_PER_INCH/DISPLAY_PIX_PER_INCH;
+    display_zoomscale = zoom;
+    zoomscale = display_zoomscale/ZOOM_FACTOR;
+    for (i = 0; i <= MAX_DEPTH; i++)
+	active_layers[i] = True;
+
+    n_num_usr_cols = -1;
+    status = read_fig(infile, &objects, DONT_MERGE, 0, 0, &settings);
+    if (status != 0) {
+	if (status > 0)
+	    fprintf(stderr, "%s: %s: %s\n", argv[0], infile, strerror(status));
+	else
+	    fprintf(stderr, "%s: %s: %s\n", argv[0], infile,
+		status == EMPTY_FILE? "empty file": "not a Fig file");
+	exit(1);
+    }
+    /* take the user colors from the file (swap_colors() would allocate them) */
+    for (i = 0; i < n_num_usr_cols; i++)
+	user_colors[i] = n_user_colors[i];
+    num_usr_cols = max2(n_num_usr_cols, 0);
+
+    /* size the canvas to the figure */
+    compound_bound(&objects, &xmin, &ymin, &xmax, &ymax);
+    zoomxoff = xmin - round(border / zoomscale);
+    zoomyoff = ymin - round(border / zoomscale);
+    width = ZOOMX(xmax) + border + 1;
+    height = ZOOMY(ymax) + border + 1;
+    CANVAS_WD = width;
+    CANVAS_HT = height;
+    if (!soft_open(width, height, WHITE)) {
+	fprintf(stderr, "%s: no memory for a %dx%d image\n", argv[0], width, height);
+	exit(1);
+    }
+    reset_clip_window();
+    redisplay_objects(&objects);
+
+    if ((fp = fopen(outfile, "wb")) == NULL) {
+	fprintf(stderr, "%s: %s: %s\n", argv[0], outfile, strerror(errno));
+	exit(1);
+    }
+    suffix = strrchr(outfile, '.');
+    if (suffix && (strcasecmp(suffix, ".ppm") == 0 || strcasecmp(suffix, ".pnm") == 0))
+	ok = soft_write_ppm(fp);
+    else
+	ok = soft_write_png(fp);
+    if (fclose(fp) != 0)
+	ok = False;
+    soft_close();
+    if (!ok) {
+	fprintf(stderr, "%s: error writing %s\n", argv[0], outfile);
+	exit(1);
+    }
+    return 0;
+}